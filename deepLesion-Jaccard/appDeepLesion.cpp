@@ -4,6 +4,7 @@
 #include "appDeepLesion.h"
 #pragma package(smart_init)
 #include <unistd.h>
+#include <sys/stat.h>
 
 void AppDeepLesion::CreateTree()
 {
@@ -15,7 +16,16 @@ void AppDeepLesion::CreateTree()
 void AppDeepLesion::CreateDiskPageManager()
 {
 
-    PageManager = new stPlainDiskPageManager("SlimTree.dat", 8192);
+    IndexPageManager = new stPlainDiskPageManager("SlimTree.dat", PageSize);
+    if ((LeafPageSize != 0) && (LeafPageSize != PageSize))
+    {
+        LeafPageManager = new stPlainDiskPageManager("SlimTreeLeaf.dat", LeafPageSize);
+        PageManager = new stDualPageManager(IndexPageManager, LeafPageManager);
+    }
+    else
+    {
+        PageManager = IndexPageManager;
+    }
     // PageManagerDummy = new stPlainDiskPageManager("DummyTree.dat", 8192);
 }
 
@@ -39,6 +49,111 @@ void AppDeepLesion::Run()
     std::cout << "\n\nFinished the whole test!";
 }
 
+//------------------------------------------------------------------------------
+void AppDeepLesion::RunApproximate()
+{
+    std::cout << "\n\nAdding objects in the SlimTree";
+    LoadTree(GEONAMESFILE);
+
+    std::cout << "\n\nAdding objects in the dummy tree";
+    PageManagerDummy = new stPlainDiskPageManager("DummyTree.dat", PageSize);
+    DummyTree = new myDummyTree(PageManagerDummy);
+    LoadDummyTree(GEONAMESFILE);
+
+    PerformApproximateNearestQuery(GEONAMESFILE);
+
+    std::cout << "\n\nFinished the whole test!";
+}
+
+//------------------------------------------------------------------------------
+void AppDeepLesion::RunColumnScan()
+{
+    std::cout << "\n\nAdding objects in the dummy tree";
+    PageManagerDummy = new stPlainDiskPageManager("DummyTree.dat", PageSize);
+    DummyTree = new myDummyTree(PageManagerDummy);
+    LoadDummyTree(GEONAMESFILE);
+
+    PerformColumnScanQueries(GEONAMESFILE);
+
+    std::cout << "\n\nFinished the whole test!";
+}
+
+//------------------------------------------------------------------------------
+void AppDeepLesion::TunePageSize()
+{
+    DeepLesionBinary binary;
+    DeepLesionBinary queryBinary;
+    vector<DeepLesion *> sample;
+    vector<DeepLesion *> queries;
+    myTuner tuner("PageSizeTuner.dat");
+    size_t step;
+    int best;
+
+    if (!OpenBinary(GEONAMESFILE, binary) || !OpenBinary(QUERYGEONAMESFILE, queryBinary))
+    {
+        std::cout << "\nProblem to open the files. Using the page size " << PageSize;
+        return;
+    }
+
+    // A sample spread over the whole file.
+    step = (binary.GetCount() + TUNESAMPLESIZE - 1) / TUNESAMPLESIZE;
+    if (step == 0)
+    {
+        step = 1;
+    }
+    for (size_t i = 0; i < binary.GetCount(); i += step)
+    {
+        DeepLesion *obj = new DeepLesion();
+        binary.Get(i, *obj);
+        sample.push_back(obj);
+    }
+    for (size_t i = 0; i < queryBinary.GetCount(); i++)
+    {
+        DeepLesion *obj = new DeepLesion();
+        queryBinary.Get(i, *obj);
+        queries.push_back(obj);
+    }
+
+    tuner.AddCandidate(2048);
+    tuner.AddCandidate(4096);
+    tuner.AddCandidate(8192);
+    tuner.AddCandidate(16384);
+    tuner.AddCandidate(32768);
+    tuner.AddCandidate(4096, 16384);
+    tuner.AddCandidate(8192, 32768);
+    // The same queries performed by PerformQueries().
+    tuner.SetQuery(5, 0.1);
+
+    std::cout << "\n\nTuning the page size with " << sample.size() << " objects";
+    best = tuner.Evaluate(sample.data(), sample.size(), queries.data(), queries.size());
+
+    std::cout << "\npage leaf height nodes accesses bytes distances cost";
+    for (u_int32_t i = 0; i < tuner.GetNumberOfCandidates(); i++)
+    {
+        const myTuner::tCandidate &candidate = tuner.GetCandidate(i);
+        std::cout << "\n"
+                  << candidate.PageSize << " " << candidate.LeafPageSize << " "
+                  << candidate.Height << " " << candidate.NodeCount << " "
+                  << candidate.DiskAccesses << " " << candidate.BytesRead << " "
+                  << candidate.DistanceCalculations << " " << candidate.Cost;
+    }
+    if (best >= 0)
+    {
+        PageSize = tuner.GetCandidate(best).PageSize;
+        LeafPageSize = tuner.GetCandidate(best).LeafPageSize;
+    }
+    std::cout << "\nRecommended page size " << PageSize << " (leaves " << LeafPageSize << ")";
+
+    for (size_t i = 0; i < sample.size(); i++)
+    {
+        delete sample[i];
+    }
+    for (size_t i = 0; i < queries.size(); i++)
+    {
+        delete queries[i];
+    }
+}
+
 //------------------------------------------------------------------------------
 void AppDeepLesion::Done()
 {
@@ -47,10 +162,26 @@ void AppDeepLesion::Done()
     {
         delete this->SlimTree;
     }
-    if (this->PageManager != NULL)
+    if (this->DummyTree != NULL)
+    {
+        delete this->DummyTree;
+    }
+    if (this->PageManagerDummy != NULL)
+    {
+        delete this->PageManagerDummy;
+    }
+    if (this->PageManager != this->IndexPageManager)
     {
         delete this->PageManager;
     }
+    if (this->LeafPageManager != NULL)
+    {
+        delete this->LeafPageManager;
+    }
+    if (this->IndexPageManager != NULL)
+    {
+        delete this->IndexPageManager;
+    }
 
     for (unsigned int i = 0; i < queryObjects.size(); i++)
     {
@@ -59,80 +190,58 @@ void AppDeepLesion::Done()
 }
 
 //------------------------------------------------------------------------------
-void AppDeepLesion::LoadTree(char *fileName)
+bool AppDeepLesion::OpenBinary(char *fileName, DeepLesionBinary &binary)
 {
-    ifstream in(fileName);
-    DeepLesion *geoname;
+    string binaryName = fileName;
+    struct stat textInfo;
+    struct stat binaryInfo;
 
-    long long oid;
-
-    double patientIndex;
-    double lesionTpe;
-    string patientGender;
-    double patientAge;
-    double d1;
-    double d2;
-    double x;
-    double y;
-    double z;
-
-    int qtd_tags;
-
-    int counter = 0;
-
-    if (SlimTree != NULL)
+    // files/name.txt -> files/name.bin
+    if ((binaryName.size() > 4) && (binaryName.compare(binaryName.size() - 4, 4, ".txt") == 0))
     {
+        binaryName.erase(binaryName.size() - 4);
+    }
+    binaryName += ".bin";
 
+    // Convert it only once (or when the text file changes).
+    if ((stat(fileName, &textInfo) == 0) &&
+        ((stat(binaryName.c_str(), &binaryInfo) != 0) || (binaryInfo.st_mtime < textInfo.st_mtime)))
+    {
         std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
 
-        if (in.is_open())
+        if (!DeepLesionBinary::Convert(fileName, binaryName.c_str()))
         {
+            return false;
+        }
 
-            std::cout << "\nLoading objects ";
-
-            while (true)
-            {
-                long long prev_oid = oid;
-
-                in >> oid;
-
-                if (in.eof())
-                    break;
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
 
-                in >> patientIndex;
-                in >> lesionTpe;
-                in >> patientGender;
-                in >> patientAge;
-                in >> d1;
-                in >> d2;
-                in >> x;
-                in >> y;
-                in >> z;
+        std::cout << "\nConverted " << fileName << " to " << binaryName << " in " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[µs]";
+    }
 
-                in >> qtd_tags;
+    return binary.Open(binaryName.c_str());
+}
 
-                vector<int> tags;
+//------------------------------------------------------------------------------
+void AppDeepLesion::LoadTree(char *fileName)
+{
+    DeepLesionBinary binary;
 
-                int tag;
+    if (SlimTree != NULL)
+    {
 
-                for (int i = 0; i < qtd_tags; i++)
-                {
-                    in >> tag;
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
 
-                    tags.push_back(tag);
-                }
+        if (OpenBinary(fileName, binary))
+        {
 
-                counter++;
+            std::cout << "\nLoading objects ";
 
-                Attributes atr = Attributes(tags);
-                Included incl = Included(patientAge);
+            // A single object is refilled for every record.
+            binary.ForEach([this](DeepLesion &obj)
+                           { SlimTree->Add(&obj); });
 
-                geoname = new DeepLesion(oid, atr, incl);
-                SlimTree->Add(geoname);
-                delete geoname;
-            }
             std::cout << " Added " << SlimTree->GetNumberOfObjects() << " objects ";
-            in.close();
         }
         else
         {
@@ -152,77 +261,22 @@ void AppDeepLesion::LoadTree(char *fileName)
 //------------------------------------------------------------------------------
 void AppDeepLesion::LoadDummyTree(char *fileName)
 {
-    ifstream in(fileName);
-    DeepLesion *geoname;
-
-    long long oid;
-
-    double patientIndex;
-    double lesionTpe;
-    string patientGender;
-    double patientAge;
-    double d1;
-    double d2;
-    double x;
-    double y;
-    double z;
-
-    int qtd_tags;
-
-    int counter = 0;
+    DeepLesionBinary binary;
 
     if (DummyTree != NULL)
     {
 
         std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
 
-        if (in.is_open())
+        if (OpenBinary(fileName, binary))
         {
 
             std::cout << "\nLoading objects on dummy";
 
-            while (true)
-            {
-                long long prev_oid = oid;
-
-                in >> oid;
-
-                if (in.eof())
-                    break;
-                in >> patientIndex;
-                in >> lesionTpe;
-                in >> patientGender;
-                in >> patientAge;
-                in >> d1;
-                in >> d2;
-                in >> x;
-                in >> y;
-                in >> z;
-
-                in >> qtd_tags;
-
-                vector<int> tags;
-
-                int tag;
-
-                for (int i = 0; i < qtd_tags; i++)
-                {
-                    in >> tag;
-
-                    tags.push_back(tag);
-                }
-
-                counter++;
+            binary.ForEach([this](DeepLesion &obj)
+                           { DummyTree->Add(&obj); });
 
-                Attributes atr = Attributes(tags);
-                Included incl = Included(patientAge);
-
-                geoname = new DeepLesion(oid, atr, incl);
-                DummyTree->Add(geoname);
-                delete geoname;
-            }
             std::cout << " Added " << DummyTree->GetNumberOfObjects() << " objects ";
-            in.close();
         }
         else
         {
@@ -242,69 +296,22 @@ void AppDeepLesion::LoadDummyTree(char *fileName)
 //------------------------------------------------------------------------------
 void AppDeepLesion::LoadVectorFromFile(char *fileName)
 {
-
-    ifstream in(fileName);
-    DeepLesion *geoname;
+    DeepLesionBinary binary;
     queryObjects.clear();
 
-    long long oid;
-
-    double patientIndex;
-    double lesionTpe;
-    string patientGender;
-    double patientAge;
-    double d1;
-    double d2;
-    double x;
-    double y;
-    double z;
-
-    int qtd_tags;
-
-    if (in.is_open())
+    if (OpenBinary(fileName, binary))
     {
         std::cout << "\nLoading query objects ";
 
-        while (true)
+        // The query objects are kept, so each one is a new object.
+        for (size_t i = 0; i < binary.GetCount(); i++)
         {
+            vector<int> tags(binary.GetTags(i), binary.GetTags(i) + binary.GetTagCount(i));
 
-            in >> oid;
-
-            // cout << oid << "\n";
-
-            if (in.eof())
-                break;
-            in >> patientIndex;
-            in >> lesionTpe;
-            in >> patientGender;
-            in >> patientAge;
-            in >> d1;
-            in >> d2;
-            in >> x;
-            in >> y;
-            in >> z;
-
-            in >> qtd_tags;
-
-            vector<int> tags;
-
-            int tag;
-
-            for (int i = 0; i < qtd_tags; i++)
-            {
-                in >> tag;
-
-                tags.push_back(tag);
-            }
-
-            Attributes atr = Attributes(tags);
-
-            this->queryObjects.insert(queryObjects.end(), new DeepLesion(atr));
+            this->queryObjects.insert(queryObjects.end(), new DeepLesion(Attributes(tags)));
         }
 
-        // end while
         std::cout << " Added " << queryObjects.size() << " query objects ";
-        in.close();
     }
     else
     {
@@ -550,7 +557,6 @@ void AppDeepLesion::PerformNearestQueryOneCenterDummy()
 void AppDeepLesion::PerformRangeQueryOneCenter()
 {
 
-    myResult *result;
     unsigned int size;
     unsigned int i;
 
@@ -569,23 +575,25 @@ void AppDeepLesion::PerformRangeQueryOneCenter()
         int tuples = 0;
         double avg_range = 0;
 
+        // The answers are written as they are found, reusing one object.
+        mySlimTree *slimTree = (mySlimTree *)SlimTree;
+        DeepLesion answer;
+
         for (i = 0; i < size; i++)
         {
-            result = SlimTree->RangeQuery(queryObjects[i], 0.1);
-
-            tuples = tuples + result->GetNumOfEntries();
+            slimTree->RangeQuery(queryObjects[i], 0.1,
+                                 [&](const unsigned char *data, u_int32_t dataSize, double distance)
+                                 {
+                                     answer.IncludedUnserializeFrom(data, dataSize);
+                                     tuples++;
 
-            for (size_t s = 0; s < result->GetNumOfEntries(); s++)
-            {
-
-                myfile << result->GetPair(s)->GetObject()->getOID() << " ";
+                                     myfile << answer.getOID() << " ";
 
-                myfile << result->GetPair(s)->GetObject()->GetIncluded().GetPatientAge() << " ";
-
-                myfile << result->GetPair(s)->GetDistance() << "\n";
-            }
+                                     myfile << answer.GetIncluded().GetPatientAge() << " ";
 
-            delete result;
+                                     myfile << distance << "\n";
+                                     return true;
+                                 });
         } // end for
 
         std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
@@ -642,3 +650,293 @@ void AppDeepLesion::PerformRangeQueryOneCenterDummy()
         cout << "Distances: " << (double)DummyTree->GetMetricEvaluator()->GetDistanceCount() << "\n";
     }
 }
+
+//------------------------------------------------------------------------------
+void AppDeepLesion::PerformApproximateNearestQuery(char *fileName)
+{
+    // A budget of the approximate query. The first one is the exact query.
+    struct Budget
+    {
+        const char *Knob;
+        double Value;
+        mySlimTree::tApproximate Approximate;
+    };
+    DeepLesionBinary binary;
+    mySlimTree *slimTree = (mySlimTree *)SlimTree;
+    mySlimTree::tHistogram distribution;
+    vector<DeepLesion *> queries;
+    vector<myResult *> exact;
+    vector<Budget> budgets;
+    Budget budget;
+    std::ofstream myfile;
+    size_t step;
+
+    if ((SlimTree == NULL) || (DummyTree == NULL) || !OpenBinary(fileName, binary))
+    {
+        std::cout << "\nProblem to open the file.";
+        return;
+    }
+
+    // Queries and the sample of the distance distribution spread over the
+    // whole file. The queries are objects of the tree, as in TunePageSize().
+    step = (binary.GetCount() + APPROXQUERIES - 1) / APPROXQUERIES;
+    for (size_t i = 0; (step > 0) && (i < binary.GetCount()); i += step)
+    {
+        DeepLesion *obj = new DeepLesion();
+        binary.Get(i, *obj);
+        queries.push_back(obj);
+    }
+    step = (binary.GetCount() + APPROXSAMPLESIZE - 1) / APPROXSAMPLESIZE;
+    for (size_t i = 0; (step > 0) && (i < binary.GetCount()); i += step)
+    {
+        DeepLesion obj;
+        binary.Get(i, obj);
+        distribution.Add(&obj);
+    }
+    distribution.Build(SlimTree->GetMetricEvaluator());
+
+    // The exact answers.
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < queries.size(); i++)
+    {
+        exact.push_back(DummyTree->NearestQuery(queries[i], APPROXK));
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    std::cout << "\n\nSequential scan of " << queries.size() << " queries (k = " << APPROXK << "): "
+              << (double)std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() / queries.size()
+              << "[µs] per query";
+
+    budget.Knob = "exact";
+    budget.Value = 0;
+    budgets.push_back(budget);
+    const u_int32_t maxNodes[] = {4, 8, 16, 32};
+    for (size_t i = 0; i < sizeof(maxNodes) / sizeof(maxNodes[0]); i++)
+    {
+        budget.Approximate = mySlimTree::tApproximate();
+        budget.Knob = "MaxNodes";
+        budget.Value = budget.Approximate.MaxNodes = maxNodes[i];
+        budgets.push_back(budget);
+    }
+    const double epsilons[] = {0.1, 0.25, 0.5};
+    for (size_t i = 0; i < sizeof(epsilons) / sizeof(epsilons[0]); i++)
+    {
+        budget.Approximate = mySlimTree::tApproximate();
+        budget.Knob = "Epsilon";
+        budget.Value = budget.Approximate.Epsilon = epsilons[i];
+        budgets.push_back(budget);
+    }
+    const double maxTimes[] = {0.05, 0.1, 0.5};
+    for (size_t i = 0; i < sizeof(maxTimes) / sizeof(maxTimes[0]); i++)
+    {
+        budget.Approximate = mySlimTree::tApproximate();
+        budget.Knob = "MaxTime[ms]";
+        budget.Value = budget.Approximate.MaxTime = maxTimes[i];
+        budgets.push_back(budget);
+    }
+    const double maxMisses[] = {1, 0.1};
+    for (size_t i = 0; i < sizeof(maxMisses) / sizeof(maxMisses[0]); i++)
+    {
+        budget.Approximate = mySlimTree::tApproximate();
+        budget.Knob = "MaxMiss";
+        budget.Value = budget.Approximate.MaxMiss = maxMisses[i];
+        budget.Approximate.Distribution = &distribution;
+        budgets.push_back(budget);
+    }
+
+    myfile.open("performance/approximate_knn_slim_results.txt");
+    myfile << "knob value recall latency[µs] max_latency[µs] disk_accesses distances\n";
+    std::cout << "\nknob value recall@" << APPROXK << " latency[µs] max_latency[µs] disk_accesses distances";
+
+    for (size_t b = 0; b < budgets.size(); b++)
+    {
+        double recall = 0;
+        double latency = 0;
+        double maxLatency = 0;
+
+        PageManager->ResetStatistics();
+        SlimTree->GetMetricEvaluator()->ResetStatistics();
+        for (size_t i = 0; i < queries.size(); i++)
+        {
+            u_int32_t found = 0;
+
+            begin = std::chrono::steady_clock::now();
+            myResult *result = slimTree->NearestQuery(queries[i], APPROXK, budgets[b].Approximate);
+            end = std::chrono::steady_clock::now();
+
+            double time = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000.0;
+            latency += time;
+            maxLatency = (time > maxLatency) ? time : maxLatency;
+
+            // The objects within the exact k-th distance, so ties at this
+            // distance are not taken as misses.
+            if (exact[i]->GetNumOfEntries() > 0)
+            {
+                double kth = exact[i]->GetPair(exact[i]->GetNumOfEntries() - 1)->GetDistance();
+
+                for (u_int32_t j = 0; j < result->GetNumOfEntries(); j++)
+                {
+                    if (result->GetPair(j)->GetDistance() <= kth)
+                    {
+                        found++;
+                    }
+                }
+                if (found > exact[i]->GetNumOfEntries())
+                {
+                    found = exact[i]->GetNumOfEntries();
+                }
+                recall += (double)found / exact[i]->GetNumOfEntries();
+            }
+            else
+            {
+                recall += 1;
+            }
+            delete result;
+        }
+
+        std::cout << "\n"
+                  << budgets[b].Knob << " " << budgets[b].Value << " "
+                  << recall / queries.size() << " " << latency / queries.size() << " " << maxLatency << " "
+                  << (double)PageManager->GetReadCount() / queries.size() << " "
+                  << (double)SlimTree->GetMetricEvaluator()->GetDistanceCount() / queries.size();
+        myfile << budgets[b].Knob << " " << budgets[b].Value << " "
+               << recall / queries.size() << " " << latency / queries.size() << " " << maxLatency << " "
+               << (double)PageManager->GetReadCount() / queries.size() << " "
+               << (double)SlimTree->GetMetricEvaluator()->GetDistanceCount() / queries.size() << "\n";
+    }
+
+    for (size_t i = 0; i < queries.size(); i++)
+    {
+        delete exact[i];
+        delete queries[i];
+    }
+}
+
+//------------------------------------------------------------------------------
+void AppDeepLesion::PerformColumnScanQueries(char *fileName)
+{
+    DeepLesionBinary binary;
+    myDummyTree *dummyTree = (myDummyTree *)DummyTree;
+    DeepLesionDistanceEvaluator *evaluator = DummyTree->GetMetricEvaluator();
+    vector<DeepLesion *> queries;
+    std::ofstream myfile;
+    size_t step;
+
+    if ((DummyTree == NULL) || !OpenBinary(fileName, binary))
+    {
+        std::cout << "\nProblem to open the file.";
+        return;
+    }
+
+    // Queries spread over the whole file.
+    step = (binary.GetCount() + COLUMNQUERIES - 1) / COLUMNQUERIES;
+    for (size_t i = 0; (step > 0) && (i < binary.GetCount()); i += step)
+    {
+        DeepLesion *obj = new DeepLesion();
+        binary.Get(i, *obj);
+        queries.push_back(obj);
+    }
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    dummyTree->EnableColumnScan(1);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    std::cout << "\n\nColumns built in " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[µs]";
+
+    myfile.open("performance/column_scan_dummy_results.txt");
+    myfile << "query filter scan threads latency[µs] distances speedup different\n";
+    std::cout << "\nquery filter scan threads latency[µs] distances speedup different";
+
+    // kNN (k = 5, as PerformQueries()) and range queries, without and with
+    // the age filter.
+    for (int query = 0; query < 4; query++)
+    {
+        bool nearest = (query % 2 == 0);
+        bool filter = (query >= 2);
+        vector<myResult *> pageAnswers;
+        double pageLatency = 0;
+
+        if (filter)
+        {
+            evaluator->SetAgeRange(COLUMNMINAGE, COLUMNMAXAGE);
+        }
+        else
+        {
+            evaluator->SetAgeRange(-numeric_limits<double>::infinity(), numeric_limits<double>::infinity());
+        }
+
+        // 0: page scan, 1: column scan with 1 thread, 2: with all cores.
+        for (int scan = 0; scan < 3; scan++)
+        {
+            int different = 0;
+
+            if (scan > 0)
+            {
+                dummyTree->EnableColumnScan((scan == 1) ? 1 : 0);
+            }
+            evaluator->ResetStatistics();
+            begin = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < queries.size(); i++)
+            {
+                myResult *result;
+
+                if (scan == 0)
+                {
+                    result = (nearest) ? DummyTree->NearestQuery(queries[i], 5, false, true)
+                                       : DummyTree->RangeQuery(queries[i], 0.4);
+                    pageAnswers.push_back(result);
+                }
+                else
+                {
+                    result = (nearest) ? dummyTree->ColumnNearestQuery(queries[i], 5, false, true)
+                                       : dummyTree->ColumnRangeQuery(queries[i], 0.4);
+
+                    // The same distances, in the same order for the kNN.
+                    vector<double> page;
+                    vector<double> column;
+                    for (u_int32_t j = 0; j < pageAnswers[i]->GetNumOfEntries(); j++)
+                    {
+                        page.push_back(pageAnswers[i]->GetPair(j)->GetDistance());
+                    }
+                    for (u_int32_t j = 0; j < result->GetNumOfEntries(); j++)
+                    {
+                        column.push_back(result->GetPair(j)->GetDistance());
+                    }
+                    if (!nearest)
+                    {
+                        sort(page.begin(), page.end());
+                        sort(column.begin(), column.end());
+                    }
+                    different += (page != column);
+                    delete result;
+                }
+            }
+            end = std::chrono::steady_clock::now();
+
+            double latency = (double)std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() / queries.size();
+            if (scan == 0)
+            {
+                pageLatency = latency;
+            }
+
+            std::cout << "\n"
+                      << ((nearest) ? "knn" : "range") << " " << ((filter) ? "age" : "none") << " "
+                      << ((scan == 0) ? "page" : "column") << " " << ((scan == 2) ? dummyTree->GetColumnStore()->GetNumberOfThreads() : 1) << " "
+                      << latency << " " << (double)evaluator->GetDistanceCount() / queries.size() << " "
+                      << pageLatency / latency << " " << different;
+            myfile << ((nearest) ? "knn" : "range") << " " << ((filter) ? "age" : "none") << " "
+                   << ((scan == 0) ? "page" : "column") << " " << ((scan == 2) ? dummyTree->GetColumnStore()->GetNumberOfThreads() : 1) << " "
+                   << latency << " " << (double)evaluator->GetDistanceCount() / queries.size() << " "
+                   << pageLatency / latency << " " << different << "\n";
+        }
+
+        for (size_t i = 0; i < pageAnswers.size(); i++)
+        {
+            delete pageAnswers[i];
+        }
+    }
+    evaluator->SetAgeRange(-numeric_limits<double>::infinity(), numeric_limits<double>::infinity());
+
+    for (size_t i = 0; i < queries.size(); i++)
+    {
+        delete queries[i];
+    }
+}
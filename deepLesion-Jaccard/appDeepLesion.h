@@ -10,11 +10,15 @@
 #include <arboretum/stDiskPageManager.h>
 #include <arboretum/stMemoryPageManager.h>
 #include <arboretum/stSlimTree.h>
+#include <arboretum/stDualPageManager.h>
+#include <arboretum/stSlimPageSizeTuner.h>
 #include <arboretum/stDummyTree.h>
 #include <arboretum/stMetricTree.h>
 
 // My object
 #include "deepLesion.h"
+#include "deepLesionBinary.h"
+#include "deepLesionColumns.h"
 
 #include <string.h>
 #include <fstream>
@@ -22,6 +26,20 @@
 #define GEONAMESFILE "files/deepLesionFeatSet22K.txt"
 #define QUERYGEONAMESFILE "files/deepLesionFeatSetQuery-1.txt"
 
+// Default page size of the SlimTree.
+#define PAGESIZE 8192
+// Maximum number of objects of the sample trees built by TunePageSize().
+#define TUNESAMPLESIZE 5000
+// Queries, k and size of the distance distribution sample of
+// RunApproximate().
+#define APPROXQUERIES 200
+#define APPROXK 10
+#define APPROXSAMPLESIZE 500
+// Queries of RunColumnScan() and the patient ages of its filtered queries.
+#define COLUMNQUERIES 200
+#define COLUMNMINAGE 40
+#define COLUMNMAXAGE 60
+
 //---------------------------------------------------------------------------
 // class TApp
 //---------------------------------------------------------------------------
@@ -40,12 +58,18 @@ public:
 
    typedef stDummyTree<DeepLesion, DeepLesionDistanceEvaluator> myDummyTree;
 
+   typedef stSlimPageSizeTuner<DeepLesion, DeepLesionDistanceEvaluator> myTuner;
+
    /**
     * Creates a new instance of this class.
     */
    AppDeepLesion()
    {
       PageManager = NULL;
+      IndexPageManager = NULL;
+      LeafPageManager = NULL;
+      PageSize = PAGESIZE;
+      LeafPageSize = 0;
       SlimTree = NULL;
       DummyTree = NULL;
       PageManagerDummy = NULL;
@@ -68,6 +92,12 @@ public:
       CreateTree();
    } // end Init
 
+   /**
+    * Builds sample trees with several page sizes, including larger leaf
+    * pages, and uses the recommended one. It must be called before Init().
+    */
+   void TunePageSize();
+
    /**
     * Runs the application.
     *
@@ -76,6 +106,19 @@ public:
     */
    void Run();
 
+   /**
+    * Runs the approximate k-nearest neighbor queries of the SlimTree with
+    * several budgets and reports their recall@k against the answers of
+    * the dummy tree (a sequential scan) and their latency.
+    */
+   void RunApproximate();
+
+   /**
+    * Compares the page scan of the dummy tree with its column scan
+    * (stDummyTree::EnableColumnScan()) with 1 thread and with all cores.
+    */
+   void RunColumnScan();
+
    /**
     * Deinitialize the application.
     */
@@ -83,11 +126,20 @@ public:
 
 private:
    /**
-    * The Page Manager for SlimTree.
+    * The Page Manager for SlimTree. It is IndexPageManager or, if the
+    * leaves have their own page size, a stDualPageManager.
     */
-   stPlainDiskPageManager *PageManager;
+   stPageManager *PageManager;
+   stPlainDiskPageManager *IndexPageManager;
+   stPlainDiskPageManager *LeafPageManager;
    stPlainDiskPageManager *PageManagerDummy;
 
+   /**
+    * Page size of the SlimTree and of its leaves (0 means PageSize).
+    */
+   u_int32_t PageSize;
+   u_int32_t LeafPageSize;
+
    /**
     * The SlimTree.
     */
@@ -110,6 +162,13 @@ private:
     */
    void CreateTree();
 
+   /**
+    * Opens the binary version of a text feature file. The binary file is
+    * created by the parallel converter if it does not exist or is older than
+    * the text file.
+    */
+   bool OpenBinary(char *fileName, DeepLesionBinary &binary);
+
    /**
     * Loads the tree from file with a set of cities.
     */
@@ -146,6 +205,18 @@ private:
    void PerformRangeQueryOneCenter();
    void PerformRangeQueryOneCenterDummy();
 
+   /**
+    * Performs the approximate k-nearest neighbor queries of
+    * RunApproximate() on a sample of the objects of a file.
+    */
+   void PerformApproximateNearestQuery(char *fileName);
+
+   /**
+    * Performs the queries of RunColumnScan() on a sample of the objects of
+    * a file.
+    */
+   void PerformColumnScanQueries(char *fileName);
+
 }; // end TApp
 
 #endif // end appH
@@ -10,136 +10,136 @@
 const uint8_t *DeepLesion::Serialize()
 {
 
-   long long *d;
-
    if (Serialized == NULL)
    {
 
       Serialized = new uint8_t[GetSerializedSize()];
 
-      d = (long long *)Serialized;
-
-      d[0] = OID;
-
-      memcpy(Serialized + (sizeof(long long)), attributes.Serialize(), attributes.GetSerializedSize());
+      SerializeInto(Serialized, GetSerializedSize());
    }
 
    return Serialized;
 }
 
-const uint8_t *Attributes::Serialize()
+size_t Attributes::SerializeInto(uint8_t *dst, size_t cap)
 {
 
-   int *d;
-   uint8_t *Serialized = new uint8_t[GetSerializedSize()];
+   size_t size = GetSerializedSize();
 
-   d = (int *)Serialized;
-
-   for (size_t i = 0; i < Tags.size(); i++)
+   if (size > cap)
    {
-      d[i] = Tags[i];
+      return 0;
    }
 
-   return Serialized;
+   memcpy(dst, Tags.data(), size);
+
+   return size;
 }
 
-const uint8_t *Included::Serialize()
+size_t Included::SerializeInto(uint8_t *dst, size_t cap)
 {
 
-   uint8_t *Serialized = new uint8_t[GetSerializedSize()];
+   if (GetSerializedSize() > cap)
+   {
+      return 0;
+   }
 
-   double *d;
+   memcpy(dst, &PatientAge, sizeof(double));
 
-   d = (double *)Serialized;
+   return GetSerializedSize();
+}
 
-   d[0] = PatientAge;
+const uint8_t *DeepLesion::IncludedSerialize()
+{
 
-   return Serialized;
+   if (IncludedSerialized == NULL)
+   {
+
+      IncludedSerialized = new uint8_t[GetIncludedSerializedSize()];
+
+      IncludedSerializeInto(IncludedSerialized, GetIncludedSerializedSize());
+   }
+
+   return IncludedSerialized;
 }
 
-const uint8_t *DeepLesion::IncludedSerialize()
+size_t DeepLesion::SerializeInto(uint8_t *dst, size_t cap)
 {
 
-   long long *d;
+   size_t size = GetSerializedSize();
 
-   if (Serialized == NULL)
+   if (size > cap)
    {
+      return 0;
+   }
+
+   memcpy(dst, &OID, sizeof(long long));
 
-      Serialized = new uint8_t[GetIncludedSerializedSize()];
+   attributes.SerializeInto(dst + sizeof(long long), cap - sizeof(long long));
 
-      d = (long long *)Serialized;
+   return size;
+}
 
-      d[0] = OID;
+size_t DeepLesion::IncludedSerializeInto(uint8_t *dst, size_t cap)
+{
 
-      memcpy(Serialized + (sizeof(long long)), attributes.Serialize(), attributes.GetSerializedSize());
+   size_t size = GetIncludedSerializedSize();
 
-      memcpy(Serialized + (sizeof(long long)) + attributes.GetSerializedSize(), included.Serialize(), included.GetSerializedSize());
+   if (size > cap)
+   {
+      return 0;
    }
 
-   return Serialized;
+   SerializeInto(dst, cap);
+
+   included.SerializeInto(dst + GetSerializedSize(), cap - GetSerializedSize());
+
+   return size;
 }
 
 void DeepLesion::Unserialize(const uint8_t *data, size_t datasize)
 {
 
-   long long *d;
+   UnserializeFrom(data, datasize);
+}
+
+void DeepLesion::IncludedUnserialize(const uint8_t *data, size_t datasize)
+{
+
+   IncludedUnserializeFrom(data, datasize);
+}
 
-   d = (long long *)data;
+void DeepLesion::UnserializeFrom(const uint8_t *data, size_t datasize)
+{
 
-   OID = d[0];
+   memcpy(&OID, data, sizeof(long long));
 
    attributes.Unserialize(data + sizeof(long long), datasize - sizeof(long long));
 
-   if (Serialized != NULL)
-   {
-      delete[] Serialized;
-      Serialized = NULL;
-   }
+   ClearSerialized();
 }
 
-void DeepLesion::IncludedUnserialize(const uint8_t *data, size_t datasize)
+void DeepLesion::IncludedUnserializeFrom(const uint8_t *data, size_t datasize)
 {
-   long long *d;
-   d = (long long *)data;
 
-   OID = d[0];
+   memcpy(&OID, data, sizeof(long long));
 
    attributes.Unserialize(data + sizeof(long long), datasize - sizeof(long long) - included.GetSerializedSize());
 
    included.Unserialize(data + sizeof(long long) + attributes.GetSerializedSize(), datasize - sizeof(long long) - attributes.GetSerializedSize());
 
-   if (Serialized != NULL)
-   {
-      delete[] Serialized;
-      Serialized = NULL;
-   }
+   ClearSerialized();
 }
 
 void Attributes::Unserialize(const uint8_t *data, size_t datasize)
 {
 
-   int *d;
-
-   d = (int *)data;
-
-   Tags.clear();
-
-   int couter = datasize / sizeof(int);
-
-   for (size_t i = 0; i < couter; i++)
-   {
-
-      int tag = d[i];
-      Tags.push_back(tag);
-   }
+   // assign() reuses the capacity of Tags.
+   Tags.assign((const int *)data, (const int *)data + (datasize / sizeof(int)));
 }
 
 void Included::Unserialize(const uint8_t *data, size_t datasize)
 {
 
-   double *d;
-
-   d = (double *)data;
-
-   PatientAge = d[0];
+   memcpy(&PatientAge, data, sizeof(double));
 }
@@ -11,6 +11,7 @@
 #include <ostream>
 #include <iostream>
 #include <algorithm>
+#include <limits>
 using namespace std;
 
 #include <arboretum/stUtil.h>
@@ -45,7 +46,12 @@ public:
         return PatientAge;
     }
 
-    const uint8_t *Serialize();
+    void SetPatientAge(double patientAge)
+    {
+        PatientAge = patientAge;
+    }
+
+    size_t SerializeInto(uint8_t *dst, size_t cap);
 
     void Unserialize(const uint8_t *data, size_t datasize);
 };
@@ -63,7 +69,7 @@ public:
     {
         Tags = tags;
     };
-    const uint8_t *Serialize();
+    size_t SerializeInto(uint8_t *dst, size_t cap);
 
     void Unserialize(const uint8_t *data, size_t datasize);
 
@@ -72,6 +78,13 @@ public:
         return Tags;
     }
 
+    // Reuses the capacity of Tags, so no allocation is required once it is
+    // large enough.
+    void SetTags(const int *tags, size_t count)
+    {
+        Tags.assign(tags, tags + count);
+    }
+
     size_t GetSerializedSize()
     {
 
@@ -80,9 +93,9 @@ public:
 
     bool IsEqual(Attributes obj)
     {
-        bool result = true;
+        bool result = (Tags.size() == obj.GetTags().size());
 
-        for (size_t i = 0; i < Tags.size(); i++)
+        for (size_t i = 0; result && (i < Tags.size()); i++)
         {
 
             if (Tags[i] != obj.GetTags()[i])
@@ -103,6 +116,7 @@ public:
     {
 
         Serialized = NULL;
+        IncludedSerialized = NULL;
     }
 
     // ORDER BY LOGIC
@@ -118,6 +132,7 @@ public:
         included = inc;
 
         Serialized = NULL;
+        IncludedSerialized = NULL;
     }
 
     DeepLesion(long long oid, Attributes atr)
@@ -126,6 +141,7 @@ public:
         attributes = atr;
 
         Serialized = NULL;
+        IncludedSerialized = NULL;
     }
 
     DeepLesion(Attributes atr)
@@ -134,15 +150,38 @@ public:
         attributes = atr;
 
         Serialized = NULL;
+        IncludedSerialized = NULL;
     }
 
-    ~DeepLesion()
+    // Copies never share the serialization caches.
+    DeepLesion(const DeepLesion &obj)
     {
+        OID = obj.OID;
+        attributes = obj.attributes;
+        included = obj.included;
 
-        if (Serialized != NULL)
+        Serialized = NULL;
+        IncludedSerialized = NULL;
+    }
+
+    DeepLesion &operator=(const DeepLesion &obj)
+    {
+        if (this != &obj)
         {
-            delete[] Serialized;
+            OID = obj.OID;
+            attributes = obj.attributes;
+            included = obj.included;
+
+            ClearSerialized();
         }
+
+        return *this;
+    }
+
+    ~DeepLesion()
+    {
+
+        ClearSerialized();
     }
 
     Attributes GetAttributes()
@@ -176,6 +215,8 @@ public:
         return (sizeof(long long)) + attributes.GetSerializedSize() + included.GetSerializedSize();
     }
 
+    // Old pointer-returning API. Each form has its own cache, built with
+    // SerializeInto() and IncludedSerializeInto().
     const uint8_t *Serialize();
 
     const uint8_t *IncludedSerialize();
@@ -183,11 +224,40 @@ public:
     void Unserialize(const uint8_t *data, size_t datasize);
     void IncludedUnserialize(const uint8_t *data, size_t datasize);
 
+    // Serialize-into-buffer protocol used by the trees (see stSerializer).
+    // They write into dst and return the number of bytes written or 0 if
+    // cap is too small. The UnserializeFrom methods reuse the memory of
+    // the tags.
+    size_t SerializeInto(uint8_t *dst, size_t cap);
+
+    size_t IncludedSerializeInto(uint8_t *dst, size_t cap);
+
+    void UnserializeFrom(const uint8_t *data, size_t datasize);
+
+    void IncludedUnserializeFrom(const uint8_t *data, size_t datasize);
+
     long long getOID()
     {
         return OID;
     }
 
+    // Used by the range cursors of the Slim-tree.
+    long long GetOID()
+    {
+        return OID;
+    }
+
+    // Refills this object in place. It is used to stream records into the
+    // trees without creating a new object for each one.
+    void Set(long long oid, const int *tags, size_t count, double patientAge)
+    {
+        OID = oid;
+        attributes.SetTags(tags, count);
+        included.SetPatientAge(patientAge);
+
+        ClearSerialized();
+    }
+
 private:
     long long OID;
 
@@ -197,6 +267,22 @@ private:
 
     uint8_t *Serialized;
 
+    uint8_t *IncludedSerialized;
+
+    void ClearSerialized()
+    {
+        if (Serialized != NULL)
+        {
+            delete[] Serialized;
+            Serialized = NULL;
+        }
+        if (IncludedSerialized != NULL)
+        {
+            delete[] IncludedSerialized;
+            IncludedSerialized = NULL;
+        }
+    }
+
 }; // end TMapPoint
 
 class DeepLesionDistanceEvaluator : public DistanceFunction<DeepLesion>
@@ -204,6 +290,26 @@ class DeepLesionDistanceEvaluator : public DistanceFunction<DeepLesion>
 public:
     DeepLesionDistanceEvaluator()
     {
+        MinAge = -numeric_limits<double>::infinity();
+        MaxAge = numeric_limits<double>::infinity();
+    }
+
+    // Only the objects with the patient age in [minAge, maxAge] pass
+    // GetFilter(). All objects pass it by default.
+    void SetAgeRange(double minAge, double maxAge)
+    {
+        MinAge = minAge;
+        MaxAge = maxAge;
+    }
+
+    double GetMinAge()
+    {
+        return MinAge;
+    }
+
+    double GetMaxAge()
+    {
+        return MaxAge;
     }
 
     double GetDistance(DeepLesion &obj1, DeepLesion &obj2)
@@ -236,8 +342,10 @@ public:
 
         */
 
-        // NO FILTER APPLIED
-        return true;
+        // WHERE MinAge <= PatientAge <= MaxAge (no filter by default)
+        double age = obj1.GetIncluded().GetPatientAge();
+
+        return !((age < MinAge) || (age > MaxAge));
     }
 
     double getDistance(DeepLesion &obj1, DeepLesion &obj2)
@@ -279,6 +387,11 @@ public:
 
         return 1 - jaccard_index(tags1, tags2);
     }
+
+private:
+    double MinAge;
+
+    double MaxAge;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,284 @@
+
+#pragma hdrstop
+#include "deepLesionBinary.h"
+#pragma package(smart_init)
+#include <fstream>
+#include <thread>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//------------------------------------------------------------------------------
+// Skips the white spaces.
+static const char *SkipSpaces(const char *p, const char *end)
+{
+   while ((p < end) && ((*p == ' ') || (*p == '\t') || (*p == '\n') || (*p == '\r')))
+   {
+      p++;
+   }
+   return p;
+}
+
+//------------------------------------------------------------------------------
+// Skips count fields.
+static const char *SkipFields(const char *p, const char *end, int count)
+{
+   for (int i = 0; i < count; i++)
+   {
+      p = SkipSpaces(p, end);
+      while ((p < end) && (*p != ' ') && (*p != '\t') && (*p != '\n') && (*p != '\r'))
+      {
+         p++;
+      }
+   }
+   return p;
+}
+
+//------------------------------------------------------------------------------
+void DeepLesionBinary::Columns::Clear()
+{
+   OID.clear();
+   Age.clear();
+   Index.clear();
+   Tags.clear();
+}
+
+//------------------------------------------------------------------------------
+void DeepLesionBinary::Columns::Append(Columns &other)
+{
+   uint64_t base = Tags.size();
+
+   OID.insert(OID.end(), other.OID.begin(), other.OID.end());
+   Age.insert(Age.end(), other.Age.begin(), other.Age.end());
+   for (size_t i = 0; i < other.Index.size(); i++)
+   {
+      Index.push_back(base + other.Index[i]);
+   }
+   Tags.insert(Tags.end(), other.Tags.begin(), other.Tags.end());
+}
+
+//------------------------------------------------------------------------------
+DeepLesionBinary::DeepLesionBinary()
+{
+   Map = NULL;
+   MapSize = 0;
+   FileHeader = NULL;
+   OIDs = NULL;
+   Ages = NULL;
+   Index = NULL;
+   Tags = NULL;
+}
+
+//------------------------------------------------------------------------------
+DeepLesionBinary::~DeepLesionBinary()
+{
+   Close();
+}
+
+//------------------------------------------------------------------------------
+void DeepLesionBinary::ParseBlock(const char *begin, const char *end, Columns &columns)
+{
+   const char *p = begin;
+   char *next;
+   long long oid;
+   double age;
+   long count;
+
+   while (true)
+   {
+      p = SkipSpaces(p, end);
+      if (p >= end)
+         break;
+
+      // oid patientIndex lesionType gender age d1 d2 x y z count tags...
+      oid = strtoll(p, &next, 10);
+      if (next == p)
+         break;
+      p = SkipFields(next, end, 3);
+      age = strtod(p, &next);
+      p = SkipFields(next, end, 5);
+      count = strtol(p, &next, 10);
+      p = next;
+
+      columns.OID.push_back(oid);
+      columns.Age.push_back(age);
+      columns.Index.push_back(columns.Tags.size());
+      columns.Tags.push_back((int32_t)count);
+      for (long i = 0; i < count; i++)
+      {
+         columns.Tags.push_back((int32_t)strtol(p, &next, 10));
+         p = next;
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+bool DeepLesionBinary::ParseText(const char *textFile, Columns &columns,
+                                 unsigned int nThreads)
+{
+   vector<char> text;
+   vector<const char *> bounds;
+   vector<Columns> partial;
+   vector<std::thread> threads;
+   ifstream in(textFile, ios::binary | ios::ate);
+
+   if (!in.is_open())
+   {
+      return false;
+   }
+
+   // Load it all. The trailing 0 stops strtod() and friends.
+   text.resize((size_t)in.tellg() + 1, 0);
+   in.seekg(0);
+   in.read(text.data(), text.size() - 1);
+   in.close();
+
+   if (nThreads == 0)
+   {
+      nThreads = std::thread::hardware_concurrency();
+   }
+   if (nThreads == 0)
+   {
+      nThreads = 1;
+   }
+
+   // Split it in blocks of whole lines.
+   const char *begin = text.data();
+   const char *end = text.data() + text.size() - 1;
+   bounds.push_back(begin);
+   for (unsigned int t = 1; t < nThreads; t++)
+   {
+      const char *p = begin + (end - begin) * t / nThreads;
+      if (p < bounds.back())
+      {
+         p = bounds.back();
+      }
+      while ((p < end) && (*p != '\n'))
+      {
+         p++;
+      }
+      bounds.push_back(p);
+   }
+   bounds.push_back(end);
+
+   partial.resize(nThreads);
+   for (unsigned int t = 0; t < nThreads; t++)
+   {
+      threads.emplace_back(ParseBlock, bounds[t], bounds[t + 1], std::ref(partial[t]));
+   }
+   for (unsigned int t = 0; t < nThreads; t++)
+   {
+      threads[t].join();
+   }
+
+   columns.Clear();
+   for (unsigned int t = 0; t < nThreads; t++)
+   {
+      columns.Append(partial[t]);
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+bool DeepLesionBinary::Write(const char *binaryFile, Columns &columns)
+{
+   Header header;
+   ofstream out(binaryFile, ios::binary | ios::trunc);
+
+   if (!out.is_open())
+   {
+      return false;
+   }
+
+   memset(&header, 0, sizeof(header));
+   memcpy(header.Magic, "DLB1", 4);
+   header.Version = 1;
+   header.Count = columns.OID.size();
+   header.OIDOffset = sizeof(Header);
+   header.AgeOffset = header.OIDOffset + header.Count * sizeof(long long);
+   header.IndexOffset = header.AgeOffset + header.Count * sizeof(double);
+   header.TagOffset = header.IndexOffset + header.Count * sizeof(uint64_t);
+   header.FileSize = header.TagOffset + columns.Tags.size() * sizeof(int32_t);
+
+   out.write((const char *)&header, sizeof(header));
+   out.write((const char *)columns.OID.data(), header.Count * sizeof(long long));
+   out.write((const char *)columns.Age.data(), header.Count * sizeof(double));
+   out.write((const char *)columns.Index.data(), header.Count * sizeof(uint64_t));
+   out.write((const char *)columns.Tags.data(), columns.Tags.size() * sizeof(int32_t));
+   out.close();
+
+   return !out.fail();
+}
+
+//------------------------------------------------------------------------------
+bool DeepLesionBinary::Convert(const char *textFile, const char *binaryFile,
+                               unsigned int nThreads)
+{
+   Columns columns;
+
+   return ParseText(textFile, columns, nThreads) && Write(binaryFile, columns);
+}
+
+//------------------------------------------------------------------------------
+bool DeepLesionBinary::Open(const char *binaryFile)
+{
+   struct stat info;
+   int fd;
+
+   Close();
+
+   fd = open(binaryFile, O_RDONLY);
+   if (fd < 0)
+   {
+      return false;
+   }
+   if ((fstat(fd, &info) != 0) || ((size_t)info.st_size < sizeof(Header)))
+   {
+      close(fd);
+      return false;
+   }
+
+   MapSize = info.st_size;
+   Map = mmap(NULL, MapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (Map == MAP_FAILED)
+   {
+      Map = NULL;
+      return false;
+   }
+
+   // Validate it.
+   FileHeader = (Header *)Map;
+   if ((memcmp(FileHeader->Magic, "DLB1", 4) != 0) || (FileHeader->Version != 1) ||
+       (FileHeader->FileSize != MapSize) ||
+       (FileHeader->TagOffset != FileHeader->IndexOffset + FileHeader->Count * sizeof(uint64_t)) ||
+       (FileHeader->TagOffset > MapSize))
+   {
+      Close();
+      return false;
+   }
+
+   OIDs = (const long long *)((const char *)Map + FileHeader->OIDOffset);
+   Ages = (const double *)((const char *)Map + FileHeader->AgeOffset);
+   Index = (const uint64_t *)((const char *)Map + FileHeader->IndexOffset);
+   Tags = (const int32_t *)((const char *)Map + FileHeader->TagOffset);
+   return true;
+}
+
+//------------------------------------------------------------------------------
+void DeepLesionBinary::Close()
+{
+   if (Map != NULL)
+   {
+      munmap(Map, MapSize);
+   }
+   Map = NULL;
+   MapSize = 0;
+   FileHeader = NULL;
+   OIDs = NULL;
+   Ages = NULL;
+   Index = NULL;
+   Tags = NULL;
+}
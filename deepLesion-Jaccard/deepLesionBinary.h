@@ -0,0 +1,168 @@
+
+#ifndef deepLesionBinary
+#define deepLesionBinary
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "deepLesion.h"
+
+//---------------------------------------------------------------------------
+// class DeepLesionBinary
+//---------------------------------------------------------------------------
+/**
+ * Binary columnar format of the DeepLesion feature files.
+ *
+ * The file starts with a Header followed by the columns. The scalar columns
+ * (OID, patient age and the offset of each tag array) have fixed width and
+ * are 8-byte aligned. The tag section holds, for each record, the number of
+ * tags followed by the tags themselves (length-prefixed arrays of int32).
+ * Only the fields used by the application are stored.
+ *
+ * The file is memory mapped by Open(), so the records are read in place.
+ * Use Get() or ForEach() to refill a single DeepLesion with each record.
+ */
+class DeepLesionBinary
+{
+public:
+   /**
+    * Header of the binary file.
+    */
+   struct Header
+   {
+      char Magic[4];          // Always "DLB1".
+      uint32_t Version;
+      uint64_t Count;         // Number of records.
+      uint64_t OIDOffset;     // int64[Count]
+      uint64_t AgeOffset;     // double[Count]
+      uint64_t IndexOffset;   // uint64[Count], offset of each tag array
+      uint64_t TagOffset;     // Tag section.
+      uint64_t FileSize;
+   };
+
+   /**
+    * Records decoded from the text format, one column per field.
+    */
+   struct Columns
+   {
+      vector<long long> OID;
+      vector<double> Age;
+      vector<uint64_t> Index;     // Offset of each tag array in Tags.
+      vector<int32_t> Tags;       // Length-prefixed tag arrays.
+
+      void Clear();
+
+      void Append(Columns &other);
+   };
+
+   DeepLesionBinary();
+
+   ~DeepLesionBinary();
+
+   /**
+    * Parses a text feature file. The file is split in blocks of lines that
+    * are parsed by nThreads threads (0 means one per core).
+    *
+    * @return False if the file can not be read.
+    */
+   static bool ParseText(const char *textFile, Columns &columns,
+                         unsigned int nThreads = 0);
+
+   /**
+    * Writes the columns to a binary file.
+    *
+    * @return False if the file can not be written.
+    */
+   static bool Write(const char *binaryFile, Columns &columns);
+
+   /**
+    * Converts a text feature file into the binary format.
+    *
+    * @return False if one of the files can not be read or written.
+    */
+   static bool Convert(const char *textFile, const char *binaryFile,
+                       unsigned int nThreads = 0);
+
+   /**
+    * Opens (maps) a binary file.
+    *
+    * @return False if the file can not be opened or is not valid.
+    */
+   bool Open(const char *binaryFile);
+
+   /**
+    * Unmaps the current file, if any.
+    */
+   void Close();
+
+   size_t GetCount()
+   {
+      return (FileHeader != NULL) ? FileHeader->Count : 0;
+   }
+
+   long long GetOID(size_t i)
+   {
+      return OIDs[i];
+   }
+
+   double GetPatientAge(size_t i)
+   {
+      return Ages[i];
+   }
+
+   uint32_t GetTagCount(size_t i)
+   {
+      return (uint32_t)Tags[Index[i]];
+   }
+
+   const int *GetTags(size_t i)
+   {
+      return (const int *)(Tags + Index[i] + 1);
+   }
+
+   /**
+    * Refills obj with the record i.
+    */
+   void Get(size_t i, DeepLesion &obj)
+   {
+      obj.Set(GetOID(i), GetTags(i), GetTagCount(i), GetPatientAge(i));
+   }
+
+   /**
+    * Calls fn for every record, in file order, reusing a single object.
+    */
+   template <class Fn>
+   void ForEach(Fn fn)
+   {
+      DeepLesion obj;
+
+      for (size_t i = 0; i < GetCount(); i++)
+      {
+         Get(i, obj);
+         fn(obj);
+      }
+   }
+
+private:
+   void *Map;
+
+   size_t MapSize;
+
+   Header *FileHeader;
+
+   const long long *OIDs;
+
+   const double *Ages;
+
+   const uint64_t *Index;
+
+   const int32_t *Tags;
+
+   /**
+    * Parses the lines in [begin, end) appending them to columns.
+    */
+   static void ParseBlock(const char *begin, const char *end, Columns &columns);
+};
+
+#endif // deepLesionBinary
@@ -0,0 +1,169 @@
+
+#ifndef deepLesionColumns
+#define deepLesionColumns
+
+#include <cstdint>
+#include <vector>
+
+#include <arboretum/stDummyColumnStore.h>
+
+#include "deepLesion.h"
+
+// Number of 64-bit words of the tag bitmaps. Tags 0 to 255 fit in them.
+#define DEEPLESIONTAGWORDS 4
+
+//---------------------------------------------------------------------------
+// class stDummyColumns<DeepLesion, DeepLesionDistanceEvaluator>
+//---------------------------------------------------------------------------
+/**
+ * Columns of the DeepLesion objects for the column scan of the dummy tree
+ * (stDummyTree::EnableColumnScan()).
+ *
+ * The patient ages, the number of tags and the tags as bitmaps are kept in
+ * contiguous arrays. The age range of DeepLesionDistanceEvaluator::GetFilter()
+ * is evaluated over the ages and the Jaccard distance over the bitmaps, with
+ * the same arithmetic as DeepLesionDistanceEvaluator::GetDistance(), so the
+ * answers are the same as those of the page scan.
+ *
+ * The bitmaps hold sets of tags between 0 and 64 * DEEPLESIONTAGWORDS - 1.
+ * Objects with other tags (or with repeated or unsorted tags, which are not
+ * sets) are measured with the evaluator instead.
+ */
+template <>
+class stDummyColumns<DeepLesion, DeepLesionDistanceEvaluator>
+{
+public:
+   /**
+    * The query center and its tag bitmap.
+    */
+   class tSample
+   {
+   public:
+      tSample(DeepLesion *sample)
+      {
+         Sample = sample;
+         IsSet = ToBitmap(sample->GetAttributes().GetTags(), Bits);
+         Size = sample->GetAttributes().GetTags().size();
+      }
+
+      DeepLesion *Sample;
+      uint64_t Bits[DEEPLESIONTAGWORDS];
+      double Size;
+
+      // False if the tags do not fit in Bits.
+      bool IsSet;
+   };
+
+   void Append(DeepLesion &obj)
+   {
+      vector<int> tags = obj.GetAttributes().GetTags();
+      uint64_t bits[DEEPLESIONTAGWORDS];
+
+      Age.push_back(obj.GetIncluded().GetPatientAge());
+      Size.push_back(tags.size());
+      IsSet.push_back(ToBitmap(tags, bits) ? 1 : 0);
+      Bits.insert(Bits.end(), bits, bits + DEEPLESIONTAGWORDS);
+   }
+
+   void Clear()
+   {
+      Age.clear();
+      Size.clear();
+      IsSet.clear();
+      Bits.clear();
+   }
+
+   void Scan(const tSample &sample, DeepLesion *objects, u_int32_t first,
+             u_int32_t rows, unsigned char *mask, double *dist,
+             DeepLesionDistanceEvaluator *metricEvaluator)
+   {
+      const double *age = Age.data() + first;
+      const double *size = Size.data() + first;
+      const unsigned char *isSet = IsSet.data() + first;
+      const uint64_t *bits = Bits.data() + ((size_t)first * DEEPLESIONTAGWORDS);
+      double minAge = metricEvaluator->GetMinAge();
+      double maxAge = metricEvaluator->GetMaxAge();
+      u_int32_t count = 0;
+      u_int32_t i;
+
+      // Predicate column, as in GetFilter().
+      for (i = 0; i < rows; i++)
+      {
+         mask[i] = !((age[i] < minAge) | (age[i] > maxAge));
+      }
+
+      if (!sample.IsSet)
+      {
+         for (i = 0; i < rows; i++)
+         {
+            if (mask[i])
+            {
+               dist[i] = metricEvaluator->GetDistance(objects[i], *sample.Sample);
+            }
+         }
+         return;
+      }
+
+      // Distance column for all rows: 1 - |A & B| / (|A| + |B| - |A & B|).
+      for (i = 0; i < rows; i++)
+      {
+         const uint64_t *row = bits + (i * DEEPLESIONTAGWORDS);
+         double in = 0;
+
+         for (int w = 0; w < DEEPLESIONTAGWORDS; w++)
+         {
+            in += __builtin_popcountll(row[w] & sample.Bits[w]);
+         }
+         dist[i] = 1 - in / (size[i] + sample.Size - in);
+      }
+
+      // The rows that are not sets are measured by the evaluator.
+      for (i = 0; i < rows; i++)
+      {
+         if (mask[i])
+         {
+            if (isSet[i])
+            {
+               count++;
+            }
+            else
+            {
+               dist[i] = metricEvaluator->GetDistance(objects[i], *sample.Sample);
+            }
+         }
+      }
+      metricEvaluator->UpdateDistanceCount(count);
+   }
+
+private:
+   vector<double> Age;
+
+   // Number of tags, as double to avoid a conversion in Scan().
+   vector<double> Size;
+
+   vector<unsigned char> IsSet;
+
+   // DEEPLESIONTAGWORDS words per row.
+   vector<uint64_t> Bits;
+
+   // Returns false if tags is not a sorted set of tags that fit in bits.
+   static bool ToBitmap(const vector<int> &tags, uint64_t *bits)
+   {
+      for (int w = 0; w < DEEPLESIONTAGWORDS; w++)
+      {
+         bits[w] = 0;
+      }
+      for (size_t i = 0; i < tags.size(); i++)
+      {
+         if ((tags[i] < 0) || (tags[i] >= 64 * DEEPLESIONTAGWORDS) ||
+             ((i > 0) && (tags[i] <= tags[i - 1])))
+         {
+            return false;
+         }
+         bits[tags[i] / 64] |= (uint64_t)1 << (tags[i] % 64);
+      }
+      return true;
+   }
+}; // end stDummyColumns<DeepLesion, DeepLesionDistanceEvaluator>
+
+#endif
@@ -6,10 +6,42 @@
 int main(int argc, char *argv[])
 {
    AppDeepLesion app;
+   bool approximate = false;
+   bool columns = false;
+
+   for (int i = 1; i < argc; i++)
+   {
+      // Chooses the page size before creating the tree.
+      if (strcmp(argv[i], "--tune") == 0)
+      {
+         app.TunePageSize();
+      }
+      // Recall and latency of the approximate k-NN queries.
+      else if (strcmp(argv[i], "--approximate") == 0)
+      {
+         approximate = true;
+      }
+      // Page scan against column scan of the dummy tree.
+      else if (strcmp(argv[i], "--columns") == 0)
+      {
+         columns = true;
+      }
+   }
 
    app.Init();
 
-   app.Run();
+   if (approximate)
+   {
+      app.RunApproximate();
+   }
+   else if (columns)
+   {
+      app.RunColumnScan();
+   }
+   else
+   {
+      app.Run();
+   }
 
    app.Done();
 
@@ -0,0 +1,312 @@
+#pragma hdrstop
+#include <arboretum/stPlainDiskPageManager.h>
+#include <arboretum/stSlimTree.h>
+
+#include "deepLesion.h"
+#include "deepLesionBinary.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#define TESTFILE "files/deepLesionFeatSet22K.txt"
+// Small pages, so the tree has enough levels to be slimmed down.
+#define TESTPAGESIZE 1024
+#define TESTOBJECTS 6000
+#define TESTINSERTS 500
+#define TESTQUERIES 20
+#define TESTRANGE 0.5
+#define TESTPAGE 7
+#define TESTFORGERIES 200
+
+typedef stSlimTree<DeepLesion, DeepLesionDistanceEvaluator> mySlimTree;
+typedef pair<double, long long> myAnswer;
+
+//---------------------------------------------------------------------------
+// Returns the answers of a sequential scan in the order of a cursor.
+static vector<myAnswer> Scan(vector<DeepLesion *> &objects, DeepLesion *sample, bool backward)
+{
+   DeepLesionDistanceEvaluator evaluator;
+   vector<myAnswer> answer;
+
+   for (size_t i = 0; i < objects.size(); i++)
+   {
+      double distance = evaluator.GetDistance(*sample, *objects[i]);
+
+      if ((distance > 0) && (distance <= TESTRANGE))
+      {
+         answer.push_back(myAnswer(distance, objects[i]->getOID()));
+      }
+   }
+   sort(answer.begin(), answer.end());
+   if (backward)
+   {
+      reverse(answer.begin(), answer.end());
+   }
+   return answer;
+}
+
+//---------------------------------------------------------------------------
+// Appends the next page of a cursor to answer. Returns false after the last
+// page.
+static bool NextPage(mySlimTree *tree, DeepLesion *sample, stRangeCursor *cursor, bool backward, vector<myAnswer> &answer)
+{
+   u_int32_t count = 0;
+   mySlimTree::tVisitor visitor = [&answer, &count](const unsigned char *data, u_int32_t size, double distance)
+   {
+      DeepLesion obj;
+
+      obj.IncludedUnserialize(data, size);
+      answer.push_back(myAnswer(distance, obj.getOID()));
+      count++;
+      return count < TESTPAGE;
+   };
+
+   if (backward)
+   {
+      tree->BackwardRangeQuery(sample, cursor, visitor);
+   }
+   else
+   {
+      tree->ForwardRangeQuery(sample, cursor, visitor);
+   }
+   return !cursor->IsFinished();
+}
+
+//---------------------------------------------------------------------------
+// Restores a cursor from its serialized form.
+static void RoundTrip(stRangeCursor *cursor)
+{
+   vector<unsigned char> data(cursor->Serialize(), cursor->Serialize() + cursor->GetSerializedSize());
+   stRangeCursor restored;
+
+   restored.Unserialize(data.data(), data.size());
+   *cursor = restored;
+}
+
+//---------------------------------------------------------------------------
+// Returns the answers of a scan after the last answer of the first pages.
+static vector<myAnswer> After(vector<myAnswer> &first, vector<myAnswer> scan, bool backward)
+{
+   vector<myAnswer> answer = first;
+
+   for (size_t i = 0; i < scan.size(); i++)
+   {
+      if ((first.empty()) ||
+          ((backward) ? (scan[i] < first.back()) : (scan[i] > first.back())))
+      {
+         answer.push_back(scan[i]);
+      }
+   }
+   return answer;
+}
+
+//---------------------------------------------------------------------------
+// A cursor after two pages of a query.
+struct Token
+{
+   DeepLesion *Sample;
+   bool Backward;
+   vector<myAnswer> First;
+   vector<unsigned char> Data;
+};
+
+//---------------------------------------------------------------------------
+// Returns two pages of a query and the serialized cursor after them.
+static Token TwoPages(mySlimTree *tree, DeepLesion *sample, bool backward)
+{
+   stRangeCursor cursor(0, TESTRANGE);
+   Token token;
+
+   token.Sample = sample;
+   token.Backward = backward;
+   NextPage(tree, sample, &cursor, backward, token.First);
+   NextPage(tree, sample, &cursor, backward, token.First);
+   token.Data.assign(cursor.Serialize(), cursor.Serialize() + cursor.GetSerializedSize());
+   return token;
+}
+
+//---------------------------------------------------------------------------
+// Resumes a token until its last page.
+static vector<myAnswer> Resume(mySlimTree *tree, Token &token, const vector<unsigned char> &data)
+{
+   vector<myAnswer> answer = token.First;
+   stRangeCursor cursor;
+
+   cursor.Unserialize(data.data(), data.size());
+   while (NextPage(tree, token.Sample, &cursor, token.Backward, answer))
+   {
+   }
+   return answer;
+}
+
+//---------------------------------------------------------------------------
+// Checks the paged range queries with cursors: pages of a cursor against a
+// sequential scan, cursors restored from their serialized form, cursors
+// resumed after the tree is modified and forged cursors.
+#pragma argsused
+int main(int argc, char *argv[])
+{
+   DeepLesionBinary::Columns columns;
+   vector<DeepLesion *> objects;
+   vector<DeepLesion *> inserts;
+   vector<DeepLesion *> queries;
+   vector<Token> tokens;
+   int errors = 0;
+   int checks = 0;
+   int totalErrors = 0;
+
+   if (!DeepLesionBinary::ParseText(TESTFILE, columns) ||
+       (columns.OID.size() < TESTOBJECTS + TESTINSERTS + TESTQUERIES))
+   {
+      printf("Unable to read %s.\n", TESTFILE);
+      return 1;
+   }
+   for (size_t i = 0; i < TESTOBJECTS + TESTINSERTS + TESTQUERIES; i++)
+   {
+      DeepLesion *obj = new DeepLesion();
+
+      obj->Set(columns.OID[i], (const int *)columns.Tags.data() + columns.Index[i] + 1,
+               columns.Tags[columns.Index[i]], columns.Age[i]);
+      if (i < TESTOBJECTS)
+      {
+         objects.push_back(obj);
+      }
+      else if (i < TESTOBJECTS + TESTINSERTS)
+      {
+         inserts.push_back(obj);
+      }
+      else
+      {
+         queries.push_back(obj);
+      }
+   }
+
+   stPlainDiskPageManager pageManager("TestSlimCursor.dat", TESTPAGESIZE);
+   mySlimTree tree(&pageManager);
+
+   for (size_t i = 0; i < objects.size(); i++)
+   {
+      tree.Add(objects[i]);
+   }
+   printf("Height: %u\n", tree.GetHeight());
+
+   // Page by page, with the same cursor and with restored cursors.
+   for (size_t i = 0; i < queries.size(); i++)
+   {
+      for (int backward = 0; backward < 2; backward++)
+      {
+         vector<myAnswer> scan = Scan(objects, queries[i], backward);
+         vector<myAnswer> paged;
+         vector<myAnswer> restored;
+         stRangeCursor cursor(0, TESTRANGE);
+         stRangeCursor restoredCursor(0, TESTRANGE);
+
+         while (NextPage(&tree, queries[i], &cursor, backward, paged))
+         {
+         }
+         while (NextPage(&tree, queries[i], &restoredCursor, backward, restored))
+         {
+            RoundTrip(&restoredCursor);
+         }
+         errors += (paged != scan) + (restored != scan);
+         checks += 2;
+      }
+   }
+   printf("Paged answers different from a sequential scan: %d of %d.\n", errors, checks);
+   totalErrors += errors;
+   errors = checks = 0;
+
+   // Cursors resumed after Optimize().
+   for (size_t i = 0; i < queries.size(); i++)
+   {
+      tokens.push_back(TwoPages(&tree, queries[i], i % 2));
+   }
+   tree.Optimize();
+   for (size_t i = 0; i < tokens.size(); i++)
+   {
+      errors += Resume(&tree, tokens[i], tokens[i].Data) !=
+                After(tokens[i].First, Scan(objects, tokens[i].Sample, tokens[i].Backward), tokens[i].Backward);
+      checks++;
+   }
+
+   // Cursors resumed after new objects are inserted.
+   tokens.clear();
+   for (size_t i = 0; i < queries.size(); i++)
+   {
+      tokens.push_back(TwoPages(&tree, queries[i], i % 2));
+   }
+   for (size_t i = 0; i < inserts.size(); i++)
+   {
+      tree.Add(inserts[i]);
+      objects.push_back(inserts[i]);
+   }
+   for (size_t i = 0; i < tokens.size(); i++)
+   {
+      errors += Resume(&tree, tokens[i], tokens[i].Data) !=
+                After(tokens[i].First, Scan(objects, tokens[i].Sample, tokens[i].Backward), tokens[i].Backward);
+      checks++;
+   }
+   printf("Paged answers different from a sequential scan after modifications: %d of %d.\n", errors, checks);
+   totalErrors += errors;
+   errors = checks = 0;
+
+   // Forged cursors. The page of the next item is replaced by the header
+   // page and by a page out of the file. These must restart as keyset
+   // queries. The position of this field follows stRangeCursor::Serialize().
+   const u_int32_t header = 4 + 4 + 8 + 8 + 8 + 4 + 8 + 4 + 4;
+   const u_int32_t pageIDPos = header + 8 + 8 + 8;
+   const u_int32_t forgedIDs[] = {0, pageManager.GetPageCount() + 10, 0xffffffff};
+
+   tokens.clear();
+   for (size_t i = 0; i < queries.size(); i++)
+   {
+      tokens.push_back(TwoPages(&tree, queries[i], i % 2));
+   }
+   for (size_t i = 0; i < tokens.size(); i++)
+   {
+      vector<myAnswer> expected = After(tokens[i].First, Scan(objects, tokens[i].Sample, tokens[i].Backward), tokens[i].Backward);
+
+      for (size_t j = 0; j < sizeof(forgedIDs) / sizeof(forgedIDs[0]); j++)
+      {
+         vector<unsigned char> data = tokens[i].Data;
+
+         if (data.size() >= pageIDPos + sizeof(u_int32_t))
+         {
+            memcpy(data.data() + pageIDPos, &forgedIDs[j], sizeof(u_int32_t));
+            errors += Resume(&tree, tokens[i], data) != expected;
+            checks++;
+         }
+      }
+   }
+   printf("Answers of cursors with forged pages different from a sequential scan: %d of %d.\n", errors, checks);
+   totalErrors += errors;
+
+   // Random bytes in the items. The answers may be wrong, but the queries
+   // must end.
+   srand(1);
+   for (int i = 0; i < TESTFORGERIES; i++)
+   {
+      Token &token = tokens[i % tokens.size()];
+      vector<unsigned char> data = token.Data;
+
+      for (int j = 0; (j < 4) && (data.size() > header); j++)
+      {
+         data[header + rand() % (data.size() - header)] = rand() % 256;
+      }
+      Resume(&tree, token, data);
+   }
+   printf("Queries with random cursors: %d.\n", TESTFORGERIES);
+
+   for (size_t i = 0; i < objects.size(); i++)
+   {
+      delete objects[i];
+   }
+   for (size_t i = 0; i < queries.size(); i++)
+   {
+      delete queries[i];
+   }
+   return (totalErrors == 0) ? 0 : 1;
+}
@@ -0,0 +1,326 @@
+
+#pragma hdrstop
+#include <arboretum/stPlainDiskPageManager.h>
+#include <arboretum/stSlimTree.h>
+
+#include "deepLesion.h"
+#include "deepLesionBinary.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+#define TESTFILE "files/deepLesionFeatSet22K.txt"
+// Small pages, so the tree has enough levels to be slimmed down.
+#define TESTPAGESIZE 1024
+#define TESTOBJECTS 6000
+#define TESTQUERIES 200
+#define TESTINSERTS 500
+// Inserts between two runs of the queries.
+#define TESTBATCH 50
+#define TESTRANGE 0.4
+#define TESTK 10
+#define TESTPIVOTS 4
+
+typedef stSlimTree<DeepLesion, DeepLesionDistanceEvaluator> mySlimTree;
+typedef stResult<DeepLesion> myResult;
+
+//---------------------------------------------------------------------------
+// Returns the OIDs and the distances of a result, in the result order.
+static vector<pair<long long, double>> GetAnswer(myResult *result)
+{
+   vector<pair<long long, double>> answer;
+
+   for (u_int32_t i = 0; i < result->GetNumOfEntries(); i++)
+   {
+      answer.push_back(pair<long long, double>(
+          ((DeepLesion *)result->GetPair(i)->GetObject())->getOID(),
+          result->GetPair(i)->GetDistance()));
+   }
+   delete result;
+   return answer;
+}
+
+//---------------------------------------------------------------------------
+// Runs the range and the k-nearest neighbor queries.
+static vector<vector<pair<long long, double>>> RunQueries(mySlimTree *tree, vector<DeepLesion *> &queries)
+{
+   vector<vector<pair<long long, double>>> answers;
+
+   for (size_t i = 0; i < queries.size(); i++)
+   {
+      answers.push_back(GetAnswer(tree->RangeQuery(queries[i], TESTRANGE)));
+      answers.push_back(GetAnswer(tree->NearestQuery(queries[i], TESTK)));
+   }
+   return answers;
+}
+
+//---------------------------------------------------------------------------
+// Counts the answers that differ.
+static int Compare(vector<vector<pair<long long, double>>> &answers, vector<vector<pair<long long, double>>> &expected)
+{
+   int errors = 0;
+
+   for (size_t i = 0; i < answers.size(); i++)
+   {
+      if (answers[i] != expected[i])
+      {
+         errors++;
+      }
+   }
+   return errors;
+}
+
+//---------------------------------------------------------------------------
+// Counts the answers that differ from a sequential scan. The range answers
+// are compared by OID and the k-nearest neighbor answers by distance, as the
+// ties may be broken in any order.
+static int CompareToScan(vector<vector<pair<long long, double>>> &answers, vector<DeepLesion *> &objects, vector<DeepLesion *> &queries)
+{
+   DeepLesionDistanceEvaluator evaluator;
+   int errors = 0;
+
+   for (size_t i = 0; i < queries.size(); i++)
+   {
+      vector<long long> range, rangeScan;
+      vector<double> nearest, nearestScan;
+
+      for (size_t j = 0; j < objects.size(); j++)
+      {
+         double distance = evaluator.GetDistance(*queries[i], *objects[j]);
+
+         if (distance <= TESTRANGE)
+         {
+            rangeScan.push_back(objects[j]->getOID());
+         }
+         nearestScan.push_back(distance);
+      }
+      sort(rangeScan.begin(), rangeScan.end());
+      sort(nearestScan.begin(), nearestScan.end());
+      nearestScan.resize(min(nearestScan.size(), (size_t)TESTK));
+
+      for (size_t j = 0; j < answers[2 * i].size(); j++)
+      {
+         range.push_back(answers[2 * i][j].first);
+      }
+      sort(range.begin(), range.end());
+      for (size_t j = 0; j < answers[2 * i + 1].size(); j++)
+      {
+         nearest.push_back(answers[2 * i + 1][j].second);
+      }
+      sort(nearest.begin(), nearest.end());
+
+      if (range != rangeScan)
+      {
+         errors++;
+      }
+      if (nearest != nearestScan)
+      {
+         errors++;
+      }
+   }
+   return errors;
+}
+
+#ifdef __stSLIMRKNN__
+//---------------------------------------------------------------------------
+// Counts the reverse k-nearest neighbor answers that differ from a sequential
+// scan.
+static int CompareReverseToScan(mySlimTree *tree, vector<DeepLesion *> &objects, vector<DeepLesion *> &queries)
+{
+   DeepLesionDistanceEvaluator evaluator;
+   vector<double> kDistances;
+   int errors = 0;
+
+   for (size_t i = 0; i < objects.size(); i++)
+   {
+      vector<double> distances;
+
+      for (size_t j = 0; j < objects.size(); j++)
+      {
+         if (i != j)
+         {
+            distances.push_back(evaluator.GetDistance(*objects[i], *objects[j]));
+         }
+      }
+      nth_element(distances.begin(), distances.begin() + TESTK - 1, distances.end());
+      kDistances.push_back(distances[TESTK - 1]);
+   }
+
+   for (size_t i = 0; i < queries.size(); i++)
+   {
+      vector<pair<long long, double>> answer = GetAnswer(tree->ReverseNearestQuery(queries[i]));
+      vector<long long> reverse, reverseScan;
+
+      for (size_t j = 0; j < objects.size(); j++)
+      {
+         if (evaluator.GetDistance(*objects[j], *queries[i]) <= kDistances[j])
+         {
+            reverseScan.push_back(objects[j]->getOID());
+         }
+      }
+      for (size_t j = 0; j < answer.size(); j++)
+      {
+         reverse.push_back(answer[j].first);
+      }
+      sort(reverse.begin(), reverse.end());
+      sort(reverseScan.begin(), reverseScan.end());
+      if (reverse != reverseScan)
+      {
+         errors++;
+      }
+   }
+   return errors;
+}
+#endif //__stSLIMRKNN__
+
+//---------------------------------------------------------------------------
+// Inserts objects in batches, running the queries (with the resident levels)
+// after each batch, and counts the answers that differ from the same tree
+// without resident levels and from a sequential scan. Each new object must
+// be found right after its insertion, before any split rebuilds the
+// resident levels.
+static int CheckInserts(mySlimTree *tree, vector<DeepLesion *> &objects, vector<DeepLesion *> &inserts, vector<DeepLesion *> &queries, bool concurrent)
+{
+   int errors;
+   int scanErrors;
+   int missing = 0;
+
+   for (size_t i = 0; i < inserts.size(); i++)
+   {
+      if (concurrent)
+      {
+         tree->ConcurrentAdd(inserts[i]);
+      }
+      else
+      {
+         tree->Add(inserts[i]);
+      }
+      objects.push_back(inserts[i]);
+
+      vector<pair<long long, double>> answer = GetAnswer(tree->RangeQuery(inserts[i], 0));
+      if (find(answer.begin(), answer.end(), pair<long long, double>(inserts[i]->getOID(), 0)) == answer.end())
+      {
+         missing++;
+      }
+      if ((i + 1) % TESTBATCH == 0)
+      {
+         RunQueries(tree, queries);
+      }
+   }
+   printf("New objects not found after %s: %d of %d.\n",
+          (concurrent) ? "ConcurrentAdd()" : "Add()", missing, (int)inserts.size());
+
+   vector<vector<pair<long long, double>>> answers = RunQueries(tree, queries);
+   tree->SetResidentLevels(0, 0);
+   vector<vector<pair<long long, double>>> expected = RunQueries(tree, queries);
+   tree->SetResidentLevels(10, 0);
+   errors = Compare(answers, expected);
+   printf("Answers changed by the resident levels after %s: %d of %d.\n",
+          (concurrent) ? "ConcurrentAdd()" : "Add()", errors, (int)answers.size());
+   scanErrors = CompareToScan(expected, objects, queries);
+   printf("Answers different from a sequential scan after %s: %d of %d.\n",
+          (concurrent) ? "ConcurrentAdd()" : "Add()", scanErrors, (int)expected.size());
+   return errors + scanErrors + missing;
+}
+
+//---------------------------------------------------------------------------
+// Checks that Optimize() and the insertions keep the answers of a tree with
+// resident levels equal to the answers of the same tree without them, and
+// that both match a sequential scan.
+#pragma argsused
+int main(int argc, char *argv[])
+{
+   DeepLesionBinary::Columns columns;
+   vector<DeepLesion *> objects;
+   vector<DeepLesion *> queries;
+   vector<DeepLesion *> inserts;
+   vector<DeepLesion *> concurrentInserts;
+   int errors;
+   int scanErrors;
+   int insertErrors;
+
+   if (!DeepLesionBinary::ParseText(TESTFILE, columns) ||
+       (columns.OID.size() < TESTOBJECTS + TESTQUERIES + 2 * TESTINSERTS))
+   {
+      printf("Unable to read %s.\n", TESTFILE);
+      return 1;
+   }
+   for (size_t i = 0; i < TESTOBJECTS + TESTQUERIES + 2 * TESTINSERTS; i++)
+   {
+      DeepLesion *obj = new DeepLesion();
+
+      obj->Set(columns.OID[i], (const int *)columns.Tags.data() + columns.Index[i] + 1,
+               columns.Tags[columns.Index[i]], columns.Age[i]);
+      if (i < TESTOBJECTS)
+      {
+         objects.push_back(obj);
+      }
+      else if (i < TESTOBJECTS + TESTQUERIES)
+      {
+         queries.push_back(obj);
+      }
+      else if (i < TESTOBJECTS + TESTQUERIES + TESTINSERTS)
+      {
+         inserts.push_back(obj);
+      }
+      else
+      {
+         concurrentInserts.push_back(obj);
+      }
+   }
+
+   stPlainDiskPageManager pageManager("TestSlimOptimize.dat", TESTPAGESIZE);
+   mySlimTree tree(&pageManager);
+
+   for (size_t i = 0; i < objects.size(); i++)
+   {
+      tree.Add(objects[i]);
+   }
+#ifdef __stSLIMPIVOTS__
+   tree.SetPivots(objects.data(), objects.size(), TESTPIVOTS);
+#endif //__stSLIMPIVOTS__
+#ifdef __stSLIMRKNN__
+   tree.SetKNNDistances(TESTK);
+#endif //__stSLIMRKNN__
+   tree.SetResidentLevels(10, 0);
+   printf("Height: %u\n", tree.GetHeight());
+
+   // Build the resident levels before the Slim-Down.
+   RunQueries(&tree, queries);
+   tree.Optimize();
+
+   vector<vector<pair<long long, double>>> answers = RunQueries(&tree, queries);
+   tree.SetResidentLevels(0, 0);
+   vector<vector<pair<long long, double>>> expected = RunQueries(&tree, queries);
+   errors = Compare(answers, expected);
+   printf("Answers changed by the resident levels after Optimize(): %d of %d.\n",
+          errors, (int)answers.size());
+   scanErrors = CompareToScan(expected, objects, queries);
+   printf("Answers different from a sequential scan after Optimize(): %d of %d.\n",
+          scanErrors, (int)expected.size());
+#ifdef __stSLIMRKNN__
+   errors = CompareReverseToScan(&tree, objects, queries);
+   printf("Reverse answers different from a sequential scan after Optimize(): %d of %d.\n",
+          errors, (int)queries.size());
+   scanErrors += errors;
+#endif //__stSLIMRKNN__
+
+   // The insertions that do not split nodes update the resident levels
+   // instead of rebuilding them.
+   tree.SetResidentLevels(10, 0);
+   insertErrors = CheckInserts(&tree, objects, inserts, queries, false);
+   tree.SetConcurrent(true);
+   insertErrors += CheckInserts(&tree, objects, concurrentInserts, queries, true);
+   tree.SetConcurrent(false);
+
+   for (size_t i = 0; i < objects.size(); i++)
+   {
+      delete objects[i];
+   }
+   for (size_t i = 0; i < queries.size(); i++)
+   {
+      delete queries[i];
+   }
+   return ((errors == 0) && (scanErrors == 0) && (insertErrors == 0)) ? 0 : 1;
+}
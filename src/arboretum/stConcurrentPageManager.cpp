@@ -0,0 +1,245 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file implements the class stConcurrentPageManager.
+*
+* @version 1.0
+*/
+#include <arboretum/stConcurrentPageManager.h>
+
+#include <vector>
+
+/**
+* A latch held by a thread.
+*/
+struct stHeldLatch{
+   /**
+   * The latched page.
+   */
+   stPage * Page;
+
+   /**
+   * The latch.
+   */
+   stLatch * Latch;
+
+   /**
+   * True if the latch is held in exclusive mode.
+   */
+   bool Exclusive;
+};//end stHeldLatch
+
+/**
+* Latch mode of the current thread.
+*/
+static thread_local stConcurrentPageManager::tLatchMode ThreadLatchMode =
+      stConcurrentPageManager::lmSHARED;
+
+/**
+* Latches held by the current thread.
+*/
+static thread_local std::vector < stHeldLatch > ThreadLatches;
+
+//------------------------------------------------------------------------------
+// Class stConcurrentPageManager
+//------------------------------------------------------------------------------
+stConcurrentPageManager::stConcurrentPageManager(stPageManager * pageman){
+
+   PageManager = pageman;
+   ResetStatistics();
+}//end stConcurrentPageManager::stConcurrentPageManager
+
+//------------------------------------------------------------------------------
+stConcurrentPageManager::~stConcurrentPageManager(){
+}//end stConcurrentPageManager::~stConcurrentPageManager
+
+//------------------------------------------------------------------------------
+stConcurrentPageManager::tLatchMode stConcurrentPageManager::SetThreadLatchMode(
+      tLatchMode mode){
+   tLatchMode old = ThreadLatchMode;
+
+   ThreadLatchMode = mode;
+   return old;
+}//end stConcurrentPageManager::SetThreadLatchMode
+
+//------------------------------------------------------------------------------
+bool stConcurrentPageManager::IsEmpty(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   return PageManager->IsEmpty();
+}//end stConcurrentPageManager::IsEmpty
+
+//------------------------------------------------------------------------------
+stPage * stConcurrentPageManager::GetHeaderPage(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   UpdateReadCounter();
+   return PageManager->GetHeaderPage();
+}//end stConcurrentPageManager::GetHeaderPage
+
+//------------------------------------------------------------------------------
+stPage * stConcurrentPageManager::GetPage(u_int32_t pageid){
+   stHeldLatch held;
+
+   held.Page = NULL;
+   held.Latch = NULL;
+   held.Exclusive = (ThreadLatchMode == lmEXCLUSIVE);
+
+   // Latch it before reading, so the contents can not change while the page
+   // is in use.
+   if (ThreadLatchMode != lmNONE){
+      held.Latch = &Latches.GetLatch(pageid);
+      if (held.Exclusive){
+         held.Latch->lock();
+      }else{
+         held.Latch->lock_shared();
+      }//end if
+   }//end if
+
+   Mutex.lock();
+   UpdateReadCounter();
+   held.Page = PageManager->GetPage(pageid);
+   Mutex.unlock();
+
+   if (held.Latch != NULL){
+      if (held.Page == NULL){
+         // Invalid page.
+         if (held.Exclusive){
+            held.Latch->unlock();
+         }else{
+            held.Latch->unlock_shared();
+         }//end if
+      }else{
+         ThreadLatches.push_back(held);
+      }//end if
+   }//end if
+   return held.Page;
+}//end stConcurrentPageManager::GetPage
+
+//------------------------------------------------------------------------------
+void stConcurrentPageManager::ReleasePage(stPage * page){
+
+   Mutex.lock();
+   PageManager->ReleasePage(page);
+   Mutex.unlock();
+   Unlatch(page);
+}//end stConcurrentPageManager::ReleasePage
+
+//------------------------------------------------------------------------------
+stPage * stConcurrentPageManager::GetNewPage(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   return PageManager->GetNewPage();
+}//end stConcurrentPageManager::GetNewPage
+
+//------------------------------------------------------------------------------
+stPage * stConcurrentPageManager::GetNewLeafPage(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   return PageManager->GetNewLeafPage();
+}//end stConcurrentPageManager::GetNewLeafPage
+
+//------------------------------------------------------------------------------
+void stConcurrentPageManager::WritePage(stPage * page){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   UpdateWriteCounter();
+   PageManager->WritePage(page);
+}//end stConcurrentPageManager::WritePage
+
+//------------------------------------------------------------------------------
+void stConcurrentPageManager::WriteHeaderPage(stPage * headerpage){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   UpdateWriteCounter();
+   PageManager->WriteHeaderPage(headerpage);
+}//end stConcurrentPageManager::WriteHeaderPage
+
+//------------------------------------------------------------------------------
+void stConcurrentPageManager::DisposePage(stPage * page){
+
+   Mutex.lock();
+   PageManager->DisposePage(page);
+   Mutex.unlock();
+   Unlatch(page);
+}//end stConcurrentPageManager::DisposePage
+
+//------------------------------------------------------------------------------
+void stConcurrentPageManager::BeginUpdate(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   PageManager->BeginUpdate();
+}//end stConcurrentPageManager::BeginUpdate
+
+//------------------------------------------------------------------------------
+void stConcurrentPageManager::EndUpdate(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   PageManager->EndUpdate();
+}//end stConcurrentPageManager::EndUpdate
+
+//------------------------------------------------------------------------------
+void stConcurrentPageManager::SubmitPrefetch(const u_int32_t * pageIDs, u_int32_t count){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   PageManager->SubmitPrefetch(pageIDs, count);
+}//end stConcurrentPageManager::SubmitPrefetch
+
+//------------------------------------------------------------------------------
+void stConcurrentPageManager::ResetStatistics(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   stPageManager::ResetStatistics();
+   PageManager->ResetStatistics();
+}//end stConcurrentPageManager::ResetStatistics
+
+//------------------------------------------------------------------------------
+u_int32_t stConcurrentPageManager::GetMinimumPageSize(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   return PageManager->GetMinimumPageSize();
+}//end stConcurrentPageManager::GetMinimumPageSize
+
+//------------------------------------------------------------------------------
+u_int32_t stConcurrentPageManager::GetLeafPageSize(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   return PageManager->GetLeafPageSize();
+}//end stConcurrentPageManager::GetLeafPageSize
+
+//------------------------------------------------------------------------------
+u_int32_t stConcurrentPageManager::GetPageCount(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   return PageManager->GetPageCount();
+}//end stConcurrentPageManager::GetPageCount
+
+//------------------------------------------------------------------------------
+void stConcurrentPageManager::Unlatch(stPage * page){
+   int i;
+
+   // The most recent latches are at the end.
+   for (i = (int)ThreadLatches.size() - 1; i >= 0; i--){
+      if (ThreadLatches[i].Page == page){
+         if (ThreadLatches[i].Exclusive){
+            ThreadLatches[i].Latch->unlock();
+         }else{
+            ThreadLatches[i].Latch->unlock_shared();
+         }//end if
+         ThreadLatches.erase(ThreadLatches.begin() + i);
+         return;
+      }//end if
+   }//end for
+}//end stConcurrentPageManager::Unlatch
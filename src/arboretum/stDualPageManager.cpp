@@ -0,0 +1,190 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file implements the class stDualPageManager.
+*
+* @version 1.0
+*/
+#include <arboretum/stDualPageManager.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Class stDualPageManager
+//------------------------------------------------------------------------------
+stDualPageManager::stDualPageManager(stPageManager * indexPages,
+      stPageManager * leafPages){
+
+   IndexPages = indexPages;
+   LeafPages = leafPages;
+   ResetStatistics();
+}//end stDualPageManager::stDualPageManager
+
+//------------------------------------------------------------------------------
+stDualPageManager::~stDualPageManager(){
+}//end stDualPageManager::~stDualPageManager
+
+//------------------------------------------------------------------------------
+bool stDualPageManager::IsEmpty(){
+
+   return IndexPages->IsEmpty() && LeafPages->IsEmpty();
+}//end stDualPageManager::IsEmpty
+
+//------------------------------------------------------------------------------
+stPage * stDualPageManager::GetHeaderPage(){
+
+   UpdateReadCounter();
+   return IndexPages->GetHeaderPage();
+}//end stDualPageManager::GetHeaderPage
+
+//------------------------------------------------------------------------------
+stPage * stDualPageManager::GetPage(u_int32_t pageid){
+   stPage * page;
+
+   UpdateReadCounter();
+   if (IsLeafPage(pageid)){
+      page = LeafPages->GetPage(pageid & ~STLEAFPAGEBIT);
+      if (page != NULL){
+         page->SetPageID(pageid);
+      }//end if
+      return page;
+   }else{
+      return IndexPages->GetPage(pageid);
+   }//end if
+}//end stDualPageManager::GetPage
+
+//------------------------------------------------------------------------------
+void stDualPageManager::ReleasePage(stPage * page){
+
+   if (IsLeafPage(page->GetPageID())){
+      LeafPages->ReleasePage(page);
+   }else{
+      IndexPages->ReleasePage(page);
+   }//end if
+}//end stDualPageManager::ReleasePage
+
+//------------------------------------------------------------------------------
+stPage * stDualPageManager::GetNewPage(){
+
+   return IndexPages->GetNewPage();
+}//end stDualPageManager::GetNewPage
+
+//------------------------------------------------------------------------------
+stPage * stDualPageManager::GetNewLeafPage(){
+   stPage * page;
+
+   page = LeafPages->GetNewPage();
+   if (page != NULL){
+      page->SetPageID(page->GetPageID() | STLEAFPAGEBIT);
+   }//end if
+   return page;
+}//end stDualPageManager::GetNewLeafPage
+
+//------------------------------------------------------------------------------
+void stDualPageManager::WritePage(stPage * page){
+   u_int32_t pageid = page->GetPageID();
+
+   UpdateWriteCounter();
+   if (IsLeafPage(pageid)){
+      // The leaf page manager knows it by its own ID.
+      page->SetPageID(pageid & ~STLEAFPAGEBIT);
+      LeafPages->WritePage(page);
+      page->SetPageID(pageid);
+   }else{
+      IndexPages->WritePage(page);
+   }//end if
+}//end stDualPageManager::WritePage
+
+//------------------------------------------------------------------------------
+void stDualPageManager::WriteHeaderPage(stPage * headerpage){
+
+   UpdateWriteCounter();
+   IndexPages->WriteHeaderPage(headerpage);
+}//end stDualPageManager::WriteHeaderPage
+
+//------------------------------------------------------------------------------
+void stDualPageManager::DisposePage(stPage * page){
+
+   if (IsLeafPage(page->GetPageID())){
+      page->SetPageID(page->GetPageID() & ~STLEAFPAGEBIT);
+      LeafPages->DisposePage(page);
+   }else{
+      IndexPages->DisposePage(page);
+   }//end if
+}//end stDualPageManager::DisposePage
+
+//------------------------------------------------------------------------------
+void stDualPageManager::BeginUpdate(){
+
+   IndexPages->BeginUpdate();
+   LeafPages->BeginUpdate();
+}//end stDualPageManager::BeginUpdate
+
+//------------------------------------------------------------------------------
+void stDualPageManager::EndUpdate(){
+
+   LeafPages->EndUpdate();
+   IndexPages->EndUpdate();
+}//end stDualPageManager::EndUpdate
+
+//------------------------------------------------------------------------------
+void stDualPageManager::SubmitPrefetch(const u_int32_t * pageIDs,
+      u_int32_t count){
+   std::vector < u_int32_t > indexIDs;
+   std::vector < u_int32_t > leafIDs;
+   u_int32_t i;
+
+   for (i = 0; i < count; i++){
+      if (IsLeafPage(pageIDs[i])){
+         leafIDs.push_back(pageIDs[i] & ~STLEAFPAGEBIT);
+      }else{
+         indexIDs.push_back(pageIDs[i]);
+      }//end if
+   }//end for
+   if (!indexIDs.empty()){
+      IndexPages->SubmitPrefetch(indexIDs.data(), indexIDs.size());
+   }//end if
+   if (!leafIDs.empty()){
+      LeafPages->SubmitPrefetch(leafIDs.data(), leafIDs.size());
+   }//end if
+}//end stDualPageManager::SubmitPrefetch
+
+//------------------------------------------------------------------------------
+void stDualPageManager::ResetStatistics(){
+
+   stPageManager::ResetStatistics();
+   IndexPages->ResetStatistics();
+   LeafPages->ResetStatistics();
+}//end stDualPageManager::ResetStatistics
+
+//------------------------------------------------------------------------------
+u_int32_t stDualPageManager::GetMinimumPageSize(){
+   u_int32_t indexSize = IndexPages->GetMinimumPageSize();
+   u_int32_t leafSize = LeafPages->GetMinimumPageSize();
+
+   return (indexSize < leafSize) ? indexSize : leafSize;
+}//end stDualPageManager::GetMinimumPageSize
+
+//------------------------------------------------------------------------------
+u_int32_t stDualPageManager::GetLeafPageSize(){
+
+   return LeafPages->GetMinimumPageSize();
+}//end stDualPageManager::GetLeafPageSize
+
+//------------------------------------------------------------------------------
+u_int32_t stDualPageManager::GetPageCount(){
+
+   return IndexPages->GetPageCount() + LeafPages->GetPageCount();
+}//end stDualPageManager::GetPageCount
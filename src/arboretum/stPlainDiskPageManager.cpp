@@ -22,6 +22,8 @@
 */
 #include <arboretum/stPlainDiskPageManager.h>
 
+#include <string.h>
+
 /**
 * Number of instances in the page cache.
 */
@@ -37,6 +39,9 @@ stPlainDiskPageManager::stPlainDiskPageManager(const char * fName, u_int32_t pag
    if (fd < 0){
       throw std::logic_error("Unable to create file.");
    }//end if
+   // The log of a previous file with the same name is not valid anymore.
+   InitLog(fName);
+   unlink(logName.c_str());
 
    // Initialize fields.
    this->headerPage = new stLockablePage(pagesize, sizeof(tHeader), 0);
@@ -58,8 +63,13 @@ stPlainDiskPageManager::stPlainDiskPageManager(const char * fName){
    if (fd < 0){
       throw std::logic_error("Unable to open file.");
    }//end if
-   
+
+   // Replay the log left by a crash.
+   InitLog(fName);
+   Recover();
+
    // Validate file
+   lseek(fd, 0, SEEK_SET);
    if ((read(fd, &tmpHeader, sizeof(tmpHeader)) != sizeof(tmpHeader)) ||
          (!IsValidHeader(&tmpHeader))){
       throw std::logic_error("invalid file.");
@@ -88,7 +98,9 @@ stPlainDiskPageManager::stPlainDiskPageManager(const char * fName){
 
 //------------------------------------------------------------------------------
 stPlainDiskPageManager::~stPlainDiskPageManager(){
-   
+
+   // Apply the log before closing.
+   DisableLog();
    // Free resources
    delete pageInstanceCache;
    // Save header page info.
@@ -111,9 +123,12 @@ stPage * stPlainDiskPageManager::GetHeaderPage(){
    // Update read count
    UpdateReadCounter();
    
-   // Effective read
-   lseek(fd, 0, SEEK_SET);  
-   read(fd, (void *)this->headerPage->GetTrueData(), header->PageSize);
+   // Effective read. The file may hold an older header while the log is
+   // enabled.
+   if (!IsLogEnabled()){
+      lseek(fd, 0, SEEK_SET);
+      read(fd, (void *)this->headerPage->GetTrueData(), header->PageSize);
+   }//end if
     
    return this->headerPage;
 }//end stPlainDiskPageManager::GetheaderPage
@@ -121,6 +136,7 @@ stPage * stPlainDiskPageManager::GetHeaderPage(){
 //------------------------------------------------------------------------------
 stPage * stPlainDiskPageManager::GetPage(u_int32_t pageid){
    stPage * myPage;
+   tDirtyPages::iterator dirty;
 
    // Do not allow users to load header page from this file.
    if ((pageid != 0) && (pageid <= header->PageCount)){
@@ -129,8 +145,14 @@ stPage * stPlainDiskPageManager::GetPage(u_int32_t pageid){
       myPage = pageInstanceCache->Get();
       
       // Read data...
-      lseek(fd, PageID2Offset(pageid), SEEK_SET);
-      read(fd, myPage->GetData(), header->PageSize);
+      dirty = dirtyPages.find(pageid);
+      if (dirty != dirtyPages.end()){
+         // The file has an older image.
+         memcpy(myPage->GetData(), dirty->second, header->PageSize);
+      }else{
+         lseek(fd, PageID2Offset(pageid), SEEK_SET);
+         read(fd, myPage->GetData(), header->PageSize);
+      }//end if
       myPage->SetPageID(pageid);
    
       // Update Counters
@@ -164,6 +186,7 @@ stPage * stPlainDiskPageManager::GetNewPage(){
    u_int32_t * next;
    stPage * page;
    
+   BeginUpdate();
    if (header->Available == 0){
       // Get instance from cache
       page = pageInstanceCache->Get();
@@ -181,6 +204,7 @@ stPage * stPlainDiskPageManager::GetNewPage(){
    // Update header
    header->UsedPages++;
    WriteHeaderPage(headerPage);
+   EndUpdate();
    
    return page;   
 }//end stPlainDiskPageManager::GetNewPage
@@ -193,9 +217,23 @@ void stPlainDiskPageManager::WritePage(stPage * page){
       throw invalid_argument("Do not use WritePage to write header pages.");
    }//end if
    #endif //__stDEBUG__
+   unsigned char * image;
 
-   lseek(fd, PageID2Offset(page->GetPageID()), SEEK_SET);
-   write(fd, page->GetData(), header->PageSize);      
+   if (IsLogEnabled()){
+      // Keep it until the update is applied.
+      BeginUpdate();
+      image = dirtyPages[page->GetPageID()];
+      if (image == NULL){
+         image = new unsigned char[header->PageSize];
+         dirtyPages[page->GetPageID()] = image;
+      }//end if
+      memcpy(image, page->GetData(), header->PageSize);
+      updatePages.insert(page->GetPageID());
+      EndUpdate();
+   }else{
+      lseek(fd, PageID2Offset(page->GetPageID()), SEEK_SET);
+      write(fd, page->GetData(), header->PageSize);
+   }//end if
    UpdateWriteCounter();
 }//end stPlainDiskPageManager::WritePage
 
@@ -208,8 +246,14 @@ void stPlainDiskPageManager::WriteHeaderPage(stPage * headerpage){
    }//end if
    #endif //__stDEBUG__
    
-   lseek(fd, 0, SEEK_SET);
-   write(fd, this->headerPage->GetTrueData(), header->PageSize);
+   if (IsLogEnabled()){
+      // The header page is logged by every update.
+      BeginUpdate();
+      EndUpdate();
+   }else{
+      lseek(fd, 0, SEEK_SET);
+      write(fd, this->headerPage->GetTrueData(), header->PageSize);
+   }//end if
    UpdateWriteCounter();
 }//end stPlainDiskPageManager::WriteHeaderPage
 
@@ -217,6 +261,7 @@ void stPlainDiskPageManager::WriteHeaderPage(stPage * headerpage){
 void stPlainDiskPageManager::DisposePage(stPage * page){
    u_int32_t * next;
    
+   BeginUpdate();
    // Append to free list
    next = (u_int32_t *)page->GetData();
    *next = header->Available;
@@ -226,6 +271,7 @@ void stPlainDiskPageManager::DisposePage(stPage * page){
    // Update header   
    header->UsedPages--;
    WriteHeaderPage(headerPage);
+   EndUpdate();
    
    // Free resources
    ReleasePage(page);
@@ -258,3 +304,273 @@ bool stPlainDiskPageManager::IsValidHeader(tHeader * header){
          (header->Magic[3] == '1'); 
 }//end stPlainDiskPageManager::IsValidHeader
 //------------------------------------------------------------------------------
+void stPlainDiskPageManager::EnableLog(u_int32_t groupCommit,
+      u_int32_t checkpointSize){
+
+   if (!IsLogEnabled()){
+      logfd = open(logName.c_str(), O_CREAT|O_TRUNC|O_WRONLY|O_APPEND|O_BINARY,
+            S_IREAD|S_IWRITE);
+      if (logfd < 0){
+         throw std::logic_error("Unable to create the log file.");
+      }//end if
+      logSize = 0;
+   }//end if
+   this->groupCommit = (groupCommit == 0) ? 1 : groupCommit;
+   this->checkpointSize = checkpointSize;
+}//end stPlainDiskPageManager::EnableLog
+
+//------------------------------------------------------------------------------
+void stPlainDiskPageManager::DisableLog(){
+
+   if (IsLogEnabled() && (updateDepth == 0)){
+      Checkpoint();
+      close(logfd);
+      logfd = -1;
+      unlink(logName.c_str());
+   }//end if
+}//end stPlainDiskPageManager::DisableLog
+
+//------------------------------------------------------------------------------
+void stPlainDiskPageManager::Flush(){
+   tDirtyPages::iterator i;
+
+   if ((!IsLogEnabled()) || (updateDepth != 0) || (pendingUpdates == 0)){
+      return;
+   }//end if
+
+   // The log must reach the disk before the data file is changed.
+   fdatasync(logfd);
+
+   // Apply the pages.
+   for (i = dirtyPages.begin(); i != dirtyPages.end(); i++){
+      WriteAt(fd, PageID2Offset(i->first), i->second, header->PageSize);
+      delete[] i->second;
+   }//end for
+   dirtyPages.clear();
+   WriteAt(fd, 0, this->headerPage->GetTrueData(), header->PageSize);
+   pendingUpdates = 0;
+
+   if (logSize >= checkpointSize){
+      Checkpoint();
+   }//end if
+}//end stPlainDiskPageManager::Flush
+
+//------------------------------------------------------------------------------
+void stPlainDiskPageManager::Checkpoint(){
+
+   if ((!IsLogEnabled()) || (updateDepth != 0)){
+      return;
+   }//end if
+
+   Flush();
+   // Now the log is useless.
+   fdatasync(fd);
+   ftruncate(logfd, 0);
+   logSize = 0;
+}//end stPlainDiskPageManager::Checkpoint
+
+//------------------------------------------------------------------------------
+void stPlainDiskPageManager::BeginUpdate(){
+
+   if (IsLogEnabled()){
+      updateDepth++;
+   }//end if
+}//end stPlainDiskPageManager::BeginUpdate
+
+//------------------------------------------------------------------------------
+void stPlainDiskPageManager::EndUpdate(){
+
+   if (IsLogEnabled() && (updateDepth > 0)){
+      updateDepth--;
+      if (updateDepth == 0){
+         CommitUpdate();
+         if (pendingUpdates >= groupCommit){
+            Flush();
+         }//end if
+      }//end if
+   }//end if
+}//end stPlainDiskPageManager::EndUpdate
+
+//------------------------------------------------------------------------------
+void stPlainDiskPageManager::InitLog(const char * fName){
+
+   logName = fName;
+   logName += ".wal";
+   logfd = -1;
+   logSize = 0;
+   groupCommit = STWALGROUPCOMMIT;
+   checkpointSize = STWALCHECKPOINTSIZE;
+   updateDepth = 0;
+   pendingUpdates = 0;
+   recoveredUpdates = 0;
+}//end stPlainDiskPageManager::InitLog
+
+//------------------------------------------------------------------------------
+void stPlainDiskPageManager::Recover(){
+   std::vector < unsigned char > log;
+   std::vector < tLogRecord * > pages;
+   std::vector < unsigned char > image;
+   tLogRecord * record;
+   u_int32_t begin;
+   u_int32_t pos;
+   u_int32_t i;
+   int logFile;
+   int r;
+
+   // Is there a log?
+   logFile = open(logName.c_str(), O_RDWR|O_BINARY);
+   if (logFile < 0){
+      return;
+   }//end if
+
+   // Load it.
+   log.resize(lseek(logFile, 0, SEEK_END));
+   lseek(logFile, 0, SEEK_SET);
+   pos = 0;
+   while (pos < log.size()){
+      r = read(logFile, log.data() + pos, log.size() - pos);
+      if (r <= 0){
+         log.resize(pos);
+      }else{
+         pos += r;
+      }//end if
+   }//end while
+
+   // Replay the committed updates. The first invalid record ends the log.
+   begin = 0;
+   pos = 0;
+   while (pos + sizeof(tLogRecord) <= log.size()){
+      record = (tLogRecord *)(log.data() + pos);
+      if ((record->Type == lrPAGE) &&
+            (pos + sizeof(tLogRecord) + record->Size <= log.size()) &&
+            (Checksum(log.data() + pos + sizeof(tLogRecord), record->Size) ==
+            record->Checksum)){
+         pages.push_back(record);
+         pos += sizeof(tLogRecord) + record->Size;
+      }else if ((record->Type == lrCOMMIT) &&
+            (record->PageID == pages.size()) &&
+            (Checksum(log.data() + begin, pos - begin) == record->Checksum)){
+         // The update is complete.
+         for (i = 0; i < pages.size(); i++){
+            if (pages[i]->PageID == 0){
+               // Restore the unused tail of the header page.
+               image.assign(((tHeader *)(pages[i] + 1))->PageSize, 0);
+               memcpy(image.data(), pages[i] + 1, pages[i]->Size);
+               WriteAt(fd, 0, image.data(), image.size());
+            }else{
+               WriteAt(fd, (off_t)pages[i]->PageID * pages[i]->Size,
+                     pages[i] + 1, pages[i]->Size);
+            }//end if
+         }//end for
+         recoveredUpdates++;
+         pages.clear();
+         pos += sizeof(tLogRecord);
+         begin = pos;
+      }else{
+         // Torn or incomplete update. Ignore the rest.
+         break;
+      }//end if
+   }//end while
+
+   // The data file is up to date. Now the log is useless.
+   fdatasync(fd);
+   ftruncate(logFile, 0);
+   close(logFile);
+}//end stPlainDiskPageManager::Recover
+
+//------------------------------------------------------------------------------
+void stPlainDiskPageManager::CommitUpdate(){
+   std::vector < unsigned char > buffer;
+   std::set < u_int32_t >::iterator i;
+   tLogRecord record;
+   u_int32_t size;
+
+   // Page images.
+   for (i = updatePages.begin(); i != updatePages.end(); i++){
+      record.Type = lrPAGE;
+      record.PageID = *i;
+      record.Size = header->PageSize;
+      record.Checksum = Checksum(dirtyPages[*i], header->PageSize);
+      buffer.insert(buffer.end(), (unsigned char *)&record,
+            (unsigned char *)(&record + 1));
+      buffer.insert(buffer.end(), dirtyPages[*i],
+            dirtyPages[*i] + header->PageSize);
+   }//end for
+
+   // The header page holds the header of the tree, so it goes with every
+   // update.
+   size = GetHeaderLogSize();
+   record.Type = lrPAGE;
+   record.PageID = 0;
+   record.Size = size;
+   record.Checksum = Checksum(this->headerPage->GetTrueData(), size);
+   buffer.insert(buffer.end(), (unsigned char *)&record,
+         (unsigned char *)(&record + 1));
+   buffer.insert(buffer.end(), this->headerPage->GetTrueData(),
+         this->headerPage->GetTrueData() + size);
+
+   // Commit.
+   record.Type = lrCOMMIT;
+   record.PageID = updatePages.size() + 1;
+   record.Size = 0;
+   record.Checksum = Checksum(buffer.data(), buffer.size());
+   buffer.insert(buffer.end(), (unsigned char *)&record,
+         (unsigned char *)(&record + 1));
+
+   // A single write for the whole update.
+   write(logfd, buffer.data(), buffer.size());
+   logSize += buffer.size();
+   updatePages.clear();
+   pendingUpdates++;
+}//end stPlainDiskPageManager::CommitUpdate
+
+//------------------------------------------------------------------------------
+u_int32_t stPlainDiskPageManager::GetHeaderLogSize(){
+   const unsigned char * data = this->headerPage->GetTrueData();
+   u_int32_t size = header->PageSize;
+
+   while ((size > sizeof(tHeader)) && (data[size - 1] == 0)){
+      size--;
+   }//end while
+
+   return size;
+}//end stPlainDiskPageManager::GetHeaderLogSize
+
+//------------------------------------------------------------------------------
+void stPlainDiskPageManager::WriteAt(int fileDesc, off_t offset,
+      const void * data, u_int32_t size){
+
+   lseek(fileDesc, offset, SEEK_SET);
+   write(fileDesc, data, size);
+}//end stPlainDiskPageManager::WriteAt
+
+//------------------------------------------------------------------------------
+u_int32_t stPlainDiskPageManager::Checksum(const unsigned char * data,
+      u_int32_t size){
+   u_int32_t hash = 2166136261u;
+   u_int32_t i;
+
+   // FNV-1a
+   for (i = 0; i < size; i++){
+      hash = (hash ^ data[i]) * 16777619u;
+   }//end for
+
+   return hash;
+}//end stPlainDiskPageManager::Checksum
+//------------------------------------------------------------------------------
+void stPlainDiskPageManager::SubmitPrefetch(const u_int32_t * pageIDs,
+      u_int32_t count){
+   u_int32_t i;
+
+   for (i = 0; i < count; i++){
+      // Only pages in the data file. The log has the newer images.
+      if ((pageIDs[i] == 0) || (pageIDs[i] > header->PageCount) ||
+            (dirtyPages.find(pageIDs[i]) != dirtyPages.end())){
+         continue;
+      }//end if
+      #ifdef POSIX_FADV_WILLNEED
+         posix_fadvise(fd, PageID2Offset(pageIDs[i]), header->PageSize,
+               POSIX_FADV_WILLNEED);
+      #endif //POSIX_FADV_WILLNEED
+   }//end for
+}//end stPlainDiskPageManager::SubmitPrefetch
@@ -0,0 +1,163 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file implements the class stQueryStats.
+*
+* @version 1.0
+*/
+#include <arboretum/stQueryStats.h>
+
+//------------------------------------------------------------------------------
+// Class stQueryStats
+//------------------------------------------------------------------------------
+stQueryStats::stQueryStats(){
+
+   Reset();
+}//end stQueryStats::stQueryStats
+
+//------------------------------------------------------------------------------
+void stQueryStats::Reset(){
+   u_int32_t i;
+
+   NodesPerLevel.clear();
+   PrunedByParent = 0;
+   PrunedByPivots = 0;
+   PrunedByDistance = 0;
+   DistanceCalls = 0;
+   FilterCalls = 0;
+   FilterRejections = 0;
+   QueuePeak = 0;
+   BytesDecoded = 0;
+   for (i = 0; i < phCOUNT; i++){
+      PhaseTime[i] = 0;
+   }//end for
+   QueryCount = 0;
+}//end stQueryStats::Reset
+
+//------------------------------------------------------------------------------
+u_int64_t stQueryStats::GetNodes(){
+   u_int64_t nodes = 0;
+   u_int32_t i;
+
+   for (i = 0; i < NodesPerLevel.size(); i++){
+      nodes += NodesPerLevel[i];
+   }//end for
+   return nodes;
+}//end stQueryStats::GetNodes
+
+//------------------------------------------------------------------------------
+void stQueryStats::Merge(stQueryStats & stats){
+   std::lock_guard < std::mutex > lock(Mutex);
+   u_int32_t i;
+
+   if (stats.NodesPerLevel.size() > NodesPerLevel.size()){
+      NodesPerLevel.resize(stats.NodesPerLevel.size(), 0);
+   }//end if
+   for (i = 0; i < stats.NodesPerLevel.size(); i++){
+      NodesPerLevel[i] += stats.NodesPerLevel[i];
+   }//end for
+   PrunedByParent += stats.PrunedByParent;
+   PrunedByPivots += stats.PrunedByPivots;
+   PrunedByDistance += stats.PrunedByDistance;
+   DistanceCalls += stats.DistanceCalls;
+   FilterCalls += stats.FilterCalls;
+   FilterRejections += stats.FilterRejections;
+   if (stats.QueuePeak > QueuePeak){
+      QueuePeak = stats.QueuePeak;
+   }//end if
+   BytesDecoded += stats.BytesDecoded;
+   for (i = 0; i < phCOUNT; i++){
+      PhaseTime[i] += stats.PhaseTime[i];
+   }//end for
+   QueryCount += stats.QueryCount;
+}//end stQueryStats::Merge
+
+//------------------------------------------------------------------------------
+void stQueryStats::WriteJSON(std::ostream & out){
+   std::lock_guard < std::mutex > lock(Mutex);
+   u_int32_t i;
+
+   out << "{\"queries\":" << QueryCount << ",\"nodesPerLevel\":[";
+   for (i = 0; i < NodesPerLevel.size(); i++){
+      if (i > 0){
+         out << ",";
+      }//end if
+      out << NodesPerLevel[i];
+   }//end for
+   out << "],\"prunedByParent\":" << PrunedByParent <<
+         ",\"prunedByPivots\":" << PrunedByPivots <<
+         ",\"prunedByDistance\":" << PrunedByDistance <<
+         ",\"distanceCalls\":" << DistanceCalls <<
+         ",\"filterCalls\":" << FilterCalls <<
+         ",\"filterRejections\":" << FilterRejections <<
+         ",\"queuePeak\":" << QueuePeak <<
+         ",\"bytesDecoded\":" << BytesDecoded << ",\"phaseTimeNs\":{";
+   for (i = 0; i < phCOUNT; i++){
+      if (i > 0){
+         out << ",";
+      }//end if
+      out << "\"" << GetPhaseName(i) << "\":" << PhaseTime[i];
+   }//end for
+   out << "}}";
+}//end stQueryStats::WriteJSON
+
+//------------------------------------------------------------------------------
+void stQueryStats::WriteCSVHeader(std::ostream & out, u_int32_t levels){
+   u_int32_t i;
+
+   out << "queries";
+   for (i = 0; i < levels; i++){
+      out << ",nodesLevel" << i;
+   }//end for
+   out << ",prunedByParent,prunedByPivots,prunedByDistance,distanceCalls"
+         ",filterCalls,filterRejections,queuePeak,bytesDecoded";
+   for (i = 0; i < phCOUNT; i++){
+      out << "," << GetPhaseName(i) << "TimeNs";
+   }//end for
+   out << "\n";
+}//end stQueryStats::WriteCSVHeader
+
+//------------------------------------------------------------------------------
+void stQueryStats::WriteCSV(std::ostream & out, u_int32_t levels){
+   std::lock_guard < std::mutex > lock(Mutex);
+   u_int32_t i;
+
+   out << QueryCount;
+   for (i = 0; i < levels; i++){
+      out << "," << ((i < NodesPerLevel.size()) ? NodesPerLevel[i] : 0);
+   }//end for
+   out << "," << PrunedByParent << "," << PrunedByPivots << "," <<
+         PrunedByDistance << "," << DistanceCalls << "," << FilterCalls <<
+         "," << FilterRejections << "," << QueuePeak << "," << BytesDecoded;
+   for (i = 0; i < phCOUNT; i++){
+      out << "," << PhaseTime[i];
+   }//end for
+   out << "\n";
+}//end stQueryStats::WriteCSV
+
+//------------------------------------------------------------------------------
+const char * stQueryStats::GetPhaseName(u_int32_t phase){
+
+   switch (phase){
+      case phREAD:
+         return "read";
+      case phINDEX:
+         return "index";
+      case phLEAF:
+         return "leaf";
+      default:
+         return "total";
+   }//end switch
+}//end stQueryStats::GetPhaseName
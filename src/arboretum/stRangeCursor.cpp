@@ -0,0 +1,219 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file implements the class stRangeCursor.
+*
+* @version 1.0
+*/
+#include <arboretum/stRangeCursor.h>
+
+#include <algorithm>
+#include <string.h>
+
+// Version of the serialized cursor.
+#define STRANGECURSORVERSION 2
+
+//------------------------------------------------------------------------------
+// Class stRangeCursor
+//------------------------------------------------------------------------------
+stRangeCursor::stRangeCursor(double internalRadius, double externalRadius,
+      long oid){
+
+   InternalRadius = internalRadius;
+   ExternalRadius = externalRadius;
+   OID = oid;
+   Backward = false;
+   Started = false;
+   Root = 0;
+   NumberOfObjects = 0;
+   Modification = 0;
+}//end stRangeCursor::stRangeCursor
+
+//------------------------------------------------------------------------------
+void stRangeCursor::Start(bool backward, u_int32_t root, long numberOfObjects,
+      u_int32_t modification){
+
+   Queue.clear();
+   Backward = backward;
+   Started = true;
+   Root = root;
+   NumberOfObjects = numberOfObjects;
+   Modification = modification;
+}//end stRangeCursor::Start
+
+//------------------------------------------------------------------------------
+bool stRangeCursor::Before(const tItem & a, const tItem & b){
+
+   if (a.Key != b.Key){
+      return Backward ? (a.Key > b.Key) : (a.Key < b.Key);
+   }else if (a.Object != b.Object){
+      return !a.Object;
+   }else{
+      return Backward ? (a.OID > b.OID) : (a.OID < b.OID);
+   }//end if
+}//end stRangeCursor::Before
+
+//------------------------------------------------------------------------------
+void stRangeCursor::Push(const tItem & item){
+
+   Queue.push_back(item);
+   // std::push_heap() builds max heaps, so the order is inverted.
+   std::push_heap(Queue.begin(), Queue.end(),
+         [this](const tItem & a, const tItem & b){ return Before(b, a); });
+}//end stRangeCursor::Push
+
+//------------------------------------------------------------------------------
+void stRangeCursor::Pop(tItem & item){
+
+   std::pop_heap(Queue.begin(), Queue.end(),
+         [this](const tItem & a, const tItem & b){ return Before(b, a); });
+   item = Queue.back();
+   Queue.pop_back();
+}//end stRangeCursor::Pop
+
+//------------------------------------------------------------------------------
+void stRangeCursor::SetLast(double distance, long oid){
+
+   if (Backward){
+      ExternalRadius = distance;
+   }else{
+      InternalRadius = distance;
+   }//end if
+   OID = oid;
+}//end stRangeCursor::SetLast
+
+//------------------------------------------------------------------------------
+bool stRangeCursor::Qualifies(double distance, long oid){
+
+   if (Backward){
+      return (distance > InternalRadius) && ((distance < ExternalRadius) ||
+            ((distance == ExternalRadius) && (oid < OID)));
+   }else{
+      return (distance <= ExternalRadius) && ((distance > InternalRadius) ||
+            ((distance == InternalRadius) && (oid > OID)));
+   }//end if
+}//end stRangeCursor::Qualifies
+
+//------------------------------------------------------------------------------
+// The serialized cursor is:
+//    u_int32_t version, u_int32_t flags (1 backward, 2 started),
+//    double internalRadius, double externalRadius, int64 oid,
+//    u_int32_t root, int64 numberOfObjects, u_int32_t modification,
+//    u_int32_t number of items,
+//    the items (double key, double distance, double radius,
+//    u_int32_t pageID, u_int32_t entry, int64 oid, u_int32_t object).
+#define STRANGECURSORHEADER (4 + 4 + 8 + 8 + 8 + 4 + 8 + 4 + 4)
+#define STRANGECURSORITEM (8 + 8 + 8 + 4 + 4 + 8 + 4)
+
+//------------------------------------------------------------------------------
+// Appends a value to a buffer.
+template < class T >
+static unsigned char * PutValue(unsigned char * p, T value){
+
+   memcpy(p, &value, sizeof(T));
+   return p + sizeof(T);
+}//end PutValue
+
+//------------------------------------------------------------------------------
+// Reads a value from a buffer.
+template < class T >
+static const unsigned char * GetValue(const unsigned char * p, T & value){
+
+   memcpy(&value, p, sizeof(T));
+   return p + sizeof(T);
+}//end GetValue
+
+//------------------------------------------------------------------------------
+u_int32_t stRangeCursor::GetSerializedSize(){
+
+   return STRANGECURSORHEADER + (Queue.size() * STRANGECURSORITEM);
+}//end stRangeCursor::GetSerializedSize
+
+//------------------------------------------------------------------------------
+const unsigned char * stRangeCursor::Serialize(){
+   unsigned char * p;
+   u_int32_t i;
+
+   Serialized.resize(GetSerializedSize());
+   p = Serialized.data();
+   p = PutValue < u_int32_t > (p, STRANGECURSORVERSION);
+   p = PutValue < u_int32_t > (p, (Backward ? 1 : 0) | (Started ? 2 : 0));
+   p = PutValue < double > (p, InternalRadius);
+   p = PutValue < double > (p, ExternalRadius);
+   p = PutValue < int64_t > (p, OID);
+   p = PutValue < u_int32_t > (p, Root);
+   p = PutValue < int64_t > (p, NumberOfObjects);
+   p = PutValue < u_int32_t > (p, Modification);
+   p = PutValue < u_int32_t > (p, Queue.size());
+   // The heap is stored as is, so it is still a heap when restored.
+   for (i = 0; i < Queue.size(); i++){
+      p = PutValue < double > (p, Queue[i].Key);
+      p = PutValue < double > (p, Queue[i].Distance);
+      p = PutValue < double > (p, Queue[i].Radius);
+      p = PutValue < u_int32_t > (p, Queue[i].PageID);
+      p = PutValue < u_int32_t > (p, Queue[i].Entry);
+      p = PutValue < int64_t > (p, Queue[i].OID);
+      p = PutValue < u_int32_t > (p, Queue[i].Object ? 1 : 0);
+   }//end for
+   return Serialized.data();
+}//end stRangeCursor::Serialize
+
+//------------------------------------------------------------------------------
+bool stRangeCursor::Unserialize(const unsigned char * data, u_int32_t datasize){
+   const unsigned char * p = data;
+   u_int32_t version;
+   u_int32_t flags;
+   u_int32_t count;
+   u_int32_t object;
+   int64_t value;
+   u_int32_t i;
+
+   *this = stRangeCursor();
+   if (datasize < STRANGECURSORHEADER){
+      return false;
+   }//end if
+   p = GetValue(p, version);
+   p = GetValue(p, flags);
+   p = GetValue(p, InternalRadius);
+   p = GetValue(p, ExternalRadius);
+   p = GetValue(p, value);
+   OID = value;
+   p = GetValue(p, Root);
+   p = GetValue(p, value);
+   NumberOfObjects = value;
+   p = GetValue(p, Modification);
+   p = GetValue(p, count);
+   if ((version != STRANGECURSORVERSION) ||
+         (datasize != STRANGECURSORHEADER + ((u_int64_t) count * STRANGECURSORITEM))){
+      *this = stRangeCursor();
+      return false;
+   }//end if
+   Backward = (flags & 1) != 0;
+   Started = (flags & 2) != 0;
+
+   Queue.resize(count);
+   for (i = 0; i < count; i++){
+      p = GetValue(p, Queue[i].Key);
+      p = GetValue(p, Queue[i].Distance);
+      p = GetValue(p, Queue[i].Radius);
+      p = GetValue(p, Queue[i].PageID);
+      p = GetValue(p, Queue[i].Entry);
+      p = GetValue(p, value);
+      Queue[i].OID = value;
+      p = GetValue(p, object);
+      Queue[i].Object = object != 0;
+   }//end for
+   return true;
+}//end stRangeCursor::Unserialize
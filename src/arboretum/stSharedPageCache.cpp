@@ -0,0 +1,63 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file implements the class stSharedPageCache.
+*
+* @version 1.0
+*/
+#include <arboretum/stSharedPageCache.h>
+
+//------------------------------------------------------------------------------
+// Class stSharedPageCache
+//------------------------------------------------------------------------------
+stSharedPageCache::stSharedPageCache(u_int32_t capacity){
+
+   Capacity = (capacity > 0) ? capacity : 1;
+   HitCount = 0;
+   MissCount = 0;
+}//end stSharedPageCache::stSharedPageCache
+
+//------------------------------------------------------------------------------
+stSharedPageCache::tPage stSharedPageCache::Get(stPageManager * pageManager,
+      u_int32_t pageID){
+   std::lock_guard < std::mutex > lock(Mutex);
+   tKey key(pageManager, pageID);
+   std::map < tKey, tPages::iterator >::iterator found;
+   stPage * page;
+   tPage copy;
+
+   found = Index.find(key);
+   if (found != Index.end()){
+      // Move it to the front.
+      HitCount++;
+      Pages.splice(Pages.begin(), Pages, found->second);
+      return found->second->second;
+   }//end if
+
+   MissCount++;
+   page = pageManager->GetPage(pageID);
+   copy.reset(new stPage(page->GetPageSize(), pageID));
+   copy->Copy(page);
+   pageManager->ReleasePage(page);
+
+   if (Pages.size() >= Capacity){
+      // The least recently used goes away.
+      Index.erase(Pages.back().first);
+      Pages.pop_back();
+   }//end if
+   Pages.push_front(std::make_pair(key, copy));
+   Index[key] = Pages.begin();
+   return copy;
+}//end stSharedPageCache::Get
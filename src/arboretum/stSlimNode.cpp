@@ -62,6 +62,19 @@ stSlimIndexNode::stSlimIndexNode(stPage * page, bool create): stSlimNode(page){
 
 //------------------------------------------------------------------------------
 int stSlimIndexNode::AddEntry(u_int32_t size, const unsigned char * object){
+   int idx;
+
+   idx = AddEntry(size);
+   if (idx >= 0){
+      memcpy((void *)(Page->GetData() + Entries[idx].Offset),
+             (void *)object, size);
+   }//end if
+
+   return idx;
+}//end stSlimIndexNode::AddEntry()
+
+//------------------------------------------------------------------------------
+int stSlimIndexNode::AddEntry(u_int32_t size){
    u_int32_t entrySize;
 
    #ifdef __stDEBUG__
@@ -87,8 +100,9 @@ int stSlimIndexNode::AddEntry(u_int32_t size, const unsigned char * object){
    }else{
       Entries[Header->Occupation].Offset = Entries[Header->Occupation - 1].Offset - size;
    }//end if
-   memcpy((void *)(Page->GetData() + Entries[Header->Occupation].Offset),
-          (void *)object, size);
+   #ifdef __stSLIMRKNN__
+      Entries[Header->Occupation].MaxKNNDistance = -1;
+   #endif //__stSLIMRKNN__
    // Update # of entries
    Header->Occupation++; // One more!
 
@@ -270,6 +284,19 @@ stSlimLeafNode::stSlimLeafNode(stPage * page, bool create):
 
 //------------------------------------------------------------------------------
 int stSlimLeafNode::AddEntry(u_int32_t size, const unsigned char * object){
+   int idx;
+
+   idx = AddEntry(size);
+   if (idx >= 0){
+      memcpy((void *)(Page->GetData() + Entries[idx].Offset),
+             (void *)object, size);
+   }//end if
+
+   return idx;
+}//end stSlimLeafNode::AddEntry()
+
+//------------------------------------------------------------------------------
+int stSlimLeafNode::AddEntry(u_int32_t size){
    u_int32_t entrySize;
 
    #ifdef __stDEBUG__
@@ -295,8 +322,15 @@ int stSlimLeafNode::AddEntry(u_int32_t size, const unsigned char * object){
    }else{
       Entries[Header->Occupation].Offset = Entries[Header->Occupation - 1].Offset - size;
    }//end if
-   memcpy((void *)(Page->GetData() + Entries[Header->Occupation].Offset),
-          (void *)object, size);
+   #ifdef __stSLIMPIVOTS__
+      // The distances to the pivots are unknown until the tree sets them.
+      for (u_int32_t i = 0; i < STSLIMPIVOTS; i++){
+         Entries[Header->Occupation].PivotDistance[i] = -1;
+      }//end for
+   #endif //__stSLIMPIVOTS__
+   #ifdef __stSLIMRKNN__
+      Entries[Header->Occupation].KNNDistance = -1;
+   #endif //__stSLIMRKNN__
 
    // Update # of entries
    Header->Occupation++; // One more!
@@ -0,0 +1,336 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file implements the class stSnapshotPageManager.
+*
+* @version 1.0
+*/
+#include <arboretum/stSnapshotPageManager.h>
+
+#include <string.h>
+#include <vector>
+#include <utility>
+
+// Maximum number of page instances kept for reuse.
+#define STSNAPSHOTPAGEMANAGER_INSTANCECACHESIZE 64
+
+/**
+* Snapshots pinned by the current thread.
+*/
+static thread_local std::vector < std::pair < stSnapshotPageManager *, u_int64_t > >
+      ThreadSnapshots;
+
+//------------------------------------------------------------------------------
+// Class stSnapshotPageManager
+//------------------------------------------------------------------------------
+stSnapshotPageManager::stSnapshotPageManager(stPageManager * pageman){
+
+   PageManager = pageman;
+   CommittedEpoch = 1;
+   VersionCount = 0;
+   HeaderPage = NULL;
+   CommittedHeader = NULL;
+   PageCache = new tPageInstanceCache(STSNAPSHOTPAGEMANAGER_INSTANCECACHESIZE,
+         new stPageAllocator(PageManager->GetMinimumPageSize()));
+   ResetStatistics();
+}//end stSnapshotPageManager::stSnapshotPageManager
+
+//------------------------------------------------------------------------------
+stSnapshotPageManager::~stSnapshotPageManager(){
+   std::map < u_int32_t, tVersionList >::iterator i;
+   u_int32_t j;
+
+   for (i = Versions.begin(); i != Versions.end(); i++){
+      for (j = 0; j < i->second.size(); j++){
+         delete i->second[j].Image;
+      }//end for
+   }//end for
+   if (CommittedHeader != NULL){
+      delete CommittedHeader;
+   }//end if
+   delete PageCache;
+}//end stSnapshotPageManager::~stSnapshotPageManager
+
+//------------------------------------------------------------------------------
+u_int64_t stSnapshotPageManager::Commit(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   // Publish the header.
+   if (HeaderPage != NULL){
+      if (CommittedHeader == NULL){
+         CommittedHeader = new stPage(HeaderPage->GetPageSize(), 0);
+      }//end if
+      memcpy(CommittedHeader->GetData(), HeaderPage->GetData(),
+             HeaderPage->GetPageSize());
+   }//end if
+   CommittedEpoch++;
+   Reclaim();
+
+   return CommittedEpoch;
+}//end stSnapshotPageManager::Commit
+
+//------------------------------------------------------------------------------
+u_int64_t stSnapshotPageManager::GetCommittedEpoch(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   return CommittedEpoch;
+}//end stSnapshotPageManager::GetCommittedEpoch
+
+//------------------------------------------------------------------------------
+u_int64_t stSnapshotPageManager::BeginSnapshot(void * header, u_int32_t size){
+   u_int64_t epoch;
+
+   Mutex.lock();
+   epoch = CommittedEpoch;
+   Pinned.insert(epoch);
+   if ((header != NULL) && (CommittedHeader != NULL)){
+      if (size > CommittedHeader->GetPageSize()){
+         size = CommittedHeader->GetPageSize();
+      }//end if
+      memcpy(header, CommittedHeader->GetData(), size);
+   }//end if
+   Mutex.unlock();
+
+   ThreadSnapshots.push_back(std::make_pair(this, epoch));
+   return epoch;
+}//end stSnapshotPageManager::BeginSnapshot
+
+//------------------------------------------------------------------------------
+void stSnapshotPageManager::EndSnapshot(){
+   int i;
+
+   for (i = (int)ThreadSnapshots.size() - 1; i >= 0; i--){
+      if (ThreadSnapshots[i].first == this){
+         std::lock_guard < std::mutex > lock(Mutex);
+         Pinned.erase(Pinned.find(ThreadSnapshots[i].second));
+         ThreadSnapshots.erase(ThreadSnapshots.begin() + i);
+         Reclaim();
+         return;
+      }//end if
+   }//end for
+}//end stSnapshotPageManager::EndSnapshot
+
+//------------------------------------------------------------------------------
+u_int32_t stSnapshotPageManager::GetVersionCount(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   return VersionCount;
+}//end stSnapshotPageManager::GetVersionCount
+
+//------------------------------------------------------------------------------
+bool stSnapshotPageManager::IsEmpty(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   return PageManager->IsEmpty();
+}//end stSnapshotPageManager::IsEmpty
+
+//------------------------------------------------------------------------------
+stPage * stSnapshotPageManager::GetHeaderPage(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   UpdateReadCounter();
+   HeaderPage = PageManager->GetHeaderPage();
+   return HeaderPage;
+}//end stSnapshotPageManager::GetHeaderPage
+
+//------------------------------------------------------------------------------
+stPage * stSnapshotPageManager::GetPage(u_int32_t pageid){
+   std::map < u_int32_t, tVersionList >::iterator versions;
+   u_int64_t snapshot = GetThreadSnapshot();
+   stPage * page;
+   stPage * current;
+   u_int32_t i;
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   UpdateReadCounter();
+   if (snapshot == 0){
+      // Writer. Save the image before it is modified.
+      page = PageManager->GetPage(pageid);
+      if (page != NULL){
+         SaveVersion(page);
+      }//end if
+      return page;
+   }//end if
+
+   // Reader. Find the first version saved after the snapshot.
+   versions = Versions.find(pageid);
+   if (versions != Versions.end()){
+      for (i = 0; i < versions->second.size(); i++){
+         if (versions->second[i].Until > snapshot){
+            page = PageCache->Get();
+            page->Copy(versions->second[i].Image);
+            page->SetPageID(pageid);
+            return page;
+         }//end if
+      }//end for
+   }//end if
+
+   // Not modified since the snapshot. A private copy is returned anyway
+   // because the writer may change it while it is in use.
+   current = PageManager->GetPage(pageid);
+   if (current == NULL){
+      return NULL;
+   }//end if
+   page = PageCache->Get();
+   page->Copy(current);
+   page->SetPageID(pageid);
+   PageManager->ReleasePage(current);
+   return page;
+}//end stSnapshotPageManager::GetPage
+
+//------------------------------------------------------------------------------
+void stSnapshotPageManager::ReleasePage(stPage * page){
+   u_int64_t snapshot = GetThreadSnapshot();
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   if ((snapshot != 0) && (page != HeaderPage)){
+      // Private copy.
+      PageCache->Put(page);
+   }else{
+      PageManager->ReleasePage(page);
+   }//end if
+}//end stSnapshotPageManager::ReleasePage
+
+//------------------------------------------------------------------------------
+stPage * stSnapshotPageManager::GetNewPage(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   return PageManager->GetNewPage();
+}//end stSnapshotPageManager::GetNewPage
+
+//------------------------------------------------------------------------------
+void stSnapshotPageManager::WritePage(stPage * page){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   UpdateWriteCounter();
+   PageManager->WritePage(page);
+}//end stSnapshotPageManager::WritePage
+
+//------------------------------------------------------------------------------
+void stSnapshotPageManager::WriteHeaderPage(stPage * headerpage){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   UpdateWriteCounter();
+   HeaderPage = headerpage;
+   PageManager->WriteHeaderPage(headerpage);
+}//end stSnapshotPageManager::WriteHeaderPage
+
+//------------------------------------------------------------------------------
+void stSnapshotPageManager::DisposePage(stPage * page){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   PageManager->DisposePage(page);
+}//end stSnapshotPageManager::DisposePage
+
+//------------------------------------------------------------------------------
+void stSnapshotPageManager::BeginUpdate(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   PageManager->BeginUpdate();
+}//end stSnapshotPageManager::BeginUpdate
+
+//------------------------------------------------------------------------------
+void stSnapshotPageManager::EndUpdate(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   PageManager->EndUpdate();
+}//end stSnapshotPageManager::EndUpdate
+
+//------------------------------------------------------------------------------
+void stSnapshotPageManager::SubmitPrefetch(const u_int32_t * pageIDs, u_int32_t count){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   PageManager->SubmitPrefetch(pageIDs, count);
+}//end stSnapshotPageManager::SubmitPrefetch
+
+//------------------------------------------------------------------------------
+void stSnapshotPageManager::ResetStatistics(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   stPageManager::ResetStatistics();
+   PageManager->ResetStatistics();
+}//end stSnapshotPageManager::ResetStatistics
+
+//------------------------------------------------------------------------------
+u_int32_t stSnapshotPageManager::GetMinimumPageSize(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   return PageManager->GetMinimumPageSize();
+}//end stSnapshotPageManager::GetMinimumPageSize
+
+//------------------------------------------------------------------------------
+u_int32_t stSnapshotPageManager::GetPageCount(){
+   std::lock_guard < std::mutex > lock(Mutex);
+
+   return PageManager->GetPageCount();
+}//end stSnapshotPageManager::GetPageCount
+
+//------------------------------------------------------------------------------
+u_int64_t stSnapshotPageManager::GetThreadSnapshot(){
+   int i;
+
+   for (i = (int)ThreadSnapshots.size() - 1; i >= 0; i--){
+      if (ThreadSnapshots[i].first == this){
+         return ThreadSnapshots[i].second;
+      }//end if
+   }//end for
+   return 0;
+}//end stSnapshotPageManager::GetThreadSnapshot
+
+//------------------------------------------------------------------------------
+void stSnapshotPageManager::SaveVersion(stPage * page){
+   tVersionList & versions = Versions[page->GetPageID()];
+   tVersion version;
+
+   // Already saved in this epoch?
+   version.Until = CommittedEpoch + 1;
+   if ((!versions.empty()) && (versions.back().Until == version.Until)){
+      return;
+   }//end if
+
+   version.Image = PageCache->Get();
+   version.Image->Copy(page);
+   version.Image->SetPageID(page->GetPageID());
+   versions.push_back(version);
+   VersionOrder.push_back(page->GetPageID());
+   VersionCount++;
+}//end stSnapshotPageManager::SaveVersion
+
+//------------------------------------------------------------------------------
+void stSnapshotPageManager::Reclaim(){
+   std::map < u_int32_t, tVersionList >::iterator versions;
+   u_int64_t limit;
+
+   // New snapshots will pin CommittedEpoch or later.
+   limit = CommittedEpoch;
+   if ((!Pinned.empty()) && (*Pinned.begin() < limit)){
+      limit = *Pinned.begin();
+   }//end if
+
+   // VersionOrder is sorted by Until, so the oldest versions are first.
+   while (!VersionOrder.empty()){
+      versions = Versions.find(VersionOrder.front());
+      if (versions->second.front().Until > limit){
+         return;
+      }//end if
+      PageCache->Put(versions->second.front().Image);
+      versions->second.pop_front();
+      if (versions->second.empty()){
+         Versions.erase(versions);
+      }//end if
+      VersionOrder.pop_front();
+      VersionCount--;
+   }//end while
+}//end stSnapshotPageManager::Reclaim
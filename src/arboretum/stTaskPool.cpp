@@ -0,0 +1,110 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file implements the class stTaskPool.
+*
+* @version 1.0
+*/
+#include <arboretum/stTaskPool.h>
+
+#include <thread>
+
+//------------------------------------------------------------------------------
+// Class stTaskPool
+//------------------------------------------------------------------------------
+stTaskPool::stTaskPool(u_int32_t nThreads){
+   u_int32_t t;
+
+   if (nThreads == 0){
+      nThreads = std::thread::hardware_concurrency();
+   }//end if
+   if (nThreads == 0){
+      nThreads = 1;
+   }//end if
+   for (t = 0; t < nThreads; t++){
+      Queues.push_back(std::unique_ptr < tQueue >(new tQueue()));
+   }//end for
+   Pending = 0;
+   StealCount = 0;
+}//end stTaskPool::stTaskPool
+
+//------------------------------------------------------------------------------
+void stTaskPool::Submit(u_int32_t thread, tTask task){
+   tQueue * queue = Queues[thread % Queues.size()].get();
+
+   Pending++;
+   std::lock_guard < std::mutex > lock(queue->Mutex);
+   queue->Tasks.push_back(task);
+}//end stTaskPool::Submit
+
+//------------------------------------------------------------------------------
+void stTaskPool::Run(){
+   std::vector < std::thread > threads;
+   u_int32_t t;
+
+   StealCount = 0;
+   for (t = 1; t < Queues.size(); t++){
+      threads.push_back(std::thread(&stTaskPool::Work, this, t));
+   }//end for
+   Work(0);
+   for (t = 0; t < threads.size(); t++){
+      threads[t].join();
+   }//end for
+}//end stTaskPool::Run
+
+//------------------------------------------------------------------------------
+bool stTaskPool::Take(u_int32_t thread, tTask & task){
+   u_int32_t i;
+   tQueue * queue;
+
+   // The newest task of its own queue.
+   queue = Queues[thread].get();
+   {
+      std::lock_guard < std::mutex > lock(queue->Mutex);
+      if (!queue->Tasks.empty()){
+         task = std::move(queue->Tasks.back());
+         queue->Tasks.pop_back();
+         return true;
+      }//end if
+   }
+
+   // The oldest task of the others.
+   for (i = 1; i < Queues.size(); i++){
+      queue = Queues[(thread + i) % Queues.size()].get();
+      std::lock_guard < std::mutex > lock(queue->Mutex);
+      if (!queue->Tasks.empty()){
+         task = std::move(queue->Tasks.front());
+         queue->Tasks.pop_front();
+         StealCount++;
+         return true;
+      }//end if
+   }//end for
+   return false;
+}//end stTaskPool::Take
+
+//------------------------------------------------------------------------------
+void stTaskPool::Work(u_int32_t thread){
+   tTask task;
+
+   while (Pending > 0){
+      if (Take(thread, task)){
+         task(thread);
+         // Its children were submitted before it finished.
+         Pending--;
+      }else{
+         std::this_thread::yield();
+      }//end if
+   }//end while
+}//end stTaskPool::Work
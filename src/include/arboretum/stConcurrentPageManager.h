@@ -0,0 +1,215 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file defines the class stConcurrentPageManager.
+*
+* @version 1.0
+*/
+#ifndef __STCONCURRENTPAGEMANAGER_H
+#define __STCONCURRENTPAGEMANAGER_H
+
+#include <arboretum/stPageManager.h>
+#include <arboretum/stLatch.h>
+
+#include <mutex>
+
+//==============================================================================
+// Class stConcurrentPageManager
+//------------------------------------------------------------------------------
+/**
+* This class wraps another stPageManager allowing it to be used by many
+* threads at the same time. All calls to the wrapped page manager are
+* serialized by a mutex and each page returned by GetPage() is latched until
+* it is released by ReleasePage() or DisposePage().
+*
+* <P>The latch mode is chosen per thread by SetThreadLatchMode(). Threads
+* that only read (queries) use the default mode (lmSHARED). The inserters
+* switch to lmEXCLUSIVE for the pages they modify, and to lmNONE when they
+* already have exclusive access to the whole tree.
+*
+* <P>This instance will not claim the ownership of the wrapped page manager.
+*
+* @version 1.0
+* @see stSlimTree::SetConcurrent()
+* @ingroup storage
+*/
+class stConcurrentPageManager: public stPageManager{
+   public:
+      /**
+      * Latch modes used by GetPage().
+      */
+      enum tLatchMode{
+         /**
+         * Pages are not latched.
+         */
+         lmNONE,
+         /**
+         * Pages are latched in shared mode.
+         */
+         lmSHARED,
+         /**
+         * Pages are latched in exclusive mode.
+         */
+         lmEXCLUSIVE
+      };//end tLatchMode
+
+      /**
+      * Creates a new stConcurrentPageManager.
+      *
+      * @param pageman The page manager to be wrapped.
+      */
+      stConcurrentPageManager(stPageManager * pageman);
+
+      /**
+      * Disposes this instance. The wrapped page manager is not disposed.
+      */
+      virtual ~stConcurrentPageManager();
+
+      /**
+      * Returns the wrapped page manager.
+      */
+      stPageManager * GetPageManager(){
+         return PageManager;
+      }//end GetPageManager
+
+      /**
+      * Sets the latch mode of the calling thread.
+      *
+      * @param mode The new mode.
+      * @return The previous mode.
+      */
+      static tLatchMode SetThreadLatchMode(tLatchMode mode);
+
+      /**
+      * Returns the latch table used by this page manager.
+      */
+      stLatchTable * GetLatchTable(){
+         return &Latches;
+      }//end GetLatchTable
+
+      /**
+      * @copydoc stPageManager::IsEmpty()
+      */
+      virtual bool IsEmpty();
+
+      /**
+      * @copydoc stPageManager::GetHeaderPage()
+      */
+      virtual stPage * GetHeaderPage();
+
+      /**
+      * Returns the page with the given page ID latched according to the mode
+      * of the calling thread.
+      *
+      * @param pageid The desired page id.
+      * @return The page or NULL for an invalid page ID.
+      * @see SetThreadLatchMode()
+      */
+      virtual stPage * GetPage(u_int32_t pageid);
+
+      /**
+      * Releases the page and its latch, if any.
+      *
+      * @param page The page.
+      */
+      virtual void ReleasePage(stPage * page);
+
+      /**
+      * @copydoc stPageManager::GetNewPage()
+      */
+      virtual stPage * GetNewPage();
+
+      /**
+      * @copydoc stPageManager::GetNewLeafPage()
+      */
+      virtual stPage * GetNewLeafPage();
+
+      /**
+      * @copydoc stPageManager::WritePage()
+      */
+      virtual void WritePage(stPage * page);
+
+      /**
+      * @copydoc stPageManager::WriteHeaderPage()
+      */
+      virtual void WriteHeaderPage(stPage * headerpage);
+
+      /**
+      * Disposes the page and releases its latch, if any.
+      *
+      * @param page The page.
+      */
+      virtual void DisposePage(stPage * page);
+
+      /**
+      * @copydoc stPageManager::BeginUpdate()
+      */
+      virtual void BeginUpdate();
+
+      /**
+      * @copydoc stPageManager::EndUpdate()
+      */
+      virtual void EndUpdate();
+
+      /**
+      * @copydoc stPageManager::SubmitPrefetch()
+      */
+      virtual void SubmitPrefetch(const u_int32_t * pageIDs, u_int32_t count);
+
+      /**
+      * Restarts the statistics of this page manager and of the wrapped one.
+      */
+      virtual void ResetStatistics();
+
+      /**
+      * @copydoc stPageManager::GetMinimumPageSize()
+      */
+      virtual u_int32_t GetMinimumPageSize();
+
+      /**
+      * @copydoc stPageManager::GetLeafPageSize()
+      */
+      virtual u_int32_t GetLeafPageSize();
+
+      /**
+      * @copydoc stPageManager::GetPageCount()
+      */
+      virtual u_int32_t GetPageCount();
+
+   private:
+      /**
+      * The wrapped page manager.
+      */
+      stPageManager * PageManager;
+
+      /**
+      * Serializes the calls to the wrapped page manager.
+      */
+      std::mutex Mutex;
+
+      /**
+      * Latches of the pages.
+      */
+      stLatchTable Latches;
+
+      /**
+      * Releases the latch held by the calling thread on the given page.
+      *
+      * @param page The page.
+      */
+      void Unlatch(stPage * page);
+};//end stConcurrentPageManager
+
+#endif //__STCONCURRENTPAGEMANAGER_H
@@ -0,0 +1,187 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file defines the class stDualPageManager.
+*
+* @version 1.0
+*/
+#ifndef __STDUALPAGEMANAGER_H
+#define __STDUALPAGEMANAGER_H
+
+#include <arboretum/stPageManager.h>
+
+// Bit set in the IDs of the leaf pages.
+#ifndef STLEAFPAGEBIT
+   #define STLEAFPAGEBIT 0x80000000
+#endif //STLEAFPAGEBIT
+
+//==============================================================================
+// Class stDualPageManager
+//------------------------------------------------------------------------------
+/**
+* This class joins two page managers, one for the index pages and one for the
+* leaf pages, so the leaf nodes of a tree may use a page size different from
+* the one of the index nodes. Larger leaves pack more variable sized objects
+* without making the index nodes (and the queries that scan them) fat.
+*
+* <P>Pages allocated by GetNewLeafPage() come from the leaf page manager and
+* their IDs have the bit STLEAFPAGEBIT set. All other pages, including the
+* header page, come from the index page manager. Each page is routed to its
+* page manager by its ID.
+*
+* <P>BeginUpdate() and EndUpdate() are forwarded to both page managers. The
+* updates are atomic in each page manager but not across them.
+*
+* <P>This instance will not claim the ownership of the wrapped page managers.
+*
+* @version 1.0
+* @see stSlimPageSizeTuner
+* @ingroup storage
+*/
+class stDualPageManager: public stPageManager{
+   public:
+      /**
+      * Creates a new stDualPageManager.
+      *
+      * @param indexPages The page manager of the index pages.
+      * @param leafPages The page manager of the leaf pages.
+      */
+      stDualPageManager(stPageManager * indexPages, stPageManager * leafPages);
+
+      /**
+      * Disposes this instance. The wrapped page managers are not disposed.
+      */
+      virtual ~stDualPageManager();
+
+      /**
+      * Returns the page manager of the index pages.
+      */
+      stPageManager * GetIndexPageManager(){
+         return IndexPages;
+      }//end GetIndexPageManager
+
+      /**
+      * Returns the page manager of the leaf pages.
+      */
+      stPageManager * GetLeafPageManager(){
+         return LeafPages;
+      }//end GetLeafPageManager
+
+      /**
+      * Returns true if the given page ID belongs to a leaf page.
+      *
+      * @param pageid The page ID.
+      */
+      static bool IsLeafPage(u_int32_t pageid){
+         return (pageid & STLEAFPAGEBIT) != 0;
+      }//end IsLeafPage
+
+      /**
+      * Returns true if both page managers are empty.
+      */
+      virtual bool IsEmpty();
+
+      /**
+      * @copydoc stPageManager::GetHeaderPage()
+      */
+      virtual stPage * GetHeaderPage();
+
+      /**
+      * @copydoc stPageManager::GetPage()
+      */
+      virtual stPage * GetPage(u_int32_t pageid);
+
+      /**
+      * @copydoc stPageManager::ReleasePage()
+      */
+      virtual void ReleasePage(stPage * page);
+
+      /**
+      * Allocates a new index page.
+      *
+      * @return A new page or NULL for errors.
+      */
+      virtual stPage * GetNewPage();
+
+      /**
+      * Allocates a new leaf page.
+      *
+      * @return A new page or NULL for errors.
+      */
+      virtual stPage * GetNewLeafPage();
+
+      /**
+      * @copydoc stPageManager::WritePage()
+      */
+      virtual void WritePage(stPage * page);
+
+      /**
+      * @copydoc stPageManager::WriteHeaderPage()
+      */
+      virtual void WriteHeaderPage(stPage * headerpage);
+
+      /**
+      * @copydoc stPageManager::DisposePage()
+      */
+      virtual void DisposePage(stPage * page);
+
+      /**
+      * @copydoc stPageManager::BeginUpdate()
+      */
+      virtual void BeginUpdate();
+
+      /**
+      * @copydoc stPageManager::EndUpdate()
+      */
+      virtual void EndUpdate();
+
+      /**
+      * @copydoc stPageManager::SubmitPrefetch()
+      */
+      virtual void SubmitPrefetch(const u_int32_t * pageIDs, u_int32_t count);
+
+      /**
+      * Restarts the statistics of this page manager and of the wrapped ones.
+      */
+      virtual void ResetStatistics();
+
+      /**
+      * Returns the smallest of the minimum page sizes of both page managers.
+      */
+      virtual u_int32_t GetMinimumPageSize();
+
+      /**
+      * Returns the minimum page size of the leaf page manager.
+      */
+      virtual u_int32_t GetLeafPageSize();
+
+      /**
+      * Returns the number of pages of both page managers.
+      */
+      virtual u_int32_t GetPageCount();
+
+   private:
+      /**
+      * The page manager of the index pages.
+      */
+      stPageManager * IndexPages;
+
+      /**
+      * The page manager of the leaf pages.
+      */
+      stPageManager * LeafPages;
+};//end stDualPageManager
+
+#endif //__STDUALPAGEMANAGER_H
@@ -0,0 +1,318 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+//Implementation of stDummyColumnStore.h
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+stDummyColumnStore<ObjectType, EvaluatorType>::stDummyColumnStore(u_int32_t nThreads){
+
+   Blocks = NULL;
+   BlockCount = 0;
+   BlockCapacity = 0;
+   Count = 0;
+   SetNumberOfThreads(nThreads);
+}//end stDummyColumnStore<ObjectType, EvaluatorType>::stDummyColumnStore
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+stDummyColumnStore<ObjectType, EvaluatorType>::~stDummyColumnStore(){
+
+   Clear();
+   if (Blocks != NULL){
+      delete[] Blocks;
+   }//end if
+}//end stDummyColumnStore<ObjectType, EvaluatorType>::~stDummyColumnStore
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void stDummyColumnStore<ObjectType, EvaluatorType>::Append(
+      const unsigned char * data, u_int32_t size){
+   ObjectType ** newBlocks;
+
+   // Do I need a new block?
+   if (Count == BlockCount * STCOLUMNBLOCKSIZE){
+      if (BlockCount == BlockCapacity){
+         // Grow the block vector. The blocks themselves are never moved.
+         BlockCapacity = (BlockCapacity == 0) ? 16 : BlockCapacity * 2;
+         newBlocks = new ObjectType * [BlockCapacity];
+         if (Blocks != NULL){
+            memcpy(newBlocks, Blocks, sizeof(ObjectType *) * BlockCount);
+            delete[] Blocks;
+         }//end if
+         Blocks = newBlocks;
+      }//end if
+      Blocks[BlockCount] = new ObjectType[STCOLUMNBLOCKSIZE];
+      BlockCount++;
+   }//end if
+
+   // Decode it only once.
+   GetObject(Count)->IncludedUnserialize(data, size);
+   Columns.Append(*GetObject(Count));
+   Count++;
+}//end stDummyColumnStore<ObjectType, EvaluatorType>::Append
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void stDummyColumnStore<ObjectType, EvaluatorType>::Clear(){
+   u_int32_t i;
+
+   for (i = 0; i < BlockCount; i++){
+      delete[] Blocks[i];
+   }//end for
+   BlockCount = 0;
+   Count = 0;
+   Columns.Clear();
+}//end stDummyColumnStore<ObjectType, EvaluatorType>::Clear
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void stDummyColumnStore<ObjectType, EvaluatorType>::SetNumberOfThreads(
+      u_int32_t nThreads){
+
+   if (nThreads == 0){
+      nThreads = std::thread::hardware_concurrency();
+      if (nThreads == 0){
+         nThreads = 1;
+      }//end if
+   }//end if
+   NumberOfThreads = nThreads;
+}//end stDummyColumnStore<ObjectType, EvaluatorType>::SetNumberOfThreads
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+u_int32_t stDummyColumnStore<ObjectType, EvaluatorType>::GetScanThreads(){
+
+   // It is not worth to start a thread to scan less than 4 blocks.
+   if (BlockCount < NumberOfThreads * 4){
+      return (BlockCount / 4) > 1 ? (BlockCount / 4) : 1;
+   }else{
+      return NumberOfThreads;
+   }//end if
+}//end stDummyColumnStore<ObjectType, EvaluatorType>::GetScanThreads
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+u_int32_t stDummyColumnStore<ObjectType, EvaluatorType>::ScanBlock(
+      u_int32_t block, const typename tColumns::tSample & sample,
+      unsigned char * mask, double * dist, EvaluatorType * metricEvaluator){
+   u_int32_t rows = GetBlockRows(block);
+
+   Columns.Scan(sample, Blocks[block], block * STCOLUMNBLOCKSIZE, rows, mask,
+         dist, metricEvaluator);
+
+   return rows;
+}//end stDummyColumnStore<ObjectType, EvaluatorType>::ScanBlock
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+template <class WorkerType>
+void stDummyColumnStore<ObjectType, EvaluatorType>::RunWorkers(
+      EvaluatorType * metricEvaluator, WorkerType worker){
+   u_int32_t nThreads = GetScanThreads();
+   u_int32_t blocksPerThread;
+   u_int32_t t;
+   std::vector < EvaluatorType > evaluators;
+   std::vector < std::thread > threads;
+
+   if (nThreads <= 1){
+      // Fast path. No threads and no evaluator copies.
+      worker(0, 0, BlockCount, metricEvaluator);
+      return;
+   }//end if
+
+   // One evaluator for each thread to avoid races on its statistics.
+   evaluators.reserve(nThreads);
+   for (t = 0; t < nThreads; t++){
+      evaluators.push_back(*metricEvaluator);
+      evaluators[t].ResetStatistics();
+   }//end for
+
+   blocksPerThread = (BlockCount + nThreads - 1) / nThreads;
+   for (t = 0; t < nThreads; t++){
+      u_int32_t first = t * blocksPerThread;
+      u_int32_t last = std::min(first + blocksPerThread, BlockCount);
+      threads.push_back(std::thread(worker, t, first, last, &evaluators[t]));
+   }//end for
+   for (t = 0; t < nThreads; t++){
+      threads[t].join();
+      metricEvaluator->UpdateDistanceCount(evaluators[t].GetDistanceCount());
+   }//end for
+}//end stDummyColumnStore<ObjectType, EvaluatorType>::RunWorkers
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void stDummyColumnStore<ObjectType, EvaluatorType>::RangeQuery(
+      tResult * result, ObjectType * sample, double range,
+      EvaluatorType * metricEvaluator){
+   std::vector < tRowList > partial(NumberOfThreads);
+   typename tColumns::tSample prepared(sample);
+   u_int32_t t, i;
+
+   RunWorkers(metricEvaluator, [&](u_int32_t thread, u_int32_t first,
+         u_int32_t last, EvaluatorType * evaluator){
+      unsigned char mask[STCOLUMNBLOCKSIZE];
+      double dist[STCOLUMNBLOCKSIZE];
+      tRowDistance row;
+      u_int32_t block, rows, idx;
+
+      for (block = first; block < last; block++){
+         rows = ScanBlock(block, prepared, mask, dist, evaluator);
+         for (idx = 0; idx < rows; idx++){
+            if ((mask[idx]) && (dist[idx] <= range)){
+               row.Row = (block * STCOLUMNBLOCKSIZE) + idx;
+               row.Distance = dist[idx];
+               partial[thread].push_back(row);
+            }//end if
+         }//end for
+      }//end for
+   });
+
+   // Merge the partial answers.
+   for (t = 0; t < partial.size(); t++){
+      for (i = 0; i < partial[t].size(); i++){
+         result->AddPair((ObjectType *) GetObject(partial[t][i].Row)->Clone(),
+                         partial[t][i].Distance);
+      }//end for
+   }//end for
+}//end stDummyColumnStore<ObjectType, EvaluatorType>::RangeQuery
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void stDummyColumnStore<ObjectType, EvaluatorType>::ExistsQuery(
+      tResult * result, ObjectType * sample, double range,
+      EvaluatorType * metricEvaluator){
+   std::atomic < bool > found(false);
+   typename tColumns::tSample prepared(sample);
+   tRowDistance answer;
+
+   RunWorkers(metricEvaluator, [&](u_int32_t thread, u_int32_t first,
+         u_int32_t last, EvaluatorType * evaluator){
+      unsigned char mask[STCOLUMNBLOCKSIZE];
+      double dist[STCOLUMNBLOCKSIZE];
+      u_int32_t block, rows, idx;
+      bool expected;
+
+      // The other threads are checked once per block.
+      for (block = first; (block < last) && (!found.load()); block++){
+         rows = ScanBlock(block, prepared, mask, dist, evaluator);
+         for (idx = 0; idx < rows; idx++){
+            if ((mask[idx]) && (dist[idx] <= range)){
+               expected = false;
+               if (found.compare_exchange_strong(expected, true)){
+                  answer.Row = (block * STCOLUMNBLOCKSIZE) + idx;
+                  answer.Distance = dist[idx];
+               }//end if
+               return;
+            }//end if
+         }//end for
+      }//end for
+   });
+
+   if (found.load()){
+      result->AddPair((ObjectType *) GetObject(answer.Row)->Clone(), answer.Distance);
+   }//end if
+}//end stDummyColumnStore<ObjectType, EvaluatorType>::ExistsQuery
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+double stDummyColumnStore<ObjectType, EvaluatorType>::Prune(
+      tRowList & list, u_int32_t k){
+   double rangeK;
+   u_int32_t i, j;
+
+   if (list.size() < k){
+      return MAXDOUBLE;
+   }//end if
+
+   // Find the k-th distance.
+   std::nth_element(list.begin(), list.begin() + (k - 1), list.end(),
+         [](const tRowDistance & a, const tRowDistance & b){
+            return a.Distance < b.Distance;
+         });
+   rangeK = list[k - 1].Distance;
+
+   // Remove all rows beyond it but keep the ties.
+   for (i = 0, j = 0; i < list.size(); i++){
+      if (list[i].Distance <= rangeK){
+         list[j] = list[i];
+         j++;
+      }//end if
+   }//end for
+   list.resize(j);
+
+   return rangeK;
+}//end stDummyColumnStore<ObjectType, EvaluatorType>::Prune
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void stDummyColumnStore<ObjectType, EvaluatorType>::NearestQuery(
+      tResult * result, ObjectType * sample, u_int32_t k, bool tiebreaker,
+      EvaluatorType * metricEvaluator){
+   std::vector < tRowList > partial(NumberOfThreads);
+   typename tColumns::tSample prepared(sample);
+   tRowList merged;
+   double rangeK;
+   u_int32_t t, i;
+
+   if (k == 0){
+      return;
+   }//end if
+
+   RunWorkers(metricEvaluator, [&](u_int32_t thread, u_int32_t first,
+         u_int32_t last, EvaluatorType * evaluator){
+      unsigned char mask[STCOLUMNBLOCKSIZE];
+      double dist[STCOLUMNBLOCKSIZE];
+      double localRangeK = MAXDOUBLE;
+      tRowList & local = partial[thread];
+      tRowDistance row;
+      u_int32_t block, rows, idx;
+
+      for (block = first; block < last; block++){
+         rows = ScanBlock(block, prepared, mask, dist, evaluator);
+         for (idx = 0; idx < rows; idx++){
+            if ((mask[idx]) && (dist[idx] <= localRangeK)){
+               row.Row = (block * STCOLUMNBLOCKSIZE) + idx;
+               row.Distance = dist[idx];
+               local.push_back(row);
+            }//end if
+         }//end for
+         // Shrink the candidates once in a while.
+         if (local.size() >= 2 * k + STCOLUMNBLOCKSIZE){
+            localRangeK = Prune(local, k);
+         }//end if
+      }//end for
+      Prune(local, k);
+   });
+
+   // Merge the partial answers.
+   for (t = 0; t < partial.size(); t++){
+      merged.insert(merged.end(), partial[t].begin(), partial[t].end());
+   }//end for
+   std::sort(merged.begin(), merged.end(),
+         [&](const tRowDistance & a, const tRowDistance & b){
+            return Less(a, b, tiebreaker);
+         });
+
+   for (i = 0; i < merged.size(); i++){
+      if (i >= k){
+         // Only the ties of the k-th object may be added now. The
+         // tiebreaker already untied them.
+         if ((tiebreaker) || (!result->GetTie()) || (merged[i].Distance > rangeK)){
+            break;
+         }//end if
+      }//end if
+      rangeK = merged[i].Distance;
+      result->AddPair((ObjectType *) GetObject(merged[i].Row)->Clone(),
+                      merged[i].Distance);
+   }//end for
+}//end stDummyColumnStore<ObjectType, EvaluatorType>::NearestQuery
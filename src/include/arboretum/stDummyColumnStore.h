@@ -0,0 +1,384 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file defines the class templates stDummyColumns and
+* stDummyColumnStore.
+*
+* @version 1.0
+*/
+#ifndef __STDUMMYCOLUMNSTORE_H
+#define __STDUMMYCOLUMNSTORE_H
+
+#include <arboretum/stCommon.h>
+#include <arboretum/stResult.h>
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+// Number of rows of each column block.
+#ifndef STCOLUMNBLOCKSIZE
+   #define STCOLUMNBLOCKSIZE 256
+#endif //STCOLUMNBLOCKSIZE
+
+//=============================================================================
+// Class template stDummyColumns
+//-----------------------------------------------------------------------------
+/**
+* This class template is the column extractor of stDummyColumnStore. It
+* extracts the columns used by the queries from each decoded object and
+* evaluates the filter and the distance of a block of rows over them.
+*
+* <P>This generic version keeps no columns of its own. It calls
+* EvaluatorType::GetFilter() and EvaluatorType::GetDistance() on the decoded
+* objects, one row at a time. An application specializes it for its object
+* and evaluator types to keep the fields used by the queries (scalar fields,
+* fixed width features, bitmaps...) in contiguous arrays and to evaluate
+* them in tight loops. A specialization must provide the same members and
+* must produce the same masks and distances as the evaluator.
+*
+* @see stDummyColumnStore
+* @ingroup dummy
+*/
+template <class ObjectType, class EvaluatorType>
+class stDummyColumns{
+   public:
+      /**
+      * The query center, prepared once for all blocks of a query.
+      */
+      class tSample{
+         public:
+            /**
+            * Prepares a query center.
+            */
+            tSample(ObjectType * sample){
+               Sample = sample;
+            }//end tSample
+
+            /**
+            * The query center.
+            */
+            ObjectType * Sample;
+      };
+
+      /**
+      * Appends the columns of an object. Rows are appended in order.
+      *
+      * @param obj The decoded object.
+      */
+      void Append(ObjectType & obj){
+      }//end Append
+
+      /**
+      * Removes all rows.
+      */
+      void Clear(){
+      }//end Clear
+
+      /**
+      * Evaluates the filter and the distance columns of a block of rows.
+      * The distances are only required for the rows that passed the filter.
+      *
+      * @param sample The query center.
+      * @param objects The decoded objects of the block.
+      * @param first The first row of the block.
+      * @param rows The number of rows of the block.
+      * @param mask The mask column (output).
+      * @param dist The distance column (output).
+      * @param metricEvaluator The metric evaluator. Its distance count must
+      * be updated.
+      */
+      void Scan(const tSample & sample, ObjectType * objects, u_int32_t first,
+            u_int32_t rows, unsigned char * mask, double * dist,
+            EvaluatorType * metricEvaluator){
+         u_int32_t i;
+
+         // Predicate column.
+         for (i = 0; i < rows; i++){
+            mask[i] = metricEvaluator->GetFilter(objects[i], *sample.Sample) ? 1 : 0;
+         }//end for
+
+         // Distance column for the rows that passed the filter.
+         for (i = 0; i < rows; i++){
+            if (mask[i]){
+               dist[i] = metricEvaluator->GetDistance(objects[i], *sample.Sample);
+            }//end if
+         }//end for
+      }//end Scan
+};//end stDummyColumns
+
+//=============================================================================
+// Class template stDummyColumnStore
+//-----------------------------------------------------------------------------
+/**
+* This class template implements the columnar scan engine used by the
+* stDummyTree. It keeps every object of the sequential list already decoded
+* (IncludedUnserialize() is called only once per object) in fixed size blocks
+* of contiguous memory, and the columns extracted from them by
+* stDummyColumns.
+*
+* <P>Queries are evaluated block by block. For each block, the columns
+* produce a mask column (EvaluatorType::GetFilter()) and a distance column
+* for the rows that passed the filter (see stDummyColumns::Scan()). Blocks
+* are partitioned between a set of threads and each thread keeps its own
+* partial answer which is merged at the end. The decoded objects are only
+* read to build the answers, unless the columns are the generic ones.
+*
+* <P>When more than one thread is used, each thread works with its own copy of
+* the metric evaluator. The distance counts of all copies are added to the
+* original evaluator when the query finishes, so the statistics remain valid.
+*
+* @warning ObjectType must be default constructible and EvaluatorType must be
+* copy constructible.
+* @see stDummyTree
+* @ingroup dummy
+*/
+template <class ObjectType, class EvaluatorType>
+class stDummyColumnStore{
+   public:
+      /**
+      * This is the class that abstracts an result set for simple queries.
+      */
+      typedef stResult <ObjectType> tResult;
+
+      /**
+      * This is the column extractor.
+      */
+      typedef stDummyColumns <ObjectType, EvaluatorType> tColumns;
+
+      /**
+      * Creates a new empty column store.
+      *
+      * @param nThreads The number of threads used by the queries. 0 means
+      * one thread per hardware core.
+      */
+      stDummyColumnStore(u_int32_t nThreads = 0);
+
+      /**
+      * Disposes this instance and releases all decoded objects.
+      */
+      ~stDummyColumnStore();
+
+      /**
+      * Decodes a serialized object (in the IncludedSerialize() form) and
+      * appends it to the columns.
+      *
+      * @param data The serialized object.
+      * @param size The size of the serialized object.
+      */
+      void Append(const unsigned char * data, u_int32_t size);
+
+      /**
+      * Removes all rows of this store.
+      */
+      void Clear();
+
+      /**
+      * Returns the number of rows of this store.
+      */
+      u_int32_t GetNumberOfObjects(){
+         return Count;
+      }//end GetNumberOfObjects
+
+      /**
+      * Returns the decoded object of a given row.
+      *
+      * @param row The row.
+      * @warning Do not modify or dispose the returned object.
+      */
+      ObjectType * GetObject(u_int32_t row){
+         return Blocks[row / STCOLUMNBLOCKSIZE] + (row % STCOLUMNBLOCKSIZE);
+      }//end GetObject
+
+      /**
+      * Sets the number of threads used by the queries.
+      *
+      * @param nThreads The number of threads. 0 means one thread per
+      * hardware core.
+      */
+      void SetNumberOfThreads(u_int32_t nThreads);
+
+      /**
+      * Returns the number of threads used by the queries.
+      */
+      u_int32_t GetNumberOfThreads(){
+         return NumberOfThreads;
+      }//end GetNumberOfThreads
+
+      /**
+      * Performs a range query over all rows, adding the qualifying objects to
+      * the given result.
+      *
+      * @param result The result.
+      * @param sample The query center.
+      * @param range The query radius.
+      * @param metricEvaluator The metric evaluator.
+      */
+      void RangeQuery(tResult * result, ObjectType * sample, double range,
+            EvaluatorType * metricEvaluator);
+
+      /**
+      * Performs an exists query. The first qualifying object found by any
+      * thread is added to the result and all threads stop.
+      *
+      * @param result The result.
+      * @param sample The query center.
+      * @param range The query radius.
+      * @param metricEvaluator The metric evaluator.
+      */
+      void ExistsQuery(tResult * result, ObjectType * sample, double range,
+            EvaluatorType * metricEvaluator);
+
+      /**
+      * Performs a k-nearest neighbor query over all rows. Each thread keeps
+      * its k best rows (and rows tied with the k-th one) and the partial
+      * answers are merged at the end.
+      *
+      * @param result The result.
+      * @param sample The query center.
+      * @param k The number of neighbors.
+      * @param tiebreaker If true, objects tied at the same distance are
+      * ordered by ObjectType::operator<(), as done by stDummyTree.
+      * @param metricEvaluator The metric evaluator.
+      */
+      void NearestQuery(tResult * result, ObjectType * sample, u_int32_t k,
+            bool tiebreaker, EvaluatorType * metricEvaluator);
+
+   private:
+      /**
+      * A qualifying row and its distance to the query center.
+      */
+      struct tRowDistance{
+         /**
+         * The row.
+         */
+         u_int32_t Row;
+
+         /**
+         * The distance.
+         */
+         double Distance;
+      };
+
+      /**
+      * List of qualifying rows.
+      */
+      typedef std::vector < tRowDistance > tRowList;
+
+      /**
+      * Blocks of decoded objects. Each block holds STCOLUMNBLOCKSIZE rows.
+      */
+      ObjectType ** Blocks;
+
+      /**
+      * Number of allocated blocks.
+      */
+      u_int32_t BlockCount;
+
+      /**
+      * Capacity of the vector Blocks.
+      */
+      u_int32_t BlockCapacity;
+
+      /**
+      * Number of rows.
+      */
+      u_int32_t Count;
+
+      /**
+      * Number of threads used by the queries.
+      */
+      u_int32_t NumberOfThreads;
+
+      /**
+      * The columns of all rows.
+      */
+      tColumns Columns;
+
+      /**
+      * Returns the number of rows in the given block.
+      */
+      u_int32_t GetBlockRows(u_int32_t block){
+         if (block == BlockCount - 1){
+            return Count - (block * STCOLUMNBLOCKSIZE);
+         }else{
+            return STCOLUMNBLOCKSIZE;
+         }//end if
+      }//end GetBlockRows
+
+      /**
+      * Evaluates the filter and the distance columns of a block. The rows
+      * that passed the filter have their distances stored in dist.
+      *
+      * @param block The block.
+      * @param sample The prepared query center.
+      * @param mask The mask column (output).
+      * @param dist The distance column (output).
+      * @param metricEvaluator The metric evaluator.
+      * @return The number of rows of the block.
+      */
+      u_int32_t ScanBlock(u_int32_t block, const typename tColumns::tSample & sample,
+            unsigned char * mask, double * dist, EvaluatorType * metricEvaluator);
+
+      /**
+      * Returns the number of threads to be used for a scan.
+      */
+      u_int32_t GetScanThreads();
+
+      /**
+      * Runs a worker over all blocks, splitting them between the threads.
+      * Each worker receives its thread number, the first and the last
+      * (exclusive) block and a metric evaluator.
+      *
+      * @param metricEvaluator The original metric evaluator.
+      * @param worker The worker.
+      */
+      template <class WorkerType>
+      void RunWorkers(EvaluatorType * metricEvaluator, WorkerType worker);
+
+      /**
+      * Compares 2 qualifying rows using their distances and, if required,
+      * ObjectType::operator<() as tiebreaker.
+      */
+      bool Less(const tRowDistance & a, const tRowDistance & b, bool tiebreaker){
+         if (a.Distance != b.Distance){
+            return a.Distance < b.Distance;
+         }else if (tiebreaker){
+            if (*GetObject(a.Row) < *GetObject(b.Row)){
+               return true;
+            }else if (*GetObject(b.Row) < *GetObject(a.Row)){
+               return false;
+            }//end if
+         }//end if
+         return a.Row < b.Row;
+      }//end Less
+
+      /**
+      * Keeps only the k best rows (and the rows tied with the k-th distance)
+      * of a list of candidates.
+      *
+      * @param list The list of candidates.
+      * @param k The number of neighbors.
+      * @return The distance of the k-th candidate or MAXDOUBLE if the list has
+      * less than k candidates.
+      */
+      double Prune(tRowList & list, u_int32_t k);
+};//end stDummyColumnStore
+
+// Include implementation
+#include <arboretum/stDummyColumnStore-inl.h>
+
+#endif //__STDUMMYCOLUMNSTORE_H
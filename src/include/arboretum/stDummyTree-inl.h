@@ -17,6 +17,8 @@ template <class ObjectType, class EvaluatorType>
 stDummyTree<ObjectType, EvaluatorType>::stDummyTree(stPageManager * pageman):
       stMetricTree<ObjectType, EvaluatorType>(pageman){
 
+   ColumnStore = NULL;
+
    // Will I create or read it
    if (this->myPageManager->IsEmpty()){
       // Create it
@@ -36,6 +38,8 @@ template <class ObjectType, class EvaluatorType>
 stDummyTree<ObjectType, EvaluatorType>::stDummyTree(stPageManager * pageman, EvaluatorType* metricEvaluator):
       stMetricTree<ObjectType, EvaluatorType>(pageman, metricEvaluator){
 
+   ColumnStore = NULL;
+
    // Will I create or read it
    if (this->myPageManager->IsEmpty()){
       // Create it
@@ -124,9 +128,103 @@ bool stDummyTree<ObjectType, EvaluatorType>::Add(tObject * obj){
    // Write Header!
    WriteHeader();
 
+   // Keep the columns up to date
+   if (ColumnStore != NULL){
+      ColumnStore->Append(obj->IncludedSerialize(), obj->GetIncludedSerializedSize());
+   }//end if
+
    return true;
 }//end stDummyTree<ObjectType><EvaluatorType>::Add
 
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void stDummyTree<ObjectType, EvaluatorType>::EnableColumnScan(u_int32_t nThreads){
+   stPage * currPage;
+   stDummyNode * currNode;
+   u_int32_t i;
+   u_int32_t nextPageID;
+
+   if (ColumnStore != NULL){
+      // Already built. Just update the number of threads.
+      ColumnStore->SetNumberOfThreads(nThreads);
+      return;
+   }//end if
+   ColumnStore = new tColumnStore(nThreads);
+
+   // Decode all objects only once
+   nextPageID = this->GetRoot();
+   while (nextPageID != 0){
+      // Get node
+      currPage = this->myPageManager->GetPage(nextPageID);
+      currNode = new stDummyNode(currPage);
+
+      for (i = 0; i < currNode->GetNumberOfEntries(); i++){
+         ColumnStore->Append(currNode->GetObject(i), currNode->GetObjectSize(i));
+      }//end for
+
+      // Next PageID...
+      nextPageID = currNode->GetNextNode();
+
+      // Free it all
+      delete currNode;
+      this->myPageManager->ReleasePage(currPage);
+   }//end while
+}//end stDummyTree<ObjectType><EvaluatorType>::EnableColumnScan
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+stResult<ObjectType> * stDummyTree<ObjectType, EvaluatorType>::ColumnRangeQuery(
+                              tObject * sample, double range){
+   tResult * result;
+
+   if (ColumnStore == NULL){
+      return RangeQuery(sample, range);
+   }//end if
+
+   // Create result
+   result = new tResult();
+   result->SetQueryInfo(sample->Clone(), RANGEQUERY, -1, range, false);
+   ColumnStore->RangeQuery(result, sample, range, this->myMetricEvaluator);
+
+   return result;
+}//end stDummyTree<ObjectType><EvaluatorType>::ColumnRangeQuery
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+stResult<ObjectType> * stDummyTree<ObjectType, EvaluatorType>::ColumnExistsQuery(
+                              tObject * sample, double range){
+   tResult * result;
+
+   if (ColumnStore == NULL){
+      return ExistsQuery(sample, range);
+   }//end if
+
+   // Create result
+   result = new tResult();
+   result->SetQueryInfo(sample->Clone(), RANGEQUERY, -1, range, false);
+   ColumnStore->ExistsQuery(result, sample, range, this->myMetricEvaluator);
+
+   return result;
+}//end stDummyTree<ObjectType><EvaluatorType>::ColumnExistsQuery
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+stResult<ObjectType> * stDummyTree<ObjectType, EvaluatorType>::ColumnNearestQuery(
+                     tObject * sample, u_int32_t k, bool tie, bool tiebreaker){
+   tResult * result;
+
+   if (ColumnStore == NULL){
+      return NearestQuery(sample, k, tie, tiebreaker);
+   }//end if
+
+   // Create result
+   result = new tResult(k);
+   result->SetQueryInfo(sample->Clone(), KNEARESTQUERY, k, -1.0, tie);
+   ColumnStore->NearestQuery(result, sample, k, tiebreaker, this->myMetricEvaluator);
+
+   return result;
+}//end stDummyTree<ObjectType><EvaluatorType>::ColumnNearestQuery
+
 //------------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
 stResult<ObjectType> * stDummyTree<ObjectType, EvaluatorType>::RangeQuery(
@@ -17,6 +17,7 @@
 #include <arboretum/stCommon.h>
 #include <arboretum/stMetricTree.h>
 #include <arboretum/stDummyNode.h>
+#include <arboretum/stDummyColumnStore.h>
 
 #include <exception>
 #include <iostream>
@@ -75,6 +76,11 @@ class stDummyTree: public stMetricTree<ObjectType, EvaluatorType>{
       */
       typedef stJoinedResult <ObjectType> tJoinedResult;
 
+      /**
+      * This is the class that abstracts the columnar scan engine.
+      */
+      typedef stDummyColumnStore <ObjectType, EvaluatorType> tColumnStore;
+
 
 
      class Iterator{
@@ -245,6 +251,9 @@ class stDummyTree: public stMetricTree<ObjectType, EvaluatorType>{
       */
       virtual ~stDummyTree(){
 
+         if (ColumnStore != NULL){
+            delete ColumnStore;
+         }//end if
          if (HeaderPage != NULL){
             // Release the header page.
             this->myPageManager->ReleasePage(HeaderPage);
@@ -514,6 +523,77 @@ class stDummyTree: public stMetricTree<ObjectType, EvaluatorType>{
       tJoinedResult * ClosestJoinQuery(stDummyTree * dummyTree, u_int32_t k,
                                        bool tie = false);
 
+      /**
+      * Enables the columnar scan engine. All objects of this tree are decoded
+      * once into a stDummyColumnStore which is kept up to date by Add().
+      * After this call, ColumnRangeQuery(), ColumnExistsQuery() and
+      * ColumnNearestQuery() do not read pages anymore.
+      *
+      * @param nThreads The number of threads used by the column queries. 0
+      * means one thread per hardware core.
+      * @see DisableColumnScan()
+      */
+      void EnableColumnScan(u_int32_t nThreads = 0);
+
+      /**
+      * Disables the columnar scan engine and releases the decoded objects.
+      */
+      void DisableColumnScan(){
+
+         if (ColumnStore != NULL){
+            delete ColumnStore;
+            ColumnStore = NULL;
+         }//end if
+      }//end DisableColumnScan
+
+      /**
+      * Returns the columnar scan engine or NULL if it is not enabled.
+      */
+      tColumnStore * GetColumnStore(){
+         return ColumnStore;
+      }//end GetColumnStore
+
+      /**
+      * This method will perform a range query using the columnar scan engine.
+      * If the engine is not enabled, it is the same as RangeQuery().
+      *
+      * @param sample The sample object.
+      * @param range The range of the results.
+      * @return The result.
+      * @warning The instance of tResult returned must be destroied by user.
+      * @see EnableColumnScan()
+      */
+      tResult * ColumnRangeQuery(tObject * sample, double range);
+
+      /**
+      * This method will perform an exists query using the columnar scan
+      * engine. If the engine is not enabled, it is the same as ExistsQuery().
+      *
+      * @param sample The sample object.
+      * @param range The range of the results.
+      * @return The result.
+      * @warning The instance of tResult returned must be destroied by user.
+      * @see EnableColumnScan()
+      */
+      tResult * ColumnExistsQuery(tObject * sample, double range);
+
+      /**
+      * This method will perform a k nearest neighbor query using the columnar
+      * scan engine. If the engine is not enabled, it is the same as
+      * NearestQuery().
+      *
+      * @param sample The sample object.
+      * @param k The number of neighbours.
+      * @param tie The tie list. Default false.
+      * @param tiebreaker Untie the objects in the k-th position using
+      * ObjectType::operator<(). Default false.
+      * @return The result.
+      * @warning The instance of tResult returned must be destroied by user.
+      * @see EnableColumnScan()
+      */
+      tResult * ColumnNearestQuery(tObject * sample, u_int32_t k,
+            bool tie = false, bool tiebreaker = false);
+
       /**
       * This method will perform a PRE-CONDITION CONSTRAINED k nearest neighbor query.
       *
@@ -590,6 +670,12 @@ class stDummyTree: public stMetricTree<ObjectType, EvaluatorType>{
       */
       bool HeaderUpdate;
 
+      /**
+      * The columnar scan engine. It is NULL unless EnableColumnScan() is
+      * called.
+      */
+      tColumnStore * ColumnStore;
+
       /**
       * Creates the header for an empty tree.
       */
@@ -71,7 +71,7 @@ void stHistogram<ObjectType, EvaluatorType>::Build(EvaluatorType * metricEvaluat
          // diagonal.
          dist[i][i] = 0;
          for (j = i + 1; j < numberOfObjects; j++){
-            dist[i][j] = metricEvaluator->GetDistance(Objects[i], Objects[j]);
+            dist[i][j] = metricEvaluator->GetDistance(*Objects[i], *Objects[j]);
             dist[j][i] = dist[i][j];
             if (dist[i][j] > maxDist){
                maxDist = dist[i][j];
@@ -0,0 +1,392 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+//Implementation of stKMedoids.h
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+stKMedoids<ObjectType, EvaluatorType>::stKMedoids(
+      EvaluatorType * metricEvaluator, u_int32_t nThreads):
+      Random(STMEDOIDSEED){
+
+   MetricEvaluator = metricEvaluator;
+   if (nThreads == 0){
+      nThreads = std::thread::hardware_concurrency();
+   }//end if
+   if (nThreads == 0){
+      nThreads = 1;
+   }//end if
+   NumberOfThreads = nThreads;
+}//end stKMedoids<ObjectType, EvaluatorType>::stKMedoids
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+u_int32_t stKMedoids<ObjectType, EvaluatorType>::Cluster(
+      ObjectType ** objects, const u_int32_t * sizes, u_int32_t numObject,
+      u_int32_t fixed, u_int32_t k, double capacity,
+      std::vector < u_int32_t > & medoids, std::vector < u_int32_t > & cluster,
+      std::vector < double > & distances){
+   std::vector < u_int32_t > indexes(numObject);
+   std::vector < u_int32_t > sampleMedoids;
+   std::vector < u_int32_t > candidate;
+   std::vector < u_int32_t > all;
+   std::vector < ObjectType * > sample;
+   std::vector < double > sampleDist;
+   std::vector < double > roundDist;
+   std::vector < double > bestDist;
+   u_int32_t numSample, rounds, round, sampleFixed, i, j;
+   double cost, bestCost;
+
+   medoids.clear();
+   cluster.assign(numObject, 0);
+   distances.assign(numObject, 0);
+   if (numObject == 0){
+      return 0;
+   }//end if
+   if (fixed > numObject){
+      fixed = numObject;
+   }//end if
+   if (k > numObject){
+      k = numObject;
+   }//end if
+   if (k == 0){
+      k = 1;
+   }//end if
+
+   // CLARA samples. Small sets are clustered by PAM at once.
+   numSample = std::min(numObject, 40 + (2 * k));
+   rounds = (numSample == numObject) ? 1 : STMEDOIDSAMPLES;
+   for (i = 0; i < numSample; i++){
+      all.push_back(i);
+   }//end for
+
+   bestCost = MAXDOUBLE;
+   for (round = 0; round < rounds; round++){
+      // Draw the sample with a partial shuffle. The fixed object is always
+      // the first one.
+      for (i = 0; i < numObject; i++){
+         indexes[i] = i;
+      }//end for
+      i = 0;
+      sampleFixed = numSample;
+      if ((fixed < numObject) && (numSample < numObject)){
+         std::swap(indexes[0], indexes[fixed]);
+         sampleFixed = 0;
+         i = 1;
+      }else if (fixed < numObject){
+         sampleFixed = fixed;
+      }//end if
+      if (numSample < numObject){
+         for (; i < numSample; i++){
+            std::uniform_int_distribution < u_int32_t > draw(i, numObject - 1);
+            std::swap(indexes[i], indexes[draw(Random)]);
+         }//end for
+      }//end if
+      sample.resize(numSample);
+      for (i = 0; i < numSample; i++){
+         sample[i] = objects[indexes[i]];
+      }//end for
+
+      // PAM over the sample.
+      sampleDist.resize(numSample * numSample);
+      ComputeDistances(sample.data(), numSample, all, sampleDist.data());
+      Pam(sampleDist.data(), numSample, sampleFixed, k, sampleMedoids);
+
+      // Quality of these medoids over the whole set.
+      candidate.resize(sampleMedoids.size());
+      for (j = 0; j < sampleMedoids.size(); j++){
+         candidate[j] = indexes[sampleMedoids[j]];
+      }//end for
+      roundDist.resize(numObject * candidate.size());
+      cost = ComputeDistances(objects, numObject, candidate, roundDist.data());
+      if (cost < bestCost){
+         bestCost = cost;
+         medoids = candidate;
+         bestDist.swap(roundDist);
+      }//end if
+   }//end for
+
+   Assign(sizes, numObject, medoids, bestDist.data(), capacity, cluster,
+          distances);
+   return medoids.size();
+}//end stKMedoids<ObjectType, EvaluatorType>::Cluster
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+double stKMedoids<ObjectType, EvaluatorType>::ComputeDistances(
+      ObjectType ** objects, u_int32_t numObject,
+      const std::vector < u_int32_t > & medoids, double * dist){
+   u_int32_t k = medoids.size();
+   double cost = 0;
+   double nearest;
+   u_int32_t i, j;
+
+   RunWorkers(numObject, k, [&](u_int32_t first, u_int32_t last,
+         EvaluatorType * evaluator){
+      u_int32_t i, j;
+
+      for (i = first; i < last; i++){
+         for (j = 0; j < k; j++){
+            if (i == medoids[j]){
+               dist[(i * k) + j] = 0;
+            }else{
+               dist[(i * k) + j] = evaluator->GetDistance(*objects[i],
+                                                          *objects[medoids[j]]);
+            }//end if
+         }//end for
+      }//end for
+   });
+
+   for (i = 0; i < numObject; i++){
+      nearest = dist[i * k];
+      for (j = 1; j < k; j++){
+         nearest = std::min(nearest, dist[(i * k) + j]);
+      }//end for
+      cost += nearest;
+   }//end for
+   return cost;
+}//end stKMedoids<ObjectType, EvaluatorType>::ComputeDistances
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void stKMedoids<ObjectType, EvaluatorType>::Pam(const double * dist,
+      u_int32_t numSample, u_int32_t fixed, u_int32_t k,
+      std::vector < u_int32_t > & medoids){
+   std::vector < bool > isMedoid(numSample, false);
+   std::vector < double > nearest(numSample, MAXDOUBLE);
+   std::vector < double > second(numSample);
+   std::vector < u_int32_t > nearestIdx(numSample);
+   u_int32_t pass, i, j, h, best, bestI, bestH;
+   double gain, bestGain, delta, bestDelta, d;
+
+   medoids.clear();
+
+   // BUILD: the first medoid is the fixed object or the most central one.
+   if (fixed < numSample){
+      best = fixed;
+   }else{
+      best = 0;
+      bestGain = MAXDOUBLE;
+      for (h = 0; h < numSample; h++){
+         gain = 0;
+         for (j = 0; j < numSample; j++){
+            gain += dist[(h * numSample) + j];
+         }//end for
+         if (gain < bestGain){
+            bestGain = gain;
+            best = h;
+         }//end if
+      }//end for
+   }//end if
+   while (true){
+      isMedoid[best] = true;
+      medoids.push_back(best);
+      for (j = 0; j < numSample; j++){
+         nearest[j] = std::min(nearest[j], dist[(best * numSample) + j]);
+      }//end for
+      if (medoids.size() == k){
+         break;
+      }//end if
+
+      // Next one is the object that reduces the total distance the most.
+      best = numSample;
+      bestGain = -1;
+      for (h = 0; h < numSample; h++){
+         if (!isMedoid[h]){
+            gain = 0;
+            for (j = 0; j < numSample; j++){
+               d = dist[(h * numSample) + j];
+               if (d < nearest[j]){
+                  gain += nearest[j] - d;
+               }//end if
+            }//end for
+            if (gain > bestGain){
+               bestGain = gain;
+               best = h;
+            }//end if
+         }//end if
+      }//end for
+   }//end while
+
+   // SWAP: replaces a medoid by a non medoid while the total distance
+   // decreases. The fixed medoid is never replaced.
+   for (pass = 0; (pass < STMEDOIDSWAPS) && (k > 1); pass++){
+      for (j = 0; j < numSample; j++){
+         nearest[j] = MAXDOUBLE;
+         second[j] = MAXDOUBLE;
+         for (i = 0; i < k; i++){
+            d = dist[(medoids[i] * numSample) + j];
+            if (d < nearest[j]){
+               second[j] = nearest[j];
+               nearest[j] = d;
+               nearestIdx[j] = i;
+            }else if (d < second[j]){
+               second[j] = d;
+            }//end if
+         }//end for
+      }//end for
+
+      bestDelta = 0;
+      bestI = k;
+      bestH = numSample;
+      for (i = 0; i < k; i++){
+         if (medoids[i] != fixed){
+            for (h = 0; h < numSample; h++){
+               if (!isMedoid[h]){
+                  delta = 0;
+                  for (j = 0; j < numSample; j++){
+                     d = dist[(h * numSample) + j];
+                     if (nearestIdx[j] == i){
+                        delta += std::min(d, second[j]) - nearest[j];
+                     }else if (d < nearest[j]){
+                        delta += d - nearest[j];
+                     }//end if
+                  }//end for
+                  if (delta < bestDelta){
+                     bestDelta = delta;
+                     bestI = i;
+                     bestH = h;
+                  }//end if
+               }//end if
+            }//end for
+         }//end if
+      }//end for
+
+      if (bestI == k){
+         // Local minimum.
+         break;
+      }//end if
+      isMedoid[medoids[bestI]] = false;
+      isMedoid[bestH] = true;
+      medoids[bestI] = bestH;
+   }//end for
+}//end stKMedoids<ObjectType, EvaluatorType>::Pam
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void stKMedoids<ObjectType, EvaluatorType>::Assign(const u_int32_t * sizes,
+      u_int32_t numObject, const std::vector < u_int32_t > & medoids,
+      const double * dist, double capacity, std::vector < u_int32_t > & cluster,
+      std::vector < double > & distances){
+   u_int32_t k = medoids.size();
+   std::vector < double > used(k, 0);
+   std::vector < double > regret(numObject, 0);
+   std::vector < u_int32_t > order;
+   std::vector < u_int32_t > rank(k);
+   const double * row;
+   double d1, d2;
+   u_int32_t i, j, chosen;
+
+   // Medoids stay in their own clusters.
+   cluster.assign(numObject, k);
+   for (j = 0; j < k; j++){
+      cluster[medoids[j]] = j;
+      distances[medoids[j]] = 0;
+      used[j] += sizes[medoids[j]];
+   }//end for
+
+   // Objects that lose more by not going to their nearest medoid first.
+   for (i = 0; i < numObject; i++){
+      if (cluster[i] == k){
+         row = dist + (i * k);
+         d1 = MAXDOUBLE;
+         d2 = MAXDOUBLE;
+         for (j = 0; j < k; j++){
+            if (row[j] < d1){
+               d2 = d1;
+               d1 = row[j];
+            }else if (row[j] < d2){
+               d2 = row[j];
+            }//end if
+         }//end for
+         regret[i] = (k > 1) ? d2 - d1 : 0;
+         order.push_back(i);
+      }//end if
+   }//end for
+   std::stable_sort(order.begin(), order.end(),
+         [&](u_int32_t a, u_int32_t b){
+      return regret[a] > regret[b];
+   });
+
+   for (u_int32_t o = 0; o < order.size(); o++){
+      i = order[o];
+      row = dist + (i * k);
+
+      // The nearest cluster with room for it.
+      for (j = 0; j < k; j++){
+         rank[j] = j;
+      }//end for
+      std::stable_sort(rank.begin(), rank.end(),
+            [&](u_int32_t a, u_int32_t b){
+         return row[a] < row[b];
+      });
+      chosen = k;
+      for (j = 0; (j < k) && (chosen == k); j++){
+         if (used[rank[j]] + sizes[i] <= capacity){
+            chosen = rank[j];
+         }//end if
+      }//end for
+      if (chosen == k){
+         // Fits nowhere. The cluster with more room takes it.
+         chosen = 0;
+         for (j = 1; j < k; j++){
+            if (used[j] < used[chosen]){
+               chosen = j;
+            }//end if
+         }//end for
+      }//end if
+      cluster[i] = chosen;
+      distances[i] = row[chosen];
+      used[chosen] += sizes[i];
+   }//end for
+}//end stKMedoids<ObjectType, EvaluatorType>::Assign
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+template <class WorkerType>
+void stKMedoids<ObjectType, EvaluatorType>::RunWorkers(u_int32_t count,
+      u_int32_t cost, WorkerType worker){
+   u_int32_t nThreads = NumberOfThreads;
+   u_int32_t itemsPerThread;
+   u_int32_t t;
+   std::vector < EvaluatorType > evaluators;
+   std::vector < std::thread > threads;
+
+   if (double(count) * double(cost) < STMEDOIDPARALLELDISTANCES){
+      nThreads = 1;
+   }else if (nThreads > count){
+      nThreads = count;
+   }//end if
+   if (nThreads <= 1){
+      // Fast path. No threads and no evaluator copies.
+      worker(0, count, MetricEvaluator);
+      return;
+   }//end if
+
+   // One evaluator for each thread to avoid races on its statistics.
+   evaluators.reserve(nThreads);
+   for (t = 0; t < nThreads; t++){
+      evaluators.push_back(*MetricEvaluator);
+      evaluators[t].ResetStatistics();
+   }//end for
+
+   itemsPerThread = (count + nThreads - 1) / nThreads;
+   for (t = 0; t < nThreads; t++){
+      u_int32_t first = std::min(t * itemsPerThread, count);
+      u_int32_t last = std::min(first + itemsPerThread, count);
+      threads.push_back(std::thread(worker, first, last, &evaluators[t]));
+   }//end for
+   for (t = 0; t < nThreads; t++){
+      threads[t].join();
+      MetricEvaluator->UpdateDistanceCount(evaluators[t].GetDistanceCount());
+   }//end for
+}//end stKMedoids<ObjectType, EvaluatorType>::RunWorkers
@@ -0,0 +1,174 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file defines the class template stKMedoids.
+*
+* @version 1.0
+*/
+#ifndef __STKMEDOIDS_H
+#define __STKMEDOIDS_H
+
+#include <arboretum/stCommon.h>
+
+#include <vector>
+#include <thread>
+#include <random>
+#include <algorithm>
+
+// Number of samples evaluated by each clustering (CLARA rounds).
+#ifndef STMEDOIDSAMPLES
+   #define STMEDOIDSAMPLES 5
+#endif //STMEDOIDSAMPLES
+
+// Maximum number of SWAP passes of PAM over each sample.
+#ifndef STMEDOIDSWAPS
+   #define STMEDOIDSWAPS 10
+#endif //STMEDOIDSWAPS
+
+// Seed of the sampling. The same input always gives the same clusters.
+#ifndef STMEDOIDSEED
+   #define STMEDOIDSEED 5489
+#endif //STMEDOIDSEED
+
+// Minimum number of distances to be computed before threads are used.
+#ifndef STMEDOIDPARALLELDISTANCES
+   #define STMEDOIDPARALLELDISTANCES 4096
+#endif //STMEDOIDPARALLELDISTANCES
+
+//=============================================================================
+// Class template stKMedoids
+//-----------------------------------------------------------------------------
+/**
+* This class template groups a set of objects around k medoids using the
+* CLARA algorithm: PAM (BUILD followed by SWAP) is applied to STMEDOIDSAMPLES
+* random samples of 40 + 2k objects and the set of medoids with the smallest
+* total distance over the whole set is kept.
+*
+* <P>Each object has a size and each cluster a capacity. The objects are
+* assigned by decreasing regret (the difference between the distances to the
+* second nearest and to the nearest medoid) to the nearest medoid that still
+* has room for them, so the clusters can be stored in nodes of a metric tree.
+* One object may be required to be a medoid, as the representative of a node
+* must also be the representative of one of its subtrees.
+*
+* <P>The distances between the objects and the medoids are computed by a
+* set of threads. Each thread works with its own copy of the metric evaluator
+* and the distance counts of all copies are added to the original evaluator.
+*
+* @warning EvaluatorType must be copy constructible.
+* @version 1.0
+* @see stSlimTree::BulkLoadMedoids()
+* @ingroup struct
+*/
+template <class ObjectType, class EvaluatorType>
+class stKMedoids{
+   public:
+      /**
+      * Creates a new instance.
+      *
+      * @param metricEvaluator The metric evaluator.
+      * @param nThreads The number of threads. 0 means one thread per
+      * hardware core.
+      */
+      stKMedoids(EvaluatorType * metricEvaluator, u_int32_t nThreads = 0);
+
+      /**
+      * Groups the objects in at most k clusters.
+      *
+      * @param objects The objects.
+      * @param sizes The size of each object.
+      * @param numObject The number of objects.
+      * @param fixed The object that must be a medoid or numObject if any
+      * object may be chosen.
+      * @param k The number of clusters. It is limited to numObject.
+      * @param capacity The capacity of each cluster. Clusters exceed it only
+      * if an object fits in none of them.
+      * @param medoids The medoid of each cluster (output). If fixed is a
+      * valid object, it is always the first one.
+      * @param cluster The cluster of each object (output).
+      * @param distances The distance between each object and the medoid of
+      * its cluster (output).
+      * @return The number of clusters.
+      */
+      u_int32_t Cluster(ObjectType ** objects, const u_int32_t * sizes,
+            u_int32_t numObject, u_int32_t fixed, u_int32_t k,
+            double capacity, std::vector < u_int32_t > & medoids,
+            std::vector < u_int32_t > & cluster,
+            std::vector < double > & distances);
+
+   private:
+      /**
+      * The metric evaluator.
+      */
+      EvaluatorType * MetricEvaluator;
+
+      /**
+      * Number of threads.
+      */
+      u_int32_t NumberOfThreads;
+
+      /**
+      * Random generator used to draw the samples.
+      */
+      std::mt19937 Random;
+
+      /**
+      * Computes the distances between each object and each medoid. The
+      * distance between object i and medoid j is stored in
+      * dist[(i * medoids.size()) + j].
+      *
+      * @return The sum of the distances of each object to its nearest
+      * medoid.
+      */
+      double ComputeDistances(ObjectType ** objects, u_int32_t numObject,
+            const std::vector < u_int32_t > & medoids, double * dist);
+
+      /**
+      * Chooses k medoids among the sample using PAM.
+      *
+      * @param dist The distance matrix of the sample.
+      * @param numSample The size of the sample.
+      * @param fixed The position of the object that must be a medoid or
+      * numSample.
+      * @param k The number of medoids.
+      * @param medoids The medoids (output). The fixed one is the first.
+      */
+      void Pam(const double * dist, u_int32_t numSample, u_int32_t fixed,
+            u_int32_t k, std::vector < u_int32_t > & medoids);
+
+      /**
+      * Assigns each object to a cluster respecting the capacities.
+      */
+      void Assign(const u_int32_t * sizes, u_int32_t numObject,
+            const std::vector < u_int32_t > & medoids, const double * dist,
+            double capacity, std::vector < u_int32_t > & cluster,
+            std::vector < double > & distances);
+
+      /**
+      * Splits count items between the threads. Each worker receives the
+      * first and the last (exclusive) item and a metric evaluator.
+      *
+      * @param count The number of items.
+      * @param cost The number of distances computed for each item.
+      * @param worker The worker.
+      */
+      template <class WorkerType>
+      void RunWorkers(u_int32_t count, u_int32_t cost, WorkerType worker);
+};//end stKMedoids
+
+// Include implementation
+#include <arboretum/stKMedoids-inl.h>
+
+#endif //__STKMEDOIDS_H
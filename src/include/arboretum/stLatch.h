@@ -0,0 +1,149 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file defines the classes stLatchTable and stSharedLatchGuard used by
+* the metric trees to support concurrent access.
+*
+* @version 1.0
+*/
+#ifndef __STLATCH_H
+#define __STLATCH_H
+
+#include <arboretum/stCommon.h>
+
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+
+// Number of latches in each chunk of the stLatchTable (power of 2).
+#define STLATCHCHUNKBITS 10
+// Maximum number of chunks of the stLatchTable.
+#define STLATCHMAXCHUNKS 65536
+
+/**
+* Latches are plain std::shared_mutex instances.
+*/
+typedef std::shared_mutex stLatch;
+
+//==============================================================================
+// Class stLatchTable
+//------------------------------------------------------------------------------
+/**
+* This class maps page IDs to latches. Each page has its own latch which is
+* created on demand (in chunks of 2^STLATCHCHUNKBITS latches) and never moves,
+* so a reference returned by GetLatch() remains valid until the table is
+* destroyed.
+*
+* <P>Looking up a latch is lock free. The internal mutex is only taken when a
+* new chunk must be allocated.
+*
+* @version 1.0
+* @ingroup struct
+*/
+class stLatchTable{
+   public:
+      /**
+      * Creates a new empty latch table.
+      */
+      stLatchTable(){
+         for (u_int32_t i = 0; i < STLATCHMAXCHUNKS; i++){
+            Chunks[i].store(NULL, std::memory_order_relaxed);
+         }//end for
+      }//end stLatchTable
+
+      /**
+      * Disposes all latches.
+      */
+      ~stLatchTable(){
+         for (u_int32_t i = 0; i < STLATCHMAXCHUNKS; i++){
+            delete[] Chunks[i].load(std::memory_order_relaxed);
+         }//end for
+      }//end ~stLatchTable
+
+      /**
+      * Returns the latch of a given page.
+      *
+      * @param pageID The page ID.
+      * @return The latch.
+      */
+      stLatch & GetLatch(u_int32_t pageID){
+         u_int32_t chunk = (pageID >> STLATCHCHUNKBITS) % STLATCHMAXCHUNKS;
+         stLatch * latches = Chunks[chunk].load(std::memory_order_acquire);
+
+         if (latches == NULL){
+            std::lock_guard < std::mutex > lock(ChunkMutex);
+            latches = Chunks[chunk].load(std::memory_order_relaxed);
+            if (latches == NULL){
+               latches = new stLatch[1 << STLATCHCHUNKBITS];
+               Chunks[chunk].store(latches, std::memory_order_release);
+            }//end if
+         }//end if
+         return latches[pageID & ((1 << STLATCHCHUNKBITS) - 1)];
+      }//end GetLatch
+
+   private:
+      /**
+      * The chunks of latches.
+      */
+      std::atomic < stLatch * > Chunks[STLATCHMAXCHUNKS];
+
+      /**
+      * Mutex used to allocate new chunks.
+      */
+      std::mutex ChunkMutex;
+};//end stLatchTable
+
+//==============================================================================
+// Class stSharedLatchGuard
+//------------------------------------------------------------------------------
+/**
+* This class holds a latch in shared mode during its lifetime. A NULL latch is
+* accepted and nothing is done, allowing the single-threaded code to skip the
+* latching.
+*
+* @version 1.0
+* @ingroup struct
+*/
+class stSharedLatchGuard{
+   public:
+      /**
+      * Acquires the latch in shared mode.
+      *
+      * @param latch The latch or NULL.
+      */
+      stSharedLatchGuard(stLatch * latch){
+         Latch = latch;
+         if (Latch != NULL){
+            Latch->lock_shared();
+         }//end if
+      }//end stSharedLatchGuard
+
+      /**
+      * Releases the latch.
+      */
+      ~stSharedLatchGuard(){
+         if (Latch != NULL){
+            Latch->unlock_shared();
+         }//end if
+      }//end ~stSharedLatchGuard
+
+   private:
+      /**
+      * The latch.
+      */
+      stLatch * Latch;
+};//end stSharedLatchGuard
+
+#endif //__STLATCH_H
@@ -0,0 +1,197 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+//Implementation of stNearestQueryHint.h
+
+//------------------------------------------------------------------------------
+template <class ObjectType>
+stNearestQueryHint<ObjectType>::stNearestQueryHint(int type, u_int32_t cacheSize):
+      stQueryHint(type){
+
+   CacheSize = cacheSize;
+   Root = 0;
+   NumberOfObjects = 0;
+   Started = false;
+   Sample = NULL;
+   K = 0;
+   KDistance = MAXDOUBLE;
+   Hits = 0;
+   Misses = 0;
+}//end stNearestQueryHint<ObjectType>::stNearestQueryHint
+
+//------------------------------------------------------------------------------
+template <class ObjectType>
+stNearestQueryHint<ObjectType>::~stNearestQueryHint(){
+
+   Clear();
+}//end stNearestQueryHint<ObjectType>::~stNearestQueryHint
+
+//------------------------------------------------------------------------------
+template <class ObjectType>
+void stNearestQueryHint<ObjectType>::Start(u_int32_t root, long numberOfObjects){
+
+   ClearCache();
+   Root = root;
+   NumberOfObjects = numberOfObjects;
+   Started = true;
+}//end stNearestQueryHint<ObjectType>::Start
+
+//------------------------------------------------------------------------------
+template <class ObjectType>
+stResult<ObjectType> * stNearestQueryHint<ObjectType>::Find(ObjectType * sample,
+      u_int32_t k, bool tie, bool tiebreaker){
+   typename std::list < tEntry >::iterator i;
+   u_int64_t hash;
+
+   hash = Hash(sample, k, tie, tiebreaker);
+   for (i = Cache.begin(); i != Cache.end(); i++){
+      if ((i->Hash == hash) && (i->K == k) && (i->Tie == tie) &&
+            (i->Tiebreaker == tiebreaker) &&
+            (i->Sample.size() == sample->GetSerializedSize()) &&
+            (memcmp(i->Sample.data(), sample->Serialize(), i->Sample.size()) == 0)){
+         // Most recently used.
+         Cache.splice(Cache.begin(), Cache, i);
+         Hits++;
+         return Copy(Cache.front().Result, k, tie);
+      }//end if
+   }//end for
+   Misses++;
+   return NULL;
+}//end stNearestQueryHint<ObjectType>::Find
+
+//------------------------------------------------------------------------------
+template <class ObjectType>
+void stNearestQueryHint<ObjectType>::Store(ObjectType * sample, tResult * result,
+      u_int32_t k, bool tie, bool tiebreaker){
+   tEntry entry;
+   const unsigned char * data;
+   u_int32_t idx;
+
+   // The last query.
+   if (Sample != NULL){
+      delete Sample;
+   }//end if
+   Sample = (ObjectType *) sample->Clone();
+   K = k;
+   if (result->GetNumOfEntries() >= k){
+      KDistance = result->GetMaximumDistance();
+   }else{
+      KDistance = MAXDOUBLE;
+   }//end if
+   ClearWitnesses();
+   for (idx = 0; idx < result->GetNumOfEntries(); idx++){
+      Witnesses.push_back((ObjectType *) result->GetPair(idx)->GetObject()->Clone());
+   }//end for
+
+   // The cache.
+   if (CacheSize > 0){
+      if (Cache.size() >= CacheSize){
+         delete Cache.back().Result;
+         Cache.pop_back();
+      }//end if
+      entry.Hash = Hash(sample, k, tie, tiebreaker);
+      data = sample->Serialize();
+      entry.Sample.assign(data, data + sample->GetSerializedSize());
+      entry.K = k;
+      entry.Tie = tie;
+      entry.Tiebreaker = tiebreaker;
+      entry.Result = Copy(result, k, tie);
+      Cache.push_front(entry);
+   }//end if
+}//end stNearestQueryHint<ObjectType>::Store
+
+//------------------------------------------------------------------------------
+template <class ObjectType>
+void stNearestQueryHint<ObjectType>::Clear(){
+
+   ClearCache();
+   ClearWitnesses();
+   if (Sample != NULL){
+      delete Sample;
+   }//end if
+   Sample = NULL;
+   K = 0;
+   KDistance = MAXDOUBLE;
+   Started = false;
+}//end stNearestQueryHint<ObjectType>::Clear
+
+//------------------------------------------------------------------------------
+template <class ObjectType>
+u_int64_t stNearestQueryHint<ObjectType>::Hash(ObjectType * sample,
+      u_int32_t k, bool tie, bool tiebreaker){
+   const unsigned char * data;
+   u_int32_t size;
+   u_int32_t idx;
+   u_int64_t hash;
+
+   data = sample->Serialize();
+   size = sample->GetSerializedSize();
+   hash = 14695981039346656037ULL;
+   for (idx = 0; idx < size; idx++){
+      hash = (hash ^ data[idx]) * 1099511628211ULL;
+   }//end for
+   hash = (hash ^ k) * 1099511628211ULL;
+   hash = (hash ^ ((tie ? 1 : 0) | (tiebreaker ? 2 : 0))) * 1099511628211ULL;
+   return hash;
+}//end stNearestQueryHint<ObjectType>::Hash
+
+//------------------------------------------------------------------------------
+template <class ObjectType>
+stResult<ObjectType> * stNearestQueryHint<ObjectType>::Copy(tResult * result,
+      u_int32_t k, bool tie){
+   tResult * copy;
+   u_int32_t first;
+   u_int32_t idx;
+
+   copy = new tResult();
+   copy->SetQueryInfo((ObjectType *) result->GetSample()->Clone(),
+         KNEARESTQUERY, k, MAXDOUBLE, tie);
+   // AddPair() puts an object tied with the first one before it and any
+   // other object after its ties. The first ties are added backwards and
+   // the others forwards, so the copy keeps the order of the answer.
+   first = 0;
+   while ((first < result->GetNumOfEntries()) &&
+         (result->GetPair(first)->GetDistance() == result->GetPair(0)->GetDistance())){
+      first++;
+   }//end while
+   for (idx = first; idx > 0; idx--){
+      copy->AddPair((ObjectType *) result->GetPair(idx - 1)->GetObject()->Clone(),
+            result->GetPair(idx - 1)->GetDistance());
+   }//end for
+   for (idx = first; idx < result->GetNumOfEntries(); idx++){
+      copy->AddPair((ObjectType *) result->GetPair(idx)->GetObject()->Clone(),
+            result->GetPair(idx)->GetDistance());
+   }//end for
+   return copy;
+}//end stNearestQueryHint<ObjectType>::Copy
+
+//------------------------------------------------------------------------------
+template <class ObjectType>
+void stNearestQueryHint<ObjectType>::ClearWitnesses(){
+   u_int32_t idx;
+
+   for (idx = 0; idx < Witnesses.size(); idx++){
+      delete Witnesses[idx];
+   }//end for
+   Witnesses.clear();
+}//end stNearestQueryHint<ObjectType>::ClearWitnesses
+
+//------------------------------------------------------------------------------
+template <class ObjectType>
+void stNearestQueryHint<ObjectType>::ClearCache(){
+   typename std::list < tEntry >::iterator i;
+
+   for (i = Cache.begin(); i != Cache.end(); i++){
+      delete i->Result;
+   }//end for
+   Cache.clear();
+}//end stNearestQueryHint<ObjectType>::ClearCache
@@ -0,0 +1,306 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file defines the class template stNearestQueryHint.
+*
+* @version 1.0
+*/
+#ifndef __STNEARESTQUERYHINT_H
+#define __STNEARESTQUERYHINT_H
+
+#include <arboretum/stCommon.h>
+#include <arboretum/stQueryHint.h>
+#include <arboretum/stResult.h>
+
+#include <string.h>
+#include <vector>
+#include <list>
+
+// Default number of results kept by the cache of a stNearestQueryHint.
+#ifndef STNEARESTHINTCACHESIZE
+   #define STNEARESTHINTCACHESIZE 16
+#endif //STNEARESTHINTCACHESIZE
+
+//=============================================================================
+// Class template stNearestQueryHint
+//-----------------------------------------------------------------------------
+/**
+* This class template implements the query hint of the k-nearest neighbor
+* queries of the stSlimTree. Create it with stSlimTree::CreateQueryHint()
+* and give the same instance to successive queries.
+*
+* <P>The hint keeps two kinds of information about the previous queries:
+*
+* <UL>
+* <LI>The sample, the k and the k-th distance of the last query and a copy of
+* the objects of its answer (the witnesses). The k-th distance of a new query
+* is at most the k-th smallest distance from the new sample to the witnesses
+* and at most the previous k-th distance plus the distance between both
+* samples, so the query starts with a finite range instead of MAXDOUBLE.
+* <LI>A small LRU cache of answers, keyed by a hash of the serialized sample,
+* k and the tie options. A repeated query is answered without reading the
+* tree.
+* </UL>
+*
+* <P>The cache is only valid for the tree it was filled from. It is cleared
+* when the root or the number of objects of the tree changes. The witnesses
+* are kept, since the tree checks the answer and restarts the query without
+* the bound if the witnesses are gone.
+*
+* @warning A hint must not be shared by concurrent queries.
+* @version 1.0
+* @ingroup struct
+*/
+template <class ObjectType>
+class stNearestQueryHint: public stQueryHint{
+   public:
+      /**
+      * This is the class that abstracts an result set for simple queries.
+      */
+      typedef stResult <ObjectType> tResult;
+
+      /**
+      * Creates a new empty hint.
+      *
+      * @param type The hint type.
+      * @param cacheSize The maximum number of cached answers. 0 disables the
+      * cache.
+      */
+      stNearestQueryHint(int type, u_int32_t cacheSize = STNEARESTHINTCACHESIZE);
+
+      /**
+      * Disposes this hint and all copies it holds.
+      */
+      virtual ~stNearestQueryHint();
+
+      /**
+      * Returns true if the cache was filled from a tree with the given root
+      * and number of objects.
+      */
+      bool IsValid(u_int32_t root, long numberOfObjects){
+         return (Started) && (Root == root) && (NumberOfObjects == numberOfObjects);
+      }//end IsValid
+
+      /**
+      * Clears the cache and binds it to a tree with the given root and
+      * number of objects.
+      */
+      void Start(u_int32_t root, long numberOfObjects);
+
+      /**
+      * Returns a copy of the cached answer of a query or NULL if it is not
+      * in the cache. The answer becomes the most recently used one.
+      *
+      * @param sample The sample object.
+      * @param k The number of neighbors.
+      * @param tie The tie list.
+      * @param tiebreaker The tiebreaker.
+      * @warning The instance of tResult returned must be destroied by user.
+      */
+      tResult * Find(ObjectType * sample, u_int32_t k, bool tie, bool tiebreaker);
+
+      /**
+      * Stores the answer of a query. It becomes the last query of the hint
+      * and is added to the cache, evicting the least recently used answer if
+      * the cache is full.
+      *
+      * @param sample The sample object.
+      * @param result The answer. It is copied.
+      * @param k The number of neighbors.
+      * @param tie The tie list.
+      * @param tiebreaker The tiebreaker.
+      */
+      void Store(ObjectType * sample, tResult * result, u_int32_t k, bool tie,
+            bool tiebreaker);
+
+      /**
+      * Returns the sample of the last query or NULL.
+      */
+      ObjectType * GetSample(){
+         return Sample;
+      }//end GetSample
+
+      /**
+      * Returns the k of the last query.
+      */
+      u_int32_t GetK(){
+         return K;
+      }//end GetK
+
+      /**
+      * Returns the k-th distance of the last query or MAXDOUBLE if its answer
+      * had less than k objects.
+      */
+      double GetKDistance(){
+         return KDistance;
+      }//end GetKDistance
+
+      /**
+      * Returns the number of witnesses.
+      */
+      u_int32_t GetNumberOfWitnesses(){
+         return Witnesses.size();
+      }//end GetNumberOfWitnesses
+
+      /**
+      * Returns a witness.
+      *
+      * @param idx The witness.
+      * @warning Do not modify or dispose the returned object.
+      */
+      ObjectType * GetWitness(u_int32_t idx){
+         return Witnesses[idx];
+      }//end GetWitness
+
+      /**
+      * Returns the number of queries answered by the cache.
+      */
+      u_int32_t GetHits(){
+         return Hits;
+      }//end GetHits
+
+      /**
+      * Returns the number of queries not found in the cache.
+      */
+      u_int32_t GetMisses(){
+         return Misses;
+      }//end GetMisses
+
+      /**
+      * Removes the last query and the cached answers.
+      */
+      void Clear();
+
+   private:
+      /**
+      * A cached answer.
+      */
+      struct tEntry{
+         /**
+         * The hash of the query.
+         */
+         u_int64_t Hash;
+
+         /**
+         * The serialized sample.
+         */
+         std::vector < unsigned char > Sample;
+
+         /**
+         * The number of neighbors.
+         */
+         u_int32_t K;
+
+         /**
+         * The tie list.
+         */
+         bool Tie;
+
+         /**
+         * The tiebreaker.
+         */
+         bool Tiebreaker;
+
+         /**
+         * A copy of the answer.
+         */
+         tResult * Result;
+      };
+
+      /**
+      * The cached answers, the most recently used first.
+      */
+      std::list < tEntry > Cache;
+
+      /**
+      * The maximum number of cached answers.
+      */
+      u_int32_t CacheSize;
+
+      /**
+      * The root of the tree of the cache.
+      */
+      u_int32_t Root;
+
+      /**
+      * The number of objects of the tree of the cache.
+      */
+      long NumberOfObjects;
+
+      /**
+      * True if the cache is bound to a tree.
+      */
+      bool Started;
+
+      /**
+      * The sample of the last query.
+      */
+      ObjectType * Sample;
+
+      /**
+      * The k of the last query.
+      */
+      u_int32_t K;
+
+      /**
+      * The k-th distance of the last query.
+      */
+      double KDistance;
+
+      /**
+      * Copies of the objects of the last answer.
+      */
+      std::vector < ObjectType * > Witnesses;
+
+      /**
+      * Number of cache hits.
+      */
+      u_int32_t Hits;
+
+      /**
+      * Number of cache misses.
+      */
+      u_int32_t Misses;
+
+      /**
+      * Returns the hash (FNV-1a) of a query.
+      */
+      static u_int64_t Hash(ObjectType * sample, u_int32_t k, bool tie,
+            bool tiebreaker);
+
+      /**
+      * Returns a copy of an answer.
+      *
+      * @param result The answer.
+      * @param k The number of neighbors.
+      * @param tie The tie list.
+      */
+      static tResult * Copy(tResult * result, u_int32_t k, bool tie);
+
+      /**
+      * Disposes the witnesses.
+      */
+      void ClearWitnesses();
+
+      /**
+      * Disposes the cached answers.
+      */
+      void ClearCache();
+};//end stNearestQueryHint
+
+// Include implementation
+#include <arboretum/stNearestQueryHint-inl.h>
+
+#endif //__STNEARESTQUERYHINT_H
@@ -136,6 +136,19 @@ class stPageManager{
       */
       virtual stPage * GetNewPage() = 0;
 
+      /**
+      * Allocates a new page for a leaf node. Page managers that keep the
+      * leaf nodes in larger pages (see stDualPageManager) override it.
+      *
+      * <P>The default implementation calls GetNewPage().
+      *
+      * @return A new page or NULL for errors.
+      * @see GetLeafPageSize()
+      */
+      virtual stPage * GetNewLeafPage(){
+         return GetNewPage();
+      }//end GetNewLeafPage
+
       /**
       * Writes the given page to the disk. This method
       * will write the page but will not release it. Use
@@ -159,6 +172,44 @@ class stPageManager{
       */
       virtual void DisposePage(stPage * page) = 0;
 
+      /**
+      * Marks the beginning of an atomic update. All pages written, allocated
+      * or disposed until the matching EndUpdate() belong to the same update
+      * and page managers that support recovery must apply all of them or none
+      * of them. Updates may be nested. Only the outermost EndUpdate() finishes
+      * the update.
+      *
+      * <P>The default implementation does nothing.
+      *
+      * @see EndUpdate()
+      */
+      virtual void BeginUpdate(){
+      }//end BeginUpdate
+
+      /**
+      * Finishes the update started by BeginUpdate().
+      *
+      * <P>The default implementation does nothing.
+      *
+      * @see BeginUpdate()
+      */
+      virtual void EndUpdate(){
+      }//end EndUpdate
+
+      /**
+      * Starts reading the given pages in background. It is only a hint: the
+      * read is completed by a later call to GetPage() that returns the page as
+      * usual. Pages that are never requested are discarded.
+      *
+      * <P>The default implementation does nothing.
+      *
+      * @param pageIDs The IDs of the pages.
+      * @param count The number of pages.
+      * @see GetPage()
+      */
+      virtual void SubmitPrefetch(const u_int32_t * pageIDs, u_int32_t count){
+      }//end SubmitPrefetch
+
       /**
       * Restarts the statistics.
       *
@@ -209,6 +260,15 @@ class stPageManager{
       */ 
       virtual u_int32_t GetMinimumPageSize() = 0;
 
+      /**
+      * Returns the size of the pages returned by GetNewLeafPage().
+      *
+      * <P>The default implementation returns GetMinimumPageSize().
+      */
+      virtual u_int32_t GetLeafPageSize(){
+         return GetMinimumPageSize();
+      }//end GetLeafPageSize
+
       /**
       * Returns the number of pages.
       */
@@ -0,0 +1,174 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+//Implementation of stPivotTable.h
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void stPivotTable<ObjectType, EvaluatorType>::Clear(){
+
+   for (u_int32_t i = 0; i < Pivots.size(); i++){
+      delete Pivots[i];
+   }//end for
+   Pivots.clear();
+}//end stPivotTable<ObjectType, EvaluatorType>::Clear
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+u_int32_t stPivotTable<ObjectType, EvaluatorType>::GetFarthest(
+      ObjectType ** objects, u_int32_t numObject, ObjectType * obj,
+      EvaluatorType * metricEvaluator){
+   u_int32_t i;
+   u_int32_t best = 0;
+   double bestDistance = -1;
+   double distance;
+
+   for (i = 0; i < numObject; i++){
+      distance = metricEvaluator->GetDistance(*objects[i], *obj);
+      if (distance > bestDistance){
+         bestDistance = distance;
+         best = i;
+      }//end if
+   }//end for
+   return best;
+}//end stPivotTable<ObjectType, EvaluatorType>::GetFarthest
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+u_int32_t stPivotTable<ObjectType, EvaluatorType>::Choose(
+      ObjectType ** objects, u_int32_t numObject, u_int32_t numPivots,
+      EvaluatorType * metricEvaluator){
+   std::vector < double > error;
+   std::vector < bool > isPivot;
+   u_int32_t i;
+   u_int32_t step;
+   u_int32_t first, second, last;
+   double edge, delta;
+   int best;
+
+   Clear();
+   if ((numObject < 2) || (numPivots == 0)){
+      return 0;
+   }//end if
+
+   // Approximated diameter. The pair is refined a few times.
+   first = 0;
+   second = GetFarthest(objects, numObject, objects[first], metricEvaluator);
+   for (step = 0; step < 3; step++){
+      last = first;
+      first = GetFarthest(objects, numObject, objects[second], metricEvaluator);
+      if (first == last){
+         break;
+      }//end if
+      second = GetFarthest(objects, numObject, objects[first], metricEvaluator);
+   }//end for
+   edge = metricEvaluator->GetDistance(*objects[first], *objects[second]);
+   if (edge == 0){
+      // All objects are equal.
+      return 0;
+   }//end if
+
+   // The extremes are the first 2 pivots.
+   isPivot.assign(numObject, false);
+   error.assign(numObject, 0);
+   best = first;
+   while (best >= 0){
+      isPivot[best] = true;
+      Pivots.push_back((ObjectType *) objects[best]->Clone());
+      if (Pivots.size() == numPivots){
+         break;
+      }else if (Pivots.size() == 1){
+         best = second;
+      }else{
+         // error[i] accumulates |edge - d(i, p)| for all pivots p chosen so
+         // far. The next pivot is the object with the minimum error.
+         last = Pivots.size() - 1;
+         best = -1;
+         for (i = 0; i < numObject; i++){
+            if (!isPivot[i]){
+               if (last == 1){
+                  // Errors of the first pivot.
+                  delta = edge - metricEvaluator->GetDistance(*objects[i], *Pivots[0]);
+                  error[i] += (delta < 0) ? -delta : delta;
+               }//end if
+               delta = edge - metricEvaluator->GetDistance(*objects[i], *Pivots[last]);
+               error[i] += (delta < 0) ? -delta : delta;
+               if ((best < 0) || (error[i] < error[best])){
+                  best = i;
+               }//end if
+            }//end if
+         }//end for
+      }//end if
+   }//end while
+
+   return Pivots.size();
+}//end stPivotTable<ObjectType, EvaluatorType>::Choose
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+u_int32_t stPivotTable<ObjectType, EvaluatorType>::GetSerializedSize(){
+   u_int32_t size = sizeof(u_int32_t);
+
+   for (u_int32_t i = 0; i < Pivots.size(); i++){
+      size += sizeof(u_int32_t) + Pivots[i]->GetSerializedSize();
+   }//end for
+   return size;
+}//end stPivotTable<ObjectType, EvaluatorType>::GetSerializedSize
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void stPivotTable<ObjectType, EvaluatorType>::Serialize(unsigned char * dst){
+   u_int32_t count = Pivots.size();
+   u_int32_t size;
+
+   // Number of pivots followed by each pivot with its size.
+   memcpy(dst, &count, sizeof(count));
+   dst += sizeof(count);
+   for (u_int32_t i = 0; i < count; i++){
+      size = Pivots[i]->GetSerializedSize();
+      memcpy(dst, &size, sizeof(size));
+      dst += sizeof(size);
+      memcpy(dst, Pivots[i]->Serialize(), size);
+      dst += size;
+   }//end for
+}//end stPivotTable<ObjectType, EvaluatorType>::Serialize
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void stPivotTable<ObjectType, EvaluatorType>::Unserialize(
+      const unsigned char * data, u_int32_t size){
+   const unsigned char * end = data + size;
+   u_int32_t count;
+   u_int32_t objSize;
+   ObjectType * pivot;
+
+   Clear();
+   if (size < sizeof(count)){
+      return;
+   }//end if
+   memcpy(&count, data, sizeof(count));
+   data += sizeof(count);
+   for (u_int32_t i = 0; i < count; i++){
+      if (data + sizeof(objSize) > end){
+         break;
+      }//end if
+      memcpy(&objSize, data, sizeof(objSize));
+      data += sizeof(objSize);
+      if (data + objSize > end){
+         break;
+      }//end if
+      pivot = new ObjectType();
+      pivot->Unserialize(data, objSize);
+      Pivots.push_back(pivot);
+      data += objSize;
+   }//end for
+}//end stPivotTable<ObjectType, EvaluatorType>::Unserialize
@@ -0,0 +1,182 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file defines the class template stPivotTable.
+*
+* @version 1.0
+*/
+#ifndef __STPIVOTTABLE_H
+#define __STPIVOTTABLE_H
+
+#include <arboretum/stCommon.h>
+
+#include <vector>
+#include <string.h>
+
+//=============================================================================
+// Class template stPivotTable
+//-----------------------------------------------------------------------------
+/**
+* This class template holds a small set of global pivots (foci) and maps
+* objects to the vector of their distances to each pivot, as done by the Omni
+* technique. For any two objects a and b, the triangle inequality gives
+*
+* <pre>
+*    d(a, b) >= max |d(a, p) - d(b, p)| for all pivots p
+* </pre>
+*
+* so the distance vectors stored with the objects allow to discard them
+* without computing d(a, b).
+*
+* <P>The pivots are selected by the HF (Hull of Foci) algorithm: the first
+* two are the extremes of an approximated diameter of the sample and each
+* following one is the object whose distances to the pivots already chosen
+* are the closest to the length of this diameter.
+*
+* @version 1.0
+* @see stOmniPivot
+* @ingroup struct
+*/
+template <class ObjectType, class EvaluatorType>
+class stPivotTable{
+   public:
+      /**
+      * Creates an empty table.
+      */
+      stPivotTable(){
+      }//end stPivotTable
+
+      /**
+      * Disposes this instance and all pivots.
+      */
+      ~stPivotTable(){
+         Clear();
+      }//end ~stPivotTable
+
+      /**
+      * Removes all pivots.
+      */
+      void Clear();
+
+      /**
+      * Returns the number of pivots.
+      */
+      u_int32_t GetNumberOfPivots(){
+         return Pivots.size();
+      }//end GetNumberOfPivots
+
+      /**
+      * Returns the pivot idx.
+      *
+      * @param idx The index of the pivot.
+      * @warning Do not modify or dispose the returned object.
+      */
+      ObjectType * GetPivot(u_int32_t idx){
+         return Pivots[idx];
+      }//end GetPivot
+
+      /**
+      * Chooses the pivots from a sample using the HF algorithm. The previous
+      * pivots are discarded.
+      *
+      * @param objects The sample.
+      * @param numObject The number of objects in the sample.
+      * @param numPivots The number of pivots to choose.
+      * @param metricEvaluator The metric evaluator.
+      * @return The number of pivots chosen, which is less than numPivots
+      * only if the sample is too small.
+      */
+      u_int32_t Choose(ObjectType ** objects, u_int32_t numObject,
+            u_int32_t numPivots, EvaluatorType * metricEvaluator);
+
+      /**
+      * Computes the distances from an object to all pivots.
+      *
+      * @param obj The object.
+      * @param distances The distances (output). It must have room for
+      * GetNumberOfPivots() values.
+      * @param metricEvaluator The metric evaluator.
+      */
+      void BuildDistances(ObjectType * obj, double * distances,
+            EvaluatorType * metricEvaluator){
+         for (u_int32_t i = 0; i < Pivots.size(); i++){
+            distances[i] = metricEvaluator->GetDistance(*obj, *Pivots[i]);
+         }//end for
+      }//end BuildDistances
+
+      /**
+      * Returns the lower bound of the distance between two objects given
+      * their distances to the pivots.
+      *
+      * @param a The distances of the first object.
+      * @param b The distances of the second object.
+      * @param numPivots The number of pivots.
+      */
+      static double GetLowerBound(const double * a, const double * b,
+            u_int32_t numPivots){
+         double bound = 0;
+         double diff;
+
+         for (u_int32_t i = 0; i < numPivots; i++){
+            diff = a[i] - b[i];
+            if (diff < 0){
+               diff = -diff;
+            }//end if
+            if (diff > bound){
+               bound = diff;
+            }//end if
+         }//end for
+         return bound;
+      }//end GetLowerBound
+
+      /**
+      * Returns the size of this table in bytes once serialized.
+      */
+      u_int32_t GetSerializedSize();
+
+      /**
+      * Serializes the pivots.
+      *
+      * @param dst The buffer. It must have room for GetSerializedSize()
+      * bytes.
+      */
+      void Serialize(unsigned char * dst);
+
+      /**
+      * Restores the pivots from a buffer written by Serialize().
+      *
+      * @param data The buffer.
+      * @param size The size of the buffer.
+      */
+      void Unserialize(const unsigned char * data, u_int32_t size);
+
+   private:
+      /**
+      * The pivots.
+      */
+      std::vector < ObjectType * > Pivots;
+
+      /**
+      * Returns the index of the object of the sample that is the farthest from
+      * obj.
+      */
+      u_int32_t GetFarthest(ObjectType ** objects, u_int32_t numObject,
+            ObjectType * obj, EvaluatorType * metricEvaluator);
+};//end stPivotTable
+
+// Include implementation
+#include <arboretum/stPivotTable-inl.h>
+
+#endif //__STPIVOTTABLE_H
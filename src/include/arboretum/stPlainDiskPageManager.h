@@ -23,11 +23,25 @@
 #define __STPLAINDISKPAGEMANAGER_H
 
 #include <stdexcept>
+#include <string>
+#include <map>
+#include <set>
+#include <vector>
 
 #include <arboretum/stPageManager.h>
 #include <arboretum/stUtil.h>
 #include <arboretum/stCommonIO.h>
 
+// Number of updates committed to the log between two fdatasync() calls.
+#ifndef STWALGROUPCOMMIT
+   #define STWALGROUPCOMMIT 64
+#endif //STWALGROUPCOMMIT
+
+// Size of the log (in bytes) that triggers a checkpoint.
+#ifndef STWALCHECKPOINTSIZE
+   #define STWALCHECKPOINTSIZE 16777216
+#endif //STWALCHECKPOINTSIZE
+
 //==============================================================================
 // stPlainDiskPageManager
 //------------------------------------------------------------------------------
@@ -40,6 +54,24 @@
 * operations are performed without chaching pages. As an additional feature, it
 * is possible to disable the system I/O cache in some operational systems.
 *
+* <p>Optionally, the updates may be protected by a write-ahead log (see
+* EnableLog()) stored in a file with the same name plus ".wal". While the log
+* is enabled, the pages written between BeginUpdate() and EndUpdate() (the
+* header page included) are kept in memory and appended to the log as a single
+* update followed by a commit record. The log is synchronized with
+* fdatasync() once every groupCommit updates (group commit) and only then the
+* pages are written to the data file. When the log grows beyond a given size,
+* a checkpoint synchronizes the data file and truncates the log.
+*
+* <p>Opening an existing file always replays the committed updates found in
+* its log. Updates without a valid commit record, like a split interrupted by
+* a crash, are discarded, so the file returns to the state before them. Use
+* GetRecoveredUpdates() to know whether a recovery was performed and
+* stSlimTree::Consistency() to verify the recovered tree.
+*
+* <p>SubmitPrefetch() asks the system to read the given pages in background
+* with posix_fadvise(). Pages that are in the log are never prefetched.
+*
 * @version 1.0
 * @author Fabio Jun Takada Chino (chino@icmc.usp.br)
 * @author Marcos Rodrigues Vieira (mrvieira@icmc.usp.br)
@@ -207,7 +239,76 @@ class stPlainDiskPageManager: public stPageManager{
       void SetSystemCache(bool enabled){
          // Nothing to do.. at least for now.
       }//end SetSystemCache
-      
+
+      /**
+      * Enables the write-ahead log. The log file is created with the name of
+      * the data file plus ".wal".
+      *
+      * @param groupCommit Number of updates committed between two
+      * synchronizations of the log. Updates not yet synchronized may be lost
+      * by a crash but never leave the file inconsistent.
+      * @param checkpointSize Size of the log in bytes that triggers a
+      * checkpoint.
+      * @exception std::logic_error If the log file can not be created.
+      */
+      void EnableLog(u_int32_t groupCommit = STWALGROUPCOMMIT,
+            u_int32_t checkpointSize = STWALCHECKPOINTSIZE);
+
+      /**
+      * Performs a checkpoint and disables the write-ahead log. The log file is
+      * removed.
+      */
+      void DisableLog();
+
+      /**
+      * Returns true if the write-ahead log is enabled.
+      */
+      bool IsLogEnabled(){
+         return logfd >= 0;
+      }//end IsLogEnabled
+
+      /**
+      * Synchronizes the log and writes all committed pages to the data file
+      * without waiting for the group to be complete. It does nothing if
+      * there is an update in progress.
+      */
+      void Flush();
+
+      /**
+      * Flushes the committed pages, synchronizes the data file and truncates
+      * the log. It does nothing if there is an update in progress.
+      */
+      void Checkpoint();
+
+      /**
+      * Returns the number of updates replayed from the log when this file was
+      * opened. It is 0 if the file was closed cleanly.
+      */
+      u_int32_t GetRecoveredUpdates(){
+         return recoveredUpdates;
+      }//end GetRecoveredUpdates
+
+      /**
+      * Marks the beginning of an atomic update. It has effect only if the log
+      * is enabled.
+      *
+      * @see EndUpdate()
+      */
+      virtual void BeginUpdate();
+
+      /**
+      * Finishes the current update. The outermost call appends all pages
+      * written by the update to the log followed by a commit record.
+      *
+      * @see BeginUpdate()
+      */
+      virtual void EndUpdate();
+
+      /**
+      * @copydoc stPageManager::SubmitPrefetch()
+      */
+      virtual void SubmitPrefetch(const u_int32_t * pageIDs, u_int32_t count);
+
    private:
       #pragma pack(1)
       /**
@@ -241,7 +342,55 @@ class stPlainDiskPageManager: public stPageManager{
          */         
          u_int32_t Available;
       };//end tHeader
+
+      /**
+      * The header of each record of the log. Page records are followed by
+      * Size bytes of the page image.
+      */
+      struct tLogRecord{
+         /**
+         * Type of the record. See tLogRecordType.
+         */
+         u_int32_t Type;
+
+         /**
+         * The page ID of a page record or the number of page records of the
+         * update for a commit record.
+         */
+         u_int32_t PageID;
+
+         /**
+         * Size of the page image. 0 for commit records.
+         */
+         u_int32_t Size;
+
+         /**
+         * The checksum of the page image or, for commit records, of all
+         * records of the update.
+         */
+         u_int32_t Checksum;
+      };//end tLogRecord
       #pragma pack()
+
+      /**
+      * Types of the log records.
+      */
+      enum tLogRecordType{
+         /**
+         * Page image.
+         */
+         lrPAGE = 0x45474150,
+
+         /**
+         * End of an update.
+         */
+         lrCOMMIT = 0x54494D43
+      };//end tLogRecordType
+
+      /**
+      * Map of the pages written but not yet applied to the data file.
+      */
+      typedef std::map < u_int32_t, unsigned char * > tDirtyPages;
       
       /**
       * Type of the instance cache used by this disk page manager.
@@ -272,6 +421,98 @@ class stPlainDiskPageManager: public stPageManager{
       */      
       stLockablePage * headerPage;
 
+      /**
+      * Name of the log file.
+      */
+      std::string logName;
+
+      /**
+      * File descriptor of the log or -1 if the log is disabled.
+      */
+      int logfd;
+
+      /**
+      * Size of the log in bytes.
+      */
+      u_int64_t logSize;
+
+      /**
+      * Number of updates between two synchronizations of the log.
+      */
+      u_int32_t groupCommit;
+
+      /**
+      * Size of the log that triggers a checkpoint.
+      */
+      u_int32_t checkpointSize;
+
+      /**
+      * Nesting level of BeginUpdate().
+      */
+      u_int32_t updateDepth;
+
+      /**
+      * Number of updates in the log not yet applied to the data file.
+      */
+      u_int32_t pendingUpdates;
+
+      /**
+      * Number of updates replayed by the recovery.
+      */
+      u_int32_t recoveredUpdates;
+
+      /**
+      * Committed and in progress pages not yet applied to the data file.
+      */
+      tDirtyPages dirtyPages;
+
+      /**
+      * Pages written by the update in progress.
+      */
+      std::set < u_int32_t > updatePages;
+
+      /**
+      * Initializes the log fields.
+      *
+      * @param fName The name of the data file.
+      */
+      void InitLog(const char * fName);
+
+      /**
+      * Replays the committed updates of the log, if any, and truncates it.
+      */
+      void Recover();
+
+      /**
+      * Appends the update in progress to the log.
+      */
+      void CommitUpdate();
+
+      /**
+      * Returns the number of bytes of the header page that must be logged.
+      * The unused tail of the page is not logged.
+      */
+      u_int32_t GetHeaderLogSize();
+
+      /**
+      * Writes a buffer at the given offset of a file.
+      *
+      * @param fileDesc The file descriptor.
+      * @param offset The offset.
+      * @param data The buffer.
+      * @param size The size of the buffer.
+      */
+      static void WriteAt(int fileDesc, off_t offset, const void * data,
+            u_int32_t size);
+
+      /**
+      * Computes the checksum of a buffer.
+      *
+      * @param data The buffer.
+      * @param size The size of the buffer.
+      */
+      static u_int32_t Checksum(const unsigned char * data, u_int32_t size);
+
       /**
       * Creates the header for an empty file.
       *
@@ -61,6 +61,17 @@ class stQueryHint{
       */
       int GetHintType() const { return type; }     
 
+   protected:
+
+      /**
+      * Creates a new hint of a given type. Only the subclasses create hints.
+      *
+      * @param type The hint type.
+      */
+      stQueryHint(int type = 0){
+         this->type = type;
+      }//end stQueryHint
+
    private:
 
       /**
@@ -0,0 +1,409 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file defines the class stQueryStats.
+*
+* @version 1.0
+*/
+#ifndef __STQUERYSTATS_H
+#define __STQUERYSTATS_H
+
+#include <arboretum/stCommon.h>
+
+#include <ostream>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+/**
+* Records an event in a stQueryStats that may be NULL. It expands to nothing
+* unless __stQUERYSTATS__ is defined, so the queries pay nothing for their
+* profiling when it is not compiled.
+*
+* @param stats The statistics.
+* @param call The method of stQueryStats to be called.
+*/
+#ifdef __stQUERYSTATS__
+   #define STQUERYSTATS(stats, call) if ((stats) != NULL){ (stats)->call; }
+#else
+   #define STQUERYSTATS(stats, call)
+#endif //__stQUERYSTATS__
+
+//=============================================================================
+// Class stQueryStats
+//-----------------------------------------------------------------------------
+/**
+* This class holds the profile of a query: the nodes visited in each level,
+* the entries pruned by the distance stored with them (the distance to the
+* representative of their node), by the global pivots or by their real
+* distance to the query center, the distances computed, the filter calls and
+* rejections, the peak size of the priority queue, the bytes of objects
+* decoded and the wall time spent in each phase.
+*
+* <P>Each query writes its own instance. Merge() adds the counters of another
+* instance under a lock, so several threads may accumulate the profiles of
+* their queries in a shared instance. The statistics can be written as JSON
+* or as CSV rows.
+*
+* @version 1.0
+* @see stSlimTree::SetQueryStats()
+* @ingroup struct
+*/
+class stQueryStats{
+   public:
+      /**
+      * Phases of a query.
+      */
+      enum tPhase{
+         /**
+         * Reading the pages.
+         */
+         phREAD = 0,
+
+         /**
+         * Evaluating the entries of index nodes.
+         */
+         phINDEX = 1,
+
+         /**
+         * Evaluating the entries of leaf nodes.
+         */
+         phLEAF = 2,
+
+         /**
+         * The whole query.
+         */
+         phTOTAL = 3,
+
+         /**
+         * Number of phases.
+         */
+         phCOUNT = 4
+      };//end tPhase
+
+      /**
+      * Creates a new empty instance.
+      */
+      stQueryStats();
+
+      /**
+      * Clears all counters.
+      */
+      void Reset();
+
+      /**
+      * Adds a query profiled.
+      */
+      void AddQuery(){
+         QueryCount++;
+      }//end AddQuery
+
+      /**
+      * Adds a node visited.
+      *
+      * @param level The level of the node. The root is at level 0.
+      */
+      void AddNode(u_int32_t level){
+         if (level >= NodesPerLevel.size()){
+            NodesPerLevel.resize(level + 1, 0);
+         }//end if
+         NodesPerLevel[level]++;
+      }//end AddNode
+
+      /**
+      * Adds an entry pruned by the distance to the representative of its node.
+      */
+      void AddPrunedByParent(){
+         PrunedByParent++;
+      }//end AddPrunedByParent
+
+      /**
+      * Adds an entry pruned by the global pivots.
+      */
+      void AddPrunedByPivots(){
+         PrunedByPivots++;
+      }//end AddPrunedByPivots
+
+      /**
+      * Adds an entry pruned by its distance to the query center.
+      */
+      void AddPrunedByDistance(){
+         PrunedByDistance++;
+      }//end AddPrunedByDistance
+
+      /**
+      * Adds the distances computed.
+      *
+      * @param count The number of distances.
+      */
+      void AddDistance(u_int32_t count = 1){
+         DistanceCalls += count;
+      }//end AddDistance
+
+      /**
+      * Adds a filter call.
+      *
+      * @param passed The result of the filter.
+      */
+      void AddFilter(bool passed){
+         FilterCalls++;
+         if (!passed){
+            FilterRejections++;
+         }//end if
+      }//end AddFilter
+
+      /**
+      * Updates the peak size of the priority queue.
+      *
+      * @param size The current size of the queue.
+      */
+      void UpdateQueue(u_int32_t size){
+         if (size > QueuePeak){
+            QueuePeak = size;
+         }//end if
+      }//end UpdateQueue
+
+      /**
+      * Adds the bytes of an object decoded.
+      *
+      * @param size The size of the serialized object.
+      */
+      void AddBytesDecoded(u_int32_t size){
+         BytesDecoded += size;
+      }//end AddBytesDecoded
+
+      /**
+      * Starts timing a phase.
+      *
+      * @param phase The phase.
+      */
+      void StartPhase(tPhase phase){
+         PhaseStart[phase] = std::chrono::steady_clock::now();
+      }//end StartPhase
+
+      /**
+      * Stops timing a phase started by StartPhase() and adds the time elapsed
+      * to it.
+      *
+      * @param phase The phase.
+      */
+      void StopPhase(tPhase phase){
+         PhaseTime[phase] += std::chrono::duration_cast <
+               std::chrono::nanoseconds >(std::chrono::steady_clock::now() -
+               PhaseStart[phase]).count();
+      }//end StopPhase
+
+      /**
+      * Returns the number of levels with visited nodes.
+      */
+      u_int32_t GetNumberOfLevels(){
+         return NodesPerLevel.size();
+      }//end GetNumberOfLevels
+
+      /**
+      * Returns the number of nodes visited in a level.
+      *
+      * @param level The level.
+      */
+      u_int64_t GetNodes(u_int32_t level){
+         return (level < NodesPerLevel.size()) ? NodesPerLevel[level] : 0;
+      }//end GetNodes
+
+      /**
+      * Returns the number of nodes visited in all levels.
+      */
+      u_int64_t GetNodes();
+
+      /**
+      * Returns the number of entries pruned by the distance to the
+      * representative of their nodes.
+      */
+      u_int64_t GetPrunedByParent(){
+         return PrunedByParent;
+      }//end GetPrunedByParent
+
+      /**
+      * Returns the number of entries pruned by the global pivots.
+      */
+      u_int64_t GetPrunedByPivots(){
+         return PrunedByPivots;
+      }//end GetPrunedByPivots
+
+      /**
+      * Returns the number of entries pruned by their distances to the query
+      * center.
+      */
+      u_int64_t GetPrunedByDistance(){
+         return PrunedByDistance;
+      }//end GetPrunedByDistance
+
+      /**
+      * Returns the number of distances computed.
+      */
+      u_int64_t GetDistanceCalls(){
+         return DistanceCalls;
+      }//end GetDistanceCalls
+
+      /**
+      * Returns the number of filter calls.
+      */
+      u_int64_t GetFilterCalls(){
+         return FilterCalls;
+      }//end GetFilterCalls
+
+      /**
+      * Returns the number of objects rejected by the filter.
+      */
+      u_int64_t GetFilterRejections(){
+         return FilterRejections;
+      }//end GetFilterRejections
+
+      /**
+      * Returns the peak size of the priority queue.
+      */
+      u_int32_t GetQueuePeak(){
+         return QueuePeak;
+      }//end GetQueuePeak
+
+      /**
+      * Returns the number of bytes of objects decoded.
+      */
+      u_int64_t GetBytesDecoded(){
+         return BytesDecoded;
+      }//end GetBytesDecoded
+
+      /**
+      * Returns the time spent in a phase in nanoseconds.
+      *
+      * @param phase The phase.
+      */
+      u_int64_t GetPhaseTime(tPhase phase){
+         return PhaseTime[phase];
+      }//end GetPhaseTime
+
+      /**
+      * Returns the number of queries profiled. It is 1 for the profile of a
+      * single query and the number of queries merged otherwise.
+      */
+      u_int32_t GetQueryCount(){
+         return QueryCount;
+      }//end GetQueryCount
+
+      /**
+      * Adds the counters of another instance to this one. The queue peak is
+      * the largest one. This method is thread safe.
+      *
+      * @param stats The other instance.
+      */
+      void Merge(stQueryStats & stats);
+
+      /**
+      * Writes the statistics as a JSON object.
+      *
+      * @param out The output stream.
+      */
+      void WriteJSON(std::ostream & out);
+
+      /**
+      * Writes the header of the CSV rows written by WriteCSV().
+      *
+      * @param out The output stream.
+      * @param levels The number of levels of the rows.
+      */
+      static void WriteCSVHeader(std::ostream & out, u_int32_t levels);
+
+      /**
+      * Writes the statistics as a CSV row. The nodes visited in each level
+      * are written in levels columns, so all rows of a file must use the same
+      * value.
+      *
+      * @param out The output stream.
+      * @param levels The number of levels. Use the height of the tree.
+      */
+      void WriteCSV(std::ostream & out, u_int32_t levels);
+
+   private:
+      /**
+      * Nodes visited in each level.
+      */
+      std::vector < u_int64_t > NodesPerLevel;
+
+      /**
+      * Entries pruned by the distance to the representative.
+      */
+      u_int64_t PrunedByParent;
+
+      /**
+      * Entries pruned by the global pivots.
+      */
+      u_int64_t PrunedByPivots;
+
+      /**
+      * Entries pruned by the distance to the query center.
+      */
+      u_int64_t PrunedByDistance;
+
+      /**
+      * Distances computed.
+      */
+      u_int64_t DistanceCalls;
+
+      /**
+      * Filter calls.
+      */
+      u_int64_t FilterCalls;
+
+      /**
+      * Objects rejected by the filter.
+      */
+      u_int64_t FilterRejections;
+
+      /**
+      * Peak size of the priority queue.
+      */
+      u_int32_t QueuePeak;
+
+      /**
+      * Bytes of objects decoded.
+      */
+      u_int64_t BytesDecoded;
+
+      /**
+      * Time spent in each phase in nanoseconds.
+      */
+      u_int64_t PhaseTime[phCOUNT];
+
+      /**
+      * Start of the current timing of each phase.
+      */
+      std::chrono::steady_clock::time_point PhaseStart[phCOUNT];
+
+      /**
+      * Number of queries profiled.
+      */
+      u_int32_t QueryCount;
+
+      /**
+      * Lock of Merge().
+      */
+      std::mutex Mutex;
+
+      /**
+      * Returns the name of a phase.
+      */
+      static const char * GetPhaseName(u_int32_t phase);
+};//end stQueryStats
+
+#endif //__STQUERYSTATS_H
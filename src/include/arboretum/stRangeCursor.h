@@ -0,0 +1,306 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file defines the class stRangeCursor.
+*
+* @version 1.0
+*/
+#ifndef __STRANGECURSOR_H
+#define __STRANGECURSOR_H
+
+#include <arboretum/stCommon.h>
+#include <arboretum/stPage.h>
+
+#include <vector>
+#include <memory>
+
+//=============================================================================
+// Class stRangeCursor
+//-----------------------------------------------------------------------------
+/**
+* This class implements the continuation token of the paged range queries of
+* the stSlimTree (ForwardRangeQuery() and BackwardRangeQuery()).
+*
+* <P>A cursor holds the frontier of a best-first traversal: the nodes and the
+* objects found but not visited yet, in the order they will be visited. The
+* next page resumes from it instead of traversing the tree again from the
+* root. It also keeps the last visited position (distance and OID), so a
+* cursor that can not be resumed (the tree was modified, as told by its
+* modification count) restarts as a keyset query from that position.
+*
+* <P>A cursor may be serialized with Serialize() and restored with
+* Unserialize(), so a stateless server may hand it to its clients. The sample
+* object is not part of the cursor and must be given again by each call.
+* The pages of a restored cursor are checked when they are read. If one of
+* them is not a node of the expected kind, the cursor restarts as a keyset
+* query from its position.
+*
+* @version 1.0
+* @ingroup struct
+*/
+class stRangeCursor{
+   public:
+      /**
+      * A node or an object of the frontier.
+      */
+      struct tItem{
+         /**
+         * The order of the item: the closest (forward) or farthest
+         * (backward) possible distance to the sample.
+         */
+         double Key;
+
+         /**
+         * The distance of the node representative or of the object.
+         */
+         double Distance;
+
+         /**
+         * The covering radius of the node or MAXDOUBLE for the root.
+         */
+         double Radius;
+
+         /**
+         * The page of the node or of the leaf holding the object.
+         */
+         u_int32_t PageID;
+
+         /**
+         * The entry of the object in its leaf.
+         */
+         u_int32_t Entry;
+
+         /**
+         * The OID of the object.
+         */
+         long OID;
+
+         /**
+         * True for an object.
+         */
+         bool Object;
+
+         /**
+         * A copy of the leaf holding the object, shared by its objects. It
+         * is NULL after Unserialize().
+         */
+         std::shared_ptr < stPage > Leaf;
+      };
+
+      /**
+      * Creates a new cursor at the start of a query.
+      *
+      * @param internalRadius The internal radius of the query.
+      * @param externalRadius The external radius of the query.
+      * @param oid The OID of the last object of the previous query. The
+      * objects at internalRadius (forward) or externalRadius (backward) are
+      * taken only after it.
+      */
+      stRangeCursor(double internalRadius = 0, double externalRadius = MAXDOUBLE,
+            long oid = MAXLONG);
+
+      /**
+      * Returns the internal radius. In a forward query, it is the distance
+      * of the last visited object.
+      */
+      double GetInternalRadius(){
+         return InternalRadius;
+      }//end GetInternalRadius
+
+      /**
+      * Returns the external radius. In a backward query, it is the distance
+      * of the last visited object.
+      */
+      double GetExternalRadius(){
+         return ExternalRadius;
+      }//end GetExternalRadius
+
+      /**
+      * Returns the OID of the last visited object.
+      */
+      long GetOID(){
+         return OID;
+      }//end GetOID
+
+      /**
+      * Returns true if the cursor goes from the external to the internal
+      * radius.
+      */
+      bool IsBackward(){
+         return Backward;
+      }//end IsBackward
+
+      /**
+      * Returns true if a query already used this cursor.
+      */
+      bool IsStarted(){
+         return Started;
+      }//end IsStarted
+
+      /**
+      * Returns true if all objects were visited.
+      */
+      bool IsFinished(){
+         return (Started) && (Queue.empty());
+      }//end IsFinished
+
+      /**
+      * Returns true if this cursor was started on a tree with the given root,
+      * number of objects and modification count.
+      */
+      bool IsValid(u_int32_t root, long numberOfObjects, u_int32_t modification){
+         return (Started) && (Root == root) &&
+               (NumberOfObjects == numberOfObjects) &&
+               (Modification == modification);
+      }//end IsValid
+
+      /**
+      * Clears the frontier and starts a traversal in a given direction from
+      * the last visited position.
+      *
+      * @param backward The direction.
+      * @param root The root of the tree.
+      * @param numberOfObjects The number of objects of the tree.
+      * @param modification The modification count of the tree.
+      */
+      void Start(bool backward, u_int32_t root, long numberOfObjects,
+            u_int32_t modification);
+
+      /**
+      * Returns true if the frontier is empty.
+      */
+      bool IsEmpty(){
+         return Queue.empty();
+      }//end IsEmpty
+
+      /**
+      * Returns the number of items of the frontier.
+      */
+      u_int32_t GetSize(){
+         return Queue.size();
+      }//end GetSize
+
+      /**
+      * Adds an item to the frontier.
+      */
+      void Push(const tItem & item);
+
+      /**
+      * Removes the next item of the frontier.
+      *
+      * @param item The item (output).
+      * @warning The frontier must not be empty.
+      */
+      void Pop(tItem & item);
+
+      /**
+      * Moves the cursor after a visited object.
+      *
+      * @param distance The distance of the object.
+      * @param oid The OID of the object.
+      */
+      void SetLast(double distance, long oid);
+
+      /**
+      * Returns true if an object is after the position of the cursor and
+      * within both radii.
+      *
+      * @param distance The distance of the object.
+      * @param oid The OID of the object.
+      */
+      bool Qualifies(double distance, long oid);
+
+      /**
+      * Returns the size of the serialized cursor.
+      */
+      u_int32_t GetSerializedSize();
+
+      /**
+      * Returns the serialized cursor.
+      *
+      * @warning The returned buffer is valid until this cursor is changed.
+      */
+      const unsigned char * Serialize();
+
+      /**
+      * Restores a serialized cursor.
+      *
+      * @param data The serialized cursor.
+      * @param datasize Its size.
+      * @return False if data is not a valid cursor. This cursor is reset to
+      * a new one in this case.
+      */
+      bool Unserialize(const unsigned char * data, u_int32_t datasize);
+
+   private:
+      /**
+      * The frontier, a heap ordered by Before().
+      */
+      std::vector < tItem > Queue;
+
+      /**
+      * The internal radius.
+      */
+      double InternalRadius;
+
+      /**
+      * The external radius.
+      */
+      double ExternalRadius;
+
+      /**
+      * The OID of the last visited object.
+      */
+      long OID;
+
+      /**
+      * The direction.
+      */
+      bool Backward;
+
+      /**
+      * True after Start().
+      */
+      bool Started;
+
+      /**
+      * The root of the tree.
+      */
+      u_int32_t Root;
+
+      /**
+      * The number of objects of the tree.
+      */
+      long NumberOfObjects;
+
+      /**
+      * The modification count of the tree.
+      */
+      u_int32_t Modification;
+
+      /**
+      * The buffer of Serialize().
+      */
+      std::vector < unsigned char > Serialized;
+
+      /**
+      * Returns true if a must be visited before b. Nodes come before objects
+      * at the same key, so all objects at a given distance are known before
+      * the first one is visited.
+      */
+      bool Before(const tItem & a, const tItem & b);
+};//end stRangeCursor
+
+#endif //__STRANGECURSOR_H
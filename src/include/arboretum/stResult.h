@@ -24,6 +24,7 @@
 #define __STRESULT_H
 
 #include <vector>
+#include <arboretum/stQueryStats.h>
 
 
 
@@ -156,7 +157,12 @@ enum tQueryType{
    /**
    * This is a result of a total order between query.
    */
-   TO_BETWEENQUERY = 24
+   TO_BETWEENQUERY = 24,
+
+   /**
+   * This is a result of a reverse k-nearest neighbor query.
+   */
+   REVERSEKNEARESTQUERY = 25
 };//end tQueryType
 
 //----------------------------------------------------------------------------
@@ -410,10 +416,20 @@ class stBasicResult{
       */
       typedef ObjectType tObject;
 
+      /**
+      * Creates a new instance without query statistics.
+      */
+      stBasicResult(){
+         QueryStats = NULL;
+      }//end stBasicResult
+
       /**
       * This method disposes this instance and releases all allocated resources.
       */
       virtual ~stBasicResult(){
+         if (QueryStats != NULL){
+            delete QueryStats;
+         }//end if
       }//end ~stBasicResult
 
       /**
@@ -457,6 +473,30 @@ class stBasicResult{
          return Tie;
       }//end GetTie
 
+      /**
+      * Gets the profile of the query that built this result. It is an
+      * optional information, available only if the query was profiled.
+      *
+      * @return The profile or NULL.
+      * @warning Do not dispose the returned object.
+      */
+      stQueryStats * GetQueryStats(){
+         return QueryStats;
+      }//end GetQueryStats
+
+      /**
+      * Sets the profile of the query. This instance claims the ownership of
+      * the given object.
+      *
+      * @param stats The profile.
+      */
+      void SetQueryStats(stQueryStats * stats){
+         if (QueryStats != NULL){
+            delete QueryStats;
+         }//end if
+         QueryStats = stats;
+      }//end SetQueryStats
+
    protected:
 
       /**
@@ -487,6 +527,11 @@ class stBasicResult{
       */
       double InnerRadius;
 
+      /**
+      * Profile of the query (Optional).
+      */
+      stQueryStats * QueryStats;
+
 };//end stBasicResult
 
 #ifdef _DEPRECATED_VECTOR_RESULT
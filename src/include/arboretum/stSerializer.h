@@ -0,0 +1,212 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file defines the class template stSerializer, the adapter between the
+* metric trees and the serialization methods of the user objects.
+*
+* @version 1.0
+*/
+#ifndef __STSERIALIZER_H
+#define __STSERIALIZER_H
+
+#include <arboretum/stCommon.h>
+
+#include <string.h>
+#include <type_traits>
+#include <utility>
+
+//==============================================================================
+// Class template stSerializer
+//------------------------------------------------------------------------------
+/**
+* This class template writes objects directly into node pages and reads them
+* back without intermediate buffers.
+*
+* <P>The object may optionally implement the serialize-into-buffer protocol:
+*
+* <pre>
+*    size_t SerializeInto(uint8_t * dst, size_t cap);
+*    size_t IncludedSerializeInto(uint8_t * dst, size_t cap);
+*    void UnserializeFrom(const uint8_t * data, size_t datasize);
+*    void IncludedUnserializeFrom(const uint8_t * data, size_t datasize);
+* </pre>
+*
+* <P>SerializeInto() writes the same bytes returned by Serialize() into dst
+* and returns the number of bytes written, or 0 if cap is not large enough.
+* UnserializeFrom() has the same semantics of Unserialize() but is expected
+* to reuse the memory already owned by the object. The Included versions do
+* the same for the IncludedSerialize() form used by the leaves of the
+* Slim-tree.
+*
+* <P>Each method of this protocol is detected at compile time. Objects that
+* do not implement it are handled by the old pointer-returning API
+* (Serialize(), IncludedSerialize(), Unserialize() and IncludedUnserialize()),
+* so existing user objects work unchanged.
+*
+* @version 1.0
+* @see stObject
+* @ingroup struct
+*/
+template <class ObjectType>
+class stSerializer{
+   private:
+      template <class T, class = void>
+      struct tHasSerializeInto: std::false_type{};
+
+      template <class T>
+      struct tHasSerializeInto<T, std::void_t<decltype(std::declval<T &>().
+            SerializeInto((unsigned char *) 0, (u_int32_t) 0))> >: std::true_type{};
+
+      template <class T, class = void>
+      struct tHasIncludedSerializeInto: std::false_type{};
+
+      template <class T>
+      struct tHasIncludedSerializeInto<T, std::void_t<decltype(std::declval<T &>().
+            IncludedSerializeInto((unsigned char *) 0, (u_int32_t) 0))> >: std::true_type{};
+
+      template <class T, class = void>
+      struct tHasUnserializeFrom: std::false_type{};
+
+      template <class T>
+      struct tHasUnserializeFrom<T, std::void_t<decltype(std::declval<T &>().
+            UnserializeFrom((const unsigned char *) 0, (u_int32_t) 0))> >: std::true_type{};
+
+      template <class T, class = void>
+      struct tHasIncludedUnserializeFrom: std::false_type{};
+
+      template <class T>
+      struct tHasIncludedUnserializeFrom<T, std::void_t<decltype(std::declval<T &>().
+            IncludedUnserializeFrom((const unsigned char *) 0, (u_int32_t) 0))> >: std::true_type{};
+
+   public:
+      /**
+      * Writes the serialized form of obj into dst.
+      *
+      * @param obj The object.
+      * @param dst The destination buffer.
+      * @param cap The capacity of dst.
+      * @return The number of bytes written or 0 if dst is too small.
+      */
+      static u_int32_t SerializeInto(ObjectType * obj, unsigned char * dst,
+                                     u_int32_t cap){
+         if constexpr (tHasSerializeInto<ObjectType>::value){
+            return obj->SerializeInto(dst, cap);
+         }else{
+            u_int32_t size = obj->GetSerializedSize();
+
+            if (size > cap){
+               return 0;
+            }//end if
+            memcpy(dst, obj->Serialize(), size);
+            return size;
+         }//end if
+      }//end SerializeInto
+
+      /**
+      * Writes the included serialized form of obj into dst.
+      *
+      * @param obj The object.
+      * @param dst The destination buffer.
+      * @param cap The capacity of dst.
+      * @return The number of bytes written or 0 if dst is too small.
+      */
+      static u_int32_t IncludedSerializeInto(ObjectType * obj,
+            unsigned char * dst, u_int32_t cap){
+         if constexpr (tHasIncludedSerializeInto<ObjectType>::value){
+            return obj->IncludedSerializeInto(dst, cap);
+         }else{
+            u_int32_t size = obj->GetIncludedSerializedSize();
+
+            if (size > cap){
+               return 0;
+            }//end if
+            memcpy(dst, obj->IncludedSerialize(), size);
+            return size;
+         }//end if
+      }//end IncludedSerializeInto
+
+      /**
+      * Rebuilds obj from its serialized form.
+      *
+      * @param obj The object.
+      * @param data The serialized object.
+      * @param datasize The size of data.
+      */
+      static void UnserializeFrom(ObjectType * obj, const unsigned char * data,
+                                  u_int32_t datasize){
+         if constexpr (tHasUnserializeFrom<ObjectType>::value){
+            obj->UnserializeFrom(data, datasize);
+         }else{
+            obj->Unserialize(data, datasize);
+         }//end if
+      }//end UnserializeFrom
+
+      /**
+      * Rebuilds obj from its included serialized form.
+      *
+      * @param obj The object.
+      * @param data The serialized object.
+      * @param datasize The size of data.
+      */
+      static void IncludedUnserializeFrom(ObjectType * obj,
+            const unsigned char * data, u_int32_t datasize){
+         if constexpr (tHasIncludedUnserializeFrom<ObjectType>::value){
+            obj->IncludedUnserializeFrom(data, datasize);
+         }else{
+            obj->IncludedUnserialize(data, datasize);
+         }//end if
+      }//end IncludedUnserializeFrom
+
+      /**
+      * Adds a new entry holding obj to a node. The object is serialized
+      * directly into the page. NodeType must provide AddEntry(size) and
+      * GetObjectBuffer(idx).
+      *
+      * @param node The node.
+      * @param obj The object.
+      * @return The index of the new entry or -1 if it does not fit.
+      */
+      template <class NodeType>
+      static int AddEntry(NodeType * node, ObjectType * obj){
+         u_int32_t size = obj->GetSerializedSize();
+         int idx = node->AddEntry(size);
+
+         if (idx >= 0){
+            SerializeInto(obj, node->GetObjectBuffer(idx), size);
+         }//end if
+         return idx;
+      }//end AddEntry
+
+      /**
+      * Adds a new entry holding the included serialized form of obj to a
+      * node. See AddEntry().
+      *
+      * @param node The node.
+      * @param obj The object.
+      * @return The index of the new entry or -1 if it does not fit.
+      */
+      template <class NodeType>
+      static int AddIncludedEntry(NodeType * node, ObjectType * obj){
+         u_int32_t size = obj->GetIncludedSerializedSize();
+         int idx = node->AddEntry(size);
+
+         if (idx >= 0){
+            IncludedSerializeInto(obj, node->GetObjectBuffer(idx), size);
+         }//end if
+         return idx;
+      }//end AddIncludedEntry
+};//end stSerializer
+
+#endif //__STSERIALIZER_H
@@ -0,0 +1,129 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file defines the class stSharedPageCache.
+*
+* @version 1.0
+*/
+#ifndef __STSHAREDPAGECACHE_H
+#define __STSHAREDPAGECACHE_H
+
+#include <arboretum/stCommon.h>
+#include <arboretum/stPage.h>
+#include <arboretum/stPageManager.h>
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <utility>
+
+//=============================================================================
+// Class stSharedPageCache
+//-----------------------------------------------------------------------------
+/**
+* This class implements a read only LRU cache of pages shared by the threads
+* of an operation that reads pages of one or more page managers, like the
+* joins of the stSlimTree.
+*
+* <P>The cache holds copies of the pages. A page is read from its page
+* manager (and released right away) only on a miss and it stays valid for the
+* threads using it even after it is evicted. Since all reads go through the
+* lock of the cache, the page managers are never used by two threads at the
+* same time.
+*
+* @version 1.0
+* @ingroup storage
+*/
+class stSharedPageCache{
+   public:
+      /**
+      * A page of the cache.
+      */
+      typedef std::shared_ptr < stPage > tPage;
+
+      /**
+      * Creates a new cache.
+      *
+      * @param capacity The maximum number of pages kept.
+      */
+      stSharedPageCache(u_int32_t capacity);
+
+      /**
+      * Returns a page, reading it if it is not in the cache.
+      *
+      * @param pageManager The page manager.
+      * @param pageID The ID of the page.
+      * @warning The page must not be modified.
+      */
+      tPage Get(stPageManager * pageManager, u_int32_t pageID);
+
+      /**
+      * Returns the number of pages found in the cache.
+      */
+      u_int64_t GetHitCount(){
+         return HitCount;
+      }//end GetHitCount
+
+      /**
+      * Returns the number of pages read from the page managers.
+      */
+      u_int64_t GetMissCount(){
+         return MissCount;
+      }//end GetMissCount
+
+   private:
+      /**
+      * The key of a page.
+      */
+      typedef std::pair < stPageManager *, u_int32_t > tKey;
+
+      /**
+      * The pages, the most recently used first.
+      */
+      typedef std::list < std::pair < tKey, tPage > > tPages;
+
+      /**
+      * The pages.
+      */
+      tPages Pages;
+
+      /**
+      * The position of each page in Pages.
+      */
+      std::map < tKey, tPages::iterator > Index;
+
+      /**
+      * The maximum number of pages.
+      */
+      u_int32_t Capacity;
+
+      /**
+      * Number of hits.
+      */
+      u_int64_t HitCount;
+
+      /**
+      * Number of misses.
+      */
+      u_int64_t MissCount;
+
+      /**
+      * Guards all fields.
+      */
+      std::mutex Mutex;
+};//end stSharedPageCache
+
+#endif //__STSHAREDPAGECACHE_H
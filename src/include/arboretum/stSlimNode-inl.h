@@ -28,7 +28,7 @@ template <class ObjectType>
 stSlimMemLeafNode< ObjectType >::stSlimMemLeafNode(stSlimLeafNode * leafNode){
    u_int32_t idx;
    u_int32_t numberOfEntries;
-   ObjectType * obj;
+   stSlimMemNodeEntry entry;
 
    numberOfEntries = leafNode->GetNumberOfEntries();
    // Get the information to be ajust.
@@ -42,11 +42,20 @@ stSlimMemLeafNode< ObjectType >::stSlimMemLeafNode(stSlimLeafNode * leafNode){
 
    // insert the entries of leafNode.
    for (idx = 0; idx < numberOfEntries; idx++){
-      obj = new ObjectType();
+      entry.Object = new ObjectType();
       // Get the first object in leafNode.
-      obj->Unserialize(leafNode->GetObject(idx), leafNode->GetObjectSize(idx));
+      stSerializer<ObjectType>::IncludedUnserializeFrom(entry.Object,
+            leafNode->GetObject(idx), leafNode->GetObjectSize(idx));
       // Add data.
-      this->Add(obj, leafNode->GetLeafEntry(idx).Distance);
+      entry.Distance = leafNode->GetLeafEntry(idx).Distance;
+      #ifdef __stSLIMPIVOTS__
+         memcpy(entry.PivotDistance, leafNode->GetLeafEntry(idx).PivotDistance,
+                sizeof(entry.PivotDistance));
+      #endif //__stSLIMPIVOTS__
+      #ifdef __stSLIMRKNN__
+         entry.KNNDistance = leafNode->GetLeafEntry(idx).KNNDistance;
+      #endif //__stSLIMRKNN__
+      this->Insert(entry);
    }//end while
 
    // remove the entry from the leafNode.
@@ -64,7 +73,7 @@ stSlimLeafNode * stSlimMemLeafNode< ObjectType >::ReleaseNode(){
       // Get a object in idx.
       obj = this->ObjectAt(idx);
       // insert this entry in srcLeafNode.
-      insertIdx = srcLeafNode->AddEntry(obj->GetSerializedSize(), obj->Serialize());
+      insertIdx = stSerializer<ObjectType>::AddIncludedEntry(srcLeafNode, obj);
 
       // if there is some problem in insertion.
       #ifdef __stDEBUG__
@@ -74,6 +83,13 @@ stSlimLeafNode * stSlimMemLeafNode< ObjectType >::ReleaseNode(){
       #endif //__stDEBUG__
       // Fill entry's fields
       srcLeafNode->GetLeafEntry(insertIdx).Distance = this->DistanceAt(idx);
+      #ifdef __stSLIMPIVOTS__
+         memcpy(srcLeafNode->GetLeafEntry(insertIdx).PivotDistance,
+                Entries[idx].PivotDistance, sizeof(Entries[idx].PivotDistance));
+      #endif //__stSLIMPIVOTS__
+      #ifdef __stSLIMRKNN__
+         srcLeafNode->GetLeafEntry(insertIdx).KNNDistance = Entries[idx].KNNDistance;
+      #endif //__stSLIMRKNN__
    }//end for
 
    // release the resources.
@@ -93,7 +109,7 @@ stSlimLeafNode * stSlimMemLeafNode< ObjectType >::ReleaseNode(){
 //------------------------------------------------------------------------------
 template <class ObjectType>
 bool stSlimMemLeafNode< ObjectType >::Add(ObjectType * obj, double distance){
-   int insertIdx, idx;
+   stSlimMemNodeEntry entry;
 
    #ifdef __stDEBUG__
       if (obj == NULL){
@@ -107,33 +123,47 @@ bool stSlimMemLeafNode< ObjectType >::Add(ObjectType * obj, double distance){
       return false;
    }//end if
 
-   // if there is free entry to store the new entry.
-   if (this->capacity <= this->numEntries){
-      // resize the entries.
-      this->Resize();
+   // The other distances of a new entry are unknown.
+   entry.Object = obj;
+   entry.Distance = distance;
+   #ifdef __stSLIMPIVOTS__
+      for (u_int32_t i = 0; i < STSLIMPIVOTS; i++){
+         entry.PivotDistance[i] = -1;
+      }//end for
+   #endif //__stSLIMPIVOTS__
+   #ifdef __stSLIMRKNN__
+      entry.KNNDistance = -1;
+   #endif //__stSLIMRKNN__
+   this->Insert(entry);
+
+   return true;
+}//end stSlimMemLeafNode::Add()
+
+//------------------------------------------------------------------------------
+template <class ObjectType>
+bool stSlimMemLeafNode< ObjectType >::MoveLastTo(stSlimMemLeafNode * dst,
+      double distance){
+   stSlimMemNodeEntry entry;
+
+   #ifdef __stDEBUG__
+      if (this->numEntries==0){
+         throw std::logic_error("There is no object.");
+      }//end if
+   #endif //__stDEBUG__
+
+   // Does it fit ?
+   if (!dst->CanAdd(this->LastObject())){
+      return false;
    }//end if
-   
-   // Look the right position to insert the new object.
-   insertIdx = InsertPosition(distance);
-   // Get the number of entries.
-   idx = this->numEntries;
-   // Lets move the data, according to insertIdx.
-   while (insertIdx != idx){
-      idx--;
-      Entries[idx+1].Distance = Entries[idx].Distance;
-      Entries[idx+1].Object = Entries[idx].Object;
-   }//end while
-   // add the new entry in the right position.
-   Entries[idx].Distance = distance;
-   Entries[idx].Object = obj;
 
-   // Update # of Entries
-   this->numEntries++; // One more!
-   // Update the usedSize
-   this->usedSize += obj->GetSerializedSize() + stSlimLeafNode::GetLeafEntryOverhead();
+   // Move the entry with all its distances.
+   entry = Entries[this->numEntries-1];
+   entry.Distance = distance;
+   this->PopObject();
+   dst->Insert(entry);
 
    return true;
-}//end stSlimMemLeafNode::Add()
+}//end stSlimMemLeafNode::MoveLastTo()
 
 //------------------------------------------------------------------------------
 template <class ObjectType>
@@ -147,19 +177,18 @@ ObjectType * stSlimMemLeafNode< ObjectType >::Remove(u_int32_t idx){
    #endif //__stDEBUG__
 
    // copy the entry.
-   returnObject = this->GetObject(idx);
+   returnObject = this->ObjectAt(idx);
 
    // Lets move the data, according to idx.
    while (idx < (this->numEntries - 1)){
-      Entries[idx].Distance = Entries[idx+1].Distance;
-      Entries[idx].Object = Entries[idx+1].Object;
+      Entries[idx] = Entries[idx+1];
       idx++;
    }//end while
 
    // Update # of Entries
    this->numEntries--; // One less!
    // Update the usedSize
-   this->usedSize -= (returnObject->GetSerializedSize() +
+   this->usedSize -= (returnObject->GetIncludedSerializedSize() +
                       stSlimLeafNode::GetLeafEntryOverhead());
    // return the removed entry.
    return returnObject;
@@ -181,7 +210,7 @@ ObjectType * stSlimMemLeafNode< ObjectType >::PopObject(){
    // Update # of Entries
    this->numEntries--; // One less!
    // Update the usedSize
-   this->usedSize -= (returnObject->GetSerializedSize() +
+   this->usedSize -= (returnObject->GetIncludedSerializedSize() +
                       stSlimLeafNode::GetLeafEntryOverhead());
    // return the removed entry.
    return returnObject;
@@ -212,6 +241,36 @@ int stSlimMemLeafNode< ObjectType >::InsertPosition(double distance){
    return idx;
 }//end stSlimMemLeafNode::InsertPosition()
 
+//------------------------------------------------------------------------------
+template <class ObjectType>
+void stSlimMemLeafNode< ObjectType >::Insert(const stSlimMemNodeEntry & entry){
+   int insertIdx, idx;
+
+   // if there is free entry to store the new entry.
+   if (this->capacity <= this->numEntries){
+      // resize the entries.
+      this->Resize();
+   }//end if
+
+   // Look the right position to insert the new object.
+   insertIdx = InsertPosition(entry.Distance);
+   // Get the number of entries.
+   idx = this->numEntries;
+   // Lets move the data, according to insertIdx.
+   while (insertIdx != idx){
+      idx--;
+      Entries[idx+1] = Entries[idx];
+   }//end while
+   // add the new entry in the right position.
+   Entries[idx] = entry;
+
+   // Update # of Entries
+   this->numEntries++; // One more!
+   // Update the usedSize
+   this->usedSize += entry.Object->GetIncludedSerializedSize() +
+         stSlimLeafNode::GetLeafEntryOverhead();
+}//end stSlimMemLeafNode::Insert()
+
 //------------------------------------------------------------------------------
 template <class ObjectType>
 void stSlimMemLeafNode< ObjectType >::Resize(u_int32_t incSize){
@@ -27,7 +27,26 @@
 #define __STSLIMNODE_H
 
 #include <arboretum/stPage.h>
+#include <arboretum/stSerializer.h>
 #include <stdexcept>
+#include <cstddef>
+#include <string.h>
+
+// Global pivots of the Slim-tree leaves. When __stSLIMPIVOTS__ is defined,
+// each leaf entry also stores its distances to STSLIMPIVOTS global pivots
+// (see stSlimTree::SetPivots()). It changes the layout of the leaves, so the
+// library and the application must be compiled with the same setting.
+#ifdef __stSLIMPIVOTS__
+   #ifndef STSLIMPIVOTS
+      #define STSLIMPIVOTS 4
+   #endif //STSLIMPIVOTS
+#endif //__stSLIMPIVOTS__
+
+// Reverse k-nearest neighbor support. When __stSLIMRKNN__ is defined, each
+// leaf entry also stores the distance to the k-th nearest neighbor of its
+// object and each index entry the maximum of these distances in its subtree
+// (see stSlimTree::SetKNNDistances()). Negative values mean unknown. Like
+// __stSLIMPIVOTS__, it changes the layout of the nodes.
 
 //-----------------------------------------------------------------------------
 // Class stSlimNode
@@ -144,6 +163,29 @@ class stSlimNode{
       */
       virtual int AddEntry(u_int32_t size, const unsigned char * object) = 0;
 
+      /**
+      * Adds a new entry with an uninitialized object of the given size. The
+      * object must be written using GetObjectBuffer() before the node is used.
+      * This allows the objects to be serialized directly into the page.
+      *
+      * @param size The size of the object in bytes.
+      * @return The position in the vector Entries or a negative value if
+      * the object does not fit.
+      * @see GetObjectBuffer()
+      */
+      virtual int AddEntry(u_int32_t size) = 0;
+
+      /**
+      * Gets the writable area of the serialized object of an entry.
+      *
+      * @param idx The idx of the entry.
+      * @warning The parameter idx is not verified by this implementation
+      * unless __stDEBUG__ is defined at compile time.
+      * @return A pointer to the serialized object.
+      * @see AddEntry()
+      */
+      virtual unsigned char * GetObjectBuffer(u_int32_t idx) = 0;
+
       /**
       * Gets the serialized object. Use GetObjectSize to determine the size of
       * the object.
@@ -222,6 +264,8 @@ class stSlimNode{
       
       
    protected:
+      friend class stSlimNodeView;
+
       /**
       * This is the structure of the Header of a SlimTree node.
       */
@@ -330,6 +374,14 @@ class stSlimIndexNode: public stSlimNode{
          * THIS NODE.
          */
          u_int32_t Offset;
+
+         #ifdef __stSLIMRKNN__
+            /**
+            * Maximum k-th nearest neighbor distance of the objects in the
+            * sub-tree or a negative value if it is unknown.
+            */
+            double MaxKNNDistance;
+         #endif //__stSLIMRKNN__
       } stSlimIndexEntry; //end stIndexEntry
       #pragma pack()
 
@@ -411,6 +463,16 @@ class stSlimIndexNode: public stSlimNode{
       */
       virtual int AddEntry(u_int32_t size, const unsigned char * object);
 
+      /**
+      * Adds a new entry with an uninitialized object of the given size.
+      *
+      * @param size The size of the object in bytes.
+      * @return The position in the vector Entries or a negative value if
+      * the object does not fit.
+      * @see GetObjectBuffer()
+      */
+      virtual int AddEntry(u_int32_t size);
+
       /**
       * Returns the entry idx that hold the representaive object.
       */
@@ -428,6 +490,17 @@ class stSlimIndexNode: public stSlimNode{
       */
       const unsigned char * GetObject(u_int32_t idx);
 
+      /**
+      * Gets the writable area of the serialized object of an entry.
+      *
+      * @param idx The idx of the entry.
+      * @return A pointer to the serialized object.
+      * @see AddEntry()
+      */
+      unsigned char * GetObjectBuffer(u_int32_t idx){
+         return Page->GetData() + Entries[idx].Offset;
+      }//end GetObjectBuffer
+
       /**
       * Returns the size of the object. Use GetObject() to get the object data.
       *
@@ -534,6 +607,22 @@ class stSlimLeafNode: public stSlimNode{
          * THIS NODE.
          */
          u_int32_t Offset;
+
+         #ifdef __stSLIMPIVOTS__
+            /**
+            * Distances to the global pivots of the tree. Only the first
+            * stSlimTree::GetNumberOfPivots() values are valid.
+            */
+            double PivotDistance[STSLIMPIVOTS];
+         #endif //__stSLIMPIVOTS__
+
+         #ifdef __stSLIMRKNN__
+            /**
+            * Distance to the k-th nearest neighbor of the object or a negative
+            * value if it is unknown.
+            */
+            double KNNDistance;
+         #endif //__stSLIMRKNN__
       } stSlimLeafEntry; //end stLeafEntry
       #pragma pack()
 
@@ -615,6 +704,16 @@ class stSlimLeafNode: public stSlimNode{
       */
       virtual int AddEntry(u_int32_t size, const unsigned char * object);
 
+      /**
+      * Adds a new entry with an uninitialized object of the given size.
+      *
+      * @param size The size of the object in bytes.
+      * @return The position in the vector Entries or a negative value if
+      * the object does not fit.
+      * @see GetObjectBuffer()
+      */
+      virtual int AddEntry(u_int32_t size);
+
       /**
       * Returns the entry idx that hold the representative object.
       * @return -1 if there is not a representative in the current node.
@@ -634,6 +733,17 @@ class stSlimLeafNode: public stSlimNode{
       */
       const unsigned char * GetObject(u_int32_t idx);
 
+      /**
+      * Gets the writable area of the serialized object of an entry.
+      *
+      * @param idx The idx of the entry.
+      * @return A pointer to the serialized object.
+      * @see AddEntry()
+      */
+      unsigned char * GetObjectBuffer(u_int32_t idx){
+         return Page->GetData() + Entries[idx].Offset;
+      }//end GetObjectBuffer
+
       /**
       * Returns the size of the object. Use GetObject() to get the object data.
       *
@@ -690,6 +800,242 @@ class stSlimLeafNode: public stSlimNode{
 
 };//end stSlimLeafNode
 
+//-----------------------------------------------------------------------------
+// Class stSlimNodeView
+//-----------------------------------------------------------------------------
+/**
+* This class is a read-mostly view of a SlimTree node (index or leaf) stored in
+* an stPage. Unlike stSlimNode::CreateNode(), it does not allocate anything and
+* has no virtual methods, so it may be created on the stack for each visited
+* node (or reused through SetPage()) by the query procedures.
+*
+* <P>It offers the same accessors of stSlimIndexNode and stSlimLeafNode used by
+* the traversals. GetIndexEntry() and GetLeafEntry() must only be used on nodes
+* of the matching type.
+*
+* @version 1.0
+* @see stSlimIndexNode
+* @see stSlimLeafNode
+* @ingroup slim
+*/
+class stSlimNodeView{
+   public:
+      /**
+      * Creates a new view. If page is NULL, SetPage() must be called before
+      * any other method.
+      *
+      * @param page The page that holds the node.
+      */
+      stSlimNodeView(stPage * page = NULL){
+         SetPage(page);
+      }//end stSlimNodeView
+
+      /**
+      * Points this view to another page.
+      *
+      * @param page The page that holds the node.
+      */
+      void SetPage(stPage * page){
+         Page = page;
+         if (page != NULL){
+            Header = (stSlimNode::stSlimNodeHeader *)(page->GetData());
+            Data = page->GetData() + sizeof(stSlimNode::stSlimNodeHeader);
+            if (Header->Type == stSlimNode::INDEX){
+               EntrySize = sizeof(stSlimIndexNode::stSlimIndexEntry);
+               OffsetPos = offsetof(stSlimIndexNode::stSlimIndexEntry, Offset);
+            }else{
+               EntrySize = sizeof(stSlimLeafNode::stSlimLeafEntry);
+               OffsetPos = offsetof(stSlimLeafNode::stSlimLeafEntry, Offset);
+            }//end if
+         }else{
+            Header = NULL;
+            Data = NULL;
+         }//end if
+      }//end SetPage
+
+      /**
+      * Returns the type of this node (stSlimNode::INDEX or stSlimNode::LEAF).
+      */
+      u_int16_t GetNodeType(){
+         return Header->Type;
+      }//end GetNodeType
+
+      /**
+      * Returns true if the page holds a well formed node: its type is known
+      * and the objects of its entries lie within the page, in order. It is
+      * meant for pages whose IDs do not come from the tree itself.
+      */
+      bool IsValid(){
+         u_int64_t end;
+         u_int32_t last;
+         u_int32_t offset;
+         u_int32_t i;
+
+         if ((Header->Type != stSlimNode::INDEX) &&
+               (Header->Type != stSlimNode::LEAF)){
+            return false;
+         }//end if
+         // The entries come before the objects.
+         end = sizeof(stSlimNode::stSlimNodeHeader) +
+               ((u_int64_t) Header->Occupation * EntrySize);
+         if (end > Page->GetPageSize()){
+            return false;
+         }//end if
+         last = Page->GetPageSize();
+         for (i = 0; i < Header->Occupation; i++){
+            offset = GetOffset(i);
+            if ((offset < end) || (offset > last)){
+               return false;
+            }//end if
+            last = offset;
+         }//end for
+         return true;
+      }//end IsValid
+
+      /**
+      * Returns the associated page.
+      */
+      stPage * GetPage(){
+         return Page;
+      }//end GetPage
+
+      /**
+      * Returns the ID of the associated page.
+      */
+      u_int32_t GetPageID(){
+         return Page->GetPageID();
+      }//end GetPageID
+
+      /**
+      * Returns the number of entries in this node.
+      */
+      u_int32_t GetNumberOfEntries(){
+         return Header->Occupation;
+      }//end GetNumberOfEntries
+
+      /**
+      * Returns the entry idx of an index node.
+      *
+      * @param idx The idx of the entry.
+      */
+      stSlimIndexNode::stSlimIndexEntry & GetIndexEntry(u_int32_t idx){
+         return ((stSlimIndexNode::stSlimIndexEntry *) Data)[idx];
+      }//end GetIndexEntry
+
+      /**
+      * Returns the entry idx of a leaf node.
+      *
+      * @param idx The idx of the entry.
+      */
+      stSlimLeafNode::stSlimLeafEntry & GetLeafEntry(u_int32_t idx){
+         return ((stSlimLeafNode::stSlimLeafEntry *) Data)[idx];
+      }//end GetLeafEntry
+
+      /**
+      * Gets the serialized object of the entry idx.
+      *
+      * @param idx The idx of the entry.
+      */
+      const unsigned char * GetObject(u_int32_t idx){
+         return Page->GetData() + GetOffset(idx);
+      }//end GetObject
+
+      /**
+      * Returns the size of the serialized object of the entry idx.
+      *
+      * @param idx The idx of the entry.
+      */
+      u_int32_t GetObjectSize(u_int32_t idx){
+         if (idx == 0){
+            return Page->GetPageSize() - GetOffset(0);
+         }else{
+            return GetOffset(idx - 1) - GetOffset(idx);
+         }//end if
+      }//end GetObjectSize
+
+      /**
+      * Returns the entry idx that holds the representative object (the first
+      * one with distance 0) or -1 if there is no representative.
+      */
+      int GetRepresentativeEntry(){
+         u_int32_t i;
+
+         for (i = 0; i < GetNumberOfEntries(); i++){
+            if (GetDistance(i) == 0.0){
+               return i;
+            }//end if
+         }//end for
+         return -1;
+      }//end GetRepresentativeEntry
+
+      /**
+      * Returns the minimum radius of this node.
+      */
+      double GetMinimumRadius(){
+         double radius = 0;
+         double distance;
+         u_int32_t i;
+
+         for (i = 0; i < GetNumberOfEntries(); i++){
+            distance = GetDistance(i);
+            if (Header->Type == stSlimNode::INDEX){
+               distance += GetIndexEntry(i).Radius;
+            }//end if
+            if (radius < distance){
+               radius = distance;
+            }//end if
+         }//end for
+         return radius;
+      }//end GetMinimumRadius
+
+   private:
+      /**
+      * The page.
+      */
+      stPage * Page;
+
+      /**
+      * Header of the node.
+      */
+      stSlimNode::stSlimNodeHeader * Header;
+
+      /**
+      * Start of the entries.
+      */
+      unsigned char * Data;
+
+      /**
+      * Size of each entry.
+      */
+      u_int32_t EntrySize;
+
+      /**
+      * Position of the field Offset in each entry.
+      */
+      u_int32_t OffsetPos;
+
+      /**
+      * Returns the distance of the entry idx to the representative.
+      */
+      double GetDistance(u_int32_t idx){
+         if (Header->Type == stSlimNode::INDEX){
+            return GetIndexEntry(idx).Distance;
+         }else{
+            return GetLeafEntry(idx).Distance;
+         }//end if
+      }//end GetDistance
+
+      /**
+      * Returns the offset of the object of the entry idx.
+      */
+      u_int32_t GetOffset(u_int32_t idx){
+         u_int32_t offset;
+
+         memcpy(&offset, Data + (idx * EntrySize) + OffsetPos, sizeof(offset));
+         return offset;
+      }//end GetOffset
+};//end stSlimNodeView
+
 //-----------------------------------------------------------------------------
 // Class stSlimMemLeafNode
 //-----------------------------------------------------------------------------
@@ -747,6 +1093,17 @@ class stSlimMemLeafNode{
       */
       bool Add(ObjectType * obj, double distance);
 
+      /**
+      * Moves the last entry of this node to dst. Unlike Add(), the distances
+      * to the global pivots and to the k-th nearest neighbor of the entry are
+      * kept.
+      *
+      * @param dst The destination node.
+      * @param distance The distance of the entry to the representative of dst.
+      * @return True for success or false if the entry does not fit in dst.
+      */
+      bool MoveLastTo(stSlimMemLeafNode * dst, double distance);
+
       /**
       * Returns the number of entries.
       */
@@ -835,7 +1192,8 @@ class stSlimMemLeafNode{
          int entrySize;
 
          // Does it fit ?
-         entrySize = obj->GetSerializedSize() + stSlimLeafNode::GetLeafEntryOverhead();
+         entrySize = obj->GetIncludedSerializedSize() +
+               stSlimLeafNode::GetLeafEntryOverhead();
          if (entrySize + this->usedSize > this->maximumSize){
             // No, it doesn't.
             return false;
@@ -876,6 +1234,20 @@ class stSlimMemLeafNode{
          * Distance from representative.
          */
          double Distance;
+
+         #ifdef __stSLIMPIVOTS__
+            /**
+            * Distances to the global pivots.
+            */
+            double PivotDistance[STSLIMPIVOTS];
+         #endif //__stSLIMPIVOTS__
+
+         #ifdef __stSLIMRKNN__
+            /**
+            * Distance to the k-th nearest neighbor.
+            */
+            double KNNDistance;
+         #endif //__stSLIMRKNN__
       };
 
       /**
@@ -917,6 +1289,14 @@ class stSlimMemLeafNode{
       * implementation.
       */
       int InsertPosition(double distance); 
+
+      /**
+      * Inserts an entry in its sorted position. The caller must check that
+      * it fits.
+      *
+      * @param entry The entry.
+      */
+      void Insert(const stSlimMemNodeEntry & entry);
       
       /**
       * Resizes the entries vector to hold more entries. It will at 16
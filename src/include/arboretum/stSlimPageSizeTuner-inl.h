@@ -0,0 +1,142 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+//Implementation of stSlimPageSizeTuner.h
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+stSlimPageSizeTuner<ObjectType, EvaluatorType>::stSlimPageSizeTuner(
+      const char * fileName){
+
+   FileName = fileName;
+   AccessCost = STTUNERACCESSCOST;
+   ByteCost = STTUNERBYTECOST;
+   DistanceCost = STTUNERDISTANCECOST;
+   K = 0;
+   Range = -1;
+   Best = -1;
+}//end stSlimPageSizeTuner<ObjectType, EvaluatorType>::stSlimPageSizeTuner
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void stSlimPageSizeTuner<ObjectType, EvaluatorType>::AddCandidate(
+      u_int32_t pageSize, u_int32_t leafPageSize){
+   tCandidate candidate;
+
+   candidate.PageSize = pageSize;
+   candidate.LeafPageSize = (leafPageSize == 0) ? pageSize : leafPageSize;
+   candidate.Height = 0;
+   candidate.NodeCount = 0;
+   candidate.DiskAccesses = 0;
+   candidate.BytesRead = 0;
+   candidate.DistanceCalculations = 0;
+   candidate.Cost = 0;
+   Candidates.push_back(candidate);
+}//end stSlimPageSizeTuner<ObjectType, EvaluatorType>::AddCandidate
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+int stSlimPageSizeTuner<ObjectType, EvaluatorType>::Evaluate(
+      ObjectType ** objects, u_int32_t numObjects,
+      ObjectType ** queries, u_int32_t numQueries){
+   u_int32_t i;
+
+   Best = -1;
+   for (i = 0; i < Candidates.size(); i++){
+      Evaluate(Candidates[i], objects, numObjects, queries, numQueries);
+      if ((Best < 0) || (Candidates[i].Cost < Candidates[Best].Cost)){
+         Best = i;
+      }//end if
+   }//end for
+   return Best;
+}//end stSlimPageSizeTuner<ObjectType, EvaluatorType>::Evaluate
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void stSlimPageSizeTuner<ObjectType, EvaluatorType>::Evaluate(
+      tCandidate & candidate, ObjectType ** objects, u_int32_t numObjects,
+      ObjectType ** queries, u_int32_t numQueries){
+   std::string leafName = FileName + ".leaf";
+   stPlainDiskPageManager * indexPages;
+   stPlainDiskPageManager * leafPages = NULL;
+   stDualPageManager * dualPages = NULL;
+   stPageManager * pageManager;
+   tSlimTree * tree;
+   double bytes;
+   u_int32_t i;
+
+   // Sample tree.
+   indexPages = new stPlainDiskPageManager(FileName.c_str(), candidate.PageSize);
+   pageManager = indexPages;
+   if (candidate.LeafPageSize != candidate.PageSize){
+      leafPages = new stPlainDiskPageManager(leafName.c_str(),
+                                             candidate.LeafPageSize);
+      dualPages = new stDualPageManager(indexPages, leafPages);
+      pageManager = dualPages;
+   }//end if
+   tree = new tSlimTree(pageManager);
+   for (i = 0; i < numObjects; i++){
+      tree->Add(objects[i]);
+   }//end for
+   candidate.Height = tree->GetHeight();
+   candidate.NodeCount = tree->GetNodeCount();
+
+   // Queries.
+   pageManager->ResetStatistics();
+   tree->GetMetricEvaluator()->ResetStatistics();
+   for (i = 0; i < numQueries; i++){
+      Query(tree, queries[i]);
+   }//end for
+   if (dualPages != NULL){
+      bytes = ((double) indexPages->GetReadCount() * candidate.PageSize) +
+              ((double) leafPages->GetReadCount() * candidate.LeafPageSize);
+   }else{
+      bytes = (double) indexPages->GetReadCount() * candidate.PageSize;
+   }//end if
+   if (numQueries > 0){
+      candidate.DiskAccesses = (double) pageManager->GetReadCount() / numQueries;
+      candidate.BytesRead = bytes / numQueries;
+      candidate.DistanceCalculations =
+            (double) tree->GetMetricEvaluator()->GetDistanceCount() / numQueries;
+   }//end if
+
+   // Cost.
+   candidate.Cost = DistanceCost * candidate.DistanceCalculations;
+   if (candidate.DiskAccesses > 0){
+      candidate.Cost += candidate.DiskAccesses * (AccessCost + ByteCost *
+            (candidate.BytesRead / candidate.DiskAccesses));
+   }//end if
+
+   // Free it all.
+   delete tree;
+   delete dualPages;
+   delete leafPages;
+   delete indexPages;
+   unlink(FileName.c_str());
+   unlink(leafName.c_str());
+}//end stSlimPageSizeTuner<ObjectType, EvaluatorType>::Evaluate
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void stSlimPageSizeTuner<ObjectType, EvaluatorType>::Query(tSlimTree * tree,
+      ObjectType * query){
+   stResult < ObjectType > * result;
+
+   if (K > 0){
+      result = tree->NearestQuery(query, K);
+      delete result;
+   }//end if
+   if (Range >= 0){
+      result = tree->RangeQuery(query, Range);
+      delete result;
+   }//end if
+}//end stSlimPageSizeTuner<ObjectType, EvaluatorType>::Query
@@ -0,0 +1,275 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file defines the class template stSlimPageSizeTuner.
+*
+* @version 1.0
+*/
+#ifndef __STSLIMPAGESIZETUNER_H
+#define __STSLIMPAGESIZETUNER_H
+
+#include <arboretum/stSlimTree.h>
+#include <arboretum/stPlainDiskPageManager.h>
+#include <arboretum/stDualPageManager.h>
+
+#include <string>
+#include <vector>
+
+// Relative cost of a disk access.
+#ifndef STTUNERACCESSCOST
+   #define STTUNERACCESSCOST 1.0
+#endif //STTUNERACCESSCOST
+
+// Relative cost of each byte transferred by a disk access.
+#ifndef STTUNERBYTECOST
+   #define STTUNERBYTECOST (1.0 / 65536.0)
+#endif //STTUNERBYTECOST
+
+// Relative cost of a distance calculation.
+#ifndef STTUNERDISTANCECOST
+   #define STTUNERDISTANCECOST 0.001
+#endif //STTUNERDISTANCECOST
+
+//=============================================================================
+// Class template stSlimPageSizeTuner
+//-----------------------------------------------------------------------------
+/**
+* This class template recommends the page size of a Slim-tree. For each
+* candidate (an index page size and, optionally, a larger leaf page size
+* used through stDualPageManager) it builds a tree with a sample of the
+* objects in a temporary file, performs a set of representative queries and
+* measures the average number of disk accesses, bytes read and distance
+* calculations per query.
+*
+* <P>Each candidate gets the cost
+* <CENTER>accesses * (accessCost + bytes per access * byteCost) +
+* distances * distanceCost</CENTER>
+* and the candidate with the lowest cost is recommended. The default weights
+* (STTUNERACCESSCOST, STTUNERBYTECOST and STTUNERDISTANCECOST) may be
+* replaced by SetCosts() to model a given disk and distance function.
+*
+* <P>Example:
+* <PRE>
+* stSlimPageSizeTuner < myObject, myEvaluator > tuner("tuner.dat");
+* tuner.AddCandidate(4096);
+* tuner.AddCandidate(8192);
+* tuner.AddCandidate(4096, 16384);
+* tuner.SetQuery(5, 0.4);
+* best = tuner.Evaluate(objects, numObjects, queries, numQueries);
+* </PRE>
+*
+* @version 1.0
+* @see stDualPageManager
+* @ingroup slim
+*/
+template <class ObjectType, class EvaluatorType>
+class stSlimPageSizeTuner{
+   public:
+      /**
+      * Type of the tree.
+      */
+      typedef stSlimTree < ObjectType, EvaluatorType > tSlimTree;
+
+      /**
+      * Result of a candidate.
+      */
+      struct tCandidate{
+         /**
+         * Size of the index pages.
+         */
+         u_int32_t PageSize;
+
+         /**
+         * Size of the leaf pages. It is equal to PageSize if the leaves do
+         * not have their own page size.
+         */
+         u_int32_t LeafPageSize;
+
+         /**
+         * Height of the sample tree.
+         */
+         u_int32_t Height;
+
+         /**
+         * Number of nodes of the sample tree.
+         */
+         long NodeCount;
+
+         /**
+         * Average number of disk accesses per query.
+         */
+         double DiskAccesses;
+
+         /**
+         * Average number of bytes read per query.
+         */
+         double BytesRead;
+
+         /**
+         * Average number of distance calculations per query.
+         */
+         double DistanceCalculations;
+
+         /**
+         * Cost of the candidate.
+         */
+         double Cost;
+      };//end tCandidate
+
+      /**
+      * Creates a new tuner.
+      *
+      * @param fileName The name of the temporary files used by the sample
+      * trees. They are removed after each evaluation.
+      */
+      stSlimPageSizeTuner(const char * fileName);
+
+      /**
+      * Adds a candidate.
+      *
+      * @param pageSize The size of the index pages.
+      * @param leafPageSize The size of the leaf pages or 0 to use pageSize.
+      */
+      void AddCandidate(u_int32_t pageSize, u_int32_t leafPageSize = 0);
+
+      /**
+      * Sets the weights of the cost.
+      *
+      * @param accessCost The cost of a disk access.
+      * @param byteCost The cost of each byte read.
+      * @param distanceCost The cost of a distance calculation.
+      */
+      void SetCosts(double accessCost, double byteCost, double distanceCost){
+         AccessCost = accessCost;
+         ByteCost = byteCost;
+         DistanceCost = distanceCost;
+      }//end SetCosts
+
+      /**
+      * Sets the queries performed for each query object.
+      *
+      * @param k The number of neighbors of a k-nearest neighbor query or 0
+      * to skip it.
+      * @param range The radius of a range query or a negative value to skip
+      * it.
+      */
+      void SetQuery(u_int32_t k, double range){
+         K = k;
+         Range = range;
+      }//end SetQuery
+
+      /**
+      * Evaluates all candidates.
+      *
+      * @param objects The sample of the objects.
+      * @param numObjects The number of objects.
+      * @param queries The query objects.
+      * @param numQueries The number of query objects.
+      * @return The index of the recommended candidate or -1 if there is no
+      * candidate.
+      */
+      int Evaluate(ObjectType ** objects, u_int32_t numObjects,
+            ObjectType ** queries, u_int32_t numQueries);
+
+      /**
+      * Returns the number of candidates.
+      */
+      u_int32_t GetNumberOfCandidates(){
+         return Candidates.size();
+      }//end GetNumberOfCandidates
+
+      /**
+      * Returns a candidate and its results.
+      *
+      * @param idx The index of the candidate.
+      */
+      const tCandidate & GetCandidate(u_int32_t idx){
+         return Candidates[idx];
+      }//end GetCandidate
+
+      /**
+      * Returns the index of the recommended candidate or -1 if Evaluate()
+      * was not called.
+      */
+      int GetBest(){
+         return Best;
+      }//end GetBest
+
+   private:
+      /**
+      * The candidates.
+      */
+      std::vector < tCandidate > Candidates;
+
+      /**
+      * Name of the temporary files.
+      */
+      std::string FileName;
+
+      /**
+      * Cost of a disk access.
+      */
+      double AccessCost;
+
+      /**
+      * Cost of each byte read.
+      */
+      double ByteCost;
+
+      /**
+      * Cost of a distance calculation.
+      */
+      double DistanceCost;
+
+      /**
+      * Number of neighbors.
+      */
+      u_int32_t K;
+
+      /**
+      * Radius of the range queries.
+      */
+      double Range;
+
+      /**
+      * The recommended candidate.
+      */
+      int Best;
+
+      /**
+      * Builds the sample tree of a candidate and measures its queries.
+      *
+      * @param candidate The candidate.
+      * @param objects The sample of the objects.
+      * @param numObjects The number of objects.
+      * @param queries The query objects.
+      * @param numQueries The number of query objects.
+      */
+      void Evaluate(tCandidate & candidate, ObjectType ** objects,
+            u_int32_t numObjects, ObjectType ** queries, u_int32_t numQueries);
+
+      /**
+      * Performs the queries of a query object.
+      *
+      * @param tree The tree.
+      * @param query The query object.
+      */
+      void Query(tSlimTree * tree, ObjectType * query);
+};//end stSlimPageSizeTuner
+
+// Include implementation
+#include <arboretum/stSlimPageSizeTuner-inl.h>
+
+#endif //__STSLIMPAGESIZETUNER_H
@@ -0,0 +1,243 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file defines the class template stSlimResidentLevels.
+*
+* @version 1.0
+*/
+#ifndef __STSLIMRESIDENTLEVELS_H
+#define __STSLIMRESIDENTLEVELS_H
+
+#include <arboretum/stCommon.h>
+
+#include <vector>
+#include <unordered_map>
+
+//=============================================================================
+// Class template stSlimResidentLevels
+//-----------------------------------------------------------------------------
+/**
+* This class template holds the upper index levels of a Slim-tree already
+* decoded. Each resident node keeps its representatives as live objects and
+* the other fields of its entries as plain arrays (one array per field), so
+* the queries may scan them without reading and unserializing the page.
+*
+* <P>An instance is a snapshot of the tree at a given structure count (see
+* GetVersion()). The tree builds a new one when its structure changes. The
+* insertions that do not split nodes only grow the number of entries and the
+* radius of some entries (see UpdateEntry()).
+*
+* @version 1.0
+* @see stSlimTree::SetResidentLevels()
+* @ingroup slim
+*/
+template <class ObjectType>
+class stSlimResidentLevels{
+   public:
+      /**
+      * A resident index node.
+      */
+      struct tNode{
+         /**
+         * ID of the page of this node.
+         */
+         u_int32_t PageID;
+
+         /**
+         * Number of entries.
+         */
+         u_int32_t NumberOfEntries;
+
+         /**
+         * Representatives of the entries.
+         */
+         std::vector < ObjectType * > Objects;
+
+         /**
+         * Pages of the subtrees.
+         */
+         std::vector < u_int32_t > PageIDs;
+
+         /**
+         * Number of objects of the subtrees.
+         */
+         std::vector < u_int32_t > NEntries;
+
+         /**
+         * Covering radius of the subtrees.
+         */
+         std::vector < double > Radius;
+
+         /**
+         * Distance to the representative of this node.
+         */
+         std::vector < double > Distance;
+
+         /**
+         * Resident subtrees or NULL if the subtree is not resident.
+         */
+         std::vector < tNode * > Children;
+      };
+
+      /**
+      * Creates an empty set of levels.
+      *
+      * @param version The structure count of the tree.
+      */
+      stSlimResidentLevels(u_int32_t version){
+         Version = version;
+         Root = NULL;
+         Size = 0;
+      }//end stSlimResidentLevels
+
+      /**
+      * Disposes all nodes and their objects.
+      */
+      ~stSlimResidentLevels(){
+         typename tNodeMap::iterator i;
+
+         for (i = Nodes.begin(); i != Nodes.end(); i++){
+            for (u_int32_t j = 0; j < i->second->NumberOfEntries; j++){
+               delete i->second->Objects[j];
+            }//end for
+            delete i->second;
+         }//end for
+      }//end ~stSlimResidentLevels
+
+      /**
+      * Creates a new node. The first node is the root.
+      *
+      * @param pageID The page of the node.
+      * @param numberOfEntries The number of entries.
+      * @param size The size of the page, used to account the memory.
+      */
+      tNode * NewNode(u_int32_t pageID, u_int32_t numberOfEntries,
+            u_int32_t size){
+         tNode * node = new tNode();
+
+         node->PageID = pageID;
+         node->NumberOfEntries = numberOfEntries;
+         node->Objects.resize(numberOfEntries, NULL);
+         node->PageIDs.resize(numberOfEntries);
+         node->NEntries.resize(numberOfEntries);
+         node->Radius.resize(numberOfEntries);
+         node->Distance.resize(numberOfEntries);
+         node->Children.resize(numberOfEntries, NULL);
+         Nodes[pageID] = node;
+         if (Root == NULL){
+            Root = node;
+         }//end if
+         Size += size;
+         return node;
+      }//end NewNode
+
+      /**
+      * Grows the number of entries and the radius of an entry. The queries
+      * may read them at the same time, so they are stored atomically. A
+      * smaller value is ignored, so the updates may be applied in any order.
+      *
+      * @param node The node.
+      * @param idx The entry.
+      * @param nEntries The number of entries.
+      * @param radius The radius.
+      */
+      void UpdateEntry(tNode * node, u_int32_t idx, u_int32_t nEntries,
+            double radius){
+         u_int32_t oldNEntries;
+         double oldRadius;
+
+         oldNEntries = __atomic_load_n(&node->NEntries[idx], __ATOMIC_RELAXED);
+         while ((oldNEntries < nEntries) &&
+               (!__atomic_compare_exchange_n(&node->NEntries[idx], &oldNEntries,
+                     nEntries, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))){
+         }//end while
+         __atomic_load(&node->Radius[idx], &oldRadius, __ATOMIC_RELAXED);
+         while ((oldRadius < radius) &&
+               (!__atomic_compare_exchange(&node->Radius[idx], &oldRadius,
+                     &radius, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))){
+         }//end while
+      }//end UpdateEntry
+
+      /**
+      * Returns the resident node of a page or NULL if it is not resident.
+      *
+      * @param pageID The page.
+      */
+      tNode * Find(u_int32_t pageID){
+         typename tNodeMap::iterator i = Nodes.find(pageID);
+
+         if (i == Nodes.end()){
+            return NULL;
+         }//end if
+         return i->second;
+      }//end Find
+
+      /**
+      * Returns the root or NULL if there is no resident node.
+      */
+      tNode * GetRoot(){
+         return Root;
+      }//end GetRoot
+
+      /**
+      * Returns the number of resident nodes.
+      */
+      u_int32_t GetNumberOfNodes(){
+         return Nodes.size();
+      }//end GetNumberOfNodes
+
+      /**
+      * Returns the total size of the pages of the resident nodes.
+      */
+      u_int64_t GetSize(){
+         return Size;
+      }//end GetSize
+
+      /**
+      * Returns the structure count of the tree when these levels were
+      * built.
+      */
+      u_int32_t GetVersion(){
+         return Version;
+      }//end GetVersion
+
+   private:
+      /**
+      * Map of resident nodes.
+      */
+      typedef std::unordered_map < u_int32_t, tNode * > tNodeMap;
+
+      /**
+      * The resident nodes.
+      */
+      tNodeMap Nodes;
+
+      /**
+      * The root.
+      */
+      tNode * Root;
+
+      /**
+      * Total size of the pages.
+      */
+      u_int64_t Size;
+
+      /**
+      * Structure count of the tree.
+      */
+      u_int32_t Version;
+};//end stSlimResidentLevels
+
+#endif //__STSLIMRESIDENTLEVELS_H
@@ -32,6 +32,11 @@ stSlimLogicNode<ObjectType, EvaluatorType>::stSlimLogicNode(u_int32_t maxOccupat
    // Allocate resources
    MaxEntries = maxOccupation;
    Entries = new stSlimLogicEntry[MaxEntries];
+   #ifdef __stSLIMRKNN__
+      for (u_int32_t i = 0; i < MaxEntries; i++){
+         Entries[i].KNNDistance = -1;
+      }//end for
+   #endif //__stSLIMRKNN__
 
    // Init Rep
    RepIndex[0] = 0;
@@ -71,7 +76,7 @@ template <class ObjectType, class EvaluatorType>
 int stSlimLogicNode<ObjectType, EvaluatorType>::AddEntry(u_int32_t size, const unsigned char * object){
    if (Count < MaxEntries){
       Entries[Count].Object = new ObjectType();
-      Entries[Count].Object->IncludedUnserialize(object, size);
+      tSerializer::IncludedUnserializeFrom(Entries[Count].Object, object, size);
       Entries[Count].Mine = true;
       Count++;
       return Count - 1;
@@ -84,7 +89,7 @@ template <class ObjectType, class EvaluatorType>
 int stSlimLogicNode<ObjectType, EvaluatorType>::AddEntryForIndex(u_int32_t size, const unsigned char * object){
    if (Count < MaxEntries){
       Entries[Count].Object = new ObjectType();  
-      Entries[Count].Object->Unserialize(object, size);
+      tSerializer::UnserializeFrom(Entries[Count].Object, object, size);
       Entries[Count].Mine = true;
       Count++;
       return Count - 1;
@@ -120,12 +125,39 @@ void stSlimLogicNode<ObjectType, EvaluatorType>::AddLeafNode(stSlimLeafNode * no
    for (i = 0; i < node->GetNumberOfEntries(); i++){
       idx = AddEntry(node->GetObjectSize(i), node->GetObject(i));
       SetEntry(idx, 0, 0, 0);
+      #ifdef __stSLIMPIVOTS__
+         memcpy(Entries[idx].PivotDistance, node->GetLeafEntry(i).PivotDistance,
+                sizeof(Entries[idx].PivotDistance));
+      #endif //__stSLIMPIVOTS__
+      #ifdef __stSLIMRKNN__
+         Entries[idx].KNNDistance = node->GetLeafEntry(i).KNNDistance;
+      #endif //__stSLIMRKNN__
    }//end for
 
    // Node type
    NodeType = stSlimNode::LEAF;
 }//end stSlimLogicNode<ObjectType, EvaluatorType>::AddLeafNode
 
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+int stSlimLogicNode<ObjectType, EvaluatorType>::AddLeafEntry(
+      stSlimLeafNode * node, u_int32_t idx, double distance){
+   int leafIdx;
+
+   leafIdx = tSerializer::AddIncludedEntry(node, Entries[idx].Object);
+   if (leafIdx >= 0){
+      node->GetLeafEntry(leafIdx).Distance = distance;
+      #ifdef __stSLIMPIVOTS__
+         memcpy(node->GetLeafEntry(leafIdx).PivotDistance,
+                Entries[idx].PivotDistance, sizeof(Entries[idx].PivotDistance));
+      #endif //__stSLIMPIVOTS__
+      #ifdef __stSLIMRKNN__
+         node->GetLeafEntry(leafIdx).KNNDistance = Entries[idx].KNNDistance;
+      #endif //__stSLIMRKNN__
+   }//end if
+   return leafIdx;
+}//end stSlimLogicNode<ObjectType, EvaluatorType>::AddLeafEntry
+
 //------------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
 u_int32_t stSlimLogicNode<ObjectType, EvaluatorType>::TestDistribution(
@@ -168,8 +200,7 @@ u_int32_t stSlimLogicNode<ObjectType, EvaluatorType>::TestDistribution(
       // Add to node 0
       currObj = idx0[l0].Index;
       Entries[currObj].Mapped = true;
-      idx = node0->AddEntry(Entries[currObj].Object->GetSerializedSize(),
-                            Entries[currObj].Object->Serialize());
+      idx = tSerializer::AddEntry(node0, Entries[currObj].Object);
 
       // Test if the new object was inserted.
       if (idx >= 0){
@@ -195,8 +226,7 @@ u_int32_t stSlimLogicNode<ObjectType, EvaluatorType>::TestDistribution(
       // Add to node 1
       currObj = idx1[l1].Index;
       Entries[currObj].Mapped = true;
-      idx = node1->AddEntry(Entries[currObj].Object->GetSerializedSize(),
-                            Entries[currObj].Object->Serialize());
+      idx = tSerializer::AddEntry(node1, Entries[currObj].Object);
       // Test if the new object was inserted.
       if (idx >= 0){
          // Ok. Inserted into node1. Fill the others filds.
@@ -221,8 +251,7 @@ u_int32_t stSlimLogicNode<ObjectType, EvaluatorType>::TestDistribution(
          Entries[i].Mapped = true;
          if (Entries[i].Distance[0] < Entries[i].Distance[1]){
             // Try to put on node 0 first
-            idx = node0->AddEntry(Entries[i].Object->GetSerializedSize(),
-                                  Entries[i].Object->Serialize());
+            idx = tSerializer::AddEntry(node0, Entries[i].Object);
             if (idx >= 0){
                node0->GetIndexEntry(idx).Distance = Entries[i].Distance[0];
                node0->GetIndexEntry(idx).PageID = Entries[i].PageID;
@@ -230,8 +259,7 @@ u_int32_t stSlimLogicNode<ObjectType, EvaluatorType>::TestDistribution(
                node0->GetIndexEntry(idx).Radius = Entries[i].Radius;
             }else{
                // Let's put it in the node 1 since it doesn't fit in the node 0
-               idx = node1->AddEntry(Entries[i].Object->GetSerializedSize(),
-                                     Entries[i].Object->Serialize());
+               idx = tSerializer::AddEntry(node1, Entries[i].Object);
                node1->GetIndexEntry(idx).Distance = Entries[i].Distance[1];
                node1->GetIndexEntry(idx).PageID = Entries[i].PageID;
                node1->GetIndexEntry(idx).NEntries = Entries[i].NEntries;
@@ -239,8 +267,7 @@ u_int32_t stSlimLogicNode<ObjectType, EvaluatorType>::TestDistribution(
             }//end if
          }else{
             // Try to put on node 1 first
-            idx = node1->AddEntry(Entries[i].Object->GetSerializedSize(),
-                                  Entries[i].Object->Serialize());
+            idx = tSerializer::AddEntry(node1, Entries[i].Object);
             if (idx >= 0){
                node1->GetIndexEntry(idx).Distance = Entries[i].Distance[1];
                node1->GetIndexEntry(idx).PageID = Entries[i].PageID;
@@ -248,8 +275,7 @@ u_int32_t stSlimLogicNode<ObjectType, EvaluatorType>::TestDistribution(
                node1->GetIndexEntry(idx).Radius = Entries[i].Radius;
             }else{
                // Let's put it in the node 0 since it doesn't fit in the node 1
-               idx = node0->AddEntry(Entries[i].Object->GetSerializedSize(),
-                                     Entries[i].Object->Serialize());
+               idx = tSerializer::AddEntry(node0, Entries[i].Object);
                node0->GetIndexEntry(idx).Distance = Entries[i].Distance[0];
                node0->GetIndexEntry(idx).PageID = Entries[i].PageID;
                node0->GetIndexEntry(idx).NEntries = Entries[i].NEntries;
@@ -275,7 +301,6 @@ u_int32_t stSlimLogicNode<ObjectType, EvaluatorType>::TestDistribution(
       EvaluatorType * metricEvaluator){
    u_int32_t dCount;
    u_int32_t i;
-   int idx;
    int l0, l1;
    int currObj;
    doubleIndex * idx0, * idx1;
@@ -310,9 +335,7 @@ u_int32_t stSlimLogicNode<ObjectType, EvaluatorType>::TestDistribution(
       // Add to node 0
       currObj = idx0[l0].Index;
       Entries[currObj].Mapped = true;
-      idx = node0->AddEntry(Entries[currObj].Object->GetIncludedSerializedSize(),
-                            Entries[currObj].Object->IncludedSerialize());
-      node0->GetLeafEntry(idx).Distance = idx0[l0].Distance;
+      AddLeafEntry(node0, currObj, idx0[l0].Distance);
 
       // Find a candidate for node 1
       while (Entries[idx1[l1].Index].Mapped){
@@ -321,9 +344,7 @@ u_int32_t stSlimLogicNode<ObjectType, EvaluatorType>::TestDistribution(
       // Add to node 1
       currObj = idx1[l1].Index;
       Entries[currObj].Mapped = true;
-      idx = node1->AddEntry(Entries[currObj].Object->GetIncludedSerializedSize(),
-                            Entries[currObj].Object->IncludedSerialize());
-      node1->GetLeafEntry(idx).Distance = idx1[l1].Distance;
+      AddLeafEntry(node1, currObj, idx1[l1].Distance);
    }//end for
 
    // Distribute the others.
@@ -332,27 +353,15 @@ u_int32_t stSlimLogicNode<ObjectType, EvaluatorType>::TestDistribution(
          Entries[i].Mapped = true;
          if (Entries[i].Distance[0] < Entries[i].Distance[1]){
             // Try to put on node 0 first
-            idx = node0->AddEntry(Entries[i].Object->GetIncludedSerializedSize(),
-                                  Entries[i].Object->IncludedSerialize());
-            if (idx >= 0){
-               node0->GetLeafEntry(idx).Distance = Entries[i].Distance[0];
-            }else{
+            if (AddLeafEntry(node0, i, Entries[i].Distance[0]) < 0){
                // Let's put it in the node 1 since it doesn't fit in the node 0
-               idx = node1->AddEntry(Entries[i].Object->GetIncludedSerializedSize(),
-                                     Entries[i].Object->IncludedSerialize());
-               node1->GetLeafEntry(idx).Distance = Entries[i].Distance[1];
+               AddLeafEntry(node1, i, Entries[i].Distance[1]);
             }//end if
          }else{
             // Try to put on node 1 first
-            idx = node1->AddEntry(Entries[i].Object->GetIncludedSerializedSize(),
-                                  Entries[i].Object->IncludedSerialize());
-            if (idx >= 0){
-               node1->GetLeafEntry(idx).Distance = Entries[i].Distance[1];
-            }else{
+            if (AddLeafEntry(node1, i, Entries[i].Distance[1]) < 0){
                // Let's put it in the node 0 since it doesn't fit in the node 1
-               idx = node0->AddEntry(Entries[i].Object->GetIncludedSerializedSize(),
-                                     Entries[i].Object->IncludedSerialize());
-               node0->GetLeafEntry(idx).Distance = Entries[i].Distance[0];
+               AddLeafEntry(node0, i, Entries[i].Distance[0]);
             }//end if
          }//end if
       }//end if
@@ -367,6 +376,109 @@ u_int32_t stSlimLogicNode<ObjectType, EvaluatorType>::TestDistribution(
    return dCount;
 }//end stSlimLogicNode<ObjectType, EvaluatorType>::TestDistribution
 
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+double stSlimLogicNode<ObjectType, EvaluatorType>::TestDistribution(
+      u_int32_t rep0, u_int32_t rep1, const double * distances,
+      const u_int32_t * sizes, u_int32_t capacity, doubleIndex * idx0,
+      doubleIndex * idx1, bool * mapped){
+   u_int32_t i;
+   int l0, l1;
+   int currObj;
+   u_int32_t used0, used1;
+   double radius0, radius1;
+   double distance;
+   bool toNode0;
+   bool isIndex = (NodeType == stSlimNode::INDEX);
+
+   // Distances to the representatives as set by UpdateDistances().
+   for (i = 0; i < Count; i++){
+      idx0[i].Index = i;
+      idx1[i].Index = i;
+      if (i == rep0){
+         idx0[i].Distance = 0;
+         idx1[i].Distance = MAXDOUBLE;
+      }else if (i == rep1){
+         idx0[i].Distance = MAXDOUBLE;
+         idx1[i].Distance = 0;
+      }else{
+         idx0[i].Distance = distances[(rep0 * Count) + i];
+         idx1[i].Distance = distances[(rep1 * Count) + i];
+      }//end if
+      mapped[i] = false;
+   }//end for
+
+   // Sorting by distance...
+   std::sort(idx0, idx0 + Count);
+   std::sort(idx1, idx1 + Count);
+
+   l0 = l1 = 0;
+   used0 = used1 = 0;
+   radius0 = radius1 = 0;
+
+   // Adds at least MinOccupation objects to each node.
+   for (i = 0; i < MinOccupation; i++){
+      // Candidate for node 0
+      while (mapped[idx0[l0].Index]){
+         l0++;
+      }//end while
+      currObj = idx0[l0].Index;
+      mapped[currObj] = true;
+      if (isIndex && (used0 + sizes[currObj] > capacity)){
+         throw std::logic_error("The page size is too small.");
+      }//end if
+      used0 += sizes[currObj];
+      distance = idx0[l0].Distance + (isIndex ? Entries[currObj].Radius : 0);
+      if (radius0 < distance){
+         radius0 = distance;
+      }//end if
+
+      // Candidate for node 1
+      while (mapped[idx1[l1].Index]){
+         l1++;
+      }//end while
+      currObj = idx1[l1].Index;
+      mapped[currObj] = true;
+      if (isIndex && (used1 + sizes[currObj] > capacity)){
+         throw std::logic_error("The page size is too small.");
+      }//end if
+      used1 += sizes[currObj];
+      distance = idx1[l1].Distance + (isIndex ? Entries[currObj].Radius : 0);
+      if (radius1 < distance){
+         radius1 = distance;
+      }//end if
+   }//end for
+
+   // Distribute the others.
+   for (i = 0; i < Count; i++){
+      if (!mapped[i]){
+         mapped[i] = true;
+         if (distances[(rep0 * Count) + i] < distances[(rep1 * Count) + i]){
+            // Node 0 first
+            toNode0 = (used0 + sizes[i] <= capacity);
+         }else{
+            // Node 1 first
+            toNode0 = (used1 + sizes[i] > capacity);
+         }//end if
+         if (toNode0){
+            used0 += sizes[i];
+            distance = distances[(rep0 * Count) + i] + (isIndex ? Entries[i].Radius : 0);
+            if (radius0 < distance){
+               radius0 = distance;
+            }//end if
+         }else{
+            used1 += sizes[i];
+            distance = distances[(rep1 * Count) + i] + (isIndex ? Entries[i].Radius : 0);
+            if (radius1 < distance){
+               radius1 = distance;
+            }//end if
+         }//end if
+      }//end if
+   }//end for
+
+   return (radius0 < radius1) ? radius1 : radius0;
+}//end stSlimLogicNode<ObjectType, EvaluatorType>::TestDistribution
+
 //------------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
 u_int32_t stSlimLogicNode<ObjectType, EvaluatorType>::UpdateDistances(
@@ -644,16 +756,14 @@ int stSlimMSTSplitter<ObjectType, EvaluatorType>::Distribute(
    PerformMST();
 
    // Add representatives first
-   idx = node0->AddEntry(Node->GetRepresentative(0)->GetSerializedSize(),
-                         Node->GetRepresentative(0)->Serialize());
+   idx = tSerializer::AddEntry(node0, Node->GetRepresentative(0));
    objIdx = Node->GetRepresentativeIndex(0);
    node0->GetIndexEntry(idx).Distance = 0.0;
    node0->GetIndexEntry(idx).Radius = Node->GetRadius(objIdx);
    node0->GetIndexEntry(idx).NEntries = Node->GetNEntries(objIdx);
    node0->GetIndexEntry(idx).PageID = Node->GetPageID(objIdx);
 
-   idx = node1->AddEntry(Node->GetRepresentative(1)->GetSerializedSize(),
-                         Node->GetRepresentative(1)->Serialize());
+   idx = tSerializer::AddEntry(node1, Node->GetRepresentative(1));
    objIdx = Node->GetRepresentativeIndex(1);
    node1->GetIndexEntry(idx).Distance = 0.0;
    node1->GetIndexEntry(idx).Radius = Node->GetRadius(objIdx);
@@ -664,8 +774,7 @@ int stSlimMSTSplitter<ObjectType, EvaluatorType>::Distribute(
    for (i = 0; i < N; i++){
       if (!Node->IsRepresentative(i)){
          if (ObjectCluster[i] == Cluster0){
-            idx = node0->AddEntry(Node->GetObject(i)->GetSerializedSize(),
-                                  Node->GetObject(i)->Serialize());
+            idx = tSerializer::AddEntry(node0, Node->GetObject(i));
             if (idx >= 0){
                // Insertion Ok!
                node0->GetIndexEntry(idx).Distance =
@@ -675,8 +784,7 @@ int stSlimMSTSplitter<ObjectType, EvaluatorType>::Distribute(
                node0->GetIndexEntry(idx).PageID = Node->GetPageID(i);
             }else{
                // Oops! We must put it in other node
-               idx = node1->AddEntry(Node->GetObject(i)->GetSerializedSize(),
-                                     Node->GetObject(i)->Serialize());
+               idx = tSerializer::AddEntry(node1, Node->GetObject(i));
                node1->GetIndexEntry(idx).Distance =
                      DMat[i][Node->GetRepresentativeIndex(1)];
                node1->GetIndexEntry(idx).Radius = Node->GetRadius(i);
@@ -684,8 +792,7 @@ int stSlimMSTSplitter<ObjectType, EvaluatorType>::Distribute(
                node1->GetIndexEntry(idx).PageID = Node->GetPageID(i);
             }//end if
          }else{
-            idx = node1->AddEntry(Node->GetObject(i)->GetSerializedSize(),
-                                  Node->GetObject(i)->Serialize());
+            idx = tSerializer::AddEntry(node1, Node->GetObject(i));
             if (idx >= 0){
                // Insertion Ok!
                node1->GetIndexEntry(idx).Distance =
@@ -695,8 +802,7 @@ int stSlimMSTSplitter<ObjectType, EvaluatorType>::Distribute(
                node1->GetIndexEntry(idx).PageID = Node->GetPageID(i);
             }else{
                // Oops! We must put it in other node
-               idx = node0->AddEntry(Node->GetObject(i)->GetSerializedSize(),
-                                     Node->GetObject(i)->Serialize());
+               idx = tSerializer::AddEntry(node0, Node->GetObject(i));
                node0->GetIndexEntry(idx).Distance =
                      DMat[i][Node->GetRepresentativeIndex(0)];
                node0->GetIndexEntry(idx).Radius = Node->GetRadius(i);
@@ -721,7 +827,6 @@ int stSlimMSTSplitter<ObjectType, EvaluatorType>::Distribute(
             stSlimLeafNode * node1, ObjectType * & rep1,
             EvaluatorType * metricEvaluator){
    int dCount;
-   int idx;
    int i;
 
    // Build Distance matrix
@@ -731,43 +836,25 @@ int stSlimMSTSplitter<ObjectType, EvaluatorType>::Distribute(
    PerformMST();
 
    // Add representatives first
-   idx = node0->AddEntry(Node->GetRepresentative(0)->GetIncludedSerializedSize(),
-                         Node->GetRepresentative(0)->IncludedSerialize());
-   node0->GetLeafEntry(idx).Distance = 0.0;
-   idx = node1->AddEntry(Node->GetRepresentative(1)->GetIncludedSerializedSize(),
-                         Node->GetRepresentative(1)->IncludedSerialize());
-   node1->GetLeafEntry(idx).Distance = 0.0;
+   Node->AddLeafEntry(node0, Node->GetRepresentativeIndex(0), 0.0);
+   Node->AddLeafEntry(node1, Node->GetRepresentativeIndex(1), 0.0);
 
    // Distribute us...
    for (i = 0; i < N; i++){
       if (!Node->IsRepresentative(i)){
          if (ObjectCluster[i] == Cluster0){
-            idx = node0->AddEntry(Node->GetObject(i)->GetIncludedSerializedSize(),
-                                  Node->GetObject(i)->IncludedSerialize());
-            if (idx >= 0){
-               // Insertion Ok!
-               node0->GetLeafEntry(idx).Distance =
-                     DMat[i][Node->GetRepresentativeIndex(0)];
-            }else{
+            if (Node->AddLeafEntry(node0, i,
+                  DMat[i][Node->GetRepresentativeIndex(0)]) < 0){
                // Oops! We must put it in other node
-               idx = node1->AddEntry(Node->GetObject(i)->GetIncludedSerializedSize(),
-                                     Node->GetObject(i)->IncludedSerialize());
-               node1->GetLeafEntry(idx).Distance =
-                     DMat[i][Node->GetRepresentativeIndex(1)];
+               Node->AddLeafEntry(node1, i,
+                     DMat[i][Node->GetRepresentativeIndex(1)]);
             }//end if
          }else{
-            idx = node1->AddEntry(Node->GetObject(i)->GetIncludedSerializedSize(),
-                                  Node->GetObject(i)->IncludedSerialize());
-            if (idx >= 0){
-               // Insertion Ok!
-               node1->GetLeafEntry(idx).Distance =
-                     DMat[i][Node->GetRepresentativeIndex(1)];
-            }else{
+            if (Node->AddLeafEntry(node1, i,
+                  DMat[i][Node->GetRepresentativeIndex(1)]) < 0){
                // Oops! We must put it in other node
-               idx = node0->AddEntry(Node->GetObject(i)->GetIncludedSerializedSize(),
-                                     Node->GetObject(i)->IncludedSerialize());
-               node0->GetLeafEntry(idx).Distance =
-                     DMat[i][Node->GetRepresentativeIndex(0)];
+               Node->AddLeafEntry(node0, i,
+                     DMat[i][Node->GetRepresentativeIndex(0)]);
             }//end if
          }//end if
       }//end if
@@ -804,6 +891,9 @@ void stSlimMSTSplitter<ObjectType, EvaluatorType>::JoinClusters(
 //       stSlimTree<ObjectType, EvaluatorType>
 #define tmpl_stSlimTree stSlimTree<ObjectType, EvaluatorType>
 
+template <class ObjectType, class EvaluatorType>
+thread_local typename tmpl_stSlimTree::tReadView * tmpl_stSlimTree::ThreadReadView = NULL;
+
 template <class ObjectType, class EvaluatorType>
 tmpl_stSlimTree::stSlimTree(stPageManager * pageman):
    stMetricTree<ObjectType, EvaluatorType>(pageman){
@@ -811,6 +901,18 @@ tmpl_stSlimTree::stSlimTree(stPageManager * pageman):
    // Initialize fields
    Header = NULL;
    HeaderPage = NULL;
+   ConcurrentPageManager = NULL;
+   SnapshotPageManager = NULL;
+   ResidentLevels = 0;
+   ResidentMaxBytes = 0;
+   PrefetchDepth = 0;
+   // Not 0, so the cursors of an earlier instance are not taken as current.
+   ModificationCount = (u_int32_t)
+         std::chrono::system_clock::now().time_since_epoch().count();
+   StructureCount = 0;
+   #ifdef __stQUERYSTATS__
+      QueryStatsEnabled = false;
+   #endif //__stQUERYSTATS__
 
    // Load header.
    LoadHeader();
@@ -838,6 +940,18 @@ tmpl_stSlimTree::stSlimTree(stPageManager * pageman, EvaluatorType * metricEval)
    // Initialize fields
    Header = NULL;
    HeaderPage = NULL;
+   ConcurrentPageManager = NULL;
+   SnapshotPageManager = NULL;
+   ResidentLevels = 0;
+   ResidentMaxBytes = 0;
+   PrefetchDepth = 0;
+   // Not 0, so the cursors of an earlier instance are not taken as current.
+   ModificationCount = (u_int32_t)
+         std::chrono::system_clock::now().time_since_epoch().count();
+   StructureCount = 0;
+   #ifdef __stQUERYSTATS__
+      QueryStatsEnabled = false;
+   #endif //__stQUERYSTATS__
 
    // Load header.
    LoadHeader();
@@ -857,6 +971,10 @@ tmpl_stSlimTree::stSlimTree(stPageManager * pageman, EvaluatorType * metricEval)
 template <class ObjectType, class EvaluatorType>
 tmpl_stSlimTree::~stSlimTree(){
 
+   // Restore the original page manager.
+   SetSnapshotIsolation(false);
+   SetConcurrent(false);
+
    // Flus header page.
    FlushHeader();
 
@@ -888,6 +1006,14 @@ void tmpl_stSlimTree::DefaultHeader(){
    Header->Height = 0;
    Header->ObjectCount = 0;
    Header->NodeCount = 0;
+   NotifyModification();
+   #ifdef __stSLIMPIVOTS__
+      Header->PivotSize = 0;
+      Pivots.Clear();
+   #endif //__stSLIMPIVOTS__
+   #ifdef __stSLIMRKNN__
+      Header->KNNDistanceK = 0;
+   #endif //__stSLIMRKNN__
 
    // Notify modifications
    HeaderUpdate = true;
@@ -912,6 +1038,16 @@ void tmpl_stSlimTree::LoadHeader(){
 
    Header = (stSlimHeader *) HeaderPage->GetData();
    HeaderUpdate = false;
+
+   #ifdef __stSLIMPIVOTS__
+      // The pivots follow the header.
+      if (Header->PivotSize <= HeaderPage->GetPageSize() - sizeof(stSlimHeader)){
+         Pivots.Unserialize(HeaderPage->GetData() + sizeof(stSlimHeader),
+                            Header->PivotSize);
+      }else{
+         Pivots.Clear();
+      }//end if
+   #endif //__stSLIMPIVOTS__
 }//end stSlimTree<ObjectType, EvaluatorType>::LoadHeader
 
 //------------------------------------------------------------------------------
@@ -927,6 +1063,446 @@ void tmpl_stSlimTree::FlushHeader(){
    }//end if
 }//end stSlimTree<ObjectType, EvaluatorType>::FlushHeader
 
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void tmpl_stSlimTree::SetResidentLevels(u_int32_t levels, u_int32_t maxBytes){
+   std::lock_guard < std::mutex > lock(ResidentMutex);
+
+   ResidentLevels = levels;
+   ResidentMaxBytes = maxBytes;
+   // The next query builds them again.
+   std::atomic_store(&Resident, std::shared_ptr < tResidentLevels >());
+}//end stSlimTree<ObjectType, EvaluatorType>::SetResidentLevels
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void tmpl_stSlimTree::Prefetch(tDynamicPriorityQueue * queue){
+   u_int32_t pageIDs[STPREFETCHQUEUE];
+   u_int32_t count;
+   u_int32_t max;
+
+   if (PrefetchDepth > 0){
+      // The queue is a heap. Its first entries are the next ones or close
+      // to them.
+      max = (PrefetchDepth < STPREFETCHQUEUE) ? PrefetchDepth : STPREFETCHQUEUE;
+      for (count = 0; (count < max) && ((int) count < queue->GetSize());
+            count++){
+         pageIDs[count] = queue->GetValue(count).PageID;
+      }//end for
+      Prefetch(pageIDs, count);
+   }//end if
+}//end stSlimTree<ObjectType, EvaluatorType>::Prefetch
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+std::shared_ptr < typename tmpl_stSlimTree::tResidentLevels >
+      tmpl_stSlimTree::GetResident(){
+   std::shared_ptr < tResidentLevels > levels;
+   u_int32_t version;
+
+   // Read views see older versions of the pages.
+   if ((ResidentLevels == 0) || (GetReadView() != NULL)){
+      return levels;
+   }//end if
+
+   // Are the current levels up to date?
+   version = __atomic_load_n(&StructureCount, __ATOMIC_ACQUIRE);
+   levels = std::atomic_load(&Resident);
+   if ((levels != NULL) && (levels->GetVersion() == version)){
+      return levels;
+   }//end if
+
+   // No. Only one thread builds them.
+   std::lock_guard < std::mutex > lock(ResidentMutex);
+   levels = std::atomic_load(&Resident);
+   if ((levels == NULL) || (levels->GetVersion() != version)){
+      levels.reset(new tResidentLevels(version));
+      if ((ResidentLevels > 0) && (this->GetRoot() != 0)){
+         BuildResident(levels.get());
+      }//end if
+      std::atomic_store(&Resident, levels);
+   }//end if
+   return levels;
+}//end stSlimTree<ObjectType, EvaluatorType>::GetResident
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void tmpl_stSlimTree::BuildResident(tResidentLevels * levels){
+   // Page, level, parent and entry of the parent of each pending node.
+   struct tPending{
+      u_int32_t PageID;
+      u_int32_t Level;
+      tResidentNode * Parent;
+      u_int32_t ParentIdx;
+   };
+   std::vector < tPending > pending;
+   tPending curr;
+   stPage * currPage;
+   stSlimNodeView currNode;
+   tResidentNode * node;
+   u_int32_t idx, i;
+
+   // Breadth first, so the size limit keeps the highest levels.
+   curr.PageID = this->GetRoot();
+   curr.Level = 0;
+   curr.Parent = NULL;
+   curr.ParentIdx = 0;
+   pending.push_back(curr);
+   for (i = 0; i < pending.size(); i++){
+      curr = pending[i];
+      currPage = tMetricTree::myPageManager->GetPage(curr.PageID);
+      currNode.SetPage(currPage);
+      if ((currNode.GetNodeType() == stSlimNode::INDEX) &&
+            ((ResidentMaxBytes == 0) ||
+             (levels->GetSize() + currPage->GetPageSize() <= ResidentMaxBytes))){
+         node = levels->NewNode(curr.PageID, currNode.GetNumberOfEntries(),
+                                currPage->GetPageSize());
+         for (idx = 0; idx < node->NumberOfEntries; idx++){
+            node->Objects[idx] = new ObjectType();
+            node->Objects[idx]->Unserialize(currNode.GetObject(idx),
+                                            currNode.GetObjectSize(idx));
+            node->PageIDs[idx] = currNode.GetIndexEntry(idx).PageID;
+            node->NEntries[idx] = currNode.GetIndexEntry(idx).NEntries;
+            node->Radius[idx] = currNode.GetIndexEntry(idx).Radius;
+            node->Distance[idx] = currNode.GetIndexEntry(idx).Distance;
+         }//end for
+         if (curr.Parent != NULL){
+            curr.Parent->Children[curr.ParentIdx] = node;
+         }//end if
+
+         // Next level.
+         if (curr.Level + 1 < ResidentLevels){
+            for (idx = 0; idx < node->NumberOfEntries; idx++){
+               tPending child;
+
+               child.PageID = node->PageIDs[idx];
+               child.Level = curr.Level + 1;
+               child.Parent = node;
+               child.ParentIdx = idx;
+               pending.push_back(child);
+            }//end for
+         }//end if
+      }//end if
+      tMetricTree::myPageManager->ReleasePage(currPage);
+   }//end for
+}//end stSlimTree<ObjectType, EvaluatorType>::BuildResident
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void tmpl_stSlimTree::UpdateResidentEntry(u_int32_t pageID, u_int32_t idx,
+      u_int32_t nEntries, double radius){
+   std::shared_ptr < tResidentLevels > levels;
+   tResidentNode * node;
+
+   if (ResidentLevels == 0){
+      return;
+   }//end if
+
+   // A build in progress may have read the page before this change, so wait
+   // for it and update the levels it stored.
+   std::lock_guard < std::mutex > lock(ResidentMutex);
+   levels = std::atomic_load(&Resident);
+   if ((levels != NULL) &&
+         (levels->GetVersion() == __atomic_load_n(&StructureCount, __ATOMIC_ACQUIRE))){
+      node = levels->Find(pageID);
+      if ((node != NULL) && (idx < node->NumberOfEntries)){
+         levels->UpdateEntry(node, idx, nEntries, radius);
+      }//end if
+   }//end if
+}//end stSlimTree<ObjectType, EvaluatorType>::UpdateResidentEntry
+
+#ifdef __stSLIMPIVOTS__
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+bool tmpl_stSlimTree::SetPivots(ObjectType ** objects, u_int32_t numObject,
+      u_int32_t numPivots){
+   ObjectType tmpObj;
+   u_int32_t size;
+   bool ok;
+
+   if (numPivots > STSLIMPIVOTS){
+      numPivots = STSLIMPIVOTS;
+   }//end if
+
+   // All pages changed by the new pivots form a single update.
+   tMetricTree::myPageManager->BeginUpdate();
+
+   // Choose them and store them in the header page.
+   ok = Pivots.Choose(objects, numObject, numPivots, this->myMetricEvaluator) > 0;
+   if (ok){
+      size = Pivots.GetSerializedSize();
+      ok = size <= HeaderPage->GetPageSize() - sizeof(stSlimHeader);
+   }//end if
+   if (ok){
+      Pivots.Serialize(HeaderPage->GetData() + sizeof(stSlimHeader));
+      Header->PivotSize = size;
+   }else{
+      Pivots.Clear();
+      Header->PivotSize = 0;
+   }//end if
+   HeaderUpdate = true;
+
+   // Update the leaves.
+   if (this->GetRoot() != 0){
+      UpdatePivotDistances(this->GetRoot(), tmpObj);
+   }//end if
+   NotifyModification();
+   WriteHeader();
+   tMetricTree::myPageManager->EndUpdate();
+
+   return ok;
+}//end stSlimTree<ObjectType, EvaluatorType>::SetPivots
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void tmpl_stSlimTree::SetPivotDistances(stSlimLeafNode * leafNode,
+      u_int32_t idx, ObjectType * obj){
+   double distances[STSLIMPIVOTS];
+
+   BuildPivotDistances(obj, distances);
+   memcpy(leafNode->GetLeafEntry(idx).PivotDistance, distances,
+          sizeof(distances));
+}//end stSlimTree<ObjectType, EvaluatorType>::SetPivotDistances
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void tmpl_stSlimTree::UpdatePivotDistances(u_int32_t pageID,
+      ObjectType & tmpObj){
+   stPage * currPage;
+   stSlimNode * currNode;
+   u_int32_t idx;
+
+   currPage = tMetricTree::myPageManager->GetPage(pageID);
+   currNode = stSlimNode::CreateNode(currPage);
+   if (currNode->GetNodeType() == stSlimNode::INDEX){
+      stSlimIndexNode * indexNode = (stSlimIndexNode *) currNode;
+
+      for (idx = 0; idx < indexNode->GetNumberOfEntries(); idx++){
+         UpdatePivotDistances(indexNode->GetIndexEntry(idx).PageID, tmpObj);
+      }//end for
+   }else{
+      stSlimLeafNode * leafNode = (stSlimLeafNode *) currNode;
+
+      for (idx = 0; idx < leafNode->GetNumberOfEntries(); idx++){
+         tmpObj.IncludedUnserialize(leafNode->GetObject(idx),
+                                    leafNode->GetObjectSize(idx));
+         SetPivotDistances(leafNode, idx, &tmpObj);
+      }//end for
+      tMetricTree::myPageManager->WritePage(currPage);
+   }//end if
+   delete currNode;
+   tMetricTree::myPageManager->ReleasePage(currPage);
+}//end stSlimTree<ObjectType, EvaluatorType>::UpdatePivotDistances
+#endif //__stSLIMPIVOTS__
+
+#ifdef __stSLIMRKNN__
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void tmpl_stSlimTree::SetKNNDistances(u_int32_t k){
+   ObjectType tmpObj;
+
+   // All pages changed by the new distances form a single update.
+   tMetricTree::myPageManager->BeginUpdate();
+   Header->KNNDistanceK = k;
+   HeaderUpdate = true;
+   if ((k > 0) && (this->GetRoot() != 0)){
+      UpdateKNNDistances(this->GetRoot(), NULL, -1, tmpObj);
+   }//end if
+   NotifyModification();
+   WriteHeader();
+   tMetricTree::myPageManager->EndUpdate();
+}//end stSlimTree<ObjectType, EvaluatorType>::SetKNNDistances
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+double tmpl_stSlimTree::GetKNNDistance(ObjectType * obj, u_int32_t k){
+   // A subtree waiting in the queue: its bound, its page and the distance of
+   // obj to its representative (-1 for the root).
+   typedef std::pair < double, std::pair < u_int32_t, double > > tItem;
+   std::vector < tItem > queue;
+   // Max heap with the k + 1 smallest distances (obj itself is one of them).
+   std::vector < double > best;
+   tItem item;
+   stPage * currPage;
+   stSlimNodeView currNode;
+   ObjectType tmpObj;
+   double rangeK = MAXDOUBLE;
+   double distance;
+   double distanceRepres;
+   double entryDistance;
+   double radius;
+   u_int32_t idx;
+   u_int32_t numberOfEntries;
+
+   if (this->GetRoot() == 0){
+      return MAXDOUBLE;
+   }//end if
+
+   // The queue is a min heap.
+   queue.push_back(tItem(0, std::pair < u_int32_t, double > (this->GetRoot(), -1)));
+   while (!queue.empty()){
+      std::pop_heap(queue.begin(), queue.end(), std::greater < tItem > ());
+      item = queue.back();
+      queue.pop_back();
+      if (item.first > rangeK){
+         // No subtree left may have a closer object.
+         break;
+      }//end if
+      distanceRepres = item.second.second;
+
+      // Read node...
+      currPage = tMetricTree::myPageManager->GetPage(item.second.first);
+      currNode.SetPage(currPage);
+      numberOfEntries = currNode.GetNumberOfEntries();
+      if (currNode.GetNodeType() == stSlimNode::INDEX){
+         for (idx = 0; idx < numberOfEntries; idx++){
+            entryDistance = currNode.GetIndexEntry(idx).Distance;
+            radius = currNode.GetIndexEntry(idx).Radius;
+            // try to cut this subtree with the triangle inequality.
+            if ((distanceRepres >= 0) &&
+                ((distanceRepres > entryDistance + radius + rangeK) ||
+                 (entryDistance > distanceRepres + radius + rangeK))){
+               continue;
+            }//end if
+            tmpObj.Unserialize(currNode.GetObject(idx),
+                               currNode.GetObjectSize(idx));
+            distance = this->myMetricEvaluator->GetDistance(tmpObj, *obj);
+            if (distance <= radius + rangeK){
+               queue.push_back(tItem((distance > radius) ? distance - radius : 0,
+                     std::pair < u_int32_t, double > (
+                     currNode.GetIndexEntry(idx).PageID, distance)));
+               std::push_heap(queue.begin(), queue.end(), std::greater < tItem > ());
+            }//end if
+         }//end for
+      }else{
+         for (idx = 0; idx < numberOfEntries; idx++){
+            entryDistance = currNode.GetLeafEntry(idx).Distance;
+            // try to cut this object with the triangle inequality.
+            if ((distanceRepres >= 0) &&
+                ((distanceRepres > entryDistance + rangeK) ||
+                 (entryDistance > distanceRepres + rangeK))){
+               continue;
+            }//end if
+            tmpObj.IncludedUnserialize(currNode.GetObject(idx),
+                                       currNode.GetObjectSize(idx));
+            distance = this->myMetricEvaluator->GetDistance(tmpObj, *obj);
+            if (distance <= rangeK){
+               best.push_back(distance);
+               std::push_heap(best.begin(), best.end());
+               if (best.size() > k + 1){
+                  std::pop_heap(best.begin(), best.end());
+                  best.pop_back();
+               }//end if
+               if (best.size() == k + 1){
+                  rangeK = best.front();
+               }//end if
+            }//end if
+         }//end for
+      }//end if
+
+      // Free it all
+      tMetricTree::myPageManager->ReleasePage(currPage);
+   }//end while
+
+   return (best.size() == k + 1) ? best.front() : MAXDOUBLE;
+}//end stSlimTree<ObjectType, EvaluatorType>::GetKNNDistance
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+double tmpl_stSlimTree::UpdateKNNDistances(u_int32_t pageID,
+      ObjectType * newObj, double distanceRepres, ObjectType & tmpObj){
+   stPage * currPage;
+   stSlimNode * currNode;
+   double maxDistance = 0;
+   double kDistance;
+   double distance;
+   double entryDistance;
+   double limit;
+   bool visit;
+   bool modified = false;
+   u_int32_t idx;
+
+   currPage = tMetricTree::myPageManager->GetPage(pageID);
+   currNode = stSlimNode::CreateNode(currPage);
+   if (currNode->GetNodeType() == stSlimNode::INDEX){
+      stSlimIndexNode * indexNode = (stSlimIndexNode *) currNode;
+
+      for (idx = 0; idx < indexNode->GetNumberOfEntries(); idx++){
+         kDistance = indexNode->GetIndexEntry(idx).MaxKNNDistance;
+         distance = -1;
+         visit = true;
+         if (newObj != NULL){
+            entryDistance = indexNode->GetIndexEntry(idx).Distance;
+            // newObj may only be closer than the k-th nearest neighbor of
+            // the objects of this subtree if d(newObj, rep) < r + maxKdist.
+            // The slack absorbs the rounding of the distances.
+            limit = (indexNode->GetIndexEntry(idx).Radius + kDistance) *
+                  (1 + 1e-9);
+            if ((kDistance >= 0) && (distanceRepres >= 0) &&
+                ((distanceRepres > entryDistance + limit) ||
+                 (entryDistance > distanceRepres + limit))){
+               visit = false;
+            }else{
+               tmpObj.Unserialize(indexNode->GetObject(idx),
+                                  indexNode->GetObjectSize(idx));
+               distance = this->myMetricEvaluator->GetDistance(tmpObj, *newObj);
+               visit = (kDistance < 0) || (distance <= limit);
+            }//end if
+         }//end if
+         if (visit){
+            kDistance = UpdateKNNDistances(indexNode->GetIndexEntry(idx).PageID,
+                  newObj, distance, tmpObj);
+            if (indexNode->GetIndexEntry(idx).MaxKNNDistance != kDistance){
+               indexNode->GetIndexEntry(idx).MaxKNNDistance = kDistance;
+               modified = true;
+            }//end if
+         }//end if
+         if (kDistance > maxDistance){
+            maxDistance = kDistance;
+         }//end if
+      }//end for
+   }else{
+      stSlimLeafNode * leafNode = (stSlimLeafNode *) currNode;
+
+      for (idx = 0; idx < leafNode->GetNumberOfEntries(); idx++){
+         kDistance = leafNode->GetLeafEntry(idx).KNNDistance;
+         visit = (newObj == NULL) || (kDistance < 0);
+         if (!visit){
+            entryDistance = leafNode->GetLeafEntry(idx).Distance;
+            limit = kDistance * (1 + 1e-9);
+            // Only the objects that are farther from their k-th nearest
+            // neighbor than from newObj change.
+            if ((distanceRepres < 0) ||
+                ((distanceRepres < entryDistance + limit) &&
+                 (entryDistance < distanceRepres + limit))){
+               tmpObj.IncludedUnserialize(leafNode->GetObject(idx),
+                                          leafNode->GetObjectSize(idx));
+               visit = this->myMetricEvaluator->GetDistance(tmpObj, *newObj) <
+                     kDistance;
+            }//end if
+         }//end if
+         if (visit){
+            tmpObj.IncludedUnserialize(leafNode->GetObject(idx),
+                                       leafNode->GetObjectSize(idx));
+            kDistance = GetKNNDistance(&tmpObj, Header->KNNDistanceK);
+            leafNode->GetLeafEntry(idx).KNNDistance = kDistance;
+            modified = true;
+         }//end if
+         if (kDistance > maxDistance){
+            maxDistance = kDistance;
+         }//end if
+      }//end for
+   }//end if
+   if (modified){
+      tMetricTree::myPageManager->WritePage(currPage);
+   }//end if
+   delete currNode;
+   tMetricTree::myPageManager->ReleasePage(currPage);
+
+   return maxDistance;
+}//end stSlimTree<ObjectType, EvaluatorType>::UpdateKNNDistances
+#endif //__stSLIMRKNN__
+
 //------------------------------------------------------------------------------
 #ifdef __stFRACTALQUERY__
 template <class ObjectType, class EvaluatorType>
@@ -948,17 +1524,20 @@ bool tmpl_stSlimTree::Add(ObjectType *newObj){
    stSubtreeInfo promo1;
    stSubtreeInfo promo2;
    int insertIdx;
+   u_int32_t nodeCount = Header->NodeCount;
+
+   // All pages changed by this insertion form a single update.
+   tMetricTree::myPageManager->BeginUpdate();
 
    // Is there a root ?
    if (this->GetRoot() == 0){
       // No! We shall create the new node.
-      stPage * auxPage  = this->NewPage();
+      stPage * auxPage  = this->NewPage(true);
       stSlimLeafNode * leafNode = new stSlimLeafNode(auxPage, true);
       this->SetRoot(auxPage->GetPageID());
 
       // Insert the new object.
-      insertIdx = leafNode->AddEntry(newObj->GetIncludedSerializedSize(),
-                                     newObj->IncludedSerialize());
+      insertIdx = tSerializer::AddIncludedEntry(leafNode, newObj);
       // Test if the page size is too big to store an object.
       if (insertIdx < 0){
          // Oops. There is an error during the insertion.
@@ -968,11 +1547,15 @@ bool tmpl_stSlimTree::Add(ObjectType *newObj){
             throw std::logic_error("The page size is too small to store the first object.");
          #endif //__stDEBUG__
          // The new object was not inserted.
+         tMetricTree::myPageManager->EndUpdate();
          return false;
       }else{
          // The new object was inserted.
          // It is the first object, fill the distance with zero.
          leafNode->GetLeafEntry(insertIdx).Distance = 0;
+         #ifdef __stSLIMPIVOTS__
+            SetPivotDistances(leafNode, insertIdx, newObj);
+         #endif //__stSLIMPIVOTS__
          // Update the Height
          Header->Height++;
          // Write the root node.
@@ -998,41 +1581,271 @@ bool tmpl_stSlimTree::Add(ObjectType *newObj){
    }//end if
 
    // Update object count.
-   UpdateObjectCounter(1);
+   if (Header->NodeCount == nodeCount){
+      // No split. The resident levels were updated by InsertRecursive().
+      Header->ObjectCount++;
+      NotifyInsertion();
+   }else{
+      UpdateObjectCounter(1);
+   }//end if
+
+   #ifdef __stSLIMRKNN__
+      // Update the k-th nearest neighbor distances changed by the new object.
+      if (Header->KNNDistanceK > 0){
+         ObjectType tmpObj;
+
+         UpdateKNNDistances(this->GetRoot(), newObj, -1, tmpObj);
+      }//end if
+   #endif //__stSLIMRKNN__
 
    // Report the modification.
    HeaderUpdate = true;
+   tMetricTree::myPageManager->EndUpdate();
    // Ok. The new object was inserted. Return success!
    return true;
 }//end stSlimTree<ObjectType, EvaluatorType>::Add
 
 //------------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
-int tmpl_stSlimTree::ChooseSubTree(
-      stSlimIndexNode * slimIndexNode, ObjectType * obj) {
-   u_int32_t idx;
-   //int j;
-   int * candidates;
-   int candidateCount;
-   bool stop;
-   u_int32_t tmpNumberOfEntries;
-   int numberOfEntries, minIndex = 0;
+bool tmpl_stSlimTree::ConcurrentAdd(ObjectType * newObj){
+   stConcurrentPageManager::tLatchMode oldMode;
+   bool inserted;
+   bool optimistic = true;
 
-   ObjectType * objectType = new ObjectType;
-   double distance;
-   double minDistance = MAXDOUBLE; // Largest magnitude double value
-   // Get the total number of entries.
-   numberOfEntries = slimIndexNode->GetNumberOfEntries();
-   idx = 0;
+   // Single-threaded fast path.
+   if (ConcurrentPageManager == NULL){
+      return Add(newObj);
+   }//end if
 
-   switch (this->GetChooseMethod()){
-      case stSlimTree::cmBIASED :
+   #ifdef __stSLIMRKNN__
+      // Only Add() maintains the k-th nearest neighbor distances.
+      optimistic = Header->KNNDistanceK == 0;
+   #endif //__stSLIMRKNN__
+
+   // Try first without changing the structure.
+   {
+      stSharedLatchGuard treeLatch(&TreeLatch);
+      inserted = optimistic && (this->GetRoot() != 0) &&
+            OptimisticInsert(newObj);
+   }
+   if (!inserted){
+      // A split (or the first root) is required. Nobody else may use the
+      // tree now, so the pages need no latches.
+      std::lock_guard < stLatch > treeLatch(TreeLatch);
+      oldMode = stConcurrentPageManager::SetThreadLatchMode(
+            stConcurrentPageManager::lmNONE);
+      inserted = Add(newObj);
+      WriteHeader();
+      stConcurrentPageManager::SetThreadLatchMode(oldMode);
+   }//end if
+
+   return inserted;
+}//end stSlimTree<ObjectType, EvaluatorType>::ConcurrentAdd
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+bool tmpl_stSlimTree::OptimisticInsert(ObjectType * newObj){
+   stConcurrentPageManager::tLatchMode oldMode;
+   stPage * currPage;
+   stSlimNode * currNode;
+   stSlimIndexNode * indexNode;
+   stSlimLeafNode * leafNode;
+   ObjectType subRep;
+   std::vector < u_int32_t > pathPageID;
+   std::vector < int > pathEntry;
+   std::vector < double > pathDistance;
+   std::vector < u_int32_t > pathNEntries;
+   std::vector < double > pathRadius;
+   u_int32_t pageID;
+   u_int32_t level;
+   u_int32_t i;
+   int subtree;
+   int insertIdx;
+   double dist = 0;
+
+   // The structure can not change while TreeLatch is held, so the path is
+   // chosen reading the index nodes in shared mode, one at a time.
+   pageID = this->GetRoot();
+   for (level = 1; level < Header->Height; level++){
+      currPage = tMetricTree::myPageManager->GetPage(pageID);
+      indexNode = (stSlimIndexNode *) stSlimNode::CreateNode(currPage);
+
+      subtree = ChooseSubTree(indexNode, newObj);
+      tSerializer::UnserializeFrom(&subRep, indexNode->GetObject(subtree),
+                                   indexNode->GetObjectSize(subtree));
+      dist = this->myMetricEvaluator->GetDistance(subRep, *newObj);
+
+      pathPageID.push_back(pageID);
+      pathEntry.push_back(subtree);
+      pathDistance.push_back(dist);
+      pageID = indexNode->GetIndexEntry(subtree).PageID;
+
+      delete indexNode;
+      tMetricTree::myPageManager->ReleasePage(currPage);
+   }//end for
+
+   // The leaf is latched in exclusive mode.
+   tMetricTree::myPageManager->BeginUpdate();
+   oldMode = stConcurrentPageManager::SetThreadLatchMode(
+         stConcurrentPageManager::lmEXCLUSIVE);
+   currPage = tMetricTree::myPageManager->GetPage(pageID);
+   currNode = stSlimNode::CreateNode(currPage);
+   leafNode = (stSlimLeafNode *) currNode;
+   insertIdx = tSerializer::AddIncludedEntry(leafNode, newObj);
+   if (insertIdx >= 0){
+      // Distance to the representative (dist is 0 if the root is a leaf).
+      leafNode->GetLeafEntry(insertIdx).Distance = dist;
+      #ifdef __stSLIMPIVOTS__
+         SetPivotDistances(leafNode, insertIdx, newObj);
+      #endif //__stSLIMPIVOTS__
+      tMetricTree::myPageManager->WritePage(currPage);
+   }//end if
+   delete currNode;
+   tMetricTree::myPageManager->ReleasePage(currPage);
+
+   if (insertIdx >= 0){
+      // Update the radius and the number of entries of the ancestors.
+      for (i = 0; i < pathPageID.size(); i++){
+         currPage = tMetricTree::myPageManager->GetPage(pathPageID[i]);
+         indexNode = (stSlimIndexNode *) stSlimNode::CreateNode(currPage);
+         indexNode->GetIndexEntry(pathEntry[i]).NEntries++;
+         if (indexNode->GetIndexEntry(pathEntry[i]).Radius < pathDistance[i]){
+            indexNode->GetIndexEntry(pathEntry[i]).Radius = pathDistance[i];
+         }//end if
+         pathNEntries.push_back(indexNode->GetIndexEntry(pathEntry[i]).NEntries);
+         pathRadius.push_back(indexNode->GetIndexEntry(pathEntry[i]).Radius);
+         tMetricTree::myPageManager->WritePage(currPage);
+         delete indexNode;
+         tMetricTree::myPageManager->ReleasePage(currPage);
+      }//end for
+
+      // The same entries of the resident levels. The pages are released, so
+      // a build of the resident levels can not wait for this thread.
+      for (i = 0; i < pathPageID.size(); i++){
+         UpdateResidentEntry(pathPageID[i], pathEntry[i], pathNEntries[i],
+               pathRadius[i]);
+      }//end for
+
+      // Update object count.
+      __atomic_add_fetch(&Header->ObjectCount, 1, __ATOMIC_RELAXED);
+      __atomic_store_n(&HeaderUpdate, true, __ATOMIC_RELAXED);
+      NotifyInsertion();
+   }//end if
+   stConcurrentPageManager::SetThreadLatchMode(oldMode);
+   tMetricTree::myPageManager->EndUpdate();
+
+   return insertIdx >= 0;
+}//end stSlimTree<ObjectType, EvaluatorType>::OptimisticInsert
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void tmpl_stSlimTree::SetConcurrent(bool concurrent){
+
+   if ((concurrent) && (ConcurrentPageManager == NULL)){
+      ConcurrentPageManager = new stConcurrentPageManager(tMetricTree::myPageManager);
+      tMetricTree::myPageManager = ConcurrentPageManager;
+   }else if ((!concurrent) && (ConcurrentPageManager != NULL)){
+      tMetricTree::myPageManager = ConcurrentPageManager->GetPageManager();
+      delete ConcurrentPageManager;
+      ConcurrentPageManager = NULL;
+   }//end if
+}//end stSlimTree<ObjectType, EvaluatorType>::SetConcurrent
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void tmpl_stSlimTree::SetSnapshotIsolation(bool enabled){
+
+   if ((enabled) && (SnapshotPageManager == NULL)){
+      SnapshotPageManager = new stSnapshotPageManager(tMetricTree::myPageManager);
+      tMetricTree::myPageManager = SnapshotPageManager;
+      // The current state is the first snapshot.
+      CommitSnapshot();
+   }else if ((!enabled) && (SnapshotPageManager != NULL)){
+      tMetricTree::myPageManager = SnapshotPageManager->GetPageManager();
+      delete SnapshotPageManager;
+      SnapshotPageManager = NULL;
+   }//end if
+}//end stSlimTree<ObjectType, EvaluatorType>::SetSnapshotIsolation
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void tmpl_stSlimTree::CommitSnapshot(){
+
+   if (SnapshotPageManager != NULL){
+      // The header is always published with the pages.
+      tMetricTree::myPageManager->WriteHeaderPage(HeaderPage);
+      HeaderUpdate = false;
+      SnapshotPageManager->Commit();
+   }//end if
+}//end stSlimTree<ObjectType, EvaluatorType>::CommitSnapshot
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+bool tmpl_stSlimTree::BeginReadView(){
+   stSlimHeader header;
+   tReadView * view;
+
+   if (SnapshotPageManager == NULL){
+      return false;
+   }//end if
+
+   SnapshotPageManager->BeginSnapshot(&header, sizeof(header));
+   view = new tReadView;
+   view->Tree = this;
+   view->Root = header.Root;
+   view->Height = header.Height;
+   view->ObjectCount = header.ObjectCount;
+   view->Previous = ThreadReadView;
+   ThreadReadView = view;
+
+   return true;
+}//end stSlimTree<ObjectType, EvaluatorType>::BeginReadView
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void tmpl_stSlimTree::EndReadView(){
+   tReadView ** link = &ThreadReadView;
+   tReadView * view;
+
+   // Unlink the most recent view of this tree.
+   while ((*link != NULL) && ((*link)->Tree != this)){
+      link = &((*link)->Previous);
+   }//end while
+   view = *link;
+   if (view != NULL){
+      *link = view->Previous;
+      delete view;
+      SnapshotPageManager->EndSnapshot();
+   }//end if
+}//end stSlimTree<ObjectType, EvaluatorType>::EndReadView
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+int tmpl_stSlimTree::ChooseSubTree(
+      stSlimIndexNode * slimIndexNode, ObjectType * obj) {
+   u_int32_t idx;
+   //int j;
+   int * candidates;
+   int candidateCount;
+   bool stop;
+   u_int32_t tmpNumberOfEntries;
+   int numberOfEntries, minIndex = 0;
+
+   ObjectType * objectType = new ObjectType;
+   double distance;
+   double minDistance = MAXDOUBLE; // Largest magnitude double value
+   // Get the total number of entries.
+   numberOfEntries = slimIndexNode->GetNumberOfEntries();
+   idx = 0;
+
+   switch (this->GetChooseMethod()){
+      case stSlimTree::cmBIASED :
          // Find the first subtree that covers the new object.
          stop = (idx >= numberOfEntries);
          while (!stop){
             // Get the object from idx position from IndexNode
-            objectType->Unserialize(slimIndexNode->GetObject(idx),
-                                    slimIndexNode->GetObjectSize(idx));
+            tSerializer::UnserializeFrom(objectType, slimIndexNode->GetObject(idx),
+                                         slimIndexNode->GetObjectSize(idx));
             // Calculate the distance.
             distance = this->myMetricEvaluator->GetDistance(*objectType, *obj);
             // is this a subtree that covers the new object?
@@ -1063,8 +1876,8 @@ int tmpl_stSlimTree::ChooseSubTree(
 		 /* Find if there is some circle that contains obj */
          for (idx = 0; idx < numberOfEntries; idx++) {
             // Recover the object from the IndexNode.
-            objectType->Unserialize(slimIndexNode->GetObject(idx),
-                                    slimIndexNode->GetObjectSize(idx));
+            tSerializer::UnserializeFrom(objectType, slimIndexNode->GetObject(idx),
+                                         slimIndexNode->GetObjectSize(idx));
             // Calculate the distance between the object and the candidate nodes.
             distance = this->myMetricEvaluator->GetDistance(*objectType, *obj);
             
@@ -1096,8 +1909,8 @@ int tmpl_stSlimTree::ChooseSubTree(
          stop = (idx >= numberOfEntries);
          while (!stop){
             //get out the object from IndexNode
-            objectType->Unserialize(slimIndexNode->GetObject(idx),
-                                    slimIndexNode->GetObjectSize(idx));
+            tSerializer::UnserializeFrom(objectType, slimIndexNode->GetObject(idx),
+                                         slimIndexNode->GetObjectSize(idx));
             // Calculate the distance.
             distance = this->myMetricEvaluator->GetDistance(*objectType, *obj);
             // find the first subtree that cover the new object.
@@ -1116,8 +1929,8 @@ int tmpl_stSlimTree::ChooseSubTree(
          // Try to find a better entry.
          while (idx < numberOfEntries) {
             // Get out the object from IndexNode.
-            objectType->Unserialize(slimIndexNode->GetObject(idx),
-                                    slimIndexNode->GetObjectSize(idx));
+            tSerializer::UnserializeFrom(objectType, slimIndexNode->GetObject(idx),
+                                         slimIndexNode->GetObjectSize(idx));
             // Calculate the distance.                                    
             distance = this->myMetricEvaluator->GetDistance(*objectType, *obj);
             if ((distance < slimIndexNode->GetIndexEntry(idx).Radius) && (distance < minDistance)) {
@@ -1132,8 +1945,8 @@ int tmpl_stSlimTree::ChooseSubTree(
          // Find if there is some circle that contains obj
          for (idx = 0; idx < numberOfEntries; idx++) {
             // Get out the object from IndexNode.
-            objectType->Unserialize(slimIndexNode->GetObject(idx),
-                                    slimIndexNode->GetObjectSize(idx));
+            tSerializer::UnserializeFrom(objectType, slimIndexNode->GetObject(idx),
+                                         slimIndexNode->GetObjectSize(idx));
             // Calculate the distance.
             distance = this->myMetricEvaluator->GetDistance(*objectType, *obj);
             if (distance < minDistance) {
@@ -1150,8 +1963,8 @@ int tmpl_stSlimTree::ChooseSubTree(
          stop = (idx >= numberOfEntries);
          while (!stop){
             //get out the object from IndexNode
-            objectType->Unserialize(slimIndexNode->GetObject(idx),
-                                    slimIndexNode->GetObjectSize(idx));
+            tSerializer::UnserializeFrom(objectType, slimIndexNode->GetObject(idx),
+                                         slimIndexNode->GetObjectSize(idx));
             // Calculate the distance.
             distance = this->myMetricEvaluator->GetDistance(*objectType, *obj);
             // find the first subtree that covers the new object.
@@ -1171,8 +1984,8 @@ int tmpl_stSlimTree::ChooseSubTree(
 
          while (idx < numberOfEntries) {
             // Get out the object from IndexNode
-            objectType->Unserialize(slimIndexNode->GetObject(idx),
-                                    slimIndexNode->GetObjectSize(idx));
+            tSerializer::UnserializeFrom(objectType, slimIndexNode->GetObject(idx),
+                                         slimIndexNode->GetObjectSize(idx));
             // Calculate the distance.
             distance = this->myMetricEvaluator->GetDistance(*objectType, *obj);
 
@@ -1214,14 +2027,14 @@ void tmpl_stSlimTree::AddNewRoot(
    newRoot = new stSlimIndexNode(newPage, true);
 
    // Add obj1
-   idx = newRoot->AddEntry(obj1->GetSerializedSize(), obj1->Serialize());
+   idx = tSerializer::AddEntry(newRoot, obj1);
    newRoot->GetIndexEntry(idx).Distance = 0.0;
    newRoot->GetIndexEntry(idx).PageID = nodeID1;
    newRoot->GetIndexEntry(idx).Radius = radius1;
    newRoot->GetIndexEntry(idx).NEntries = nEntries1;
 
    // Add obj2
-   idx = newRoot->AddEntry(obj2->GetSerializedSize(), obj2->Serialize());
+   idx = tSerializer::AddEntry(newRoot, obj2);
    newRoot->GetIndexEntry(idx).Distance = 0.0;
    newRoot->GetIndexEntry(idx).PageID = nodeID2;
    newRoot->GetIndexEntry(idx).Radius = radius2;
@@ -1269,8 +2082,8 @@ int tmpl_stSlimTree::InsertRecursive(
 
       // Lets get the information about this tree.
       subRep = new ObjectType();
-      subRep->Unserialize(indexNode->GetObject(subtree),
-                          indexNode->GetObjectSize(subtree));
+      tSerializer::UnserializeFrom(subRep, indexNode->GetObject(subtree),
+                                   indexNode->GetObjectSize(subtree));
 
       // Try to insert...
       switch (InsertRecursive(indexNode->GetIndexEntry(subtree).PageID,
@@ -1278,6 +2091,8 @@ int tmpl_stSlimTree::InsertRecursive(
          case NO_ACT: // Update Radius and count.
             indexNode->GetIndexEntry(subtree).NEntries++;
             indexNode->GetIndexEntry(subtree).Radius = promo1.Radius;
+            UpdateResidentEntry(currNodeID, subtree,
+                  indexNode->GetIndexEntry(subtree).NEntries, promo1.Radius);
 
             // Returning status.
             promo1.NObjects = indexNode->GetTotalObjectCount();
@@ -1289,8 +2104,7 @@ int tmpl_stSlimTree::InsertRecursive(
             indexNode->RemoveEntry(subtree);
 
             // Try to add the new entry...
-            insertIdx = indexNode->AddEntry(promo1.Rep->GetSerializedSize(),
-                                            promo1.Rep->Serialize());
+            insertIdx = tSerializer::AddEntry(indexNode, promo1.Rep);
             if (insertIdx >= 0){
                // Swap OK. Fill data.
                indexNode->GetIndexEntry(insertIdx).Radius = promo1.Radius;
@@ -1360,8 +2174,7 @@ int tmpl_stSlimTree::InsertRecursive(
                indexNode->GetIndexEntry(subtree).PageID = promo1.RootID;
 
                // Try to insert the promo2.Rep
-               insertIdx = indexNode->AddEntry(promo2.Rep->GetSerializedSize(),
-                                               promo2.Rep->Serialize());
+               insertIdx = tSerializer::AddEntry(indexNode, promo2.Rep);
                if (insertIdx >= 0){
                   // Swap OK. Fill data.
                   indexNode->GetIndexEntry(insertIdx).NEntries = promo2.NObjects;
@@ -1409,8 +2222,7 @@ int tmpl_stSlimTree::InsertRecursive(
                indexNode->RemoveEntry(subtree);
 
                // Try to add the new entry...
-               insertIdx = indexNode->AddEntry(promo1.Rep->GetSerializedSize(),
-                                               promo1.Rep->Serialize());
+               insertIdx = tSerializer::AddEntry(indexNode, promo1.Rep);
                if (insertIdx >= 0){
                   // Swap OK. Fill data.
                   indexNode->GetIndexEntry(insertIdx).Radius = promo1.Radius;
@@ -1451,8 +2263,7 @@ int tmpl_stSlimTree::InsertRecursive(
                   }//end if
 
                   // Try to add promo2
-                  insertIdx = indexNode->AddEntry(promo2.Rep->GetSerializedSize(),
-                                                  promo2.Rep->Serialize());
+                  insertIdx = tSerializer::AddEntry(indexNode, promo2.Rep);
                   if (insertIdx >= 0){
                      // Swap OK. Fill data.
                      indexNode->GetIndexEntry(insertIdx).Radius = promo2.Radius;
@@ -1543,8 +2354,7 @@ int tmpl_stSlimTree::InsertRecursive(
       leafNode = (stSlimLeafNode *) currNode;
 
       // Try to insert...
-      insertIdx = leafNode->AddEntry(newObj->GetIncludedSerializedSize(),
-                                     newObj->IncludedSerialize());
+      insertIdx = tSerializer::AddIncludedEntry(leafNode, newObj);
       if (insertIdx >= 0){
          // Don't split!
          // Calculate distance and verify if it is a new radius!
@@ -1556,6 +2366,9 @@ int tmpl_stSlimTree::InsertRecursive(
 
          // Fill entry's fields
          leafNode->GetLeafEntry(insertIdx).Distance = dist;
+         #ifdef __stSLIMPIVOTS__
+            SetPivotDistances(leafNode, insertIdx, newObj);
+         #endif //__stSLIMPIVOTS__
 
          // Write node.
          tMetricTree::myPageManager->WritePage(currPage);
@@ -1569,7 +2382,7 @@ int tmpl_stSlimTree::InsertRecursive(
       }else{
          // Split it!
          // New node.
-         newPage = this->NewPage();
+         newPage = this->NewPage(true);
          newLeafNode = new stSlimLeafNode(newPage, true);
 
          // Split!
@@ -1620,78 +2433,337 @@ void tmpl_stSlimTree::RandomPromote(tLogicNode * node) {
 template <class ObjectType, class EvaluatorType>
 void tmpl_stSlimTree::MinMaxPromote(tLogicNode * node) {
 
-   double iRadius, jRadius, min;
-   u_int32_t numberOfEntries, idx1, idx2, i, j;
-   stPage * newPage1 = new stPage(tMetricTree::myPageManager->GetMinimumPageSize());
-   stPage * newPage2 = new stPage(tMetricTree::myPageManager->GetMinimumPageSize());
+   double * distances;
+   u_int32_t * sizes;
+   double minRadius;
+   u_int32_t numberOfEntries, capacity, nThreads, idx1, idx2, i, j, t;
+   stPage * newPage;
 
+   // Leaves may have their own page size.
+   if (node->GetNodeType() == stSlimNode::INDEX){
+      newPage = new stPage(tMetricTree::myPageManager->GetMinimumPageSize());
+   }else{
+      newPage = new stPage(tMetricTree::myPageManager->GetLeafPageSize());
+   }//end if
    numberOfEntries = node->GetNumberOfEntries();
-   min = MAXDOUBLE;   // Largest magnitude double value
+   sizes = new u_int32_t[numberOfEntries];
 
-   // Is it an Index node?
+   // Free space of an empty node and the space used by each entry.
    if (node->GetNodeType() == stSlimNode::INDEX) {
-      stSlimIndexNode * indexNode1 = new stSlimIndexNode(newPage1, true);
-      stSlimIndexNode * indexNode2 = new stSlimIndexNode(newPage2, true);
-
-      for (i = 0; i < numberOfEntries; i++) {
-         for (j = i + 1; j < numberOfEntries; j++) {
-            node->SetRepresentative(i, j);
-            indexNode1->RemoveAll();
-            indexNode2->RemoveAll();
-            node->TestDistribution(indexNode1, indexNode2, this->myMetricEvaluator);
-            iRadius = indexNode1->GetMinimumRadius();
-            jRadius = indexNode2->GetMinimumRadius();
-            if (iRadius < jRadius){
-               iRadius = jRadius;      // take the maximum
-            }//end if
-            if (iRadius < min) {
-               min = iRadius;
-               idx1 = i;
-               idx2 = j;
-            }//end if
-         }//end for
+      stSlimIndexNode * indexNode = new stSlimIndexNode(newPage, true);
+      capacity = indexNode->GetFree();
+      delete indexNode;
+      for (i = 0; i < numberOfEntries; i++){
+         sizes[i] = sizeof(stSlimIndexNode::stSlimIndexEntry) +
+                    node->GetObject(i)->GetSerializedSize();
       }//end for
-      delete indexNode1;
-	  indexNode1 = 0;
-      delete indexNode2;
-	  indexNode2 = 0;
    }else{//it is a Leaf node
-      stSlimLeafNode * leafNode1 = new stSlimLeafNode(newPage1, true);
-      stSlimLeafNode * leafNode2 = new stSlimLeafNode(newPage2, true);
-
-      for (i = 0; i < numberOfEntries; i++) {
-         for (j = i + 1; j < numberOfEntries; j++) {
-            node->SetRepresentative(i, j);
-            leafNode1->RemoveAll();
-            leafNode2->RemoveAll();
-            node->TestDistribution(leafNode1, leafNode2, this->myMetricEvaluator);
-            iRadius = leafNode1->GetMinimumRadius();
-            jRadius = leafNode2->GetMinimumRadius();
-            if (iRadius < jRadius){
-               iRadius = jRadius;      // take the maximum
-            }//end if
-            if (iRadius < min) {
-               min = iRadius;
-               idx1 = i;
-               idx2 = j;
-            }//end if
-         }//end for
+      stSlimLeafNode * leafNode = new stSlimLeafNode(newPage, true);
+      capacity = leafNode->GetFree();
+      delete leafNode;
+      for (i = 0; i < numberOfEntries; i++){
+         sizes[i] = sizeof(stSlimLeafNode::stSlimLeafEntry) +
+                    node->GetObject(i)->GetIncludedSerializedSize();
+      }//end for
+   }//end if
+   delete newPage;
+   newPage = 0;
+
+   // The distance matrix is computed only once. All pairs are evaluated
+   // from it and only the winner is materialized by Distribute().
+   distances = new double[numberOfEntries * numberOfEntries];
+   for (i = 0; i < numberOfEntries; i++){
+      distances[(i * numberOfEntries) + i] = 0;
+      for (j = i + 1; j < numberOfEntries; j++){
+         distances[(i * numberOfEntries) + j] = this->myMetricEvaluator->GetDistance(
+               *node->GetObject(i), *node->GetObject(j));
+         distances[(j * numberOfEntries) + i] = distances[(i * numberOfEntries) + j];
+      }//end for
+   }//end for
+
+   // Large nodes have their pairs evaluated in parallel.
+   nThreads = 1;
+   if (numberOfEntries >= STMINMAXPARALLELENTRIES){
+      nThreads = std::thread::hardware_concurrency();
+      if (nThreads > numberOfEntries){
+         nThreads = numberOfEntries;
+      }//end if
+   }//end if
+   if (nThreads <= 1){
+      MinMaxEvaluate(node, distances, sizes, capacity, 0, 1, minRadius, idx1, idx2);
+   }else{
+      std::vector < double > radius(nThreads);
+      std::vector < u_int32_t > first(nThreads);
+      std::vector < u_int32_t > second(nThreads);
+      std::vector < std::thread > threads;
+
+      for (t = 0; t < nThreads; t++){
+         threads.push_back(std::thread(&tmpl_stSlimTree::MinMaxEvaluate, this,
+               node, distances, sizes, capacity, t, nThreads,
+               std::ref(radius[t]), std::ref(first[t]), std::ref(second[t])));
+      }//end for
+      for (t = 0; t < nThreads; t++){
+         threads[t].join();
+      }//end for
+
+      // Same choice as the sequential evaluation: the smallest radius and,
+      // in case of ties, the first pair.
+      minRadius = radius[0];
+      idx1 = first[0];
+      idx2 = second[0];
+      for (t = 1; t < nThreads; t++){
+         if ((radius[t] < minRadius) ||
+               ((radius[t] == minRadius) && ((first[t] < idx1) ||
+               ((first[t] == idx1) && (second[t] < idx2))))){
+            minRadius = radius[t];
+            idx1 = first[t];
+            idx2 = second[t];
+         }//end if
       }//end for
-      delete leafNode1;
-	  leafNode1 = 0;
-      delete leafNode2;
-	  leafNode2 = 0;
-   }//end else
+   }//end if
 
    // Choose representatives
    node->SetRepresentative(idx1, idx2);
 
-   delete newPage1;
-   newPage1 = 0;
-   delete newPage2;
-   newPage2 = 0;
+   delete[] distances;
+   distances = 0;
+   delete[] sizes;
+   sizes = 0;
 }//end stSlimTree<ObjectType, EvaluatorType>::MinMaxPromote
 
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void tmpl_stSlimTree::MinMaxEvaluate(tLogicNode * node,
+      const double * distances, const u_int32_t * sizes, u_int32_t capacity,
+      u_int32_t first, u_int32_t step, double & minRadius, u_int32_t & idx1,
+      u_int32_t & idx2){
+   u_int32_t numberOfEntries, i, j;
+   double radius;
+   doubleIndex * sorted0;
+   doubleIndex * sorted1;
+   bool * mapped;
+
+   numberOfEntries = node->GetNumberOfEntries();
+   sorted0 = new doubleIndex[numberOfEntries];
+   sorted1 = new doubleIndex[numberOfEntries];
+   mapped = new bool[numberOfEntries];
+
+   minRadius = MAXDOUBLE;
+   idx1 = idx2 = numberOfEntries;
+   for (i = first; i < numberOfEntries; i += step){
+      for (j = i + 1; j < numberOfEntries; j++){
+         radius = node->TestDistribution(i, j, distances, sizes, capacity,
+                                         sorted0, sorted1, mapped);
+         if (radius < minRadius){
+            minRadius = radius;
+            idx1 = i;
+            idx2 = j;
+         }//end if
+      }//end for
+   }//end for
+
+   delete[] sorted0;
+   delete[] sorted1;
+   delete[] mapped;
+}//end stSlimTree<ObjectType, EvaluatorType>::MinMaxEvaluate
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+bool tmpl_stSlimTree::BulkLoadMedoids(ObjectType ** objects, u_int32_t numObj,
+      double nodeOccupancy, u_int32_t nThreads){
+   std::vector < ObjectType * > all(objects, objects + numObj);
+   std::vector < ObjectType * > overflow;
+   std::vector < u_int32_t > sizes(numObj);
+   std::vector < double > distances(numObj, 0);
+   stSubtreeInfo info;
+   stPage * tmpPage;
+   u_int32_t fanout, indexFree, height, i;
+   double leafCapacity, capacity, total;
+
+   if (this->GetRoot() != 0){
+      return false;
+   }else if (numObj == 0){
+      return true;
+   }//end if
+
+   // Index nodes hold about fanout entries of average objects. The nodes
+   // whose medoids are larger than that get less entries.
+   total = 0;
+   for (i = 0; i < numObj; i++){
+      total += objects[i]->GetSerializedSize();
+   }//end for
+   tmpPage = new stPage(tMetricTree::myPageManager->GetMinimumPageSize());
+   stSlimIndexNode * indexNode = new stSlimIndexNode(tmpPage, true);
+   indexFree = indexNode->GetFree();
+   fanout = u_int32_t(indexFree * nodeOccupancy /
+         ((total / numObj) + sizeof(stSlimIndexNode::stSlimIndexEntry)));
+   delete indexNode;
+   delete tmpPage;
+   if (fanout < 2){
+      fanout = 2;
+   }//end if
+
+   // Leaves are filled up to leafCapacity bytes.
+   tmpPage = new stPage(tMetricTree::myPageManager->GetLeafPageSize());
+   stSlimLeafNode * leafNode = new stSlimLeafNode(tmpPage, true);
+   leafCapacity = leafNode->GetFree() * nodeOccupancy;
+   delete leafNode;
+   delete tmpPage;
+   total = 0;
+   for (i = 0; i < numObj; i++){
+      sizes[i] = sizeof(stSlimLeafNode::stSlimLeafEntry) +
+                 objects[i]->GetIncludedSerializedSize();
+      total += sizes[i];
+   }//end for
+
+   // Smallest height able to hold all objects.
+   height = 1;
+   capacity = leafCapacity;
+   while (capacity < total){
+      capacity *= fanout;
+      height++;
+   }//end while
+
+   tMetricTree::myPageManager->BeginUpdate();
+   tKMedoids clustering(this->myMetricEvaluator, nThreads);
+   BulkLoadMedoidsRecursive(clustering, all, sizes, distances, numObj, height,
+         fanout, indexFree, leafCapacity, nodeOccupancy, overflow, info);
+   Header->Height = height;
+   SetRoot(info.RootID);
+   UpdateObjectCounter(numObj - overflow.size());
+   HeaderUpdate = true;
+   tMetricTree::myPageManager->EndUpdate();
+
+   // Leftovers of the packing.
+   for (i = 0; i < overflow.size(); i++){
+      Add(overflow[i]);
+   }//end for
+   return true;
+}//end stSlimTree<ObjectType, EvaluatorType>::BulkLoadMedoids
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void tmpl_stSlimTree::BulkLoadMedoidsRecursive(tKMedoids & clustering,
+      std::vector < ObjectType * > & objects, std::vector < u_int32_t > & sizes,
+      std::vector < double > & distances, u_int32_t rep, u_int32_t height,
+      u_int32_t fanout, u_int32_t indexFree, double leafCapacity,
+      double nodeOccupancy, std::vector < ObjectType * > & overflow,
+      stSubtreeInfo & info){
+   u_int32_t numObj = objects.size();
+   stPage * newPage;
+   u_int32_t i, j;
+   int idx;
+
+   if (height == 1){
+      // Leaf. Entries of the root have no representative.
+      newPage = this->NewPage(true);
+      stSlimLeafNode * leafNode = new stSlimLeafNode(newPage, true);
+      for (i = 0; i < numObj; i++){
+         idx = tSerializer::AddIncludedEntry(leafNode, objects[i]);
+         if (idx < 0){
+            overflow.push_back(objects[i]);
+         }else{
+            leafNode->GetLeafEntry(idx).Distance = (rep < numObj) ?
+                  distances[i] : 0;
+            #ifdef __stSLIMPIVOTS__
+               SetPivotDistances(leafNode, idx, objects[i]);
+            #endif //__stSLIMPIVOTS__
+         }//end if
+      }//end for
+      info.Rep = (rep < numObj) ? objects[rep] : NULL;
+      info.RootID = newPage->GetPageID();
+      info.Radius = leafNode->GetMinimumRadius();
+      info.NObjects = leafNode->GetNumberOfEntries();
+      tMetricTree::myPageManager->WritePage(newPage);
+      delete leafNode;
+      tMetricTree::myPageManager->ReleasePage(newPage);
+   }else{
+      std::vector < u_int32_t > medoids;
+      std::vector < u_int32_t > cluster;
+      std::vector < double > medoidDistances;
+      std::vector < u_int32_t > position(numObj);
+      double childCapacity, maxCapacity, total;
+      u_int32_t k, used;
+      bool fit;
+
+      // Number of subtrees able to hold these objects filled up to
+      // nodeOccupancy. The free space left lets more objects join their
+      // nearest medoids.
+      childCapacity = leafCapacity;
+      for (i = 2; i < height; i++){
+         childCapacity *= fanout;
+      }//end for
+      maxCapacity = childCapacity / pow(nodeOccupancy, height - 1);
+      total = 0;
+      for (i = 0; i < numObj; i++){
+         total += sizes[i];
+      }//end for
+      k = (u_int32_t) ceil(total / childCapacity);
+      k = std::min(k, std::min(u_int32_t(fanout / nodeOccupancy), numObj));
+      k = std::max(k, 1u);
+      do{
+         k = clustering.Cluster(objects.data(), sizes.data(), numObj, rep, k,
+               maxCapacity, medoids, cluster, medoidDistances);
+
+         // Do the medoids fit the index node?
+         used = 0;
+         for (j = 0; j < k; j++){
+            used += sizeof(stSlimIndexNode::stSlimIndexEntry) +
+                    objects[medoids[j]]->GetSerializedSize();
+         }//end for
+         fit = (used <= indexFree) || (k == 1);
+         if (!fit){
+            k--;
+         }//end if
+      }while (!fit);
+
+      // Split the objects.
+      std::vector < std::vector < ObjectType * > > childObjects(k);
+      std::vector < std::vector < u_int32_t > > childSizes(k);
+      std::vector < std::vector < double > > childDistances(k);
+      for (i = 0; i < numObj; i++){
+         j = cluster[i];
+         position[i] = childObjects[j].size();
+         childObjects[j].push_back(objects[i]);
+         childSizes[j].push_back(sizes[i]);
+         childDistances[j].push_back(medoidDistances[i]);
+      }//end for
+
+      newPage = this->NewPage();
+      stSlimIndexNode * indexNode = new stSlimIndexNode(newPage, true);
+      for (j = 0; j < k; j++){
+         stSubtreeInfo childInfo;
+
+         BulkLoadMedoidsRecursive(clustering, childObjects[j], childSizes[j],
+               childDistances[j], position[medoids[j]], height - 1, fanout,
+               indexFree, leafCapacity, nodeOccupancy, overflow, childInfo);
+         // Free it as soon as possible.
+         std::vector < ObjectType * >().swap(childObjects[j]);
+         std::vector < u_int32_t >().swap(childSizes[j]);
+         std::vector < double >().swap(childDistances[j]);
+
+         idx = tSerializer::AddEntry(indexNode, objects[medoids[j]]);
+         #ifdef __stDEBUG__
+            if (idx < 0){
+               throw std::logic_error("The index entry does not fit.");
+            }//end if
+         #endif //__stDEBUG__
+         indexNode->GetIndexEntry(idx).Distance = (rep < numObj) ?
+               distances[medoids[j]] : 0;
+         indexNode->GetIndexEntry(idx).PageID = childInfo.RootID;
+         indexNode->GetIndexEntry(idx).Radius = childInfo.Radius;
+         indexNode->GetIndexEntry(idx).NEntries = childInfo.NObjects;
+      }//end for
+      info.Rep = (rep < numObj) ? objects[rep] : NULL;
+      info.RootID = newPage->GetPageID();
+      info.Radius = indexNode->GetMinimumRadius();
+      info.NObjects = indexNode->GetTotalObjectCount();
+      tMetricTree::myPageManager->WritePage(newPage);
+      delete indexNode;
+      tMetricTree::myPageManager->ReleasePage(newPage);
+   }//end if
+}//end stSlimTree<ObjectType, EvaluatorType>::BulkLoadMedoidsRecursive
+
 //------------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
 void tmpl_stSlimTree::MapSplit(stSlimLeafNode * oldNode, ObjectType *newObj) {
@@ -1930,7 +3002,12 @@ void tmpl_stSlimTree::SplitLeaf(
 
    // Add objects
    logicNode->AddLeafNode(oldNode);
-   logicNode->AddEntry(newObj);
+   #ifdef __stSLIMPIVOTS__
+      BuildPivotDistances(newObj,
+            logicNode->GetPivotDistances(logicNode->AddEntry(newObj)));
+   #else
+      logicNode->AddEntry(newObj);
+   #endif //__stSLIMPIVOTS__
 
    // Split it.
    switch (GetSplitMethod()) {
@@ -3303,365 +4380,376 @@ double tmpl_stSlimTree::GetAvgRadiusLeaf(u_int32_t pageID, u_int32_t height){
 //------------------------------------------------------------------------------
 
 template <class ObjectType, class EvaluatorType>
-double tmpl_stSlimTree::AggregateDistanceToSlimNode(double numerator, double denominator,
-    ObjectType ** sampleList, u_int32_t sampleSize, ObjectType *representativeObject, double nodeRadius, double *weights){
-
-    if (denominator == 0)
-        return 0;
-
-    int idy;
-    double distance = 0, a, b;
-
-    bool delweights = false;
-    if (weights == NULL) {
-       delweights = true;
-       weights = new double[sampleSize];
-       for (idy = 0; idy < sampleSize; idy++)
-           weights[idy] = 1.0;
-    }
+void tmpl_stSlimTree::InitAggregate(tAggregate & agg, double numerator,
+      double denominator, ObjectType ** sampleList, u_int32_t sampleSize,
+      double * weights){
+   u_int32_t idx;
 
-    if ((numerator == MAXDOUBLE) && (denominator == 1)) { // INFINITY
-        b = nodeRadius;
-        for (idy = 0; idy < sampleSize; idy++) {
-            a = this->myMetricEvaluator->GetDistance(representativeObject, sampleList[idy]);
-            if (weights[idy] * (a - b) > distance)
-                distance = weights[idy] * (a - b);
-        }
-    }
-    else if ((numerator == -MAXDOUBLE) && (denominator == 1)) { // minus INFINITY
-        distance = MAXDOUBLE;
-        b = nodeRadius;
-        for (idy = 0; idy < sampleSize; idy++) {
-            a = this->myMetricEvaluator->GetDistance(representativeObject, sampleList[idy]);
-            if (weights[idy] * (a - b) < distance)
-                distance = weights[idy] * (a - b);
-        }
-    }
-    else if (numerator/denominator > 0) {
-        b = nodeRadius;
-        for (idy = 0; idy < sampleSize; idy++) {
-            a = this->myMetricEvaluator->GetDistance(representativeObject, sampleList[idy]);
-            if (a > b)
-                distance += weights[idy] * pow(fabs(a - b), numerator/denominator);
-        }
-        if (distance != 0)
-            distance = pow(fabs(distance), denominator/numerator);
-    }
-    else if (numerator/denominator < 0) {
-        b = nodeRadius;
-        double num = 1;
-        double den = 0;
-        for (idy = 0; idy < sampleSize; idy++) {
-            a = this->myMetricEvaluator->GetDistance(representativeObject, sampleList[idy]);
-            if (a > b) {
-                num = num * pow(fabs(a - b), fabs(numerator));
-                den = den + pow(fabs(a - b), fabs(numerator));
-            }
-            else {
-                num = 0;
-                idy = sampleSize;
-            }
-        }
-        if (den != 0)
-           distance = num / den;
-        if (distance != 0)
-            distance = pow(fabs(distance), 1.0/fabs(numerator));
-    }
+   agg.Samples = sampleList;
+   agg.SampleSize = sampleSize;
+   agg.Weights.resize(sampleSize);
+   for (idx = 0; idx < sampleSize; idx++){
+      agg.Weights[idx] = (weights != NULL) ? weights[idx] : 1.0;
+   }//end for
+   agg.Numerator = numerator;
+   agg.Power = 0;
+   agg.InversePower = 0;
+   if (denominator == 0){
+      agg.Kind = aggNONE;
+   }else if ((numerator == MAXDOUBLE) && (denominator == 1)){
+      agg.Kind = aggMAX;
+   }else if ((numerator == -MAXDOUBLE) && (denominator == 1)){
+      agg.Kind = aggMIN;
+   }else{
+      agg.Kind = (numerator / denominator > 0) ? aggPOWER : aggNEGATIVE;
+      agg.Power = numerator / denominator;
+      agg.InversePower = denominator / numerator;
+   }//end if
 
-    if (delweights) {
-        delete[]weights;
-        weights = NULL;
-    }
+   // One vector of distances for each level.
+   agg.Levels.resize(GetHeight() + 1);
+   for (idx = 0; idx < agg.Levels.size(); idx++){
+      agg.Levels[idx].resize(sampleSize);
+   }//end for
+}//end InitAggregate
 
-    return distance;
-}
 //------------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
-double tmpl_stSlimTree::GroupDistance(
-          double numerator, double denominator, ObjectType ** sampleList, u_int32_t sampleSize, ObjectType *obj, double *weights) {
-
-    if (denominator == 0)
-        return 0;
-
-    u_int32_t idx;
-    double distance = 0.0, tmpdistance;
-
-    bool delweights = false;
-    if (weights == NULL) {
-       delweights = true;
-       weights = new double[sampleSize];
-       for (idx = 0; idx < sampleSize; idx++)
-           weights[idx] = 1.0;
-    }
-
-    if ((numerator == MAXDOUBLE) && (denominator == 1)) { // INFINITY
-        for (idx = 0; idx < sampleSize; idx++) {
-            // Evaluate distance
-            tmpdistance = this->myMetricEvaluator->GetDistance(obj, sampleList[idx]);
-            if (weights[idx] * tmpdistance > distance) {
-                distance = weights[idx] * tmpdistance;
-            }
-        }//end for
-    }
-    else if ((numerator == -MAXDOUBLE) && (denominator == 1)) { // minus INFINITY
-        distance = MAXDOUBLE;
-        // For each sample object
-        for (idx = 0; idx < sampleSize; idx++) {
-            // Evaluate distance
-            tmpdistance = this->myMetricEvaluator->GetDistance(obj, sampleList[idx]);
-            if (weights[idx] * tmpdistance < distance) {
-                distance = weights[idx] * tmpdistance;
-            }
-        }//end for
-    }
-    else { 
-       // For each sample object
-       for (idx = 0; idx < sampleSize; idx++) {
-          // Evaluate distance
-          tmpdistance = this->myMetricEvaluator->GetDistance(obj, sampleList[idx]);
-          if (tmpdistance != 0)
-              distance += weights[idx] * pow(fabs(tmpdistance),numerator/denominator);
-       }//end for
-       if (distance != 0)
-           distance = pow(fabs(distance),denominator/numerator);
-    }
+double tmpl_stSlimTree::AggregateValue(const tAggregate & agg,
+      const double * distances, double radius, bool node){
+   double distance = 0;
+   double term;
+   double num;
+   double den;
+   u_int32_t idx;
 
-    if (delweights) {
-        delete[]weights;
-        weights = NULL;
-    }
+   switch (agg.Kind){
+      case aggNONE:
+         break;
+      case aggMAX:
+         for (idx = 0; idx < agg.SampleSize; idx++){
+            term = agg.Weights[idx] * (distances[idx] - radius);
+            if (term > distance){
+               distance = term;
+            }//end if
+         }//end for
+         break;
+      case aggMIN:
+         distance = MAXDOUBLE;
+         for (idx = 0; idx < agg.SampleSize; idx++){
+            term = agg.Weights[idx] * (distances[idx] - radius);
+            if (term < distance){
+               distance = term;
+            }//end if
+         }//end for
+         break;
+      case aggPOWER:
+         for (idx = 0; idx < agg.SampleSize; idx++){
+            if (distances[idx] > radius){
+               distance += agg.Weights[idx] * AggregateTerm(agg, distances[idx] - radius);
+            }//end if
+         }//end for
+         if (distance != 0){
+            if (agg.Power == 1){
+               distance = fabs(distance);
+            }else if (agg.Power == 2){
+               distance = sqrt(fabs(distance));
+            }else{
+               distance = pow(fabs(distance), agg.InversePower);
+            }//end if
+         }//end if
+         break;
+      case aggNEGATIVE:
+         if (node){
+            num = 1;
+            den = 0;
+            for (idx = 0; idx < agg.SampleSize; idx++){
+               if (distances[idx] > radius){
+                  term = pow(fabs(distances[idx] - radius), fabs(agg.Numerator));
+                  num = num * term;
+                  den = den + term;
+               }else{
+                  num = 0;
+                  break;
+               }//end if
+            }//end for
+            if (den != 0){
+               distance = num / den;
+            }//end if
+            if (distance != 0){
+               distance = pow(fabs(distance), 1.0 / fabs(agg.Numerator));
+            }//end if
+         }else{
+            for (idx = 0; idx < agg.SampleSize; idx++){
+               if (distances[idx] != 0){
+                  distance += agg.Weights[idx] * AggregateTerm(agg, distances[idx]);
+               }//end if
+            }//end for
+            if (distance != 0){
+               distance = pow(fabs(distance), agg.InversePower);
+            }//end if
+         }//end if
+         break;
+   }//end switch
+   return distance;
+}//end AggregateValue
 
-    return distance;
-}//end GroupDistance
 //------------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
-stResult<ObjectType> * tmpl_stSlimTree::AggregateRangeQuery(
-          double numerator, double denominator, ObjectType ** sampleList, u_int32_t sampleSize, double range, double *weights) {
+bool tmpl_stSlimTree::AggregateDistances(const tAggregate & agg,
+      ObjectType & obj, double * distances, bool bounded, double radius,
+      double limit){
+   double sum = 0;
+   double sumLimit = MAXDOUBLE;
+   double largest = 0;
+   double distance;
+   u_int32_t idx;
 
-   tResult * result = new tResult();  // Create result
-   stPage * currPage;
-   stSlimNode * currNode;
-   ObjectType tmpObj;
-   u_int32_t idx, idy;
-   double distance, a, b;
-
-   // Set the information.
-   //result->SetQueryInfo(sample->Clone(), RANGEQUERY, -1, range, false);
-
-   if (weights == NULL) {
-       weights = new double[sampleSize];
-       for (idx = 0; idx < sampleSize; idx++)
-           weights[idx] = 1.0;
-   }
+   if (agg.Kind == aggPOWER){
+      // The sum of the terms, using the lower bounds for the distances not
+      // computed yet. The limit has a small slack for the rounding of the
+      // root taken at the end.
+      if (limit < MAXDOUBLE){
+         sumLimit = AggregateTerm(agg, limit) * (1 + 1e-9);
+      }//end if
+      for (idx = 0; (bounded) && (idx < agg.SampleSize); idx++){
+         if (distances[idx] > radius){
+            sum += agg.Weights[idx] * AggregateTerm(agg, distances[idx] - radius);
+         }//end if
+      }//end for
+   }//end if
 
-   // Evaluate the root node.
-   if (this->GetRoot() != 0){
-      currPage = this->myPageManager->GetPage(this->GetRoot());
-      currNode = stSlimNode::CreateNode(currPage);
+   for (idx = 0; idx < agg.SampleSize; idx++){
+      distance = this->myMetricEvaluator->GetDistance(obj, *agg.Samples[idx]);
+      if (agg.Kind == aggPOWER){
+         if (distance > radius){
+            sum += agg.Weights[idx] * AggregateTerm(agg, distance - radius);
+         }//end if
+         if ((bounded) && (distances[idx] > radius)){
+            sum -= agg.Weights[idx] * AggregateTerm(agg, distances[idx] - radius);
+         }//end if
+         if (sum > sumLimit){
+            return false;
+         }//end if
+      }else if (agg.Kind == aggMAX){
+         if (agg.Weights[idx] * (distance - radius) > largest){
+            largest = agg.Weights[idx] * (distance - radius);
+            if (largest > limit){
+               return false;
+            }//end if
+         }//end if
+      }//end if
+      distances[idx] = distance;
+   }//end for
+   return true;
+}//end AggregateDistances
 
-      // Is it an Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX){
-         // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
-         for (idx = 0; idx < indexNode->GetNumberOfEntries(); idx++) {
-            tmpObj.Unserialize(indexNode->GetObject(idx), indexNode->GetObjectSize(idx));
-            distance = AggregateDistanceToSlimNode(numerator, denominator, sampleList, sampleSize, &tmpObj, indexNode->GetIndexEntry(idx).Radius, weights);
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+double tmpl_stSlimTree::AggregateEntry(const tAggregate & agg,
+      stSlimNodeView & node, u_int32_t idx, const double * parent,
+      double * distances, double radius, double limit, ObjectType & tmpObj){
+   bool index = node.GetNodeType() == stSlimNode::INDEX;
+   bool bounded = false;
+   double entryDistance;
+   u_int32_t i;
 
-            // test if this subtree qualifies.
-            if (distance <= range) {
-                this->AggregateRangeQuery(indexNode->GetIndexEntry(idx).PageID, result, numerator, denominator, sampleList, sampleSize, range, weights);
-            }
+   if (parent != NULL){
+      if (index){
+         entryDistance = node.GetIndexEntry(idx).Distance;
+      }else{
+         entryDistance = node.GetLeafEntry(idx).Distance;
+      }//end if
+      if (entryDistance == 0.0){
+         // It shares the representative of the node.
+         for (i = 0; i < agg.SampleSize; i++){
+            distances[i] = parent[i];
          }//end for
-      }
-      else {
-         // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
-         for (idx = 0; idx < leafNode->GetNumberOfEntries(); idx++) {
-            tmpObj.Unserialize(leafNode->GetObject(idx), leafNode->GetObjectSize(idx));
-            distance = GroupDistance(numerator, denominator, sampleList, sampleSize, &tmpObj, weights);
-            // is it a object that qualified?
-            if (distance <= range){
-               result->AddPair(tmpObj.Clone(), distance);
-            }//end if
+         return AggregateValue(agg, distances, radius, index);
+      }//end if
+      if (IsAggregateMonotone(agg)){
+         // Try to cut it with the triangle inequality for all samples.
+         for (i = 0; i < agg.SampleSize; i++){
+            distances[i] = fabs(parent[i] - entryDistance);
          }//end for
-      }//end else
+         if (AggregateValue(agg, distances, radius, index) > limit){
+            return MAXDOUBLE;
+         }//end if
+         bounded = true;
+      }//end if
+   }//end if
 
-      // Free it all
-      delete currNode;
-      this->myPageManager->ReleasePage(currPage);
+   // Rebuild the object
+   if (index){
+      tmpObj.Unserialize(node.GetObject(idx), node.GetObjectSize(idx));
+   }else{
+      tmpObj.IncludedUnserialize(node.GetObject(idx), node.GetObjectSize(idx));
+   }//end if
+   if (!AggregateDistances(agg, tmpObj, distances, bounded, radius, limit)){
+      return MAXDOUBLE;
+   }//end if
+   return AggregateValue(agg, distances, radius, index);
+}//end AggregateEntry
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+stResult<ObjectType> * tmpl_stSlimTree::AggregateRangeQuery(
+          double numerator, double denominator, ObjectType ** sampleList, u_int32_t sampleSize, double range, double *weights) {
+   stSharedLatchGuard readLatch(GetReadLatch());
+   tResult * result = new tResult();  // Create result
+   tAggregate agg;
+   ObjectType tmpObj;
+
+   // Evaluate the root node.
+   if (this->GetRoot() != 0){
+      InitAggregate(agg, numerator, denominator, sampleList, sampleSize, weights);
+      this->AggregateRangeQuery(this->GetRoot(), result, agg, range, NULL, 0,
+            tmpObj);
    }//end if
    return result;
 }//end AggregateRangeQuery
+
 //------------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
 void tmpl_stSlimTree::AggregateRangeQuery(u_int32_t pageID,
-         tResult * result, double numerator, double denominator, ObjectType ** sampleList, u_int32_t sampleSize, double range, double *weights){
+      tResult * result, tAggregate & agg, double range, const double * parent,
+      u_int32_t level, ObjectType & tmpObj){
    stPage * currPage;
-   stSlimNode * currNode;
-   ObjectType tmpObj;
-   double distance, a, b;
-   u_int32_t idx, idy;
+   stSlimNodeView currNode;
+   double * distances = agg.Levels[level].data();
+   double distance;
+   u_int32_t idx;
    u_int32_t numberOfEntries;
 
    if (pageID != 0){
       currPage = this->myPageManager->GetPage(pageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
+      numberOfEntries = currNode.GetNumberOfEntries();
       // Is it an Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
-         // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
-         numberOfEntries = indexNode->GetNumberOfEntries();
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          // For each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
-               tmpObj.Unserialize(indexNode->GetObject(idx), indexNode->GetObjectSize(idx));
-               distance = AggregateDistanceToSlimNode(numerator, denominator, sampleList, sampleSize, &tmpObj, indexNode->GetIndexEntry(idx).Radius, weights);
-
-               // is this a qualified subtree?
-               if (distance <= range) {
-                  this->AggregateRangeQuery(indexNode->GetIndexEntry(idx).PageID, result, numerator, denominator, sampleList, sampleSize, range, weights);
-               }
+            distance = AggregateEntry(agg, currNode, idx, parent, distances,
+                  currNode.GetIndexEntry(idx).Radius, range, tmpObj);
+            // is this a qualified subtree?
+            if (distance <= range) {
+               this->AggregateRangeQuery(currNode.GetIndexEntry(idx).PageID,
+                     result, agg, range, distances, level + 1, tmpObj);
+            }//end if
          }//end for
-      }
-      else {
-         // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
-         numberOfEntries = leafNode->GetNumberOfEntries();
+      }else{
          // for each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
-             tmpObj.Unserialize(leafNode->GetObject(idx), leafNode->GetObjectSize(idx));
-             distance = GroupDistance(numerator, denominator, sampleList, sampleSize, &tmpObj, weights);
-             if (distance <= range) {
-                // Yes! Put it in the result set.
-                result->AddPair(tmpObj.Clone(), distance);
-             }
-         }
-      }
+            distance = AggregateEntry(agg, currNode, idx, parent, distances,
+                  0, range, tmpObj);
+            if (distance <= range) {
+               // Yes! Put it in the result set.
+               tmpObj.IncludedUnserialize(currNode.GetObject(idx),
+                     currNode.GetObjectSize(idx));
+               result->AddPair(tmpObj.Clone(), distance);
+            }//end if
+         }//end for
+      }//end if
 
       // Free it all
-      delete currNode;
       this->myPageManager->ReleasePage(currPage);
    }//end if
-}
+}//end AggregateRangeQuery
+
 //------------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
 stResult<ObjectType> * tmpl_stSlimTree::AggregateNearestQuery(
           double numerator, double denominator, ObjectType ** sampleList, u_int32_t sampleSize, u_int32_t k, bool tie, double *weights) {
-
+   stSharedLatchGuard readLatch(GetReadLatch());
    tResult * result = new tResult();  // Create result
-   tDynamicPriorityQueue * queue;
-   u_int32_t idx;
+   tAggregate agg;
+   // A subtree waiting in the queue: its bound, its page and the slot of
+   // the distances of its representative (-1 for the root).
+   typedef std::pair < double, std::pair < u_int32_t, int32_t > > tItem;
+   std::vector < tItem > queue;
+   std::deque < std::vector < double > > slots;
+   std::vector < int32_t > freeSlots;
+   tItem item;
+   int32_t slot;
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
+   const double * parent;
    double distance;
-   double distanceRepres = 0;
-   u_int32_t numberOfEntries;
-   stQueryPriorityQueueValue pqCurrValue;
-   stQueryPriorityQueueValue pqTmpValue;
-   bool stop;
    double rangeK = MAXDOUBLE;
+   u_int32_t idx;
+   u_int32_t numberOfEntries;
 
-   // Root node
-   pqCurrValue.PageID = this->GetRoot();
-   pqCurrValue.Radius = 0;
-   
-   // Create the Global Priority Queue
-   queue = new tDynamicPriorityQueue(STARTVALUEQUEUE, INCREMENTVALUEQUEUE);
+   if ((this->GetRoot() == 0) || (k == 0)){
+      return result;
+   }//end if
+   InitAggregate(agg, numerator, denominator, sampleList, sampleSize, weights);
+
+   // The queue is a min heap.
+   queue.push_back(tItem(0, std::pair < u_int32_t, int32_t > (this->GetRoot(), -1)));
+   while (!queue.empty()){
+      std::pop_heap(queue.begin(), queue.end(), std::greater < tItem > ());
+      item = queue.back();
+      queue.pop_back();
+      if (item.first > rangeK){
+         // No subtree left may have a better object.
+         break;
+      }//end if
 
-   // Let's search
-   while (pqCurrValue.PageID != 0){
       // Read node...
-      currPage = this->myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
-      // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
-         // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
-         numberOfEntries = indexNode->GetNumberOfEntries();
-         
-         // for each entry...
+      currPage = this->myPageManager->GetPage(item.second.first);
+      currNode.SetPage(currPage);
+      numberOfEntries = currNode.GetNumberOfEntries();
+      if (item.second.second >= 0){
+         parent = slots[item.second.second].data();
+      }else{
+         parent = NULL;
+      }//end if
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          for (idx = 0; idx < numberOfEntries; idx++) {
-            // try to cut this subtree with the triangle inequality.
-            //if ( fabs(distanceRepres - indexNode->GetIndexEntry(idx).Distance) <= rangeK + indexNode->GetIndexEntry(idx).Radius){
-               
-                // Rebuild the object
-               tmpObj.Unserialize(indexNode->GetObject(idx),indexNode->GetObjectSize(idx));
-
-               // Evaluate distance
-               distance = AggregateDistanceToSlimNode(numerator, denominator, sampleList, sampleSize, &tmpObj, indexNode->GetIndexEntry(idx).Radius, weights);
-
-               if (distance <= rangeK) {
-               //if (distance <= rangeK + indexNode->GetIndexEntry(idx).Radius){
-                  // Yes! I'm qualified! Put it in the queue.
-                  pqTmpValue.PageID = indexNode->GetIndexEntry(idx).PageID;
-                  pqTmpValue.Radius = indexNode->GetIndexEntry(idx).Radius;
-                  queue->Add(distance, pqTmpValue);
-               }//end if
-            //}//end if
+            if (freeSlots.empty()){
+               slots.push_back(std::vector < double > (sampleSize));
+               freeSlots.push_back(slots.size() - 1);
+            }//end if
+            slot = freeSlots.back();
+            distance = AggregateEntry(agg, currNode, idx, parent,
+                  slots[slot].data(), currNode.GetIndexEntry(idx).Radius,
+                  rangeK, tmpObj);
+            if (distance <= rangeK) {
+               // Yes! I'm qualified! Put it in the queue.
+               freeSlots.pop_back();
+               queue.push_back(tItem(distance, std::pair < u_int32_t, int32_t > (
+                     currNode.GetIndexEntry(idx).PageID, slot)));
+               std::push_heap(queue.begin(), queue.end(), std::greater < tItem > ());
+            }//end if
          }//end for
       }else{
-         // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
-         numberOfEntries = leafNode->GetNumberOfEntries();
-
-         // for each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
-            // try to cut this object with the triangle inequality.
-            //if ( fabs(distanceRepres - leafNode->GetLeafEntry(idx).Distance) <= rangeK){
-
-                // Rebuild the object
-               tmpObj.Unserialize(leafNode->GetObject(idx),leafNode->GetObjectSize(idx));
-
-               // When this entry is a representative, it does not need to evaluate
-               // a distance, because distanceRepres is iqual to distance.
-               // Evaluate distance
-               distance = GroupDistance(numerator, denominator, sampleList, sampleSize, &tmpObj, weights);
-               
-               //test if the object qualify
-               if (distance <= rangeK){
-                  // Add the object.
-                  result->AddPair(tmpObj.Clone(), distance);
-                  // there is more than k elements?
-                  if (result->GetNumOfEntries() >= k){
-                     //cut if there is more than k elements
-                     result->Cut(k);
-                     //may I use this for performance?
-                     rangeK = result->GetMaximumDistance();
-                  }//end if
+            distance = AggregateEntry(agg, currNode, idx, parent,
+                  agg.Levels[0].data(), 0, rangeK, tmpObj);
+            //test if the object qualify
+            if (distance <= rangeK){
+               // Add the object.
+               tmpObj.IncludedUnserialize(currNode.GetObject(idx),
+                     currNode.GetObjectSize(idx));
+               result->AddPair(tmpObj.Clone(), distance);
+               // there is more than k elements?
+               if (result->GetNumOfEntries() >= k){
+                  //cut if there is more than k elements
+                  result->Cut(k);
+                  rangeK = result->GetMaximumDistance();
                }//end if
-            //}//end if
+            }//end if
          }//end for
-
       }//end else
 
       // Free it all
-      delete currNode;
       this->myPageManager->ReleasePage(currPage);
-
-      // Go to next node
-      stop = false;
-      do{
-         if (queue->Get(distance, pqCurrValue)){
-            // Qualified if distance <= rangeK + radius
-            if (distance <= rangeK + pqCurrValue.Radius){
-               // Yes, get the pageID and the distance from the representative
-               // and the query object.
-               distanceRepres = distance;
-               // Break the while.
-               stop = true;
-            }//end if
-         }else{
-            // the queue is empty!
-            pqCurrValue.PageID = 0;
-            // Break the while.
-            stop = true;
-         }//end if
-      }while (!stop);
+      if (item.second.second >= 0){
+         freeSlots.push_back(item.second.second);
+      }//end if
    }// end while
 
-   // Release the Global Priority Queue
-   delete queue;
-   
    return result;
 }//end AggregateNearestQuery
 //------------------------------------------------------------------------------
@@ -3671,7 +4759,7 @@ stResultPaged<ObjectType> * tmpl_stSlimTree::ForwardRangeQueryWithoutPriority(
         double internalRadius, double externalRadius, long oid){
    tResultPaged * result = new tResultPaged();  // Create result
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    u_int32_t idx, numberOfEntries;
    double distance;
@@ -3686,12 +4774,12 @@ stResultPaged<ObjectType> * tmpl_stSlimTree::ForwardRangeQueryWithoutPriority(
    if (this->GetRoot() != 0){
       // Read node...
       currPage = this->myPageManager->GetPage(this->GetRoot());
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
 
       // Is it an Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX){
+      if (currNode.GetNodeType() == stSlimNode::INDEX){
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
 
          // For each entry...
@@ -3713,7 +4801,7 @@ stResultPaged<ObjectType> * tmpl_stSlimTree::ForwardRangeQueryWithoutPriority(
 
       }else{
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
 
          // For each entry...
@@ -3741,8 +4829,6 @@ stResultPaged<ObjectType> * tmpl_stSlimTree::ForwardRangeQueryWithoutPriority(
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       this->myPageManager->ReleasePage(currPage);
    }//end if
 
@@ -3756,7 +4842,7 @@ void tmpl_stSlimTree::ForwardRangeQueryWithoutPriority(
          u_int32_t nObj, double internalRadius, double & externalRadius,
          double distanceRepres, long oid){
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    double distance;
    u_int32_t idx;
@@ -3766,11 +4852,11 @@ void tmpl_stSlimTree::ForwardRangeQueryWithoutPriority(
    if (pageID != 0){
       // Read node...
       currPage = this->myPageManager->GetPage(pageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it an Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
 
          // For each entry...
@@ -3802,7 +4888,7 @@ void tmpl_stSlimTree::ForwardRangeQueryWithoutPriority(
 
       }else{
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
 
          // for each entry...
@@ -3839,8 +4925,6 @@ void tmpl_stSlimTree::ForwardRangeQueryWithoutPriority(
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       this->myPageManager->ReleasePage(currPage);
    }//end if
 }//end tmpl_stSlimTree<ObjectType, EvaluatorType>::ForwardRangeQueryWithoutPriority
@@ -3854,7 +4938,7 @@ stResultPaged<ObjectType> * tmpl_stSlimTree::ForwardRangeQuery(
    tDynamicPriorityQueue * queue;
    u_int32_t idx;
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    tResultPaged * result;
    ObjectType tmpObj;
    double distance;
@@ -3883,11 +4967,11 @@ stResultPaged<ObjectType> * tmpl_stSlimTree::ForwardRangeQuery(
       while (pqCurrValue.PageID != 0){
          // Read node...
          currPage = this->myPageManager->GetPage(pqCurrValue.PageID);
-         currNode = stSlimNode::CreateNode(currPage);
+         currNode.SetPage(currPage);
          // Is it a Index node?
-         if (currNode->GetNodeType() == stSlimNode::INDEX) {
+         if (currNode.GetNodeType() == stSlimNode::INDEX) {
             // Get Index node
-            stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+            stSlimNodeView * indexNode = &currNode;
             numberOfEntries = indexNode->GetNumberOfEntries();
 
             // for each entry...
@@ -3919,7 +5003,7 @@ stResultPaged<ObjectType> * tmpl_stSlimTree::ForwardRangeQuery(
             }//end for
          }else{
             // No, it is a leaf node. Get it.
-            stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+            stSlimNodeView * leafNode = &currNode;
             numberOfEntries = leafNode->GetNumberOfEntries();
 
             // for each entry...
@@ -3956,8 +5040,6 @@ stResultPaged<ObjectType> * tmpl_stSlimTree::ForwardRangeQuery(
          }//end else
 
          // Free it all
-         delete currNode;
-		 currNode = 0;
          this->myPageManager->ReleasePage(currPage);
 
          // Go to next node
@@ -3999,7 +5081,7 @@ stResultPaged<ObjectType> * tmpl_stSlimTree::BackwardRangeQueryWithoutPriority(
         double internalRadius, double externalRadius, long oid){
    tResultPaged * result = new tResultPaged();  // Create result
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    u_int32_t idx, numberOfEntries;
    double distance;
@@ -4014,12 +5096,12 @@ stResultPaged<ObjectType> * tmpl_stSlimTree::BackwardRangeQueryWithoutPriority(
    if (this->GetRoot() != 0){
       // Read node...
       currPage = this->myPageManager->GetPage(this->GetRoot());
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
 
       // Is it an Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX){
+      if (currNode.GetNodeType() == stSlimNode::INDEX){
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
 
          // For each entry...
@@ -4041,7 +5123,7 @@ stResultPaged<ObjectType> * tmpl_stSlimTree::BackwardRangeQueryWithoutPriority(
 
       }else{
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
 
          // For each entry...
@@ -4069,8 +5151,6 @@ stResultPaged<ObjectType> * tmpl_stSlimTree::BackwardRangeQueryWithoutPriority(
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       this->myPageManager->ReleasePage(currPage);
    }//end if
 
@@ -4084,7 +5164,7 @@ void tmpl_stSlimTree::BackwardRangeQueryWithoutPriority(
          u_int32_t nObj, double & internalRadius, double externalRadius,
          double distanceRepres, long oid){
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    double distance;
    u_int32_t idx;
@@ -4094,11 +5174,11 @@ void tmpl_stSlimTree::BackwardRangeQueryWithoutPriority(
    if (pageID != 0){
       // Read node...
       currPage = this->myPageManager->GetPage(pageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it an Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
 
          // For each entry...
@@ -4130,7 +5210,7 @@ void tmpl_stSlimTree::BackwardRangeQueryWithoutPriority(
 
       }else{
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
 
          // for each entry...
@@ -4167,8 +5247,6 @@ void tmpl_stSlimTree::BackwardRangeQueryWithoutPriority(
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       this->myPageManager->ReleasePage(currPage);
    }//end if
 }//end tmpl_stSlimTree<ObjectType, EvaluatorType>::BackwardRangeQueryWithoutPriority
@@ -4182,7 +5260,7 @@ stResultPaged<ObjectType> * tmpl_stSlimTree::BackwardRangeQuery(
    tDynamicReversedPriorityQueue * queue;
    u_int32_t idx;
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    tResultPaged * result;
    ObjectType tmpObj;
    double distance;
@@ -4210,11 +5288,11 @@ stResultPaged<ObjectType> * tmpl_stSlimTree::BackwardRangeQuery(
       while (pqCurrValue.PageID != 0){
          // Read node...
          currPage = this->myPageManager->GetPage(pqCurrValue.PageID);
-         currNode = stSlimNode::CreateNode(currPage);
+         currNode.SetPage(currPage);
          // Is it a Index node?
-         if (currNode->GetNodeType() == stSlimNode::INDEX) {
+         if (currNode.GetNodeType() == stSlimNode::INDEX) {
             // Get Index node
-            stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+            stSlimNodeView * indexNode = &currNode;
             numberOfEntries = indexNode->GetNumberOfEntries();
 
             // for each entry...
@@ -4245,7 +5323,7 @@ stResultPaged<ObjectType> * tmpl_stSlimTree::BackwardRangeQuery(
             }//end for
          }else{
             // No, it is a leaf node. Get it.
-            stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+            stSlimNodeView * leafNode = &currNode;
             numberOfEntries = leafNode->GetNumberOfEntries();
 
             // for each entry...
@@ -4282,8 +5360,6 @@ stResultPaged<ObjectType> * tmpl_stSlimTree::BackwardRangeQuery(
          }//end else
 
          // Free it all
-         delete currNode;
-		 currNode = 0;
          this->myPageManager->ReleasePage(currPage);
 
          // Go to next node
@@ -4332,16 +5408,34 @@ stResult<ObjectType> * tmpl_stSlimTree::GetEmptyResult(
 template <class ObjectType, class EvaluatorType>
 stResult<ObjectType> * tmpl_stSlimTree::RangeQuery(
             ObjectType * sample, double range){
+   stSharedLatchGuard readLatch(GetReadLatch());
+
    tResult * result = new tResult();  // Create result
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    u_int32_t idx, numberOfEntries;
    double distance;
+   double * samplePivots = NULL;
+   std::shared_ptr < tResidentLevels > resident = GetResident();
+   std::vector < u_int32_t > childPageIDs;
+   std::vector < double > childDistances;
+   bool filter;
+   #ifdef __stQUERYSTATS__
+      stQueryStats * stats = NewQueryStats(result);
+   #endif //__stQUERYSTATS__
    #ifdef __stMAMVIEW__
       stMessageString title;
       stMessageString comment;
    #endif //__stMAMVIEW__
+   #ifdef __stSLIMPIVOTS__
+      double pivots[STSLIMPIVOTS];
+
+      // Distances of the sample to the global pivots.
+      BuildPivotDistances(sample, pivots);
+      STQUERYSTATS(stats, AddDistance(Pivots.GetNumberOfPivots()));
+      samplePivots = pivots;
+   #endif //__stSLIMPIVOTS__
 
    // Set the information.
    result->SetQueryInfo((ObjectType*) sample->Clone(), RANGEQUERY, -1, range, false);
@@ -4358,17 +5452,24 @@ stResult<ObjectType> * tmpl_stSlimTree::RangeQuery(
    #endif //__stMAMVIEW__
 
    // Evaluate the root node.
-   if (this->GetRoot() != 0){
+   if ((resident != NULL) && (resident->GetRoot() != NULL)){
+      // The root is resident.
+      this->RangeQuery(resident->GetRoot(), result, sample, range, false, 0,
+                       tmpObj, samplePivots, 0);
+   }else if (this->GetRoot() != 0){
       // Read node...
+      STQUERYSTATS(stats, StartPhase(stQueryStats::phREAD));
       currPage = tMetricTree::myPageManager->GetPage(this->GetRoot());
-      currNode = stSlimNode::CreateNode(currPage);
+      STQUERYSTATS(stats, StopPhase(stQueryStats::phREAD));
+      currNode.SetPage(currPage);
+      STQUERYSTATS(stats, AddNode(0));
 
 
 
       // Is it an Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX){
+      if (currNode.GetNodeType() == stSlimNode::INDEX){
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
 
          // Visualization support
@@ -4391,23 +5492,36 @@ stResult<ObjectType> * tmpl_stSlimTree::RangeQuery(
          #endif //__stMAMVIEW__
 
          // For each entry...
+         STQUERYSTATS(stats, StartPhase(stQueryStats::phINDEX));
          for (idx = 0; idx < numberOfEntries; idx++) {
             // Rebuild the object
             tmpObj.Unserialize(indexNode->GetObject(idx),
                                indexNode->GetObjectSize(idx));
+            STQUERYSTATS(stats, AddBytesDecoded(indexNode->GetObjectSize(idx)));
             // Evaluate distance
             distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+            STQUERYSTATS(stats, AddDistance());
             // test if this subtree qualifies.
             if (distance <= range + indexNode->GetIndexEntry(idx).Radius){
-               // Yes! Analyze this subtree.
-               this->RangeQuery(indexNode->GetIndexEntry(idx).PageID, result,
-                                sample, range, distance);
+               // Yes! Analyze this subtree later.
+               childPageIDs.push_back(indexNode->GetIndexEntry(idx).PageID);
+               childDistances.push_back(distance);
+            }else{
+               STQUERYSTATS(stats, AddPrunedByDistance());
             }//end if
          }//end for
+         STQUERYSTATS(stats, StopPhase(stQueryStats::phINDEX));
+
+         // Read all qualifying subtrees ahead.
+         Prefetch(childPageIDs.data(), childPageIDs.size());
+         for (idx = 0; idx < childPageIDs.size(); idx++){
+            this->RangeQuery(childPageIDs[idx], result, sample, range,
+                             childDistances[idx], tmpObj, samplePivots, 1);
+         }//end for
          
       }else{
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
 
          #ifdef __stMAMVIEW__
@@ -4425,28 +5539,41 @@ stResult<ObjectType> * tmpl_stSlimTree::RangeQuery(
          #endif //__stMAMVIEW__
          
          // For each entry...
+         STQUERYSTATS(stats, StartPhase(stQueryStats::phLEAF));
          for (idx = 0; idx < numberOfEntries; idx++) {
+            #ifdef __stSLIMPIVOTS__
+               // Try to cut this object with the pivots.
+               if (PivotPrune(leafNode, idx, samplePivots, range)){
+                  STQUERYSTATS(stats, AddPrunedByPivots());
+                  continue;
+               }//end if
+            #endif //__stSLIMPIVOTS__
             // Rebuild the object
             tmpObj.IncludedUnserialize(leafNode->GetObject(idx),
                                leafNode->GetObjectSize(idx));
+            STQUERYSTATS(stats, AddBytesDecoded(leafNode->GetObjectSize(idx)));
 
-            if(this->myMetricEvaluator->GetFilter(tmpObj, *sample) == true){
+            filter = this->myMetricEvaluator->GetFilter(tmpObj, *sample);
+            STQUERYSTATS(stats, AddFilter(filter));
+            if(filter == true){
 
             // Evaluate distance
             distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+            STQUERYSTATS(stats, AddDistance());
             // is it a object that qualified?
             if (distance <= range){
                // Yes! Put it in the result set.
 
                   result->AddPair((ObjectType*) tmpObj.Clone(), distance);
+               }else{
+                  STQUERYSTATS(stats, AddPrunedByDistance());
                }
             }//end if
          }//end for
+         STQUERYSTATS(stats, StopPhase(stQueryStats::phLEAF));
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
    }//end if
 
@@ -4463,6 +5590,7 @@ stResult<ObjectType> * tmpl_stSlimTree::RangeQuery(
       MAMViewer->EndFrame();
       MAMViewer->EndAnimation();
    #endif //__stMAMVIEW__
+   STQUERYSTATS(stats, StopPhase(stQueryStats::phTOTAL));
    return result;
 }//end stSlimTree<ObjectType, EvaluatorType>::RangeQuery
 
@@ -4470,13 +5598,19 @@ stResult<ObjectType> * tmpl_stSlimTree::RangeQuery(
 template <class ObjectType, class EvaluatorType>
 void tmpl_stSlimTree::RangeQuery(
          u_int32_t pageID, tResult * result, ObjectType * sample,
-         double range, double distanceRepres){
+         double range, double distanceRepres, ObjectType & tmpObj,
+         const double * samplePivots, u_int32_t level){
    stPage * currPage;
-   stSlimNode * currNode;
-   ObjectType tmpObj;
+   stSlimNodeView currNode;
    double distance;
    u_int32_t idx;
    u_int32_t numberOfEntries;
+   std::vector < u_int32_t > childPageIDs;
+   std::vector < double > childDistances;
+   bool filter;
+   #ifdef __stQUERYSTATS__
+      stQueryStats * stats = result->GetQueryStats();
+   #endif //__stQUERYSTATS__
    #ifdef __stMAMVIEW__
       stMessageString comment;
    #endif //__stMAMVIEW__
@@ -4484,12 +5618,15 @@ void tmpl_stSlimTree::RangeQuery(
    // Let's search
    if (pageID != 0){
       // Read node...
+      STQUERYSTATS(stats, StartPhase(stQueryStats::phREAD));
       currPage = tMetricTree::myPageManager->GetPage(pageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      STQUERYSTATS(stats, StopPhase(stQueryStats::phREAD));
+      currNode.SetPage(currPage);
+      STQUERYSTATS(stats, AddNode(level));
       // Is it an Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
 
          // Visualization support
@@ -4515,33 +5652,55 @@ void tmpl_stSlimTree::RangeQuery(
          #endif //__stMAMVIEW__
 
          // For each entry...
+         STQUERYSTATS(stats, StartPhase(stQueryStats::phINDEX));
          for (idx = 0; idx < numberOfEntries; idx++) {
             // use of the triangle inequality to cut a subtree
             if ( fabs(distanceRepres - indexNode->GetIndexEntry(idx).Distance) <=
                       range + indexNode->GetIndexEntry(idx).Radius){
-               // Rebuild the object
-               tmpObj.Unserialize(indexNode->GetObject(idx),
-                                  indexNode->GetObjectSize(idx));
-               // Evaluate distance
-               distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+               if (indexNode->GetIndexEntry(idx).Distance == 0.0){
+                  // It shares the representative of this node. Reuse its
+                  // distance.
+                  distance = distanceRepres;
+               }else{
+                  // Rebuild the object
+                  tmpObj.Unserialize(indexNode->GetObject(idx),
+                                     indexNode->GetObjectSize(idx));
+                  STQUERYSTATS(stats, AddBytesDecoded(indexNode->GetObjectSize(idx)));
+                  // Evaluate distance
+                  distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+                  STQUERYSTATS(stats, AddDistance());
+               }//end if
                // is this a qualified subtree?
                if (distance <= range + indexNode->GetIndexEntry(idx).Radius){
-                  // Yes! Analyze it!
-                  this->RangeQuery(indexNode->GetIndexEntry(idx).PageID, result,
-                                    sample, range, distance);
-                  #ifdef __stMAMVIEW__
-                     comment.Clear();
-                     comment.Append("Returning to the index node ");
-                     comment.Append((int) pageID);
-                     comment.Append(" at level ");
-                     comment.Append((int)  MAMViewer->GetLevel());
-                     MAMViewer->BeginFrame(comment.GetStr());
-                     MAMViewer->EnableNode(pageID);
-                     MAMViewer->EndFrame();
-                  #endif //__stMAMVIEW__
+                  // Yes! Analyze it later.
+                  childPageIDs.push_back(indexNode->GetIndexEntry(idx).PageID);
+                  childDistances.push_back(distance);
+               }else{
+                  STQUERYSTATS(stats, AddPrunedByDistance());
                }//end if
+            }else{
+               STQUERYSTATS(stats, AddPrunedByParent());
             }//end if
          }//end for
+         STQUERYSTATS(stats, StopPhase(stQueryStats::phINDEX));
+
+         // Read all qualifying subtrees ahead.
+         Prefetch(childPageIDs.data(), childPageIDs.size());
+         for (idx = 0; idx < childPageIDs.size(); idx++){
+            this->RangeQuery(childPageIDs[idx], result, sample, range,
+                             childDistances[idx], tmpObj, samplePivots,
+                             level + 1);
+            #ifdef __stMAMVIEW__
+               comment.Clear();
+               comment.Append("Returning to the index node ");
+               comment.Append((int) pageID);
+               comment.Append(" at level ");
+               comment.Append((int)  MAMViewer->GetLevel());
+               MAMViewer->BeginFrame(comment.GetStr());
+               MAMViewer->EnableNode(pageID);
+               MAMViewer->EndFrame();
+            #endif //__stMAMVIEW__
+         }//end for
 
          // Visualization support
          #ifdef __stMAMVIEW__
@@ -4549,7 +5708,7 @@ void tmpl_stSlimTree::RangeQuery(
          #endif //__stMAMVIEW__
       }else{
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
 
          #ifdef __stMAMVIEW__
@@ -4571,18 +5730,36 @@ void tmpl_stSlimTree::RangeQuery(
          #endif //__stMAMVIEW__
          
          // for each entry...
+         STQUERYSTATS(stats, StartPhase(stQueryStats::phLEAF));
          for (idx = 0; idx < numberOfEntries; idx++) {
             // use of the triangle inequality.
             if ( fabs(distanceRepres - leafNode->GetLeafEntry(idx).Distance) <=
                       range){
+               #ifdef __stSLIMPIVOTS__
+                  // Try to cut this object with the pivots.
+                  if (PivotPrune(leafNode, idx, samplePivots, range)){
+                     STQUERYSTATS(stats, AddPrunedByPivots());
+                     continue;
+                  }//end if
+               #endif //__stSLIMPIVOTS__
                // Rebuild the object
                tmpObj.IncludedUnserialize(leafNode->GetObject(idx),
                                   leafNode->GetObjectSize(idx));
+               STQUERYSTATS(stats, AddBytesDecoded(leafNode->GetObjectSize(idx)));
 
-               if(this->myMetricEvaluator->GetFilter(tmpObj, *sample) == true){
+               filter = this->myMetricEvaluator->GetFilter(tmpObj, *sample);
+               STQUERYSTATS(stats, AddFilter(filter));
+               if(filter == true){
 
-               // No, it is not a representative. Evaluate distance
-               distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+               if (leafNode->GetLeafEntry(idx).Distance == 0.0){
+                  // It is at distance 0 from the representative, so its
+                  // distance is the one of the representative.
+                  distance = distanceRepres;
+               }else{
+                  // No, it is not a representative. Evaluate distance
+                  distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+                  STQUERYSTATS(stats, AddDistance());
+               }//end if
                // Is this a qualified object?
                if (distance <= range){
                   // Yes! Put it in the result set.
@@ -4590,10 +5767,15 @@ void tmpl_stSlimTree::RangeQuery(
 
                   result->AddPair((ObjectType*) tmpObj.Clone(), distance);
 
+                }else{
+                  STQUERYSTATS(stats, AddPrunedByDistance());
                 }
                }//end if
+            }else{
+               STQUERYSTATS(stats, AddPrunedByParent());
             }//end if
          }//end for
+         STQUERYSTATS(stats, StopPhase(stQueryStats::phLEAF));
 
          #ifdef __stMAMVIEW__
             comment.Clear();
@@ -4612,21 +5794,82 @@ void tmpl_stSlimTree::RangeQuery(
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
    }//end if
 }//end stSlimTree<ObjectType, EvaluatorType>::RangeQuery
 
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void tmpl_stSlimTree::RangeQuery(
+         tResidentNode * node, tResult * result, ObjectType * sample,
+         double range, bool hasRepres, double distanceRepres,
+         ObjectType & tmpObj, const double * samplePivots, u_int32_t level){
+   double distance;
+   u_int32_t idx;
+   std::vector < u_int32_t > childIdx;
+   std::vector < double > childDistances;
+   std::vector < u_int32_t > childPageIDs;
+   #ifdef __stQUERYSTATS__
+      stQueryStats * stats = result->GetQueryStats();
+   #endif //__stQUERYSTATS__
+
+   // For each entry...
+   STQUERYSTATS(stats, AddNode(level));
+   STQUERYSTATS(stats, StartPhase(stQueryStats::phINDEX));
+   for (idx = 0; idx < node->NumberOfEntries; idx++) {
+      // use of the triangle inequality to cut a subtree
+      if ((!hasRepres) || (fabs(distanceRepres - node->Distance[idx]) <=
+                           range + node->Radius[idx])){
+         if (hasRepres && (node->Distance[idx] == 0.0)){
+            // It shares the representative of this node.
+            distance = distanceRepres;
+         }else{
+            distance = this->myMetricEvaluator->GetDistance(
+                  *node->Objects[idx], *sample);
+            STQUERYSTATS(stats, AddDistance());
+         }//end if
+         // is this a qualified subtree?
+         if (distance <= range + node->Radius[idx]){
+            // Yes! Analyze it later.
+            childIdx.push_back(idx);
+            childDistances.push_back(distance);
+            if (node->Children[idx] == NULL){
+               childPageIDs.push_back(node->PageIDs[idx]);
+            }//end if
+         }else{
+            STQUERYSTATS(stats, AddPrunedByDistance());
+         }//end if
+      }else{
+         STQUERYSTATS(stats, AddPrunedByParent());
+      }//end if
+   }//end for
+   STQUERYSTATS(stats, StopPhase(stQueryStats::phINDEX));
+
+   // Read the qualifying subtrees that are not resident ahead.
+   Prefetch(childPageIDs.data(), childPageIDs.size());
+   for (idx = 0; idx < childIdx.size(); idx++){
+      if (node->Children[childIdx[idx]] != NULL){
+         this->RangeQuery(node->Children[childIdx[idx]], result, sample, range,
+                          true, childDistances[idx], tmpObj, samplePivots,
+                          level + 1);
+      }else{
+         this->RangeQuery(node->PageIDs[childIdx[idx]], result, sample, range,
+                          childDistances[idx], tmpObj, samplePivots, level + 1);
+      }//end if
+   }//end for
+}//end stSlimTree<ObjectType, EvaluatorType>::RangeQuery
+
 
 
 //------------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
 stResult<ObjectType> * tmpl_stSlimTree::ExistsQuery(
             ObjectType * sample, double range){
+   stSharedLatchGuard readLatch(GetReadLatch());
+
    tResult * result = new tResult();  // Create result
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    u_int32_t idx, numberOfEntries;
    double distance;
@@ -4653,12 +5896,12 @@ stResult<ObjectType> * tmpl_stSlimTree::ExistsQuery(
    if (this->GetRoot() != 0){
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(this->GetRoot());
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
 
       // Is it an Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX){
+      if (currNode.GetNodeType() == stSlimNode::INDEX){
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
 
          // Visualization support
@@ -4692,7 +5935,7 @@ stResult<ObjectType> * tmpl_stSlimTree::ExistsQuery(
                // Yes! Analyze this subtree.
                if(result->GetNumOfEntries() == 0){
                   this->ExistsQuery(indexNode->GetIndexEntry(idx).PageID, result,
-                                 sample, range, distance);
+                                 sample, range, distance, tmpObj);
                }else{
                   return result;
                }
@@ -4701,7 +5944,7 @@ stResult<ObjectType> * tmpl_stSlimTree::ExistsQuery(
          
       }else{
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
 
          #ifdef __stMAMVIEW__
@@ -4739,8 +5982,6 @@ stResult<ObjectType> * tmpl_stSlimTree::ExistsQuery(
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
    }//end if
 
@@ -4764,10 +6005,9 @@ stResult<ObjectType> * tmpl_stSlimTree::ExistsQuery(
 template <class ObjectType, class EvaluatorType>
 void tmpl_stSlimTree::ExistsQuery(
          u_int32_t pageID, tResult * result, ObjectType * sample,
-         double range, double distanceRepres){
+         double range, double distanceRepres, ObjectType & tmpObj){
    stPage * currPage;
-   stSlimNode * currNode;
-   ObjectType tmpObj;
+   stSlimNodeView currNode;
    double distance;
    u_int32_t idx;
    u_int32_t numberOfEntries;
@@ -4779,11 +6019,11 @@ void tmpl_stSlimTree::ExistsQuery(
    if (pageID != 0){
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it an Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
 
          // Visualization support
@@ -4826,7 +6066,7 @@ void tmpl_stSlimTree::ExistsQuery(
                      if(result->GetNumOfEntries() == 0){
                      
                         this->ExistsQuery(indexNode->GetIndexEntry(idx).PageID, result,
-                                    sample, range, distance);
+                                    sample, range, distance, tmpObj);
                      }
                   
                   #ifdef __stMAMVIEW__
@@ -4849,7 +6089,7 @@ void tmpl_stSlimTree::ExistsQuery(
          #endif //__stMAMVIEW__
       }else{
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
 
          #ifdef __stMAMVIEW__
@@ -4913,8 +6153,6 @@ void tmpl_stSlimTree::ExistsQuery(
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
    }//end if
 }//end stSlimTree<ObjectType, EvaluatorType>::RangeQuery
@@ -4925,9 +6163,11 @@ void tmpl_stSlimTree::ExistsQuery(
 template <class ObjectType, class EvaluatorType>
 stResult<ObjectType> * tmpl_stSlimTree::ReversedRangeQuery(
             ObjectType * sample, double range){
+   stSharedLatchGuard readLatch(GetReadLatch());
+
    tResult * result = new tResult();  // Create result
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    u_int32_t idx, numberOfEntries;
    double distance;
@@ -4938,12 +6178,12 @@ stResult<ObjectType> * tmpl_stSlimTree::ReversedRangeQuery(
    if (this->GetRoot() != 0){
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(this->GetRoot());
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
 
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX){
+      if (currNode.GetNodeType() == stSlimNode::INDEX){
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
 
          // For each entry...
@@ -4963,7 +6203,7 @@ stResult<ObjectType> * tmpl_stSlimTree::ReversedRangeQuery(
 
       }else{
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
 
          // For each entry...
@@ -4982,8 +6222,6 @@ stResult<ObjectType> * tmpl_stSlimTree::ReversedRangeQuery(
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
    }//end if
 
@@ -4996,7 +6234,7 @@ void tmpl_stSlimTree::ReversedRangeQuery(
          u_int32_t pageID, tResult * result, ObjectType * sample,
          double range, double distanceRepres){
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    double distance;
    u_int32_t idx;
@@ -5006,11 +6244,11 @@ void tmpl_stSlimTree::ReversedRangeQuery(
    if (pageID != 0){
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it an Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
 
          // For each entry...
@@ -5033,7 +6271,7 @@ void tmpl_stSlimTree::ReversedRangeQuery(
          }//end for
       }else{
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
 
          // for each entry...
@@ -5055,12 +6293,108 @@ void tmpl_stSlimTree::ReversedRangeQuery(
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
    }//end if
 }//end stSlimTree<ObjectType, EvaluatorType>::ReversedRangeQuery
 
+#ifdef __stSLIMRKNN__
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+stResult<ObjectType> * tmpl_stSlimTree::ReverseNearestQuery(
+      ObjectType * sample){
+   stSharedLatchGuard readLatch(GetReadLatch());
+   tResult * result = new tResult();  // Create result
+   ObjectType tmpObj;
+
+   result->SetQueryInfo(sample->Clone(), REVERSEKNEARESTQUERY,
+                        Header->KNNDistanceK, -1, false);
+
+   // Evaluate the root node.
+   if ((this->GetRoot() != 0) && (Header->KNNDistanceK > 0)){
+      ReverseNearestQuery(this->GetRoot(), result, sample, -1, tmpObj);
+   }//end if
+
+   return result;
+}//end stSlimTree<ObjectType, EvaluatorType>::ReverseNearestQuery
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void tmpl_stSlimTree::ReverseNearestQuery(u_int32_t pageID, tResult * result,
+      ObjectType * sample, double distanceRepres, ObjectType & tmpObj){
+   stPage * currPage;
+   stSlimNodeView currNode;
+   double kDistance;
+   double distance;
+   double entryDistance;
+   double limit;
+   u_int32_t idx;
+   u_int32_t numberOfEntries;
+
+   // Read node...
+   currPage = tMetricTree::myPageManager->GetPage(pageID);
+   currNode.SetPage(currPage);
+   numberOfEntries = currNode.GetNumberOfEntries();
+   // Is it an Index node?
+   if (currNode.GetNodeType() == stSlimNode::INDEX){
+      // For each entry...
+      for (idx = 0; idx < numberOfEntries; idx++){
+         kDistance = currNode.GetIndexEntry(idx).MaxKNNDistance;
+         entryDistance = currNode.GetIndexEntry(idx).Distance;
+         // The slack keeps the objects tied with their k-th nearest neighbor
+         // despite the rounding of the distances.
+         limit = (currNode.GetIndexEntry(idx).Radius + kDistance) * (1 + 1e-9);
+         // try to cut this subtree with the triangle inequality.
+         if ((kDistance >= 0) && (distanceRepres >= 0) &&
+             ((distanceRepres > entryDistance + limit) ||
+              (entryDistance > distanceRepres + limit))){
+            continue;
+         }//end if
+         // Rebuild the object
+         tmpObj.Unserialize(currNode.GetObject(idx),
+                            currNode.GetObjectSize(idx));
+         // Evaluate distance
+         distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+         // Is d(q, rep) <= r + maxKdist?
+         if ((kDistance < 0) || (distance <= limit)){
+            ReverseNearestQuery(currNode.GetIndexEntry(idx).PageID, result,
+                                sample, distance, tmpObj);
+         }//end if
+      }//end for
+   }else{
+      // For each entry...
+      for (idx = 0; idx < numberOfEntries; idx++){
+         kDistance = currNode.GetLeafEntry(idx).KNNDistance;
+         if (kDistance < 0){
+            // Unknown. Compute it now.
+            tmpObj.IncludedUnserialize(currNode.GetObject(idx),
+                                       currNode.GetObjectSize(idx));
+            kDistance = GetKNNDistance(&tmpObj, Header->KNNDistanceK);
+         }//end if
+         entryDistance = currNode.GetLeafEntry(idx).Distance;
+         limit = kDistance * (1 + 1e-9);
+         // try to cut this object with the triangle inequality.
+         if ((distanceRepres >= 0) &&
+             ((distanceRepres > entryDistance + limit) ||
+              (entryDistance > distanceRepres + limit))){
+            continue;
+         }//end if
+         // Rebuild the object
+         tmpObj.IncludedUnserialize(currNode.GetObject(idx),
+                                    currNode.GetObjectSize(idx));
+         // Evaluate distance
+         distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+         // Is the sample among its k nearest neighbors?
+         if (distance <= kDistance){
+            result->AddPair(tmpObj.Clone(), distance);
+         }//end if
+      }//end for
+   }//end if
+
+   // Free it all
+   tMetricTree::myPageManager->ReleasePage(currPage);
+}//end stSlimTree<ObjectType, EvaluatorType>::ReverseNearestQuery
+#endif //__stSLIMRKNN__
+
 //------------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
 stResult<ObjectType> * tmpl_stSlimTree::LocalNearestQuery(
@@ -5068,7 +6402,7 @@ stResult<ObjectType> * tmpl_stSlimTree::LocalNearestQuery(
    tResult * result = new tResult();  // Create result
    double rangeK = MAXDOUBLE;
    stPage * rootPage;
-   stSlimNode * rootNode;
+   stSlimNodeView rootNode;
    ObjectType tmpObj;
    double distance;
    u_int32_t idx;
@@ -5083,12 +6417,12 @@ stResult<ObjectType> * tmpl_stSlimTree::LocalNearestQuery(
    if (this->GetRoot() != 0){
       // Read node...
       rootPage = tMetricTree::myPageManager->GetPage(this->GetRoot());
-      rootNode = stSlimNode::CreateNode(rootPage);
+      rootNode.SetPage(rootPage);
 
       // Is it a Index node?
-      if (rootNode->GetNodeType() == stSlimNode::INDEX) {
+      if (rootNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)rootNode;
+         stSlimNodeView * indexNode = &rootNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
          // Priority queue
          queue = new tPriorityQueue(numberOfEntries);
@@ -5128,7 +6462,7 @@ stResult<ObjectType> * tmpl_stSlimTree::LocalNearestQuery(
 
       }else{  
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)rootNode;
+         stSlimNodeView * leafNode = &rootNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
          // for each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
@@ -5153,8 +6487,6 @@ stResult<ObjectType> * tmpl_stSlimTree::LocalNearestQuery(
       }//end else
 
       // Free it all
-      delete rootNode;
-	  rootNode = 0;
       tMetricTree::myPageManager->ReleasePage(rootPage);
    }//end if
 
@@ -5167,7 +6499,7 @@ void tmpl_stSlimTree::LocalNearestQuery(
          u_int32_t pageID, tResult * result, ObjectType * sample,
          double & rangeK, u_int32_t k, double distanceRepres){
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    double distance;
    u_int32_t idx;
@@ -5179,11 +6511,11 @@ void tmpl_stSlimTree::LocalNearestQuery(
    if (pageID != 0){
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
          // Priority queue
          queue = new tPriorityQueue(numberOfEntries);
@@ -5225,7 +6557,7 @@ void tmpl_stSlimTree::LocalNearestQuery(
          
       }else{  
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
          // for each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
@@ -5259,8 +6591,6 @@ void tmpl_stSlimTree::LocalNearestQuery(
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
    }//end if
 
@@ -5290,7 +6620,7 @@ void stSlimTree<ObjectType, EvaluatorType>::ListNearestQuery(tResult * result,
    tGenericPriorityQueue * globalQueue;
    u_int32_t idx;
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    double distance;
    double distanceRepres = 0;
@@ -5303,11 +6633,11 @@ void stSlimTree<ObjectType, EvaluatorType>::ListNearestQuery(tResult * result,
       globalQueue = new tGenericPriorityQueue();
       // Get the root node.
       currPage = tMetricTree::myPageManager->GetPage(this->GetRoot());
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
          // for each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
@@ -5323,7 +6653,7 @@ void stSlimTree<ObjectType, EvaluatorType>::ListNearestQuery(tResult * result,
          }//end for
       }else{
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
 
          // for each entry...
@@ -5349,8 +6679,6 @@ void stSlimTree<ObjectType, EvaluatorType>::ListNearestQuery(tResult * result,
       }//end if
 
       //Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
 
       do{
@@ -5358,11 +6686,11 @@ void stSlimTree<ObjectType, EvaluatorType>::ListNearestQuery(tResult * result,
          this->sumOperationsQueue++;  // Update the statistics for the queue
          // Read node...
          currPage = tMetricTree::myPageManager->GetPage(entryNode->GetPageID());
-         currNode = stSlimNode::CreateNode(currPage);
+         currNode.SetPage(currPage);
          // Is it a Index node?
-         if (currNode->GetNodeType() == stSlimNode::INDEX) {
+         if (currNode.GetNodeType() == stSlimNode::INDEX) {
             // Get Index node
-            stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+            stSlimNodeView * indexNode = &currNode;
             numberOfEntries = indexNode->GetNumberOfEntries();
 
             // for each entry...
@@ -5385,7 +6713,7 @@ void stSlimTree<ObjectType, EvaluatorType>::ListNearestQuery(tResult * result,
             }//end for
          }else{
             // No, it is a leaf node. Get it.
-            stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+            stSlimNodeView * leafNode = &currNode;
             numberOfEntries = leafNode->GetNumberOfEntries();
             // for each entry...
             for (idx = 0; idx < numberOfEntries; idx++) {
@@ -5415,8 +6743,6 @@ void stSlimTree<ObjectType, EvaluatorType>::ListNearestQuery(tResult * result,
             }//end for
          }//end if
          //Free it all
-         delete currNode;
-		 currNode = 0;
          tMetricTree::myPageManager->ReleasePage(currPage);
 
          // Release this entry.
@@ -5434,8 +6760,14 @@ void stSlimTree<ObjectType, EvaluatorType>::ListNearestQuery(tResult * result,
 //------------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
 stResult<ObjectType> * stSlimTree<ObjectType, EvaluatorType>::NearestQuery(
-      ObjectType * sample, u_int32_t k, bool tie, bool tiebreaker){
+      ObjectType * sample, u_int32_t k, const tApproximate & approx, bool tie,
+      bool tiebreaker){
+   stSharedLatchGuard readLatch(GetReadLatch());
+
    tResult * result = new tResult();  // Create result
+   #ifdef __stQUERYSTATS__
+      stQueryStats * stats = NewQueryStats(result);
+   #endif //__stQUERYSTATS__
    #ifdef __stMAMVIEW__
       stMessageString title;
       stMessageString comment;
@@ -5456,7 +6788,7 @@ stResult<ObjectType> * stSlimTree<ObjectType, EvaluatorType>::NearestQuery(
 
    // Let's search
    if (this->GetRoot() != 0){
-      this->NearestQuery(result, sample, MAXDOUBLE, k, tiebreaker);
+      this->NearestQuery(result, sample, MAXDOUBLE, k, tiebreaker, approx);
    }//end if
 
    // Visualization support
@@ -5472,10 +6804,225 @@ stResult<ObjectType> * stSlimTree<ObjectType, EvaluatorType>::NearestQuery(
       MAMViewer->EndFrame();
       MAMViewer->EndAnimation();
    #endif //__stMAMVIEW__
+   STQUERYSTATS(stats, StopPhase(stQueryStats::phTOTAL));
 
    return result;
 }//end stSlimTree<ObjectType, EvaluatorType>::NearestQuery
 
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+stResult<ObjectType> * stSlimTree<ObjectType, EvaluatorType>::NearestQuery(
+      ObjectType * sample, u_int32_t k, stQueryHint * hint, bool tie,
+      bool tiebreaker){
+   tNearestQueryHint * nearestHint;
+   tResult * result;
+   double rangeK;
+
+   if ((hint == NULL) || (hint->GetHintType() != QHT_NEARESTQUERY)){
+      return NearestQuery(sample, k, tie, tiebreaker);
+   }//end if
+   nearestHint = (tNearestQueryHint *) hint;
+
+   stSharedLatchGuard readLatch(GetReadLatch());
+
+   // The cached answers are lost if the tree was modified.
+   if (!nearestHint->IsValid(this->GetRoot(), GetNumberOfObjects())){
+      nearestHint->Start(this->GetRoot(), GetNumberOfObjects());
+   }//end if
+   result = nearestHint->Find(sample, k, tie, tiebreaker);
+   if (result != NULL){
+      return result;
+   }//end if
+
+   result = new tResult();
+   #ifdef __stQUERYSTATS__
+      stQueryStats * stats = NewQueryStats(result);
+   #endif //__stQUERYSTATS__
+   result->SetQueryInfo((ObjectType*) sample->Clone(), KNEARESTQUERY, k, MAXDOUBLE, tie);
+
+   if (this->GetRoot() != 0){
+      rangeK = GetNearestBound(nearestHint, sample, k);
+      this->NearestQuery(result, sample, rangeK, k, tiebreaker, tApproximate());
+      // Less than k objects within the bound: some witnesses were removed
+      // from the tree. Do it again without the bound.
+      if ((rangeK < MAXDOUBLE) && (result->GetNumOfEntries() < k) &&
+            (result->GetNumOfEntries() < GetNumberOfObjects())){
+         delete result;
+         result = new tResult();
+         #ifdef __stQUERYSTATS__
+            stats = NewQueryStats(result);
+         #endif //__stQUERYSTATS__
+         result->SetQueryInfo((ObjectType*) sample->Clone(), KNEARESTQUERY, k, MAXDOUBLE, tie);
+         this->NearestQuery(result, sample, MAXDOUBLE, k, tiebreaker, tApproximate());
+      }//end if
+   }//end if
+   STQUERYSTATS(stats, StopPhase(stQueryStats::phTOTAL));
+
+   nearestHint->Store(sample, result, k, tie, tiebreaker);
+   return result;
+}//end stSlimTree<ObjectType, EvaluatorType>::NearestQuery
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+stResult<ObjectType> * tmpl_stSlimTree::DiverseNearestQuery(
+      ObjectType * sample, u_int32_t k, double diversity, bool tie,
+      bool tiebreaker){
+   stSharedLatchGuard readLatch(GetReadLatch());
+   tResult * result = new tResult();  // Create result
+   std::vector < tDiverseItem > queue;
+   std::vector < tDiverseItem > batch;
+   tDiverseItem item;
+   tDiverseItem child;
+   stPage * currPage;
+   stSlimNodeView currNode;
+   ObjectType tmpObj;
+   double lastDistance = MAXDOUBLE;
+   double distance;
+   bool discard;
+   u_int32_t idx;
+   u_int32_t i;
+   u_int32_t numberOfEntries;
+
+   result->SetQueryInfo((ObjectType *) sample->Clone(), KNEARESTQUERY, k,
+                        MAXDOUBLE, tie);
+   if ((this->GetRoot() == 0) || (k == 0)){
+      return result;
+   }//end if
+
+   // The queue is a min heap.
+   item.Distance = 0;
+   item.PageID = this->GetRoot();
+   item.Radius = 0;
+   item.Object = NULL;
+   queue.push_back(item);
+   while (!queue.empty()){
+      std::pop_heap(queue.begin(), queue.end(), std::greater < tDiverseItem > ());
+      item = queue.back();
+      queue.pop_back();
+      if ((result->GetNumOfEntries() >= k) &&
+          ((!tie) || (item.Distance > lastDistance))){
+         // Done.
+         delete item.Object;
+         break;
+      }//end if
+
+      if (item.PageID != 0){
+         // Are all objects of this subtree influenced by a result r? The
+         // objects s are within d(r, rep) + radius of r and at least
+         // item.Distance from the sample.
+         discard = false;
+         if ((item.Object != NULL) && (diversity > 0)){
+            for (i = 0; (i < result->GetNumOfEntries()) && (!discard); i++){
+               distance = this->myMetricEvaluator->GetDistance(
+                     *result->GetPair(i)->GetObject(), *item.Object);
+               discard = (distance + item.Radius) * (1 + 1e-9) <
+                     diversity * item.Distance;
+            }//end for
+         }//end if
+         delete item.Object;
+         if (discard){
+            continue;
+         }//end if
+
+         // Read node...
+         currPage = tMetricTree::myPageManager->GetPage(item.PageID);
+         currNode.SetPage(currPage);
+         numberOfEntries = currNode.GetNumberOfEntries();
+         if (currNode.GetNodeType() == stSlimNode::INDEX){
+            // Add all subtrees.
+            for (idx = 0; idx < numberOfEntries; idx++){
+               tmpObj.Unserialize(currNode.GetObject(idx),
+                                  currNode.GetObjectSize(idx));
+               distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+               child.Radius = currNode.GetIndexEntry(idx).Radius;
+               child.Distance = (distance > child.Radius) ?
+                     distance - child.Radius : 0;
+               child.PageID = currNode.GetIndexEntry(idx).PageID;
+               child.Object = tmpObj.Clone();
+               queue.push_back(child);
+               std::push_heap(queue.begin(), queue.end(), std::greater < tDiverseItem > ());
+            }//end for
+         }else{
+            // Add all objects that pass the filter.
+            for (idx = 0; idx < numberOfEntries; idx++){
+               tmpObj.IncludedUnserialize(currNode.GetObject(idx),
+                                          currNode.GetObjectSize(idx));
+               if (this->myMetricEvaluator->GetFilter(tmpObj, *sample)){
+                  child.Distance = this->myMetricEvaluator->GetDistance(
+                        tmpObj, *sample);
+                  child.PageID = 0;
+                  child.Radius = 0;
+                  child.Object = tmpObj.Clone();
+                  queue.push_back(child);
+                  std::push_heap(queue.begin(), queue.end(), std::greater < tDiverseItem > ());
+               }//end if
+            }//end for
+         }//end if
+         // Free it all
+         tMetricTree::myPageManager->ReleasePage(currPage);
+      }else{
+         // All objects tied at this distance.
+         batch.clear();
+         batch.push_back(item);
+         while ((!queue.empty()) && (queue.front().PageID == 0) &&
+                (queue.front().Distance == item.Distance)){
+            std::pop_heap(queue.begin(), queue.end(), std::greater < tDiverseItem > ());
+            batch.push_back(queue.back());
+            queue.pop_back();
+         }//end while
+         if (tiebreaker){
+            std::stable_sort(batch.begin(), batch.end(),
+                  [](const tDiverseItem & a, const tDiverseItem & b){
+                     return *a.Object < *b.Object;
+                  });
+         }//end if
+
+         for (i = 0; i < batch.size(); i++){
+            if (((result->GetNumOfEntries() < k) ||
+                 (tie && (batch[i].Distance == lastDistance))) &&
+                (!IsInfluenced(result, batch[i].Object, batch[i].Distance,
+                               diversity))){
+               result->AddPair(batch[i].Object, batch[i].Distance);
+               if (result->GetNumOfEntries() == k){
+                  lastDistance = batch[i].Distance;
+               }//end if
+            }else{
+               delete batch[i].Object;
+            }//end if
+         }//end for
+      }//end if
+   }//end while
+
+   // Clean home before go away...
+   for (i = 0; i < queue.size(); i++){
+      delete queue[i].Object;
+   }//end for
+
+   return result;
+}//end stSlimTree<ObjectType, EvaluatorType>::DiverseNearestQuery
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+bool tmpl_stSlimTree::IsInfluenced(tResult * result, ObjectType * obj,
+      double distance, double diversity){
+   double influence;
+   u_int32_t i;
+
+   if (diversity <= 0){
+      return false;
+   }//end if
+   for (i = 0; i < result->GetNumOfEntries(); i++){
+      influence = this->myMetricEvaluator->GetDistance(
+            *result->GetPair(i)->GetObject(), *obj);
+      // The duplicates of a result are influenced even when they are
+      // duplicates of the sample too.
+      if ((influence < diversity * distance) || (influence == 0)){
+         return true;
+      }//end if
+   }//end for
+   return false;
+}//end stSlimTree<ObjectType, EvaluatorType>::IsInfluenced
+
 
 #include <list>
 #include <iterator>
@@ -5483,279 +7030,397 @@ stResult<ObjectType> * stSlimTree<ObjectType, EvaluatorType>::NearestQuery(
 //------------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
 void stSlimTree<ObjectType, EvaluatorType>::NearestQuery(tResult * result,
-         ObjectType * sample, double rangeK, u_int32_t k, bool tiebreaker){
-   
+         ObjectType * sample, double rangeK, u_int32_t k, bool tiebreaker,
+         const tApproximate & approx){
+   std::chrono::steady_clock::time_point start;
    tDynamicPriorityQueue * queue;
    u_int32_t idx;
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    double distance;
    double distanceRepres = 0;
+   bool hasRepres = false;
+   std::shared_ptr < tResidentLevels > resident = GetResident();
+   tResidentNode * residentNode;
    u_int32_t numberOfEntries;
    stQueryPriorityQueueValue pqCurrValue;
    stQueryPriorityQueueValue pqTmpValue;
    bool stop;
+   bool filter;
+   u_int32_t nodes = 0;
+   u_int32_t objects = 0;
+   // The relaxation of the pruning (exact if approx.Epsilon is 0).
+   double relax = 1.0 / (1.0 + approx.Epsilon);
+   #ifdef __stQUERYSTATS__
+      stQueryStats * stats = result->GetQueryStats();
+   #endif //__stQUERYSTATS__
    #ifdef __stMAMVIEW__
       stMessageString comment;
    #endif //__stMAMVIEW__   
+   #ifdef __stSLIMPIVOTS__
+      double samplePivots[STSLIMPIVOTS];
+
+      // Distances of the sample to the global pivots.
+      BuildPivotDistances(sample, samplePivots);
+      STQUERYSTATS(stats, AddDistance(Pivots.GetNumberOfPivots()));
+   #endif //__stSLIMPIVOTS__
 
    // Root node
    pqCurrValue.PageID = this->GetRoot();
    pqCurrValue.Radius = 0;
    #ifdef __stMAMVIEW__
       pqCurrValue.Parent = -1;
-      pqCurrValue.Level = 0;
    #endif //__stMAMVIEW__
+   #if defined(__stMAMVIEW__) || defined(__stQUERYSTATS__)
+      pqCurrValue.Level = 0;
+   #endif //__stMAMVIEW__ || __stQUERYSTATS__
    
    // Create the Global Priority Queue
    queue = new tDynamicPriorityQueue(STARTVALUEQUEUE, INCREMENTVALUEQUEUE);
+   if (approx.MaxTime > 0){
+      start = std::chrono::steady_clock::now();
+   }//end if
 
    // Let's search
    while (pqCurrValue.PageID != 0){
-      // Read node...
-      currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
-      // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
-         // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
-         numberOfEntries = indexNode->GetNumberOfEntries();
-
-         // Visualization support
-         #ifdef __stMAMVIEW__
-            comment.Clear();
-            comment.Append("Entering in the index node ");
-            comment.Append((int) pqCurrValue.PageID);
-            comment.Append(" at level ");
-            comment.Append((int) pqCurrValue.Level);            
-            MAMViewer->SetLevel( pqCurrValue.Level + 1);
-            MAMViewer->BeginFrame(comment.GetStr());
-            MAMViewer->EnableNode(pqCurrValue.PageID);
-            // for each entry...
-            for (idx = 0; idx < numberOfEntries; idx++) {
-               // Add all child nodes all active
-               tmpObj.Unserialize(indexNode->GetObject(idx),
-                                  indexNode->GetObjectSize(idx));
-               MAMViewer->SetNode(indexNode->GetIndexEntry(idx).PageID, &tmpObj,
-                                  indexNode->GetIndexEntry(idx).Radius,
-                                  pqCurrValue.PageID, 0, true);
-            }//end for
-            MAMViewer->SetResult(sample, result);
-            MAMViewer->EndFrame();
-         #endif //__stMAMVIEW__
-         
-         // for each entry...
-         for (idx = 0; idx < numberOfEntries; idx++) {
+      nodes++;
+      residentNode = NULL;
+      if (resident != NULL){
+         residentNode = resident->Find(pqCurrValue.PageID);
+      }//end if
+      if (residentNode != NULL){
+         // Resident index node. Its entries are already decoded.
+         STQUERYSTATS(stats, AddNode(pqCurrValue.Level));
+         STQUERYSTATS(stats, StartPhase(stQueryStats::phINDEX));
+         for (idx = 0; idx < residentNode->NumberOfEntries; idx++){
             // try to cut this subtree with the triangle inequality.
-            if ( fabs(distanceRepres - indexNode->GetIndexEntry(idx).Distance) <=
-                      rangeK + indexNode->GetIndexEntry(idx).Radius){
-               // Rebuild the object
-               tmpObj.Unserialize(indexNode->GetObject(idx),
-                                  indexNode->GetObjectSize(idx));
-               // Evaluate distance
-               distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
-
-               if (distance <= rangeK + indexNode->GetIndexEntry(idx).Radius){
-                  // Yes! I'm qualified! Put it in the queue.
-                  pqTmpValue.PageID = indexNode->GetIndexEntry(idx).PageID;
-                  pqTmpValue.Radius = indexNode->GetIndexEntry(idx).Radius;
+            if ((!hasRepres) ||
+                  (fabs(distanceRepres - residentNode->Distance[idx]) <=
+                   rangeK * relax + residentNode->Radius[idx])){
+               if (hasRepres && (residentNode->Distance[idx] == 0.0)){
+                  distance = distanceRepres;
+               }else{
+                  distance = this->myMetricEvaluator->GetDistance(
+                        *residentNode->Objects[idx], *sample);
+                  STQUERYSTATS(stats, AddDistance());
+               }//end if
+               if (distance <= rangeK * relax + residentNode->Radius[idx]){
+                  pqTmpValue.PageID = residentNode->PageIDs[idx];
+                  pqTmpValue.Radius = residentNode->Radius[idx];
                   #ifdef __stMAMVIEW__
                      pqTmpValue.Parent = pqCurrValue.Parent;
+                  #endif //__stMAMVIEW__
+                  #if defined(__stMAMVIEW__) || defined(__stQUERYSTATS__)
                      pqTmpValue.Level = pqCurrValue.Level + 1;
-                  #endif //__stMAMVIEW__                     
+                  #endif //__stMAMVIEW__ || __stQUERYSTATS__
                   queue->Add(distance, pqTmpValue);
                   this->sumOperationsQueue++;  // Update the statistics for the queue
+               }else{
+                  STQUERYSTATS(stats, AddPrunedByDistance());
                }//end if
+            }else{
+               STQUERYSTATS(stats, AddPrunedByParent());
             }//end if
          }//end for
-      }else{ 
-         // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
-         numberOfEntries = leafNode->GetNumberOfEntries();
+         STQUERYSTATS(stats, StopPhase(stQueryStats::phINDEX));
+         // Read the next nodes ahead.
+         Prefetch(queue);
+      }else{
+         // Read node...
+         STQUERYSTATS(stats, StartPhase(stQueryStats::phREAD));
+         currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
+         STQUERYSTATS(stats, StopPhase(stQueryStats::phREAD));
+         currNode.SetPage(currPage);
+         STQUERYSTATS(stats, AddNode(pqCurrValue.Level));
+         // Is it a Index node?
+         if (currNode.GetNodeType() == stSlimNode::INDEX) {
+            // Get Index node
+            stSlimNodeView * indexNode = &currNode;
+            numberOfEntries = indexNode->GetNumberOfEntries();
 
-         #ifdef __stMAMVIEW__
-            comment.Clear();
-            comment.Append("Entering in the leaf node ");
-            comment.Append((int) pqCurrValue.PageID);
-            comment.Append(" at level ");
-            comment.Append((int) pqCurrValue.Level);
-            
-            MAMViewer->BeginFrame(comment.GetStr());
-            MAMViewer->EnableNode(pqCurrValue.PageID);
+            // Visualization support
+            #ifdef __stMAMVIEW__
+               comment.Clear();
+               comment.Append("Entering in the index node ");
+               comment.Append((int) pqCurrValue.PageID);
+               comment.Append(" at level ");
+               comment.Append((int) pqCurrValue.Level);            
+               MAMViewer->SetLevel( pqCurrValue.Level + 1);
+               MAMViewer->BeginFrame(comment.GetStr());
+               MAMViewer->EnableNode(pqCurrValue.PageID);
+               // for each entry...
+               for (idx = 0; idx < numberOfEntries; idx++) {
+                  // Add all child nodes all active
+                  tmpObj.Unserialize(indexNode->GetObject(idx),
+                                     indexNode->GetObjectSize(idx));
+                  MAMViewer->SetNode(indexNode->GetIndexEntry(idx).PageID, &tmpObj,
+                                     indexNode->GetIndexEntry(idx).Radius,
+                                     pqCurrValue.PageID, 0, true);
+               }//end for
+               MAMViewer->SetResult(sample, result);
+               MAMViewer->EndFrame();
+            #endif //__stMAMVIEW__
+         
             // for each entry...
+            STQUERYSTATS(stats, StartPhase(stQueryStats::phINDEX));
             for (idx = 0; idx < numberOfEntries; idx++) {
-               // Add objects to the node
-               tmpObj.Unserialize(leafNode->GetObject(idx),
-                                  leafNode->GetObjectSize(idx));
-               MAMViewer->SetObject(&tmpObj, pqCurrValue.PageID, true);
+               // try to cut this subtree with the triangle inequality.
+               if ( fabs(distanceRepres - indexNode->GetIndexEntry(idx).Distance) <=
+                         rangeK * relax + indexNode->GetIndexEntry(idx).Radius){
+                  if (hasRepres && (indexNode->GetIndexEntry(idx).Distance == 0.0)){
+                     // It shares the representative of this node. Reuse its
+                     // distance.
+                     distance = distanceRepres;
+                  }else{
+                     // Rebuild the object
+                     tmpObj.Unserialize(indexNode->GetObject(idx),
+                                        indexNode->GetObjectSize(idx));
+                     STQUERYSTATS(stats, AddBytesDecoded(indexNode->GetObjectSize(idx)));
+                     // Evaluate distance
+                     distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+                     STQUERYSTATS(stats, AddDistance());
+                  }//end if
+
+                  if (distance <= rangeK * relax + indexNode->GetIndexEntry(idx).Radius){
+                     // Yes! I'm qualified! Put it in the queue.
+                     pqTmpValue.PageID = indexNode->GetIndexEntry(idx).PageID;
+                     pqTmpValue.Radius = indexNode->GetIndexEntry(idx).Radius;
+                     #ifdef __stMAMVIEW__
+                        pqTmpValue.Parent = pqCurrValue.Parent;
+                     #endif //__stMAMVIEW__                     
+                     #if defined(__stMAMVIEW__) || defined(__stQUERYSTATS__)
+                        pqTmpValue.Level = pqCurrValue.Level + 1;
+                     #endif //__stMAMVIEW__ || __stQUERYSTATS__
+                     queue->Add(distance, pqTmpValue);
+                     this->sumOperationsQueue++;  // Update the statistics for the queue
+                  }else{
+                     STQUERYSTATS(stats, AddPrunedByDistance());
+                  }//end if
+               }else{
+                  STQUERYSTATS(stats, AddPrunedByParent());
+               }//end if
             }//end for
-            MAMViewer->EndFrame();
-         #endif //__stMAMVIEW__
+            STQUERYSTATS(stats, StopPhase(stQueryStats::phINDEX));
+            // Read the next nodes ahead.
+            Prefetch(queue);
+         }else{ 
+            // No, it is a leaf node. Get it.
+            stSlimNodeView * leafNode = &currNode;
+            numberOfEntries = leafNode->GetNumberOfEntries();
+            objects += numberOfEntries;
+
+            #ifdef __stMAMVIEW__
+               comment.Clear();
+               comment.Append("Entering in the leaf node ");
+               comment.Append((int) pqCurrValue.PageID);
+               comment.Append(" at level ");
+               comment.Append((int) pqCurrValue.Level);
+            
+               MAMViewer->BeginFrame(comment.GetStr());
+               MAMViewer->EnableNode(pqCurrValue.PageID);
+               // for each entry...
+               for (idx = 0; idx < numberOfEntries; idx++) {
+                  // Add objects to the node
+                  tmpObj.Unserialize(leafNode->GetObject(idx),
+                                     leafNode->GetObjectSize(idx));
+                  MAMViewer->SetObject(&tmpObj, pqCurrValue.PageID, true);
+               }//end for
+               MAMViewer->EndFrame();
+            #endif //__stMAMVIEW__
 
-         // for each entry...
-         for (idx = 0; idx < numberOfEntries; idx++) {
-            // try to cut this object with the triangle inequality.
-            if ( fabs(distanceRepres - leafNode->GetLeafEntry(idx).Distance) <=
-                      rangeK){
-               // Rebuild the object
-               tmpObj.IncludedUnserialize(leafNode->GetObject(idx),
-                                  leafNode->GetObjectSize(idx));
+            // for each entry...
+            STQUERYSTATS(stats, StartPhase(stQueryStats::phLEAF));
+            for (idx = 0; idx < numberOfEntries; idx++) {
+               // try to cut this object with the triangle inequality.
+               if ( fabs(distanceRepres - leafNode->GetLeafEntry(idx).Distance) <=
+                         rangeK){
+                  #ifdef __stSLIMPIVOTS__
+                     // Try to cut this object with the pivots.
+                     if (PivotPrune(leafNode, idx, samplePivots, rangeK)){
+                        STQUERYSTATS(stats, AddPrunedByPivots());
+                        continue;
+                     }//end if
+                  #endif //__stSLIMPIVOTS__
+                  // Rebuild the object
+                  tmpObj.IncludedUnserialize(leafNode->GetObject(idx),
+                                     leafNode->GetObjectSize(idx));
+                  STQUERYSTATS(stats, AddBytesDecoded(leafNode->GetObjectSize(idx)));
 
-            if(this->myMetricEvaluator->GetFilter(tmpObj, *sample) == true){
+               filter = this->myMetricEvaluator->GetFilter(tmpObj, *sample);
+               STQUERYSTATS(stats, AddFilter(filter));
+               if(filter == true){
 
-               // When this entry is a representative, it does not need to evaluate
-               // a distance, because distanceRepres is iqual to distance.
-               // Evaluate distance
-               distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
-               //test if the object qualify
-               if (distance <= rangeK){
+                  // When this entry is a representative, it does not need to evaluate
+                  // a distance, because distanceRepres is iqual to distance.
+                  if (hasRepres && (leafNode->GetLeafEntry(idx).Distance == 0.0)){
+                     distance = distanceRepres;
+                  }else{
+                     // Evaluate distance
+                     distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+                     STQUERYSTATS(stats, AddDistance());
+                  }//end if
+                  //test if the object qualify
+                  if (distance > rangeK){
+                     STQUERYSTATS(stats, AddPrunedByDistance());
+                  }//end if
+                  if (distance <= rangeK){
                 
-                  if(tiebreaker){
+                     if(tiebreaker){
 
-                     if(result->GetNumOfEntries() < (k-1)){
-                        //I don't have k-2 elements yet, I can just add
+                        if(result->GetNumOfEntries() < (k-1)){
+                           //I don't have k-2 elements yet, I can just add
 
-                        result->AddPair((ObjectType*) tmpObj.Clone(), distance);
+                           result->AddPair((ObjectType*) tmpObj.Clone(), distance);
 
-                     }else if(result->GetNumOfEntries() == (k-1)){
+                        }else if(result->GetNumOfEntries() == (k-1)){
 
-                        //I'm going to have k elements. Add the element and calculate the radius
+                           //I'm going to have k elements. Add the element and calculate the radius
 
-                        result->AddPair((ObjectType*) tmpObj.Clone(), distance);
-                        rangeK = result->GetMaximumDistance();
-                        //std::cout << "Maximum distance: " <<  rangeK << "\n";
+                           result->AddPair((ObjectType*) tmpObj.Clone(), distance);
+                           rangeK = result->GetMaximumDistance();
+                           //std::cout << "Maximum distance: " <<  rangeK << "\n";
 
 
-                     }else if(result->GetNumOfEntries() == k && distance < rangeK){
+                        }else if(result->GetNumOfEntries() == k && distance < rangeK){
 
-                        //I already have k elements. The new element is not a tie. I add it, cut the last element and recalculate the distance.
+                           //I already have k elements. The new element is not a tie. I add it, cut the last element and recalculate the distance.
 
-                        result->AddPair((ObjectType*) tmpObj.Clone(), distance);
+                           result->AddPair((ObjectType*) tmpObj.Clone(), distance);
 
-                        int index = k;
+                           int index = k;
 
-                        std::list<ObjectType> sortList;
+                           std::list<ObjectType> sortList;
 
-                        while(result->GetPair(index)->GetDistance() == rangeK){
+                           while(result->GetPair(index)->GetDistance() == rangeK){
                         
-                           ObjectType* objAux = (ObjectType*) result->GetPair(index)->GetObject()->Clone();  
+                              ObjectType* objAux = (ObjectType*) result->GetPair(index)->GetObject()->Clone();  
 
-                           sortList.push_front(*objAux);
+                              sortList.push_front(*objAux);
 
-                           result->RemoveLast();
+                              result->RemoveLast();
 
-                           index--;
+                              index--;
 
-                           if(index == -1){
-                              break;
-                           }
+                              if(index == -1){
+                                 break;
+                              }
 
-                        }
+                           }
                         
-                        sortList.sort();
+                           sortList.sort();
 
-                        for(typename std::list<ObjectType>::iterator iter= sortList.begin(); iter != sortList.end(); iter++){
+                           for(typename std::list<ObjectType>::iterator iter= sortList.begin(); iter != sortList.end(); iter++){
 
-                           result->AddPair((ObjectType*) iter->Clone(), rangeK);
+                              result->AddPair((ObjectType*) iter->Clone(), rangeK);
 
-                        }
+                           }
 
-                        result->Cut(k);
-                        rangeK = result->GetMaximumDistance();
+                           result->Cut(k);
+                           rangeK = result->GetMaximumDistance();
 
 
-                     }else if(result->GetNumOfEntries() == k && distance == rangeK){
-                        //I already have k elements. The new element is a tie.
+                        }else if(result->GetNumOfEntries() == k && distance == rangeK){
+                           //I already have k elements. The new element is a tie.
 
-                        result->AddPair((ObjectType*) tmpObj.Clone(), distance);
+                           result->AddPair((ObjectType*) tmpObj.Clone(), distance);
 
-                        int index = k;
+                           int index = k;
 
-                        std::list<ObjectType> sortList;
+                           std::list<ObjectType> sortList;
 
-                        while(result->GetPair(index)->GetDistance() == distance){
+                           while(result->GetPair(index)->GetDistance() == distance){
                         
-                           ObjectType* objAux = (ObjectType*) result->GetPair(index)->GetObject()->Clone();  
+                              ObjectType* objAux = (ObjectType*) result->GetPair(index)->GetObject()->Clone();  
 
-                           sortList.push_front(*objAux);
+                              sortList.push_front(*objAux);
 
-                           result->RemoveLast();
+                              result->RemoveLast();
 
-                           index--;
+                              index--;
 
-                           if(index == -1){
-                              break;
-                           }
+                              if(index == -1){
+                                 break;
+                              }
 
-                        }
+                           }
 
-                        sortList.sort();
+                           sortList.sort();
 
-                        for(typename std::list<ObjectType>::iterator iter= sortList.begin(); iter != sortList.end(); iter++){
+                           for(typename std::list<ObjectType>::iterator iter= sortList.begin(); iter != sortList.end(); iter++){
 
-                           result->AddPair((ObjectType*) iter->Clone(), distance);
+                              result->AddPair((ObjectType*) iter->Clone(), distance);
 
-                        }
+                           }
                            
-                        result->Cut(k);
+                           result->Cut(k);
 
-                     }
-                  }else {
+                        }
+                     }else {
                  
-                         // Add the object.
-                     result->AddPair((ObjectType*) tmpObj.Clone(), distance);
-                     // there is more than k elements?
-                     if (result->GetNumOfEntries() >= k){
-                        //cut if there is more than k elements
-                        result->Cut(k);
-                        //may I use this for performance?
-                        rangeK = result->GetMaximumDistance();
-                     }//end if
+                            // Add the object.
+                        result->AddPair((ObjectType*) tmpObj.Clone(), distance);
+                        // there is more than k elements?
+                        if (result->GetNumOfEntries() >= k){
+                           //cut if there is more than k elements
+                           result->Cut(k);
+                           //may I use this for performance?
+                           rangeK = result->GetMaximumDistance();
+                        }//end if
 
-                  }
+                     }
             
 
-                    }
+                       }
+                  }//end if
+               }else{
+                  STQUERYSTATS(stats, AddPrunedByParent());
                }//end if
-            }//end if
-         }//end for
-
-         #ifdef __stMAMVIEW__
-            comment.Clear();
-            comment.Append("The result after the leaf node ");
-            comment.Append((int) pqCurrValue.PageID);
-            comment.Append(" at level ");
-            comment.Append((int) pqCurrValue.Level);
-            comment.Append(" has ");
-            comment.Append((int)result->GetNumOfEntries());
-            comment.Append(" object(s) and radius ");
-            comment.Append((double)result->GetMaximumDistance());
-            MAMViewer->BeginFrame(comment.GetStr());
-            MAMViewer->SetResult(sample, result);
-            MAMViewer->EndFrame();
-         #endif //__stMAMVIEW__
-      }//end else
+            }//end for
+            STQUERYSTATS(stats, StopPhase(stQueryStats::phLEAF));
+
+            #ifdef __stMAMVIEW__
+               comment.Clear();
+               comment.Append("The result after the leaf node ");
+               comment.Append((int) pqCurrValue.PageID);
+               comment.Append(" at level ");
+               comment.Append((int) pqCurrValue.Level);
+               comment.Append(" has ");
+               comment.Append((int)result->GetNumOfEntries());
+               comment.Append(" object(s) and radius ");
+               comment.Append((double)result->GetMaximumDistance());
+               MAMViewer->BeginFrame(comment.GetStr());
+               MAMViewer->SetResult(sample, result);
+               MAMViewer->EndFrame();
+            #endif //__stMAMVIEW__
+         }//end else
 
-      // Free it all
-      delete currNode;
-	  currNode = 0;
-      tMetricTree::myPageManager->ReleasePage(currPage);
+         // Free it all
+         tMetricTree::myPageManager->ReleasePage(currPage);
+      }//end if
 
       if (queue->GetSize() > this->maxQueue)
          this->maxQueue = queue->GetSize();
+      STQUERYSTATS(stats, UpdateQueue(queue->GetSize()));
+      // Approximate query: is it good enough?
+      if (IsApproximateStop(approx, result, k, nodes, objects, start)){
+         break;
+      }//end if
       // Go to next node
       stop = false;
       do{
          if (queue->Get(distance, pqCurrValue)){
             this->sumOperationsQueue++;  // Update the statistics for the queue
             // Qualified if distance <= rangeK + radius
-            if (distance <= rangeK + pqCurrValue.Radius){
+            if (distance <= rangeK * relax + pqCurrValue.Radius){
                // Yes, get the pageID and the distance from the representative
                // and the query object.
                distanceRepres = distance;
+               hasRepres = true;
                // Break the while.
                stop = true;
+            }else{
+               STQUERYSTATS(stats, AddPrunedByDistance());
             }//end if
          }else{
             // the queue is empty!
@@ -5771,11 +7436,88 @@ void stSlimTree<ObjectType, EvaluatorType>::NearestQuery(tResult * result,
    queue = 0;
 }//end stSlimTree<ObjectType, EvaluatorType>::NearestQuery
 
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+bool stSlimTree<ObjectType, EvaluatorType>::IsApproximateStop(
+      const tApproximate & approx, tResult * result, u_int32_t k,
+      u_int32_t nodes, u_int32_t objects,
+      std::chrono::steady_clock::time_point start){
+   double rangeK;
+   double unread;
+
+   // Budgets.
+   if ((approx.MaxNodes > 0) && (nodes >= approx.MaxNodes)){
+      return true;
+   }//end if
+   if ((approx.MaxTime > 0) &&
+       (std::chrono::duration < double, std::milli > (
+             std::chrono::steady_clock::now() - start).count() >= approx.MaxTime)){
+      return true;
+   }//end if
+
+   // Expected number of unread objects closer than the k-th one, assuming
+   // the distances to the sample follow the distance distribution.
+   if ((approx.Distribution != NULL) && (approx.MaxMiss > 0) &&
+       (result->GetNumOfEntries() >= k)){
+      rangeK = result->GetMaximumDistance();
+      unread = (objects < GetNumberOfObjects()) ?
+            GetNumberOfObjects() - objects : 0;
+      if (unread * approx.Distribution->GetValueOfBin(rangeK) <= approx.MaxMiss){
+         return true;
+      }//end if
+   }//end if
+
+   return false;
+}//end stSlimTree<ObjectType, EvaluatorType>::IsApproximateStop
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+double stSlimTree<ObjectType, EvaluatorType>::GetNearestBound(
+      tNearestQueryHint * hint, ObjectType * sample, u_int32_t k){
+   std::vector < double > distances;
+   double bound = MAXDOUBLE;
+   u_int32_t idx;
+
+   if ((hint->GetSample() == NULL) || (hint->GetK() < k) || (k == 0)){
+      return MAXDOUBLE;
+   }//end if
+
+   // The k-th distance of the last query plus the distance between the
+   // samples.
+   if (hint->GetKDistance() < MAXDOUBLE){
+      bound = hint->GetKDistance() + this->myMetricEvaluator->GetDistance(
+            *hint->GetSample(), *sample);
+   }//end if
+
+   // At least k objects (the witnesses) are within the k-th smallest
+   // distance to them.
+   if (hint->GetNumberOfWitnesses() >= k){
+      for (idx = 0; idx < hint->GetNumberOfWitnesses(); idx++){
+         distances.push_back(this->myMetricEvaluator->GetDistance(
+               *hint->GetWitness(idx), *sample));
+      }//end for
+      std::nth_element(distances.begin(), distances.begin() + (k - 1),
+            distances.end());
+      if (distances[k - 1] < bound){
+         bound = distances[k - 1];
+      }//end if
+   }//end if
+
+   // The slack absorbs the rounding of the triangle inequality, so the
+   // nodes holding the objects tied at the bound are not pruned.
+   if (bound < MAXDOUBLE){
+      bound *= 1.0 + 1e-9;
+   }//end if
+   return bound;
+}//end stSlimTree<ObjectType, EvaluatorType>::GetNearestBound
+
 //------------------------------------------------------------------------------
 //
 template <class ObjectType, class EvaluatorType>
 stResult<ObjectType> * stSlimTree<ObjectType, EvaluatorType>::FarthestQuery(
       ObjectType * sample, u_int32_t k, bool tie){
+   stSharedLatchGuard readLatch(GetReadLatch());
+
    tResult * result = new tResult();  // Create result
 
    // Set information for this query
@@ -5796,7 +7538,7 @@ void stSlimTree<ObjectType, EvaluatorType>::FarthestQuery(tResult * result,
    tDynamicReversedPriorityQueue * queue;
    u_int32_t idx;
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    double distance;
    double distanceRepres = 0;
@@ -5816,11 +7558,11 @@ void stSlimTree<ObjectType, EvaluatorType>::FarthestQuery(tResult * result,
    while (pqCurrValue.PageID != 0){
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
 
          // for each entry...
@@ -5845,7 +7587,7 @@ void stSlimTree<ObjectType, EvaluatorType>::FarthestQuery(tResult * result,
          }//end for
       }else{
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
 
          // for each entry...
@@ -5877,8 +7619,6 @@ void stSlimTree<ObjectType, EvaluatorType>::FarthestQuery(tResult * result,
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
 
       // Go to next node
@@ -5912,6 +7652,8 @@ void stSlimTree<ObjectType, EvaluatorType>::FarthestQuery(tResult * result,
 template <class ObjectType, class EvaluatorType>
 stResult<ObjectType> * stSlimTree<ObjectType, EvaluatorType>::PointQuery(
       ObjectType * sample){
+   stSharedLatchGuard readLatch(GetReadLatch());
+
    tResult * result = new tResult();  // Create result
 
    // Set information for this query
@@ -5931,7 +7673,7 @@ void stSlimTree<ObjectType, EvaluatorType>::PointQuery(
    tDynamicPriorityQueue * queue;
    u_int32_t idx;
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    double distance;
    double distanceRepres = 0;
@@ -5952,11 +7694,11 @@ void stSlimTree<ObjectType, EvaluatorType>::PointQuery(
    while ((pqCurrValue.PageID != 0) && (!find)){
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?        
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
          // for each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
@@ -5980,7 +7722,7 @@ void stSlimTree<ObjectType, EvaluatorType>::PointQuery(
          }//end for
       }else{ 
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
          // for each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
@@ -6005,8 +7747,6 @@ void stSlimTree<ObjectType, EvaluatorType>::PointQuery(
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
 
       // Go to next node.
@@ -6121,6 +7861,8 @@ stResult<ObjectType> * tmpl_stSlimTree::EstimateNearestQuery(
 template <class ObjectType, class EvaluatorType>
 stResult<ObjectType> * tmpl_stSlimTree::KAndRangeQuery(
       ObjectType * sample, double range, u_int32_t k, bool tie){
+   stSharedLatchGuard readLatch(GetReadLatch());
+
 
    tResult * result = new tResult();  // Create result
 
@@ -6140,7 +7882,7 @@ void tmpl_stSlimTree::KAndRangeQuery(
    tDynamicPriorityQueue * queue;
    u_int32_t idx;
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    double distance;
    double distanceRepres = 0;
@@ -6160,11 +7902,11 @@ void tmpl_stSlimTree::KAndRangeQuery(
    while (pqCurrValue.PageID != 0){
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
          // for each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
@@ -6189,7 +7931,7 @@ void tmpl_stSlimTree::KAndRangeQuery(
 
       }else{ 
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
          // for each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
@@ -6228,8 +7970,6 @@ void tmpl_stSlimTree::KAndRangeQuery(
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
 
       // Next node
@@ -6263,6 +8003,8 @@ void tmpl_stSlimTree::KAndRangeQuery(
 template <class ObjectType, class EvaluatorType>
 stResult<ObjectType> * tmpl_stSlimTree::KOrRangeQuery(
             ObjectType * sample, double range, u_int32_t k, bool tie){
+   stSharedLatchGuard readLatch(GetReadLatch());
+
    tResult * result = new tResult();  // Create result
 
    result->SetQueryInfo((ObjectType*) sample->Clone(), KORRANGEQUERY, k, range, tie);
@@ -6282,7 +8024,7 @@ void tmpl_stSlimTree::KOrRangeQuery(
    tDynamicPriorityQueue * queue;
    u_int32_t idx;
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    stQueryPriorityQueueValue pqCurrValue;
    stQueryPriorityQueueValue pqTMPValue;
@@ -6303,11 +8045,11 @@ void tmpl_stSlimTree::KOrRangeQuery(
    while (pqCurrValue.PageID != 0){
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
          // for each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
@@ -6332,7 +8074,7 @@ void tmpl_stSlimTree::KOrRangeQuery(
 
       }else{ 
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
          // for each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
@@ -6371,8 +8113,6 @@ void tmpl_stSlimTree::KOrRangeQuery(
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
 
       // Next node...
@@ -6406,8 +8146,11 @@ void tmpl_stSlimTree::KOrRangeQuery(
 template <class ObjectType, class EvaluatorType>
 stResult<ObjectType> * tmpl_stSlimTree::RingQuery(
       ObjectType * sample, double inRange, double outRange){
+   stSharedLatchGuard readLatch(GetReadLatch());
+
    tResult * result = new tResult();  // Create result
    double distanceRepres = 0;
+   ObjectType tmpObj;
 
    result->SetQueryInfo((ObjectType*) sample->Clone(), RINGQUERY, -1, outRange, inRange);
 
@@ -6416,7 +8159,7 @@ stResult<ObjectType> * tmpl_stSlimTree::RingQuery(
       // Let's search
       if (this->GetRoot() != 0){
          this->RingQuery(this->GetRoot(), result, sample, inRange, outRange,
-                         distanceRepres);
+                         distanceRepres, tmpObj);
       }//end if
    }//end if
 
@@ -6427,11 +8170,11 @@ stResult<ObjectType> * tmpl_stSlimTree::RingQuery(
 template <class ObjectType, class EvaluatorType>
 void tmpl_stSlimTree::RingQuery(
          u_int32_t pageID, tResult * result, ObjectType * sample,
-         double inRange, double outRange, double distanceRepres){
+         double inRange, double outRange, double distanceRepres,
+         ObjectType & tmpObj){
 
    stPage * currPage;
-   stSlimNode * currNode;
-   ObjectType tmpObj;
+   stSlimNodeView currNode;
    double distance;
    u_int32_t idx;
    u_int32_t numberOfEntries;
@@ -6442,11 +8185,11 @@ void tmpl_stSlimTree::RingQuery(
    if (pageID != 0){
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
          // Priority queue
          queue = new tPriorityQueue(numberOfEntries);
@@ -6478,7 +8221,7 @@ void tmpl_stSlimTree::RingQuery(
 
                // Yes! I'm qualified !
                this->RingQuery(indexNode->GetIndexEntry(pid).PageID, result,
-                     sample, inRange, outRange, distance);
+                     sample, inRange, outRange, distance, tmpObj);
             }//end if
          }//end while
 
@@ -6488,7 +8231,7 @@ void tmpl_stSlimTree::RingQuery(
 
       }else{ 
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
          // for each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
@@ -6496,7 +8239,7 @@ void tmpl_stSlimTree::RingQuery(
             if ( fabs(distanceRepres - leafNode->GetLeafEntry(idx).Distance) <=
                       outRange){
                // Rebuild the object
-               tmpObj.Unserialize(leafNode->GetObject(idx),
+               tmpObj.IncludedUnserialize(leafNode->GetObject(idx),
                                   leafNode->GetObjectSize(idx));
                // is it a Representative?
                if (leafNode->GetLeafEntry(idx).Distance != 0) {
@@ -6515,13 +8258,303 @@ void tmpl_stSlimTree::RingQuery(
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
    }//end if
 
 }//end stSlimTree<ObjectType, EvaluatorType>::RingQuery
 
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+bool tmpl_stSlimTree::VisitRing(u_int32_t pageID, ObjectType * sample,
+      double inRange, double outRange, bool hasRepres, double distanceRepres,
+      ObjectType & tmpObj, tVisitor & visitor){
+   stPage * currPage;
+   stSlimNodeView currNode;
+   double distance;
+   u_int32_t idx;
+   u_int32_t numberOfEntries;
+   std::vector < u_int32_t > childPageIDs;
+   std::vector < double > childDistances;
+   bool go = true;
+
+   if (pageID == 0){
+      return true;
+   }//end if
+   currPage = tMetricTree::myPageManager->GetPage(pageID);
+   currNode.SetPage(currPage);
+   numberOfEntries = currNode.GetNumberOfEntries();
+   if (currNode.GetNodeType() == stSlimNode::INDEX){
+      // For each entry...
+      for (idx = 0; idx < numberOfEntries; idx++){
+         const stSlimIndexNode::stSlimIndexEntry & entry =
+               currNode.GetIndexEntry(idx);
+
+         // Try to cut this subtree with the triangle inequality.
+         if ((hasRepres) && ((fabs(distanceRepres - entry.Distance) >
+               outRange + entry.Radius) ||
+               (distanceRepres + entry.Distance + entry.Radius <= inRange))){
+            continue;
+         }//end if
+         if ((hasRepres) && (entry.Distance == 0.0)){
+            distance = distanceRepres;
+         }else{
+            tmpObj.Unserialize(currNode.GetObject(idx), currNode.GetObjectSize(idx));
+            distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+         }//end if
+         if ((distance <= outRange + entry.Radius) &&
+               (distance + entry.Radius > inRange)){
+            childPageIDs.push_back(entry.PageID);
+            childDistances.push_back(distance);
+         }//end if
+      }//end for
+
+      // Read all qualifying subtrees ahead.
+      Prefetch(childPageIDs.data(), childPageIDs.size());
+      for (idx = 0; (go) && (idx < childPageIDs.size()); idx++){
+         go = VisitRing(childPageIDs[idx], sample, inRange, outRange, true,
+               childDistances[idx], tmpObj, visitor);
+      }//end for
+   }else{
+      // For each entry...
+      for (idx = 0; (go) && (idx < numberOfEntries); idx++){
+         // Try to cut this object with the triangle inequality.
+         if ((hasRepres) && ((fabs(distanceRepres -
+               currNode.GetLeafEntry(idx).Distance) > outRange) ||
+               (distanceRepres + currNode.GetLeafEntry(idx).Distance <= inRange))){
+            continue;
+         }//end if
+         tmpObj.IncludedUnserialize(currNode.GetObject(idx),
+               currNode.GetObjectSize(idx));
+         if (!this->myMetricEvaluator->GetFilter(tmpObj, *sample)){
+            continue;
+         }//end if
+         if ((hasRepres) && (currNode.GetLeafEntry(idx).Distance == 0.0)){
+            distance = distanceRepres;
+         }else{
+            distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+         }//end if
+         if ((distance <= outRange) && (distance > inRange)){
+            go = visitor(currNode.GetObject(idx), currNode.GetObjectSize(idx),
+                  distance);
+         }//end if
+      }//end for
+   }//end if
+
+   // Free it all
+   tMetricTree::myPageManager->ReleasePage(currPage);
+   return go;
+}//end stSlimTree<ObjectType, EvaluatorType>::VisitRing
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void tmpl_stSlimTree::StartRangeCursor(stRangeCursor * cursor, bool backward,
+      u_int32_t modification){
+   stRangeCursor::tItem item;
+
+   cursor->Start(backward, this->GetRoot(), GetNumberOfObjects(), modification);
+   if (this->GetRoot() != 0){
+      item.Key = backward ? cursor->GetExternalRadius() : cursor->GetInternalRadius();
+      item.Distance = 0;
+      item.Radius = MAXDOUBLE;
+      item.PageID = this->GetRoot();
+      item.Entry = 0;
+      item.OID = 0;
+      item.Object = false;
+      cursor->Push(item);
+   }//end if
+}//end tmpl_stSlimTree<ObjectType, EvaluatorType>::StartRangeCursor
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+bool tmpl_stSlimTree::RangeCursorQuery(ObjectType * sample,
+      stRangeCursor * cursor, bool backward, tVisitor & visitor){
+   stSharedLatchGuard readLatch(GetReadLatch());
+   stRangeCursor::tItem item;
+   stRangeCursor::tItem child;
+   std::shared_ptr < stPage > leaf;
+   stPage * currPage;
+   stSlimNodeView currNode;
+   ObjectType tmpObj;
+   u_int32_t numberOfEntries;
+   u_int32_t idx;
+   u_int32_t modification;
+   double distance;
+   double inRange;
+   double outRange;
+   double slack;
+   bool restarted = false;
+
+   modification = __atomic_load_n(&ModificationCount, __ATOMIC_ACQUIRE);
+   if ((!cursor->IsValid(this->GetRoot(), GetNumberOfObjects(), modification)) ||
+         (cursor->IsBackward() != backward)){
+      // Start from the root at the position of the cursor.
+      StartRangeCursor(cursor, backward, modification);
+      restarted = true;
+   }//end if
+
+   while (!cursor->IsEmpty()){
+      cursor->Pop(item);
+
+      if (item.Object){
+         // The next object.
+         if (item.Leaf == NULL){
+            // The cursor was restored. Read its leaf again, once for all
+            // its objects.
+            if ((leaf == NULL) || (leaf->GetPageID() != item.PageID)){
+               leaf.reset();
+               currPage = tMetricTree::myPageManager->GetPage(item.PageID);
+               if (currPage != NULL){
+                  currNode.SetPage(currPage);
+                  if (currNode.IsValid()){
+                     leaf.reset(new stPage(currPage->GetPageSize(), item.PageID));
+                     leaf->Copy(currPage);
+                  }//end if
+                  tMetricTree::myPageManager->ReleasePage(currPage);
+               }//end if
+            }//end if
+            item.Leaf = leaf;
+         }//end if
+         if (item.Leaf != NULL){
+            currNode.SetPage(item.Leaf.get());
+         }//end if
+         if ((item.Leaf == NULL) ||
+               (currNode.GetNodeType() != stSlimNode::LEAF) ||
+               (item.Entry >= currNode.GetNumberOfEntries())){
+            // Not a valid cursor for this tree. Restart it (once).
+            if (!restarted){
+               StartRangeCursor(cursor, backward, modification);
+               restarted = true;
+            }//end if
+            continue;
+         }//end if
+         cursor->SetLast(item.Distance, item.OID);
+         if (!visitor(currNode.GetObject(item.Entry),
+               currNode.GetObjectSize(item.Entry), item.Distance)){
+            return false;
+         }//end if
+         continue;
+      }//end if
+
+      // Read node...
+      currPage = tMetricTree::myPageManager->GetPage(item.PageID);
+      if (currPage != NULL){
+         currNode.SetPage(currPage);
+      }//end if
+      if ((currPage == NULL) || (!currNode.IsValid())){
+         // Not a valid cursor for this tree. Restart it (once).
+         if (currPage != NULL){
+            tMetricTree::myPageManager->ReleasePage(currPage);
+         }//end if
+         if (!restarted){
+            StartRangeCursor(cursor, backward, modification);
+            restarted = true;
+         }//end if
+         continue;
+      }//end if
+      numberOfEntries = currNode.GetNumberOfEntries();
+      // The objects at the position of the cursor are still taken, so the
+      // slack keeps the bounds of the triangle inequality safe despite the
+      // rounding of the distances.
+      inRange = cursor->GetInternalRadius() * (1 - 1e-9);
+      outRange = cursor->GetExternalRadius() * (1 + 1e-9);
+      if (currNode.GetNodeType() == stSlimNode::INDEX){
+         for (idx = 0; idx < numberOfEntries; idx++){
+            const stSlimIndexNode::stSlimIndexEntry & entry =
+                  currNode.GetIndexEntry(idx);
+
+            // Try to cut this subtree with the triangle inequality.
+            if ((item.Radius != MAXDOUBLE) &&
+                  ((item.Distance - entry.Distance - entry.Radius > outRange) ||
+                  (item.Distance + entry.Distance + entry.Radius < inRange))){
+               continue;
+            }//end if
+            tmpObj.Unserialize(currNode.GetObject(idx), currNode.GetObjectSize(idx));
+            distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+            if ((distance - entry.Radius <= outRange) &&
+                  (distance + entry.Radius >= inRange)){
+               // A node must come before its objects, so its key is a
+               // little closer to the cursor than its bound.
+               slack = (distance + entry.Radius) * 1e-9;
+               if (backward){
+                  child.Key = std::min(distance + entry.Radius + slack,
+                        cursor->GetExternalRadius());
+               }else{
+                  child.Key = std::max(distance - entry.Radius - slack,
+                        cursor->GetInternalRadius());
+               }//end if
+               child.Distance = distance;
+               child.Radius = entry.Radius;
+               child.PageID = entry.PageID;
+               child.Entry = 0;
+               child.OID = 0;
+               child.Object = false;
+               cursor->Push(child);
+            }//end if
+         }//end for
+      }else{
+         for (idx = 0; idx < numberOfEntries; idx++){
+            // Try to cut this object with the triangle inequality.
+            if ((item.Radius != MAXDOUBLE) &&
+                  ((item.Distance - currNode.GetLeafEntry(idx).Distance >
+                  outRange) ||
+                  (item.Distance + currNode.GetLeafEntry(idx).Distance <
+                  inRange))){
+               continue;
+            }//end if
+            tmpObj.IncludedUnserialize(currNode.GetObject(idx),
+                  currNode.GetObjectSize(idx));
+            distance = this->myMetricEvaluator->GetDistance(tmpObj, *sample);
+            if (cursor->Qualifies(distance, tmpObj.GetOID())){
+               if ((leaf == NULL) || (leaf->GetPageID() != item.PageID)){
+                  // The objects wait in a copy of the leaf.
+                  leaf.reset(new stPage(currPage->GetPageSize(), item.PageID));
+                  leaf->Copy(currPage);
+               }//end if
+               child.Key = distance;
+               child.Distance = distance;
+               child.Radius = 0;
+               child.PageID = item.PageID;
+               child.Entry = idx;
+               child.OID = tmpObj.GetOID();
+               child.Object = true;
+               child.Leaf = leaf;
+               cursor->Push(child);
+            }//end if
+         }//end for
+         child.Leaf.reset();
+      }//end if
+
+      // Free it all
+      tMetricTree::myPageManager->ReleasePage(currPage);
+   }//end while
+   return true;
+}//end tmpl_stSlimTree<ObjectType, EvaluatorType>::RangeCursorQuery
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+stResultPaged<ObjectType> * tmpl_stSlimTree::RangeCursorQuery(
+      ObjectType * sample, u_int32_t nObj, stRangeCursor * cursor,
+      bool backward){
+   tResultPaged * result = new tResultPaged();
+   tVisitor visitor;
+
+   result->SetQueryInfo(sample->Clone(),
+         backward ? PREVIOUSRANGEQUERY : NEXTRANGEQUERY, nObj,
+         cursor->GetExternalRadius(), false);
+   if (nObj > 0){
+      visitor = [result, nObj](const unsigned char * data, u_int32_t size,
+            double distance){
+         ObjectType * obj = new ObjectType();
+
+         obj->IncludedUnserialize(data, size);
+         result->AddPair(obj, distance);
+         return result->GetNumOfEntries() < nObj;
+      };
+      RangeCursorQuery(sample, cursor, backward, visitor);
+   }//end if
+   return result;
+}//end tmpl_stSlimTree<ObjectType, EvaluatorType>::RangeCursorQuery
+
 //------------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
 stResult<ObjectType> * tmpl_stSlimTree::LocalKRingQuery(
@@ -6554,7 +8587,7 @@ void tmpl_stSlimTree::LocalKRingQuery(
          double distanceRepres){
 
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    double distance;
    u_int32_t idx;
@@ -6566,11 +8599,11 @@ void tmpl_stSlimTree::LocalKRingQuery(
    if (pageID != 0){
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
          // Priority queue
          queue = new tPriorityQueue(numberOfEntries);
@@ -6612,7 +8645,7 @@ void tmpl_stSlimTree::LocalKRingQuery(
 
       }else{ 
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
          // for each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
@@ -6646,8 +8679,6 @@ void tmpl_stSlimTree::LocalKRingQuery(
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
    }//end if
 
@@ -6749,7 +8780,7 @@ void stSlimTree<ObjectType, EvaluatorType>::KRingQuery(
    tDynamicPriorityQueue * queue;
    u_int32_t idx;
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    stQueryPriorityQueueValue pqCurrValue;
    stQueryPriorityQueueValue pqTMPValue;
@@ -6769,11 +8800,11 @@ void stSlimTree<ObjectType, EvaluatorType>::KRingQuery(
    while (pqCurrValue.PageID != 0){
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
          // for each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
@@ -6799,7 +8830,7 @@ void stSlimTree<ObjectType, EvaluatorType>::KRingQuery(
 
       }else{ 
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
          // for each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
@@ -6833,8 +8864,6 @@ void stSlimTree<ObjectType, EvaluatorType>::KRingQuery(
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
 
       if (queue->GetSize() > this->maxQueue)
@@ -6898,7 +8927,7 @@ void stSlimTree<ObjectType, EvaluatorType>::InitializeIncrementalNearestQuery(
       ObjectType * sample, u_int32_t k, tResult * result, tGenericPriorityQueue * globalQueue){
 
    stPage * rootPage;
-   stSlimNode * rootNode;
+   stSlimNodeView rootNode;
    ObjectType tmpObj;
    double distance;
    u_int32_t idx;
@@ -6908,11 +8937,11 @@ void stSlimTree<ObjectType, EvaluatorType>::InitializeIncrementalNearestQuery(
 
    if (this->GetRoot() != 0){
       rootPage = tMetricTree::myPageManager->GetPage(this->GetRoot());
-      rootNode = stSlimNode::CreateNode(rootPage);
+      rootNode.SetPage(rootPage);
       // Is it a Index node?
-      if (rootNode->GetNodeType() == stSlimNode::INDEX) {
+      if (rootNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)rootNode;
+         stSlimNodeView * indexNode = &rootNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
          // for each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
@@ -6928,7 +8957,7 @@ void stSlimTree<ObjectType, EvaluatorType>::InitializeIncrementalNearestQuery(
          }//end for
       }else{ 
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)rootNode;
+         stSlimNodeView * leafNode = &rootNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
          // for each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
@@ -6946,8 +8975,6 @@ void stSlimTree<ObjectType, EvaluatorType>::InitializeIncrementalNearestQuery(
       if (globalQueue->GetSize() > this->maxQueue)
          this->maxQueue = globalQueue->GetSize();
       //Free it all
-      delete rootNode;
-	  rootNode = 0;
       tMetricTree::myPageManager->ReleasePage(rootPage);
    }//end if
    
@@ -6958,7 +8985,7 @@ template <class ObjectType, class EvaluatorType>
 void stSlimTree<ObjectType, EvaluatorType>::IncrementalNearestQuery(
          ObjectType * sample, u_int32_t k, tResult * result, tGenericPriorityQueue * globalQueue){
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    double distance;
    u_int32_t idx;
@@ -6974,11 +9001,11 @@ void stSlimTree<ObjectType, EvaluatorType>::IncrementalNearestQuery(
          case NODE:
             // Read node...
             currPage = tMetricTree::myPageManager->GetPage(entryNode->GetPageID());
-            currNode = stSlimNode::CreateNode(currPage);
+            currNode.SetPage(currPage);
             // Is it a Index node?
-            if (currNode->GetNodeType() == stSlimNode::INDEX) {
+            if (currNode.GetNodeType() == stSlimNode::INDEX) {
                // Get Index node
-               stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+               stSlimNodeView * indexNode = &currNode;
                numberOfEntries = indexNode->GetNumberOfEntries();
 
                // for each entry...
@@ -6994,7 +9021,7 @@ void stSlimTree<ObjectType, EvaluatorType>::IncrementalNearestQuery(
                }//end for
             }else{
                // No, it is a leaf node. Get it.
-               stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+               stSlimNodeView * leafNode = &currNode;
                numberOfEntries = leafNode->GetNumberOfEntries();
                // for each entry...
                for (idx = 0; idx < numberOfEntries; idx++) {
@@ -7007,8 +9034,6 @@ void stSlimTree<ObjectType, EvaluatorType>::IncrementalNearestQuery(
                }//end for
             }//end if
             //Free it all
-            delete currNode;
-			currNode = 0;
             tMetricTree::myPageManager->ReleasePage(currPage);
             break;
          case APPROXIMATENODE :
@@ -7078,7 +9103,7 @@ void stSlimTree<ObjectType, EvaluatorType>::InitializeIncrementalNearestQuery(
       ObjectType * sample, u_int32_t k, tResult * result, tPGenericHeap * globalQueue){
 
    stPage * rootPage;
-   stSlimNode * rootNode;
+   stSlimNodeView rootNode;
    ObjectType tmpObj;
    double distance;
    u_int32_t idx;
@@ -7088,11 +9113,11 @@ void stSlimTree<ObjectType, EvaluatorType>::InitializeIncrementalNearestQuery(
 
    if (this->GetRoot() != 0){
       rootPage = tMetricTree::myPageManager->GetPage(this->GetRoot());
-      rootNode = stSlimNode::CreateNode(rootPage);
+      rootNode.SetPage(rootPage);
       // Is it a Index node?
-      if (rootNode->GetNodeType() == stSlimNode::INDEX) {
+      if (rootNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)rootNode;
+         stSlimNodeView * indexNode = &rootNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
          // for each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
@@ -7109,7 +9134,7 @@ void stSlimTree<ObjectType, EvaluatorType>::InitializeIncrementalNearestQuery(
          }//end for
       }else{ 
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)rootNode;
+         stSlimNodeView * leafNode = &rootNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
          // for each entry...
          for (idx = 0; idx < numberOfEntries; idx++) {
@@ -7128,8 +9153,6 @@ void stSlimTree<ObjectType, EvaluatorType>::InitializeIncrementalNearestQuery(
       if (globalQueue->GetSize() > this->maxQueue)
          this->maxQueue = globalQueue->GetSize();
       //Free it all
-      delete rootNode;
-	  rootNode = 0;
       tMetricTree::myPageManager->ReleasePage(rootPage);
    }//end if
    
@@ -7140,7 +9163,7 @@ template <class ObjectType, class EvaluatorType>
 void stSlimTree<ObjectType, EvaluatorType>::IncrementalNearestQuery(
          ObjectType * sample, u_int32_t k, tResult * result, tPGenericHeap * globalQueue){
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    ObjectType * object;
    u_int32_t pageID;
@@ -7164,11 +9187,11 @@ void stSlimTree<ObjectType, EvaluatorType>::IncrementalNearestQuery(
          case NODE:
             // Read node...
             currPage = tMetricTree::myPageManager->GetPage(pageID);
-            currNode = stSlimNode::CreateNode(currPage);
+            currNode.SetPage(currPage);
             // Is it a Index node?
-            if (currNode->GetNodeType() == stSlimNode::INDEX) {
+            if (currNode.GetNodeType() == stSlimNode::INDEX) {
                // Get Index node
-               stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+               stSlimNodeView * indexNode = &currNode;
                numberOfEntries = indexNode->GetNumberOfEntries();
 
                // for each entry...
@@ -7186,7 +9209,7 @@ void stSlimTree<ObjectType, EvaluatorType>::IncrementalNearestQuery(
                }//end for
             }else{
                // No, it is a leaf node. Get it.
-               stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+               stSlimNodeView * leafNode = &currNode;
                numberOfEntries = leafNode->GetNumberOfEntries();
                // for each entry...
                for (idx = 0; idx < numberOfEntries; idx++) {
@@ -7201,8 +9224,6 @@ void stSlimTree<ObjectType, EvaluatorType>::IncrementalNearestQuery(
                }//end for
             }//end if
             //Free it all
-            delete currNode;
-			currNode = 0;
             tMetricTree::myPageManager->ReleasePage(currPage);
             break;//end NODE
          case APPROXIMATENODE :
@@ -7261,7 +9282,7 @@ void stSlimTree<ObjectType, EvaluatorType>::LazyRangeQuery(
          bool & stop){
 
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    double distance;
    u_int32_t idx;
@@ -7271,11 +9292,11 @@ void stSlimTree<ObjectType, EvaluatorType>::LazyRangeQuery(
    if (pageID != 0){
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
 
          for (idx = 0; (idx < numberOfEntries) && !stop; idx++) {
@@ -7297,7 +9318,7 @@ void stSlimTree<ObjectType, EvaluatorType>::LazyRangeQuery(
          }//end for
       }else{
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          numberOfEntries = leafNode->GetNumberOfEntries();
 
          for (idx = 0; (idx < numberOfEntries) && !stop; idx++) {
@@ -7328,8 +9349,6 @@ void stSlimTree<ObjectType, EvaluatorType>::LazyRangeQuery(
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
    }//end if
 
@@ -7359,7 +9378,7 @@ void tmpl_stSlimTree::AproximateNearestQuery(
          u_int32_t pageID, tResult * result, ObjectType * sample,
          double & rangeK, u_int32_t k){
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    ObjectType tmpObj;
    double distance;
    u_int32_t idx;
@@ -7376,13 +9395,13 @@ void tmpl_stSlimTree::AproximateNearestQuery(
 
    // Let's search
    if (pageID != 0){
-      stSlimIndexNode * indexNode;
+      stSlimNodeView * indexNode;
 
       //Get the PageID of a Leaf Node
       for (idx = 0; (idx < TreeHeight-1) && (tpath[idx] < numberOfEntries); idx++){
          currPage = tMetricTree::myPageManager->GetPage(pageID);
-         currNode = stSlimNode::CreateNode(currPage);
-         indexNode = (stSlimIndexNode *)currNode;
+         currNode.SetPage(currPage);
+         indexNode = &currNode;
          numberOfEntries = indexNode->GetNumberOfEntries();
 
          //Exist the node?
@@ -7403,13 +9422,13 @@ void tmpl_stSlimTree::AproximateNearestQuery(
 
       //leaf node
       currPage = tMetricTree::myPageManager->GetPage(pageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
 
       // Get Leaf node
-      stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+      stSlimNodeView * leafNode = &currNode;
       numberOfEntries = leafNode->GetNumberOfEntries();
 
-      if (currNode->GetNodeType() == stSlimNode::LEAF){
+      if (currNode.GetNodeType() == stSlimNode::LEAF){
          //search in the leaf node
          for (int i = 0; i < numberOfEntries; i++) {
             // use of the triangle inequality
@@ -7443,8 +9462,6 @@ void tmpl_stSlimTree::AproximateNearestQuery(
       }//end if
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
    }//end if
 }//end AproximateNearestQuery
@@ -7452,644 +9469,748 @@ void tmpl_stSlimTree::AproximateNearestQuery(
 //------------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
 stJoinedResult<ObjectType> * tmpl_stSlimTree::NearestJoinQuery(
-      stSlimTree * slimTree, u_int32_t k, bool tie){
+      stSlimTree * slimTree, u_int32_t k, bool tie, u_int32_t nThreads){
+   stPage * currPage;
+   stSlimNodeView currNode;
+   tJoinCandidate cand;
+   std::vector < tJoinTask > tasks;
+   std::vector < tJoinTask > split;
+   std::vector < std::vector < tJoinTriple > > triples;
+   std::vector < EvaluatorType > evaluators;
+   std::vector < std::thread > threads;
+   std::atomic < u_int32_t > nextTask;
+   u_int32_t depth;
+   u_int32_t i;
+   u_int32_t j;
+   u_int32_t t;
+
    // Create result
    tJoinedResult * result = new tJoinedResult();
    // Set the result.
    result->SetQueryInfo(KNEARESTJOINQUERY, k, MAXDOUBLE, tie);
 
-   // Soon...
+   if ((this->GetRoot() == 0) || (slimTree->GetRoot() == 0) || (k == 0)){
+      return result;
+   }//end if
+   stSharedLatchGuard readLatch(GetReadLatch());
+   stSharedLatchGuard joinedLatch((slimTree != this) ? slimTree->GetReadLatch() : NULL);
 
-   // Return the result.
-   return result;
-}//end NearestJoinQuery
+   if (nThreads == 0){
+      nThreads = std::thread::hardware_concurrency();
+   }//end if
+   if ((nThreads == 0) || (!IsConcurrent()) || (!slimTree->IsConcurrent())){
+      // The page managers can not be shared.
+      nThreads = 1;
+   }//end if
 
-//------------------------------------------------------------------------------
-template <class ObjectType, class EvaluatorType>
-stJoinedResult<ObjectType> * tmpl_stSlimTree::RangeJoinQuery(
-      stSlimTree * slimTree, double range, bool buffer){
-   // Create result
-   tJoinedResult * result = new tJoinedResult();
-   result->SetQueryInfo(RANGEJOINQUERY, -1, range, false);
-   stPage * currPage;
-   stSlimNode * currIndexNode;
+   // The root of this tree starts with the entries of the joined root.
+   tasks.resize(1);
+   tasks[0].PageID = this->GetRoot();
+   tasks[0].Radius = MAXDOUBLE;
+   tasks[0].Bound = MAXDOUBLE;
+   currPage = slimTree->GetPageManager()->GetPage(slimTree->GetRoot());
+   currNode.SetPage(currPage);
+   for (i = 0; i < currNode.GetNumberOfEntries(); i++){
+      cand.Object.reset(new ObjectType());
+      if (currNode.GetNodeType() == stSlimNode::INDEX){
+         cand.Object->Unserialize(currNode.GetObject(i), currNode.GetObjectSize(i));
+         cand.PageID = currNode.GetIndexEntry(i).PageID;
+         cand.Radius = currNode.GetIndexEntry(i).Radius;
+         cand.NEntries = currNode.GetIndexEntry(i).NEntries;
+      }else{
+         cand.Object->IncludedUnserialize(currNode.GetObject(i), currNode.GetObjectSize(i));
+         cand.PageID = 0;
+         cand.Radius = 0;
+         cand.NEntries = 1;
+      }//end if
+      cand.Offset = 0;
+      cand.Size = 0;
+      cand.Distance = 0;
+      tasks[0].Candidates.push_back(cand);
+   }//end for
+   slimTree->GetPageManager()->ReleasePage(currPage);
+
+   // Split the upper levels until there are enough subtrees for all threads.
+   triples.resize(1);
+   depth = 1;
+   while ((nThreads > 1) && (tasks.size() < nThreads * STJOINTASKSPERTHREAD) &&
+         (depth < this->GetHeight())){
+      split.clear();
+      for (i = 0; i < tasks.size(); i++){
+         NearestJoinTask(tasks[i], slimTree, k, tie, this->myMetricEvaluator,
+                         triples[0], &split);
+      }//end for
+      tasks.swap(split);
+      depth++;
+   }//end while
 
-   // Is there entries in the first tree?
-   if (this->GetRoot() != 0){
-      // Read node...
-      currPage = tMetricTree::myPageManager->GetPage(GetRoot());
-      currIndexNode = stSlimNode::CreateNode(currPage);
-      //verifing navegation
-      RangeJoinRecursive(this->GetHeight(), currIndexNode, slimTree, range,
-                         buffer, result);
-      // Free it all
-      delete currIndexNode;
-	  currIndexNode = 0;
-      tMetricTree::myPageManager->ReleasePage(currPage);
+   // Solve them.
+   triples.resize(tasks.size());
+   if (nThreads > tasks.size()){
+      nThreads = tasks.size();
+   }//end if
+   if (nThreads <= 1){
+      for (i = 0; i < tasks.size(); i++){
+         NearestJoinTask(tasks[i], slimTree, k, tie, this->myMetricEvaluator,
+                         triples[i], NULL);
+      }//end for
+   }else{
+      // One evaluator for each thread to avoid races on its statistics.
+      evaluators.reserve(nThreads);
+      for (t = 0; t < nThreads; t++){
+         evaluators.push_back(*this->myMetricEvaluator);
+         evaluators[t].ResetStatistics();
+      }//end for
+      nextTask = 0;
+      for (t = 0; t < nThreads; t++){
+         threads.push_back(std::thread([&, t](){
+            u_int32_t task;
+
+            while ((task = nextTask++) < tasks.size()){
+               NearestJoinTask(tasks[task], slimTree, k, tie, &evaluators[t],
+                               triples[task], NULL);
+            }//end while
+         }));
+      }//end for
+      for (t = 0; t < nThreads; t++){
+         threads[t].join();
+         this->myMetricEvaluator->UpdateDistanceCount(evaluators[t].GetDistanceCount());
+      }//end for
    }//end if
+
+   // Add the triples in the order of the outer subtrees.
+   for (i = 0; i < triples.size(); i++){
+      for (j = 0; j < triples[i].size(); j++){
+         result->AddJoinedTriple(triples[i][j].Object,
+               triples[i][j].JoinedObject, triples[i][j].Distance);
+      }//end for
+   }//end for
+
+   // Return the result.
    return result;
-}//end RangeJoinQuery
+}//end NearestJoinQuery
 
 //------------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
-void tmpl_stSlimTree:: RangeJoinRecursive(u_int32_t heightIndex,
-      stSlimNode * currNode, stSlimTree * slimTree,
-      double range, bool buffer, tJoinedResult * result){
-
-   stPage * subPageIndex;
-   stPage * joinedPage;
-   stPage ** subPageJoin;
-   stSlimNode * subNodeIndex;
-   stSlimNode * joinedNode;
-   stSlimNode ** subNodeJoin;
-   stSlimIndexNode * indexNode;
-   stSlimIndexNode * joinedIndexNode;
-   stSlimIndexNode * indexNodeIndex;
-   u_int32_t numberOfEntries, joinedNumberOfEntries, leafNumberOfEntries;
-   stSlimLeafNode * leafNode;
-   ObjectType * tmpObj;
-   ObjectType ** bufferJoinedObj;
+void tmpl_stSlimTree::NearestJoinTask(tJoinTask & task,
+      stSlimTree * joinedTree, u_int32_t k, bool tie, EvaluatorType * evaluator,
+      std::vector < tJoinTriple > & triples, std::vector < tJoinTask > * split){
+   stPage * currPage;
+   stSlimNodeView currNode;
+   tJoinTask child;
+   tJoinCandidates large;
+   tJoinCandidates entries;
+   std::vector < unsigned char > data;
    double distance;
-   u_int32_t i, j;
+   u_int32_t numberOfEntries;
+   u_int32_t i;
+   u_int32_t j;
+   u_int32_t e;
 
-   // Get the number of entries in currNode.
-   numberOfEntries = currNode->GetNumberOfEntries();
+   currPage = tMetricTree::myPageManager->GetPage(task.PageID);
+   currNode.SetPage(currPage);
 
-   // When the height of index is more than the height of the joined tree.
-   if (heightIndex > slimTree->GetHeight()){
-      //node of index is index
-      indexNode = (stSlimIndexNode *) currNode;
+   if (currNode.GetNodeType() == stSlimNode::INDEX){
+      numberOfEntries = currNode.GetNumberOfEntries();
       for (i = 0; i < numberOfEntries; i++){
-         // Read node...
-         subPageIndex = tMetricTree::myPageManager->GetPage(indexNode->GetIndexEntry(i).PageID);
-         subNodeIndex = stSlimNode::CreateNode(subPageIndex);
-         // Navegate thought it.
-         RangeJoinRecursive(heightIndex - 1, subNodeIndex, slimTree, range, 
-                            buffer, result);
-         // Free it all.
-         delete subNodeIndex;
-		 subNodeIndex = 0;
-         tMetricTree::myPageManager->ReleasePage(subPageIndex);
-      }//end for
-   }else{
-      // Read node join..
-      joinedPage = slimTree->GetPageManager()->GetPage(slimTree->GetRoot());
-      joinedNode = stSlimNode::CreateNode(joinedPage);
-      //number of entries
-      joinedNumberOfEntries = joinedNode->GetNumberOfEntries();
-      //obj index
-      tmpObj = new ObjectType;
-      //create cache objJoin
-      bufferJoinedObj = new ObjectType * [joinedNumberOfEntries];
-      
-      // For each entry in node join
-      for (i = 0; i < joinedNumberOfEntries; i++) {
-         // Rebuild the object
-         bufferJoinedObj[i] = new ObjectType;
-         bufferJoinedObj[i]->Unserialize(joinedNode->GetObject(i),
-                                    joinedNode->GetObjectSize(i));
-      }//end for
-
-      // Is it an Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX){
-         //node of index is index
-         indexNodeIndex = (stSlimIndexNode *) currNode;
-         // if node of index is index, so node of join is index
-         joinedIndexNode = (stSlimIndexNode *)joinedNode;
-         // buffer is active
-         if (buffer){
-            //create cache distance
-            subPageJoin = new stPage * [joinedNumberOfEntries];
-            subNodeJoin = new stSlimNode * [joinedNumberOfEntries];
-            for (j = 0; j < joinedNumberOfEntries; j++){
-               //page and node is null
-               subPageJoin[j] = NULL;
-               subNodeJoin[j] = NULL;
-            }//end for
-         }else{
-            //create cache distance
-            subPageJoin = new stPage * [1];
-            subNodeJoin = new stSlimNode * [1];
-         }//end if
-         for (i = 0; i < numberOfEntries; i++){
-            // Rebuild the object
-            tmpObj->Unserialize(indexNodeIndex->GetObject(i),
-                                indexNodeIndex->GetObjectSize(i));
-            // read sub node
-            subPageIndex = tMetricTree::myPageManager->GetPage(
-                           indexNodeIndex->GetIndexEntry(i).PageID);
-            subNodeIndex = stSlimNode::CreateNode(subPageIndex);
-            // For each entry in node join
-            for (j = 0; j < joinedNumberOfEntries; j++) {
-               // Evaluate distance
-               distance = this->myMetricEvaluator->GetDistance(tmpObj,
-                                                         bufferJoinedObj[j]);
-               // is this a qualified subtree?
-               if (distance <= indexNodeIndex->GetIndexEntry(i).Radius +
-                   joinedIndexNode->GetIndexEntry(j).Radius + range){
-                  // buffer is active
-                  if (buffer){
-                     // if not read
-                     if (subPageJoin[j] == NULL){
-                        //read node
-                        subPageJoin[j] = slimTree->GetPageManager()->GetPage(
-                           joinedIndexNode->GetIndexEntry(j).PageID);
-                        subNodeJoin[j] = stSlimNode::CreateNode(subPageJoin[j]);
-                     }//end if
-                     // Yes! Analyze it!
-                     RangeJoinQueryRecursive(subNodeIndex,
-                        indexNodeIndex->GetIndexEntry(i).Radius,
-                        subNodeJoin[j], joinedIndexNode->GetIndexEntry(j).Radius,
-                        slimTree->GetPageManager(), distance, range,
-                        result, buffer);
-                  }else{
-                     //read node
-                     subPageJoin[0] = slimTree->GetPageManager()->GetPage(
-                        joinedIndexNode->GetIndexEntry(j).PageID);
-                     subNodeJoin[0] = stSlimNode::CreateNode(subPageJoin[0]);
-                     // Yes! Analyze it!
-                     RangeJoinQueryRecursive(subNodeIndex,
-                        indexNodeIndex->GetIndexEntry(i).Radius,
-                        subNodeJoin[0], joinedIndexNode->GetIndexEntry(j).Radius,
-                        slimTree->GetPageManager(), distance, range,
-                        result, buffer);
-                     //free it all
-                     delete subNodeJoin[0];
-					 subNodeJoin[0] = 0;
-                     slimTree->GetPageManager()->ReleasePage(subPageJoin[0]);
-                  }//end if
-               }//end if
-            }//end for
-            // Free it all
-            delete subNodeIndex;
-			subNodeIndex = 0;
-            tMetricTree::myPageManager->ReleasePage(subPageIndex);
-         }//end for
-         // Free it all
-         if (buffer){
-            for (j = 0; j < joinedNumberOfEntries; j++) {
-               if (subNodeJoin[j] != NULL){
-                  delete subNodeJoin[j];
-				  subNodeJoin[j] = 0;
-                  slimTree->GetPageManager()->ReleasePage(subPageJoin[j]);
-               }//end if
-            }//end for
-         }//end if
-         delete[] subNodeJoin;
-		 subNodeJoin = 0;
-         delete[] subPageJoin;
-		 subPageJoin = 0;
-      }else{
-         //node of index is leaf
-         leafNode = (stSlimLeafNode *) currNode;
-         // Is it an Index node?
-         if (joinedNode->GetNodeType() == stSlimNode::INDEX) {
-            //node of join is index
-            joinedIndexNode = (stSlimIndexNode *)joinedNode;
-            // buffer is active
-            if (buffer){
-               //create cache distance
-               subPageJoin = new stPage * [joinedNumberOfEntries];
-               subNodeJoin = new stSlimNode * [joinedNumberOfEntries];
-               for (j = 0; j < joinedNumberOfEntries; j++){
-                  //page and node is null
-                  subPageJoin[j] = NULL;
-                  subNodeJoin[j] = NULL;
-               }//end for
-            }else{
-               //create cache distance
-               subPageJoin = new stPage * [1];
-               subNodeJoin = new stSlimNode * [1];
+         child.PageID = currNode.GetIndexEntry(i).PageID;
+         child.Radius = currNode.GetIndexEntry(i).Radius;
+         child.Representative.reset(new ObjectType());
+         child.Representative->Unserialize(currNode.GetObject(i),
+               currNode.GetObjectSize(i));
+         child.Bound = task.Bound;
+         child.Candidates.clear();
+         large.clear();
+
+         // Distances to the new representative.
+         for (j = 0; j < task.Candidates.size(); j++){
+            const tJoinCandidate & cand = task.Candidates[j];
+
+            // Cut it with the distance of both representatives first.
+            if ((task.Representative != NULL) &&
+                  (fabs(cand.Distance - currNode.GetIndexEntry(i).Distance) -
+                  cand.Radius - child.Radius > child.Bound)){
+               continue;
+            }//end if
+            distance = evaluator->GetDistance(*child.Representative, *cand.Object);
+            if (distance - cand.Radius - child.Radius <= child.Bound){
+               child.Candidates.push_back(cand);
+               child.Candidates.back().Distance = distance;
             }//end if
-            for (i = 0; i < numberOfEntries; i++){
-               // Rebuild the object
-               tmpObj->Unserialize(leafNode->GetObject(i),
-                                   leafNode->GetObjectSize(i));
-               for (j = 0; j < joinedNumberOfEntries; j++){
-                  // Evaluate distance
-                  distance = this->myMetricEvaluator->GetDistance(tmpObj,
-                                                            bufferJoinedObj[j]);
-                  // is this a qualified subtree?
-                  if (distance <= joinedIndexNode->GetIndexEntry(j).Radius + range){
-                     // buffer is active
-                     if (buffer){
-                        // if not read
-                        if (subPageJoin[j] == NULL){
-                           //read node
-                           subPageJoin[j] = slimTree->GetPageManager()->GetPage(
-                              joinedIndexNode->GetIndexEntry(j).PageID);
-                           subNodeJoin[j] = stSlimNode::CreateNode(subPageJoin[j]);
-                        }//end if
-                        // Yes! Analyze it!
-                        JoinedTreeRangeJoinRecursive(slimTree->GetPageManager(),
-                                    subNodeJoin[j], tmpObj,
-                                    distance, range, result);
-                     }else{
-                        //read node
-                        subPageJoin[0] = slimTree->GetPageManager()->GetPage(
-                                         joinedIndexNode->GetIndexEntry(j).PageID);
-                        subNodeJoin[0] = stSlimNode::CreateNode(subPageJoin[0]);
-                        // Yes! Analyze it!
-                        JoinedTreeRangeJoinRecursive(slimTree->GetPageManager(),
-                                                     subNodeJoin[0], tmpObj,
-                                                     distance, range, result);
-                        // Free it all
-                        delete subNodeJoin[0];
-						subNodeJoin[0] = 0;
-                        slimTree->GetPageManager()->ReleasePage(subPageJoin[0]);
-                     }//end if
+         }//end for
+         child.Bound = GetJoinBound(child.Candidates, child.Radius, k, child.Bound);
+
+         // Expand the candidate subtrees larger than the child, so the pairs
+         // of subtrees go down together.
+         for (j = 0; j < child.Candidates.size(); j++){
+            if ((child.Candidates[j].PageID != 0) &&
+                  (child.Candidates[j].Radius > child.Radius) &&
+                  (child.Candidates[j].Distance - child.Candidates[j].Radius -
+                  child.Radius <= child.Bound)){
+               entries.clear();
+               data.clear();
+               ExpandJoinCandidate(child.Candidates[j], joinedTree, entries, data);
+               for (e = 0; e < entries.size(); e++){
+                  // Cut it with the distance to the representative of the
+                  // subtree first.
+                  if (fabs(child.Candidates[j].Distance - entries[e].Distance) -
+                        entries[e].Radius - child.Radius > child.Bound){
+                     continue;
                   }//end if
-               }//end for
-            }//end for
-            // Free it all
-            if (buffer){
-               for (j = 0; j < joinedNumberOfEntries; j++) {
-                  if (subNodeJoin[j] != NULL){
-                     delete subNodeJoin[j];
-					 subNodeJoin[j] = 0;
-                     slimTree->GetPageManager()->ReleasePage(subPageJoin[j]);
+                  GetJoinObject(entries[e], data);
+                  if (entries[e].Distance == 0.0){
+                     entries[e].Distance = child.Candidates[j].Distance;
+                  }else{
+                     entries[e].Distance = evaluator->GetDistance(
+                           *child.Representative, *entries[e].Object);
+                  }//end if
+                  if (entries[e].Distance - entries[e].Radius - child.Radius <=
+                        child.Bound){
+                     large.push_back(entries[e]);
                   }//end if
                }//end for
+               child.Candidates[j].Object.reset();
+            }//end if
+         }//end for
+         // Drop the expanded and the pruned ones.
+         for (j = 0; j < child.Candidates.size(); j++){
+            if ((child.Candidates[j].Object != NULL) &&
+                  (child.Candidates[j].Distance - child.Candidates[j].Radius -
+                  child.Radius <= child.Bound)){
+               large.push_back(child.Candidates[j]);
             }//end if
-            delete[] subNodeJoin;
-			subNodeJoin = 0;
-            delete[] subPageJoin;
-			subPageJoin = 0;
+         }//end for
+         child.Candidates.swap(large);
+         child.Bound = GetJoinBound(child.Candidates, child.Radius, k, child.Bound);
+
+         if (split != NULL){
+            split->push_back(child);
          }else{
-            // joined node is leaf
-            // Lets check all objects in this node
-            for (i = 0; i < numberOfEntries; i++){
-               // Rebuild the object
-               tmpObj->Unserialize(leafNode->GetObject(i),
-                                   leafNode->GetObjectSize(i));
-               // For each entry in node join
-               for (j = 0; j < joinedNumberOfEntries; j++) {
-                  // Evaluate distance
-                  distance = this->myMetricEvaluator->GetDistance(tmpObj,
-                                                            bufferJoinedObj[j]);
-                  // is this a qualified subtree?
-                  if (distance <= range){
-                     // Yes! Put it in the result set.
-                     result->AddJoinedTriple(tmpObj->Clone(),
-                                             bufferJoinedObj[j]->Clone(),
-                                             distance);
-                  }//end if
-               }//end for
-            }//end for
+            NearestJoinTask(child, joinedTree, k, tie, evaluator, triples, NULL);
          }//end if
-      }//end if
-
-      // Free it all
-      for (j = 0; j < joinedNumberOfEntries; j++) {
-         delete bufferJoinedObj[j];
-		 bufferJoinedObj[j] = 0;
       }//end for
-      delete[] bufferJoinedObj;
-	  bufferJoinedObj = 0;
-      delete joinedNode;
-	  joinedNode = 0;      
-      slimTree->GetPageManager()->ReleasePage(joinedPage);
-      delete tmpObj;
-	  tmpObj = 0;
+   }else{
+      NearestJoinLeaf(&currNode, task, joinedTree, k, tie, evaluator, triples);
    }//end if
-}//end RangeJoinRecursive
+
+   tMetricTree::myPageManager->ReleasePage(currPage);
+   // This subtree is done.
+   task.Candidates.clear();
+}//end stSlimTree<ObjectType, EvaluatorType>::NearestJoinTask
 
 //------------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
-void tmpl_stSlimTree::RangeJoinQueryRecursive(
-      stSlimNode * currIndexNode, double radiusObjIndex,
-      stSlimNode * joinedNode, double radiusObjJoin,
-      stPageManager * PageManagerJoin, double distRepres,
-      const double range, tJoinedResult * result,
-      bool buffer){
-      
-   u_int32_t numberOfEntries, joinedNumberOfEntries;
-   ObjectType * tmpObj = new ObjectType();
-   ObjectType ** bufferJoinedObj;
+void tmpl_stSlimTree::NearestJoinLeaf(stSlimNodeView * node, tJoinTask & task,
+      stSlimTree * joinedTree, u_int32_t k, bool tie,
+      EvaluatorType * evaluator, std::vector < tJoinTriple > & triples){
+   ObjectType obj;
+   ObjectType * rep;
+   tJoinCandidates items;
+   std::vector < double > repDistances;
+   std::vector < u_int32_t > firstChild;
+   std::vector < u_int32_t > lastChild;
+   std::vector < tJoinStep > queue;
+   std::vector < u_int32_t > seeds;
+   std::vector < double > seedDistances;
+   std::vector < unsigned char > data;
+   tJoinNeighbors neighbors;
+   tJoinStep step;
+   tJoinTriple triple;
+   u_int32_t numberOfEntries;
+   u_int32_t numberOfSeeds;
+   u_int32_t low;
+   u_int32_t high;
+   double bound;
    double distance;
-   u_int32_t i, j;
-   stPage ** subPageJoin;
-   stSlimNode ** subNodeJoin;
-   stSlimIndexNode * indexNodeIndex;
-   stSlimIndexNode * joinedIndexNode;
-   stSlimLeafNode * leafNode;
-   stSlimLeafNode * leafNodeJoin;
-
-   // Get the number of entries.
-   joinedNumberOfEntries = joinedNode->GetNumberOfEntries();
-   numberOfEntries = currIndexNode->GetNumberOfEntries();
-   // Create cache objJoin
-   bufferJoinedObj = new ObjectType * [joinedNumberOfEntries];
-
-   // For each entry in node join
-   for (j = 0; j < joinedNumberOfEntries; j++) {
-      // Rebuild the object
-      bufferJoinedObj[j] = new ObjectType();
-      bufferJoinedObj[j]->Unserialize(joinedNode->GetObject(j),
-                                 joinedNode->GetObjectSize(j));
-   }//end for
+   u_int32_t i;
+   u_int32_t j;
 
+   numberOfEntries = node->GetNumberOfEntries();
+   repDistances.resize(numberOfEntries);
+   for (i = 0; i < numberOfEntries; i++){
+      repDistances[i] = node->GetLeafEntry(i).Distance;
+   }//end for
 
-   // Is it an Index node?
-   if (currIndexNode->GetNodeType() == stSlimNode::INDEX){
-      //node of index is index
-      indexNodeIndex = (stSlimIndexNode *) currIndexNode;
-      // joined node always will be index
-      joinedIndexNode = (stSlimIndexNode *)joinedNode;
-      // buffer is active
-      if (buffer){
-         //create cache distance
-         subPageJoin = new stPage * [joinedNumberOfEntries];
-         subNodeJoin = new stSlimNode * [joinedNumberOfEntries];
-         for (j = 0; j < joinedNumberOfEntries; j++){
-            //page and node is null
-            subPageJoin[j] = NULL;
-            subNodeJoin[j] = NULL;
-         }//end for
-      }else{
-         //create cache distance
-         subPageJoin = new stPage * [1];
-         subNodeJoin = new stSlimNode * [1];
-      }//end if
+   // The candidates of the task are the seeds of all objects. The entries
+   // of the subtrees are added to items when they are first expanded.
+   items = task.Candidates;
+   numberOfSeeds = items.size();
+   if (task.Representative != NULL){
+      rep = task.Representative.get();
+   }else{
+      // The root is a leaf. Its first object is the representative.
+      rep = new ObjectType();
+      rep->IncludedUnserialize(node->GetObject(0), node->GetObjectSize(0));
       for (i = 0; i < numberOfEntries; i++){
-         // use of the triangle inequality to cut a subtree
-         if (distRepres <= indexNodeIndex->GetIndexEntry(i).Distance +
-             indexNodeIndex->GetIndexEntry(i).Radius + radiusObjJoin + range){
-            // Rebuild the object
-            tmpObj->Unserialize(indexNodeIndex->GetObject(i),
-                                indexNodeIndex->GetObjectSize(i));
-            // read sub node
-            stPage * subPageIndex = tMetricTree::myPageManager->GetPage(
-                  indexNodeIndex->GetIndexEntry(i).PageID);
-            stSlimNode * subNodeIndex = stSlimNode::CreateNode(subPageIndex);
-            // For each entry in node join
-            for (j = 0; j < joinedNumberOfEntries; j++) {
-               // use of the triangle inequality to cut a subtree
-               if (distRepres <= joinedIndexNode->GetIndexEntry(j).Distance +
-                   joinedIndexNode->GetIndexEntry(j).Radius +
-                   radiusObjIndex + range){
-                  // Evaluate distance
-                  distance = this->myMetricEvaluator->GetDistance(tmpObj,
-                                                            bufferJoinedObj[j]);
-                  // is this a qualified subtree?
-                  if (distance <= indexNodeIndex->GetIndexEntry(i).Radius +
-                      joinedIndexNode->GetIndexEntry(j).Radius + range){
-                     // buffer is active
-                     if (buffer){
-                        // if not read
-                        if (subPageJoin[j] == NULL){
-                           //read node
-                           subPageJoin[j] = PageManagerJoin->GetPage(
-                              joinedIndexNode->GetIndexEntry(j).PageID);
-                           subNodeJoin[j] = stSlimNode::CreateNode(subPageJoin[j]);
-                        }//end if
-                        // Yes! Analyze it!
-                        RangeJoinQueryRecursive(subNodeIndex,
-                           indexNodeIndex->GetIndexEntry(i).Radius,
-                           subNodeJoin[j], joinedIndexNode->GetIndexEntry(j).Radius,
-                           PageManagerJoin, distance, range, result,
-                           buffer);
-                     }else{
-                        //read node
-                        subPageJoin[0] = PageManagerJoin->GetPage(
-                           joinedIndexNode->GetIndexEntry(j).PageID);
-                        subNodeJoin[0] = stSlimNode::CreateNode(subPageJoin[0]);
-                        // Yes! Analyze it!
-                        RangeJoinQueryRecursive(subNodeIndex,
-                           indexNodeIndex->GetIndexEntry(i).Radius,
-                           subNodeJoin[0], joinedIndexNode->GetIndexEntry(j).Radius,
-                           PageManagerJoin, distance, range, result,
-                           buffer);
-                        //free it all
-                        delete subNodeJoin[0];
-						subNodeJoin[0] = 0;
-                        PageManagerJoin->ReleasePage(subPageJoin[0]);
-                     }//end if
-                  }//end if
-               }//end if
-            }//end for
-            // Free it all
-            delete subNodeIndex;
-            subNodeIndex = 0;
-            tMetricTree::myPageManager->ReleasePage(subPageIndex);
+         obj.IncludedUnserialize(node->GetObject(i), node->GetObjectSize(i));
+         repDistances[i] = evaluator->GetDistance(*rep, obj);
+      }//end for
+      for (j = 0; j < numberOfSeeds; j++){
+         items[j].Distance = evaluator->GetDistance(*rep, *items[j].Object);
+      }//end for
+      delete rep;
+   }//end if
+   firstChild.assign(numberOfSeeds, 0);
+   lastChild.assign(numberOfSeeds, 0);
+
+   // The seed objects sorted by their distances to the representative, so
+   // each object walks them in order of their lower bounds.
+   for (j = 0; j < numberOfSeeds; j++){
+      if (items[j].PageID == 0){
+         seeds.push_back(j);
+      }//end if
+   }//end for
+   std::sort(seeds.begin(), seeds.end(), [&items](u_int32_t a, u_int32_t b){
+      return items[a].Distance < items[b].Distance;
+   });
+   seedDistances.resize(seeds.size());
+   for (j = 0; j < seeds.size(); j++){
+      seedDistances[j] = items[seeds[j]].Distance;
+   }//end for
+
+   // A best first search for each object.
+   for (i = 0; i < numberOfEntries; i++){
+      obj.IncludedUnserialize(node->GetObject(i), node->GetObjectSize(i));
+      bound = task.Bound;
+      neighbors.clear();
+      queue.clear();
+
+      // The distances of the seed subtrees to the representative cut them
+      // for free.
+      for (j = 0; j < numberOfSeeds; j++){
+         if (items[j].PageID != 0){
+            step.LowerBound = fabs(items[j].Distance - repDistances[i]) -
+                  items[j].Radius;
+            if (step.LowerBound <= bound){
+               step.Item = j;
+               step.Distance = (repDistances[i] == 0.0) ? items[j].Distance : -1;
+               queue.push_back(step);
+            }//end if
          }//end if
       }//end for
-      // Free it all
-      if (buffer){
-         for (j = 0; j < joinedNumberOfEntries; j++) {
-            if (subNodeJoin[j] != NULL){
-               delete subNodeJoin[j];
-			   subNodeJoin[j] = 0;
-               PageManagerJoin->ReleasePage(subPageJoin[j]);
+      std::make_heap(queue.begin(), queue.end());
+      high = std::lower_bound(seedDistances.begin(), seedDistances.end(),
+            repDistances[i]) - seedDistances.begin();
+      low = high;
+
+      while (true){
+         // The nearest seed object not visited yet.
+         step.LowerBound = MAXDOUBLE;
+         if ((low > 0) && (repDistances[i] - seedDistances[low - 1] < step.LowerBound)){
+            step.LowerBound = repDistances[i] - seedDistances[low - 1];
+            step.Item = low - 1;
+         }//end if
+         if ((high < seeds.size()) && (seedDistances[high] - repDistances[i] < step.LowerBound)){
+            step.LowerBound = seedDistances[high] - repDistances[i];
+            step.Item = high;
+         }//end if
+         if ((!queue.empty()) && (queue.front().LowerBound <= step.LowerBound)){
+            std::pop_heap(queue.begin(), queue.end());
+            step = queue.back();
+            queue.pop_back();
+         }else if (step.LowerBound < MAXDOUBLE){
+            if (step.Item < low){
+               low--;
+            }else{
+               high++;
             }//end if
-         }//end for
-      }//end if
-      delete[] subNodeJoin;
-	  subNodeJoin = 0;
-      delete[] subPageJoin;
-	  subPageJoin = 0;
-   }else{
-      // The node is a leaf node.
-      leafNode = (stSlimLeafNode *) currIndexNode;
-      // Is it an Index node?
-      if (joinedNode->GetNodeType() == stSlimNode::INDEX) {
-         //node of join is index
-         joinedIndexNode = (stSlimIndexNode *)joinedNode;
-         //buffer is active
-         if (buffer){
-            //create cache distance
-            subPageJoin = new stPage * [joinedNumberOfEntries];
-            subNodeJoin = new stSlimNode * [joinedNumberOfEntries];
-            for (j = 0; j < joinedNumberOfEntries; j++){
-               //page and node is null
-               subPageJoin[j] = NULL;
-               subNodeJoin[j] = NULL;
-            }//end for
+            step.Item = seeds[step.Item];
+            step.Distance = (repDistances[i] == 0.0) ? items[step.Item].Distance : -1;
          }else{
-            //create cache distance
-            subPageJoin = new stPage * [1];
-            subNodeJoin = new stSlimNode * [1];
+            break;
          }//end if
-         for (i = 0; i < numberOfEntries; i++){
-            // use of the triangle inequality to cut a subtree
-            if (distRepres <= leafNode->GetLeafEntry(i).Distance +
-                radiusObjJoin + range){
-               // Rebuild the object
-               tmpObj->Unserialize(leafNode->GetObject(i),
-                                   leafNode->GetObjectSize(i));
-               for (j = 0; j < joinedNumberOfEntries; j++){
-                  // use of the triangle inequality to cut a subtree
-                  if (distRepres <= joinedIndexNode->GetIndexEntry(j).Distance +
-                      joinedIndexNode->GetIndexEntry(j).Radius +
-                      radiusObjIndex + range){
-                     // Evaluate distance
-                     distance = this->myMetricEvaluator->GetDistance(tmpObj,
-                                                               bufferJoinedObj[j]);
-                     // is this a qualified subtree?
-                     if (distance <= joinedIndexNode->GetIndexEntry(j).Radius + range){
-                        //buffer is active
-                        if (buffer){
-                           // if not read
-                           if (subPageJoin[j] == NULL){
-                              //read node
-                              subPageJoin[j] = PageManagerJoin->GetPage(
-                                 joinedIndexNode->GetIndexEntry(j).PageID);
-                              subNodeJoin[j] = stSlimNode::CreateNode(subPageJoin[j]);
-                           }//end if
-                           // Yes! Analyze it!
-                           JoinedTreeRangeJoinRecursive(PageManagerJoin,
-                                             subNodeJoin[j], tmpObj,
-                                             distance, range, result);
-                        }else{
-                           //read node
-                           subPageJoin[0] = PageManagerJoin->GetPage(
-                              joinedIndexNode->GetIndexEntry(j).PageID);
-                           subNodeJoin[0] = stSlimNode::CreateNode(subPageJoin[0]);
-                           // Yes! Analyze it!
-                           JoinedTreeRangeJoinRecursive(PageManagerJoin, subNodeJoin[0],
-                                             tmpObj, distance,
-                                             range, result);
-                           // Free it all
-                           delete subNodeJoin[0];
-						   subNodeJoin[0] = 0;
-                           PageManagerJoin->ReleasePage(subPageJoin[0]);
-                        }//end if
-                     }//end if
-                  }//end if
-               }//end for
-            }//end if
-         }//end for
-         // Free it all
-         if (buffer){
-            for (j = 0; j < joinedNumberOfEntries; j++) {
-               if (subNodeJoin[j] != NULL){
-                  delete subNodeJoin[j];
-				  subNodeJoin[j] = 0;
-                  PageManagerJoin->ReleasePage(subPageJoin[j]);
+         if (step.LowerBound > bound){
+            break;
+         }//end if
+
+         if (step.Distance >= 0){
+            distance = step.Distance;
+         }else{
+            distance = evaluator->GetDistance(obj, *GetJoinObject(items[step.Item], data));
+         }//end if
+         if (items[step.Item].PageID == 0){
+            if (distance <= bound){
+               GetJoinObject(items[step.Item], data);
+               bound = std::min(bound, AddJoinNeighbor(neighbors, distance,
+                     items[step.Item].Object, k, tie));
+            }//end if
+         }else if (distance - items[step.Item].Radius <= bound){
+            if (firstChild[step.Item] == lastChild[step.Item]){
+               // Expand it once for all objects.
+               firstChild[step.Item] = items.size();
+               ExpandJoinCandidate(items[step.Item], joinedTree, items, data);
+               lastChild[step.Item] = items.size();
+               firstChild.resize(items.size(), 0);
+               lastChild.resize(items.size(), 0);
+            }//end if
+            for (j = firstChild[step.Item]; j < lastChild[step.Item]; j++){
+               // Distances to the representative of the subtree.
+               tJoinStep child;
+
+               child.LowerBound = fabs(distance - items[j].Distance) - items[j].Radius;
+               if (child.LowerBound <= bound){
+                  child.Item = j;
+                  child.Distance = (items[j].Distance == 0.0) ? distance : -1;
+                  queue.push_back(child);
+                  std::push_heap(queue.begin(), queue.end());
                }//end if
             }//end for
          }//end if
-         delete[] subNodeJoin;
-		 subNodeJoin = 0;
-         delete[] subPageJoin;
-		 subPageJoin = 0;
+      }//end while
+
+      for (j = 0; j < neighbors.size(); j++){
+         triple.Object = obj.Clone();
+         triple.JoinedObject = neighbors[j].second->Clone();
+         triple.Distance = neighbors[j].first;
+         triples.push_back(triple);
+      }//end for
+   }//end for
+}//end stSlimTree<ObjectType, EvaluatorType>::NearestJoinLeaf
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void tmpl_stSlimTree::ExpandJoinCandidate(const tJoinCandidate & cand,
+      stSlimTree * joinedTree, tJoinCandidates & candidates,
+      std::vector < unsigned char > & data){
+   stPage * currPage;
+   stSlimNodeView currNode;
+   tJoinCandidate entry;
+   u_int32_t i;
+
+   currPage = joinedTree->GetPageManager()->GetPage(cand.PageID);
+   currNode.SetPage(currPage);
+   for (i = 0; i < currNode.GetNumberOfEntries(); i++){
+      if (currNode.GetNodeType() == stSlimNode::INDEX){
+         entry.PageID = currNode.GetIndexEntry(i).PageID;
+         entry.Radius = currNode.GetIndexEntry(i).Radius;
+         entry.NEntries = currNode.GetIndexEntry(i).NEntries;
+         entry.Distance = currNode.GetIndexEntry(i).Distance;
       }else{
-         // joined node is leaf
-         leafNodeJoin = (stSlimLeafNode *)joinedNode;
-         // Lets check all objects in this node
-         for (i = 0; i < numberOfEntries; i++){
-            // use of the triangle inequality to cut a subtree
-            if (distRepres <= leafNode->GetLeafEntry(i).Distance +
-                radiusObjJoin + range){
-               // Rebuild the object
-               tmpObj->Unserialize(leafNode->GetObject(i),
-                                   leafNode->GetObjectSize(i));
-               // For each entry in node join
-               for (j = 0; j < joinedNumberOfEntries; j++) {
-                  // use of the triangle inequality to cut a subtree
-                  if (distRepres <= leafNodeJoin->GetLeafEntry(j).Distance +
-                      radiusObjIndex + range){
-                     // Evaluate distance
-                     distance = this->myMetricEvaluator->GetDistance(tmpObj,
-                                                               bufferJoinedObj[j]);
-                     // is this a qualified subtree?
-                     if (distance <= range){
-                        // Yes! Put it in the result set.
-                        result->AddJoinedTriple(tmpObj->Clone(),
-                                                bufferJoinedObj[j]->Clone(),
-                                                distance);
-                     }//end if
-                  }//end if
-               }//end for
-            }//end if
-         }//end for
+         entry.PageID = 0;
+         entry.Radius = 0;
+         entry.NEntries = 1;
+         entry.Distance = currNode.GetLeafEntry(i).Distance;
       }//end if
-   }//end if
-   
-   // Free it all
-   for (j = 0; j < joinedNumberOfEntries; j++) {
-      delete bufferJoinedObj[j];
-	  bufferJoinedObj[j] = 0;
+      entry.Offset = data.size();
+      entry.Size = currNode.GetObjectSize(i);
+      data.insert(data.end(), currNode.GetObject(i),
+            currNode.GetObject(i) + entry.Size);
+      candidates.push_back(entry);
    }//end for
-   delete[] bufferJoinedObj;
-   bufferJoinedObj = 0;
-   delete tmpObj;
-   tmpObj = 0;
-}//end RangeJoinQueryRecursive
+   joinedTree->GetPageManager()->ReleasePage(currPage);
+}//end stSlimTree<ObjectType, EvaluatorType>::ExpandJoinCandidate
 
 //------------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
-void tmpl_stSlimTree::JoinedTreeRangeJoinRecursive(
-      stPageManager * PageManagerJoin, stSlimNode * joinedNode,
-      ObjectType * objIndex, double distRepres, double range,
-      tJoinedResult * result){
+double tmpl_stSlimTree::GetJoinBound(tJoinCandidates & candidates,
+      double radius, u_int32_t k, double bound){
+   std::vector < std::pair < double, u_int32_t > > upper;
+   u_int32_t count;
+   u_int32_t i;
 
-   double distance;
-   ObjectType * tmpObj = new ObjectType();
+   upper.reserve(candidates.size());
+   for (i = 0; i < candidates.size(); i++){
+      upper.push_back(std::make_pair(
+            candidates[i].Distance + candidates[i].Radius + radius,
+            candidates[i].NEntries));
+   }//end for
+   std::sort(upper.begin(), upper.end());
+
+   // The k-th object reached by the upper bounds.
+   count = 0;
+   for (i = 0; (i < upper.size()) && (upper[i].first < bound); i++){
+      count += upper[i].second;
+      if (count >= k){
+         return upper[i].first;
+      }//end if
+   }//end for
+   return bound;
+}//end stSlimTree<ObjectType, EvaluatorType>::GetJoinBound
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+double tmpl_stSlimTree::AddJoinNeighbor(tJoinNeighbors & neighbors,
+      double distance, const std::shared_ptr < ObjectType > & obj,
+      u_int32_t k, bool tie){
+   u_int32_t last;
+
+   if (neighbors.size() >= k){
+      if ((distance > neighbors[k - 1].first) ||
+            ((!tie) && (distance == neighbors[k - 1].first))){
+         return neighbors[k - 1].first;
+      }//end if
+   }//end if
+   neighbors.insert(std::upper_bound(neighbors.begin(), neighbors.end(),
+         std::make_pair(distance, obj),
+         [](const std::pair < double, std::shared_ptr < ObjectType > > & a,
+            const std::pair < double, std::shared_ptr < ObjectType > > & b){
+            return a.first < b.first;
+         }), std::make_pair(distance, obj));
+
+   if (neighbors.size() > k){
+      if (tie){
+         // Keep the ones tied with the k-th.
+         last = neighbors.size();
+         while ((last > k) && (neighbors[last - 1].first > neighbors[k - 1].first)){
+            last--;
+         }//end while
+         neighbors.resize(last);
+      }else{
+         neighbors.resize(k);
+      }//end if
+   }//end if
+
+   if (neighbors.size() >= k){
+      return neighbors[k - 1].first;
+   }else{
+      return MAXDOUBLE;
+   }//end if
+}//end stSlimTree<ObjectType, EvaluatorType>::AddJoinNeighbor
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+stJoinedResult<ObjectType> * tmpl_stSlimTree::RangeJoinQuery(
+      stSlimTree * slimTree, double range, bool buffer){
+   // Create result
+   tJoinedResult * result = new tJoinedResult();
+   result->SetQueryInfo(RANGEJOINQUERY, -1, range, false);
+
+   RangeJoinQuery(slimTree, range,
+         [result](ObjectType & obj, ObjectType & joinedObj, double distance){
+            result->AddJoinedTriple(obj.Clone(), joinedObj.Clone(), distance);
+            return true;
+         });
+   return result;
+}//end RangeJoinQuery
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+bool tmpl_stSlimTree::RunRangeJoin(stSlimTree * slimTree, double range,
+      tJoinCallback callback, bool self, u_int32_t nThreads,
+      u_int32_t cachePages){
+   tRangeJoinContext context;
+   tRangeJoinPair root;
+   std::vector < EvaluatorType > evaluators;
+   u_int32_t t;
+
+   if ((this->GetRoot() == 0) || (slimTree->GetRoot() == 0)){
+      return true;
+   }//end if
+   stSharedLatchGuard readLatch(GetReadLatch());
+   stSharedLatchGuard joinedLatch((slimTree != this) ? slimTree->GetReadLatch() : NULL);
+   stTaskPool pool(nThreads);
+   stSharedPageCache cache(cachePages);
+
+   context.JoinedTree = slimTree;
+   context.Range = range;
+   context.Self = self;
+   context.Callback = callback;
+   context.Stop = false;
+   context.Cache = &cache;
+   context.Pool = &pool;
+   if (pool.GetNumberOfThreads() == 1){
+      context.Evaluators.push_back(this->myMetricEvaluator);
+   }else{
+      // One evaluator for each thread to avoid races on its statistics.
+      evaluators.reserve(pool.GetNumberOfThreads());
+      for (t = 0; t < pool.GetNumberOfThreads(); t++){
+         evaluators.push_back(*this->myMetricEvaluator);
+         evaluators[t].ResetStatistics();
+         context.Evaluators.push_back(&evaluators[t]);
+      }//end for
+   }//end if
+
+   // The roots have no representatives.
+   root.PageID = this->GetRoot();
+   root.Radius = MAXDOUBLE;
+   root.JoinedPageID = slimTree->GetRoot();
+   root.JoinedRadius = MAXDOUBLE;
+   root.Distance = -1;
+   SubmitRangeJoinPair(&context, root, 0);
+   pool.Run();
+
+   for (t = 0; t < evaluators.size(); t++){
+      this->myMetricEvaluator->UpdateDistanceCount(evaluators[t].GetDistanceCount());
+   }//end for
+   return !context.Stop;
+}//end RunRangeJoin
+
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+void tmpl_stSlimTree::RangeJoinPair(tRangeJoinContext * context,
+      const tRangeJoinPair & pair, u_int32_t thread){
+   EvaluatorType * evaluator = context->Evaluators[thread];
+   double range = context->Range;
+   stSharedPageCache::tPage page;
+   stSharedPageCache::tPage joinedPage;
+   stSlimNodeView node;
+   stSlimNodeView joinedNode;
+   std::vector < std::shared_ptr < ObjectType > > objects;
+   std::vector < std::shared_ptr < ObjectType > > joinedObjects;
+   tRangeJoinPair child;
+   u_int32_t numberOfEntries;
    u_int32_t joinedNumberOfEntries;
-   stSlimIndexNode * joinedIndexNode;
-   stSlimLeafNode * leafNodeJoin;
-   u_int32_t i, j;
+   double distance;
+   bool self;
+   bool index;
+   bool joinedIndex;
+   u_int32_t i;
+   u_int32_t j;
 
-   // Get the number of entries.
-   joinedNumberOfEntries = joinedNode->GetNumberOfEntries();
-   
-   // Is it an Index node?
-   if (joinedNode->GetNodeType() == stSlimNode::INDEX) {
-      // Get Index node
-      joinedIndexNode = (stSlimIndexNode *)joinedNode;
-      // For each entry...
-      for (j = 0; j < joinedNumberOfEntries; j++) {
-         // use of the triangle inequality to cut a subtree
-         if (fabs(distRepres - joinedIndexNode->GetIndexEntry(j).Distance) <=
-             range + joinedIndexNode->GetIndexEntry(j).Radius){
-            // Rebuild the object
-            tmpObj->Unserialize(joinedIndexNode->GetObject(j),
-                               joinedIndexNode->GetObjectSize(j));
-            // Evaluate distance
-            distance = this->myMetricEvaluator->GetDistance(tmpObj, objIndex);
-            // is this a qualified subtree?
-            if (distance <= range + joinedIndexNode->GetIndexEntry(j).Radius){
-               //read sub node
-               stPage * subPageJoin = PageManagerJoin->GetPage(
-                  joinedIndexNode->GetIndexEntry(j).PageID);
-               stSlimNode * subNodeJoin = stSlimNode::CreateNode(subPageJoin);
-               // Yes! Analyze it!
-               JoinedTreeRangeJoinRecursive(PageManagerJoin, subNodeJoin,
-                  objIndex, distance, range, result);
-               // Free it all
-               delete subNodeJoin;
-               subNodeJoin = 0;
-               PageManagerJoin->ReleasePage(subPageJoin);
+   if (context->Stop){
+      return;
+   }//end if
+   // A node paired with itself in the SelfRangeJoin().
+   self = (context->Self) && (pair.PageID == pair.JoinedPageID);
+   page = context->Cache->Get(tMetricTree::myPageManager, pair.PageID);
+   node.SetPage(page.get());
+   if (self){
+      joinedPage = page;
+   }else{
+      joinedPage = context->Cache->Get(context->JoinedTree->GetPageManager(),
+            pair.JoinedPageID);
+   }//end if
+   joinedNode.SetPage(joinedPage.get());
+   numberOfEntries = node.GetNumberOfEntries();
+   joinedNumberOfEntries = joinedNode.GetNumberOfEntries();
+   index = node.GetNodeType() == stSlimNode::INDEX;
+   joinedIndex = joinedNode.GetNodeType() == stSlimNode::INDEX;
+
+   // Decode both nodes.
+   objects.resize(numberOfEntries);
+   for (i = 0; i < numberOfEntries; i++){
+      objects[i].reset(new ObjectType());
+      if (index){
+         objects[i]->Unserialize(node.GetObject(i), node.GetObjectSize(i));
+      }else{
+         objects[i]->IncludedUnserialize(node.GetObject(i), node.GetObjectSize(i));
+      }//end if
+   }//end for
+   if (self){
+      joinedObjects = objects;
+   }else{
+      joinedObjects.resize(joinedNumberOfEntries);
+   }//end if
+   for (j = 0; (!self) && (j < joinedNumberOfEntries); j++){
+      joinedObjects[j].reset(new ObjectType());
+      if (joinedIndex){
+         joinedObjects[j]->Unserialize(joinedNode.GetObject(j),
+               joinedNode.GetObjectSize(j));
+      }else{
+         joinedObjects[j]->IncludedUnserialize(joinedNode.GetObject(j),
+               joinedNode.GetObjectSize(j));
+      }//end if
+   }//end for
+
+   if ((index) && (joinedIndex)){
+      // Both go down. The pairs are submitted grouped by the child of the
+      // joined tree in reverse order, so they run in order from the back of
+      // the queue. A node paired with itself takes only i <= j.
+      for (j = joinedNumberOfEntries; j > 0; j--){
+         for (i = self ? j : numberOfEntries; i > 0; i--){
+            const stSlimIndexNode::stSlimIndexEntry & entry = node.GetIndexEntry(i - 1);
+            const stSlimIndexNode::stSlimIndexEntry & joinedEntry =
+                  joinedNode.GetIndexEntry(j - 1);
+
+            // Cut it with the distances to both representatives first.
+            if ((pair.Distance >= 0) && (pair.Distance > entry.Distance +
+                  joinedEntry.Distance + entry.Radius + joinedEntry.Radius + range)){
+               continue;
+            }//end if
+            if ((self) && (i == j)){
+               distance = 0;
+            }else{
+               distance = evaluator->GetDistance(*objects[i - 1], *joinedObjects[j - 1]);
+            }//end if
+            if (distance <= entry.Radius + joinedEntry.Radius + range){
+               child.PageID = entry.PageID;
+               child.Representative = objects[i - 1];
+               child.Radius = entry.Radius;
+               child.JoinedPageID = joinedEntry.PageID;
+               child.JoinedRepresentative = joinedObjects[j - 1];
+               child.JoinedRadius = joinedEntry.Radius;
+               child.Distance = distance;
+               SubmitRangeJoinPair(context, child, thread);
+            }//end if
+         }//end for
+      }//end for
+   }else if (index){
+      // Only this tree goes down (the joined one is shorter).
+      for (i = numberOfEntries; i > 0; i--){
+         const stSlimIndexNode::stSlimIndexEntry & entry = node.GetIndexEntry(i - 1);
+
+         child.PageID = entry.PageID;
+         child.Representative = objects[i - 1];
+         child.Radius = entry.Radius;
+         child.JoinedPageID = pair.JoinedPageID;
+         child.JoinedRepresentative = pair.JoinedRepresentative;
+         child.JoinedRadius = pair.JoinedRadius;
+         child.Distance = -1;
+         if (pair.JoinedRepresentative != NULL){
+            if ((pair.Distance >= 0) && (pair.Distance > entry.Distance +
+                  entry.Radius + pair.JoinedRadius + range)){
+               continue;
+            }//end if
+            child.Distance = evaluator->GetDistance(*objects[i - 1],
+                  *pair.JoinedRepresentative);
+            if (child.Distance > entry.Radius + pair.JoinedRadius + range){
+               continue;
+            }//end if
+         }//end if
+         SubmitRangeJoinPair(context, child, thread);
+      }//end for
+   }else if (joinedIndex){
+      // Only the joined tree goes down.
+      for (j = joinedNumberOfEntries; j > 0; j--){
+         const stSlimIndexNode::stSlimIndexEntry & joinedEntry =
+               joinedNode.GetIndexEntry(j - 1);
+
+         child.PageID = pair.PageID;
+         child.Representative = pair.Representative;
+         child.Radius = pair.Radius;
+         child.JoinedPageID = joinedEntry.PageID;
+         child.JoinedRepresentative = joinedObjects[j - 1];
+         child.JoinedRadius = joinedEntry.Radius;
+         child.Distance = -1;
+         if (pair.Representative != NULL){
+            if ((pair.Distance >= 0) && (pair.Distance > joinedEntry.Distance +
+                  joinedEntry.Radius + pair.Radius + range)){
+               continue;
+            }//end if
+            child.Distance = evaluator->GetDistance(*pair.Representative,
+                  *joinedObjects[j - 1]);
+            if (child.Distance > joinedEntry.Radius + pair.Radius + range){
+               continue;
             }//end if
          }//end if
+         SubmitRangeJoinPair(context, child, thread);
       }//end for
    }else{
-      // No, it is a leaf node. Get it.
-      leafNodeJoin = (stSlimLeafNode *)joinedNode;
-      // for each entry...
-      for (j = 0; j < joinedNumberOfEntries; j++) {
-         // use of the triangle inequality.
-         if ( fabs(distRepres - leafNodeJoin->GetLeafEntry(j).Distance) <= range){
-            // Rebuild the object
-            tmpObj->Unserialize(leafNodeJoin->GetObject(j),
-                               leafNodeJoin->GetObjectSize(j));
-            // No, it is not a representative. Evaluate distance
-            distance = this->myMetricEvaluator->GetDistance(tmpObj, objIndex);
-            // Is this a qualified object?
+      // Two leaves. A leaf paired with itself takes only i < j, so each
+      // distance is computed once and no entry meets itself.
+      for (i = 0; i < numberOfEntries; i++){
+         for (j = self ? i + 1 : 0; j < joinedNumberOfEntries; j++){
+            // Cut it with the distances to both representatives first.
+            if ((pair.Distance >= 0) && (pair.Distance >
+                  node.GetLeafEntry(i).Distance +
+                  joinedNode.GetLeafEntry(j).Distance + range)){
+               continue;
+            }//end if
+            distance = evaluator->GetDistance(*objects[i], *joinedObjects[j]);
             if (distance <= range){
-               // Yes! Put it in the result set.
-               result->AddJoinedTriple(objIndex->Clone(),
-                                       tmpObj->Clone(),
-                                       distance);
+               std::lock_guard < std::mutex > lock(context->CallbackMutex);
+               if (context->Stop){
+                  return;
+               }//end if
+               if (!context->Callback(*objects[i], *joinedObjects[j], distance)){
+                  context->Stop = true;
+                  return;
+               }//end if
             }//end if
-         }//end if
+         }//end for
       }//end for
-   }//end else
-   //free it all
-   delete tmpObj;
-   tmpObj = 0;
-}//end JoinedTreeRangeJoinRecursive
+   }//end if
+}//end stSlimTree<ObjectType, EvaluatorType>::RangeJoinPair
 
 //------------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
@@ -8117,10 +10238,10 @@ void tmpl_stSlimTree::DummyRangeJoinQueryRecursive(
       stMetricTree<ObjectType, EvaluatorType> * joinedTree,
       u_int32_t pageID, double range){
 
-   stSlimIndexNode * indexNode;
-   stSlimLeafNode * leafNode;
+   stSlimNodeView * indexNode;
+   stSlimNodeView * leafNode;
    stPage * curPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    tResult * localResult;
    ObjectType tmp;
    u_int32_t i, j;
@@ -8129,11 +10250,11 @@ void tmpl_stSlimTree::DummyRangeJoinQueryRecursive(
    if (pageID != 0){
       // Read node...
       curPage = tMetricTree::myPageManager->GetPage(pageID);
-      currNode = stSlimNode::CreateNode(curPage);  
+      currNode.SetPage(curPage);
       // if node is index
-      if (currNode->GetNodeType() == stSlimNode::INDEX){
+      if (currNode.GetNodeType() == stSlimNode::INDEX){
          // It is a index node.
-         indexNode = (stSlimIndexNode *) currNode;
+         indexNode = &currNode;
          // For each entry, call it recursively.
          for (i = 0; i < indexNode->GetNumberOfEntries(); i++){
             //call recursive
@@ -8143,14 +10264,12 @@ void tmpl_stSlimTree::DummyRangeJoinQueryRecursive(
          }//end for
       }else{
          // It is a leaf node.
-         leafNode = (stSlimLeafNode *) currNode;
+         leafNode = &currNode;
          // Check all entries in this leaf node.
          for (i = 0; i < leafNode->GetNumberOfEntries(); i++){
             // Rebuild the object
-            tmp.Unserialize(leafNode->GetObject(i),
-                            leafNode->GetObjectSize(i));
-            // Allocate the resorces.
-            localResult = new tResult();
+            tmp.IncludedUnserialize(leafNode->GetObject(i),
+                                    leafNode->GetObjectSize(i));
             // Call the range query for tmp object.
             localResult = joinedTree->RangeQuery(&tmp, range);
             // For all elements in the result, copy then in result.
@@ -8167,8 +10286,6 @@ void tmpl_stSlimTree::DummyRangeJoinQueryRecursive(
       
       // Clean the mess.
       tMetricTree::myPageManager->ReleasePage(curPage);
-      delete currNode;
-      currNode = 0;
    }//end if
    
 }//end DummyRangeJoinQueryRecursive
@@ -8218,18 +10335,18 @@ template <class ObjectType, class EvaluatorType>
 void tmpl_stSlimTree::GetSampleRecursive(
       u_int32_t pageID, tmpl_stSlimTree::tObjectSample * sample){
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    u_int32_t i;
 
    // Let's search
    if (pageID != 0){
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
 
          // for each entry call GetSampleRecursive
          for (i = 0; i < indexNode->GetNumberOfEntries(); i++) {
@@ -8237,7 +10354,7 @@ void tmpl_stSlimTree::GetSampleRecursive(
          }//end for
       }else{
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
          ObjectType tmp;
 
          for (i = 0; i < leafNode->GetNumberOfEntries(); i++) {
@@ -8251,8 +10368,6 @@ void tmpl_stSlimTree::GetSampleRecursive(
       }//end else
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
    }//end if
 }//end stSlimTree<ObjectType, EvaluatorType>::GetSampleRecursive
@@ -8355,7 +10470,7 @@ template <class ObjectType, class EvaluatorType>
 void tmpl_stSlimTree::GetTreeInfoRecursive(u_int32_t pageID, int level,
       stTreeInformation * info){
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    u_int32_t i;
    ObjectType tmp;
 
@@ -8366,11 +10481,11 @@ void tmpl_stSlimTree::GetTreeInfoRecursive(u_int32_t pageID, int level,
 
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
 
          // Object count
          info->UpdateObjectCount(level, indexNode->GetNumberOfEntries());
@@ -8382,7 +10497,7 @@ void tmpl_stSlimTree::GetTreeInfoRecursive(u_int32_t pageID, int level,
          }//end for
       }else{
          // No, it is a leaf node. Get it.
-         stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+         stSlimNodeView * leafNode = &currNode;
 
          // Object count
          info->UpdateObjectCount(level, leafNode->GetNumberOfEntries());
@@ -8393,8 +10508,8 @@ void tmpl_stSlimTree::GetTreeInfoRecursive(u_int32_t pageID, int level,
             info->UpdateMeanObjectSize(leafNode->GetObjectSize(i));
 
             // Compute intersections
-            tmp.Unserialize(leafNode->GetObject(i),
-                            leafNode->GetObjectSize(i));
+            tmp.IncludedUnserialize(leafNode->GetObject(i),
+                                    leafNode->GetObjectSize(i));
 
             // Compute intersections
             ObjectIntersectionsRecursive(this->GetRoot(), &tmp, 0, info);
@@ -8402,8 +10517,6 @@ void tmpl_stSlimTree::GetTreeInfoRecursive(u_int32_t pageID, int level,
       }//end if
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
    }//end if
 }//end stSlimTree<ObjectType, EvaluatorType>::GetTreeInfoRecursive
@@ -8413,7 +10526,7 @@ template <class ObjectType, class EvaluatorType>
 void tmpl_stSlimTree::ObjectIntersectionsRecursive(u_int32_t pageID,
       ObjectType * obj, int level, stTreeInformation * info){
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    u_int32_t i;
    ObjectType tmp;
    double d;
@@ -8422,11 +10535,11 @@ void tmpl_stSlimTree::ObjectIntersectionsRecursive(u_int32_t pageID,
    if (pageID != 0){
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
          // Get Index node
-         stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+         stSlimNodeView * indexNode = &currNode;
 
          // Scan all entries
          for (i = 0; i < indexNode->GetNumberOfEntries(); i++){
@@ -8443,12 +10556,22 @@ void tmpl_stSlimTree::ObjectIntersectionsRecursive(u_int32_t pageID,
       }//end if
 
       // Free it all
-      delete currNode;
-	  currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
    }//end if
 }//end stSlimTree<ObjectType, EvaluatorType>::ObjectIntersectionsRecursive
 
+//------------------------------------------------------------------------------
+template <class ObjectType, class EvaluatorType>
+double tmpl_stSlimTree::GetFatFactor(){
+   stTreeInfoResult * info;
+   double fatFactor;
+
+   info = GetTreeInfo();
+   fatFactor = info->GetGlobalFatFactor();
+   delete info;
+   return fatFactor;
+}//end stSlimTree<ObjectType, EvaluatorType>::GetFatFactor
+
 //-----------------------------------------------------------------------------
 template <class ObjectType, class EvaluatorType>
 void tmpl_stSlimTree::Optimize(){
@@ -8457,6 +10580,8 @@ void tmpl_stSlimTree::Optimize(){
       SlimDownRecursive(this->GetRoot(), 0);
       // Notify modifications.
       HeaderUpdate = true;
+      // The radii and the entries of the index nodes changed.
+      NotifyModification();
       // Don't worry. This is a debug block!!!
    #ifdef __stPRINTMSG__
    }else{
@@ -8616,6 +10741,12 @@ double tmpl_stSlimTree::SlimDown(u_int32_t pageID){
             // Update entry
             indexNode->GetIndexEntry(idx).NEntries = leafNode->GetNumberOfEntries();
             indexNode->GetIndexEntry(idx).Radius = leafNode->GetMinimumRadius();
+            #ifdef __stSLIMRKNN__
+               // The objects moved with their k-NN distances, so only the
+               // maximum of each leaf changes.
+               indexNode->GetIndexEntry(idx).MaxKNNDistance =
+                     GetMaxKNNDistance(leafNode);
+            #endif //__stSLIMRKNN__
             idx++;
 
             // Write back
@@ -8703,7 +10834,7 @@ void tmpl_stSlimTree::LocalSlimDown(
                localSwapCount++;
    
                // Swap!
-               memLeafNodes[dst]->Add(memLeafNodes[src]->PopObject(), minDist);
+               memLeafNodes[src]->MoveLastTo(memLeafNodes[dst], minDist);
             }//end if
          //}else{
             // This node is empty.
@@ -8767,7 +10898,7 @@ bool tmpl_stSlimTree::BulkLoadOrdered(ObjectType **objects, u_int32_t numObj, do
 template <class ObjectType, class EvaluatorType>
 int tmpl_stSlimTree::BulkLoadSimple(ObjectType **objects, u_int32_t numObj, double leafNodeOccupancy, stPage *& auxPage, int currObj) {
 
-   auxPage  = this->NewPage();
+   auxPage  = this->NewPage(true);
    stSlimLeafNode * leafNode = new stSlimLeafNode(auxPage, true);
 
    ObjectType *newObj; // Object
@@ -8855,7 +10986,7 @@ int tmpl_stSlimTree::BulkLoadSampled(ObjectType **objects, u_int32_t numObj, dou
       newObj = objects[currObj];
       newObjSize = newObj->GetSerializedSize();
       // Insert the new object.
-      samplePage[i] = this->NewPage();
+      samplePage[i] = this->NewPage(true);
       sampleNode[i] = new SlimLeafNode(samplePage[i],true); // @todo: Change this to work
       insertIdx = sampleNode[i]->AddEntry(newObjSize,
                                           newObj->Serialize());
@@ -9683,7 +11814,7 @@ bool tmpl_stSlimTree::BulkLoadMemory(vector< SampleSon<ObjectType> > objects, in
       #endif //__stPRINTMSG__
 
       // new leaf node
-      stPage * newPage  = this->NewPage();
+      stPage * newPage  = this->NewPage(true);
       stSlimLeafNode * leafNode = new stSlimLeafNode(newPage, true);
 
       u_int32_t repIdx = father;
@@ -10052,9 +12183,9 @@ bool tmpl_stSlimTree::Consistency(){
 
    u_int32_t idx;
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    u_int32_t numberOfEntries;
-   ObjectType subRep;
+   ObjectType subRep, tmpObj;
    double radius;
    u_int32_t maxHeight, minHeight;
    u_int32_t * heights;
@@ -10078,14 +12209,14 @@ bool tmpl_stSlimTree::Consistency(){
          result = false;
       }else{
          // Get the node.
-         currNode =  stSlimNode::CreateNode(currPage);
+         currNode.SetPage(currPage);
          result = true;
          objectCount = 0;
 
          // Is it an Index node?
-         if (currNode->GetNodeType() == stSlimNode::INDEX){
+         if (currNode.GetNodeType() == stSlimNode::INDEX){
             // Get Index node
-            stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+            stSlimNodeView * indexNode = &currNode;
             numberOfEntries = indexNode->GetNumberOfEntries();
             heights = new u_int32_t[numberOfEntries];
             // Set the height variables.
@@ -10099,11 +12230,13 @@ bool tmpl_stSlimTree::Consistency(){
                subRep.Unserialize(indexNode->GetObject(idx),
                                   indexNode->GetObjectSize(idx));
                // Call it recursively.
-               result = result && this->Consistency(indexNode->GetIndexEntry(idx).PageID,
-                                                    &subRep, radius, heights[idx], 
-                                                    subtreeObjects);
-               // Test the subtree radius.
-               if (radius != indexNode->GetIndexEntry(idx).Radius){
+               if (!this->Consistency(indexNode->GetIndexEntry(idx).PageID,
+                                      &subRep, radius, heights[idx],
+                                      subtreeObjects, tmpObj)){
+                  result = false;
+               }//end if
+               // Test the subtree radius. It must cover the subtree.
+               if (radius > indexNode->GetIndexEntry(idx).Radius){
                   #ifdef __stPRINTMSG__
                      cout << "\nThere is a radius problem with entry " << idx
                           << " in pageID: " << indexNode->GetIndexEntry(idx).PageID
@@ -10149,12 +12282,24 @@ bool tmpl_stSlimTree::Consistency(){
                // Problem!
                result = false;
             }//end if
+            // Test the header.
+            if ((objectCount != Header->ObjectCount) ||
+                  (heights[maxHeight] + 1 != Header->Height)){
+               #ifdef __stPRINTMSG__
+                  cout << "\nThe header is set with: " << Header->ObjectCount
+                       << " objects and height " << Header->Height
+                       << " but the tree has " << objectCount
+                       << " objects and height " << heights[maxHeight] + 1 << ".";
+               #endif //__stPRINTMSG__
+               // Problem!
+               result = false;
+            }//end if
             // release memory.
             delete[] heights;
 			heights = 0;
          }else{
             // No, it is a leaf node. There is only the header to test it.
-            stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+            stSlimNodeView * leafNode = &currNode;
             if (leafNode->GetNumberOfEntries() != Header->ObjectCount){
                // Ops, problem with the header.
                result = false;
@@ -10167,8 +12312,6 @@ bool tmpl_stSlimTree::Consistency(){
          }//end else
 
          // Free it all
-         delete currNode;
-		 currNode = 0;
          tMetricTree::myPageManager->ReleasePage(currPage);
       }//end if
    }//end if
@@ -10180,19 +12323,20 @@ bool tmpl_stSlimTree::Consistency(){
 template <class ObjectType, class EvaluatorType>
 bool tmpl_stSlimTree::Consistency(u_int32_t pageID, ObjectType * repObj, 
                                   double & radius, u_int32_t & height, 
-                                  u_int32_t & objectCount){
+                                  u_int32_t & objectCount, ObjectType & tmpObj){
 
    u_int32_t idx;
    stPage * currPage;
-   stSlimNode * currNode;
+   stSlimNodeView currNode;
    u_int32_t numberOfEntries;
    double distance;
-   ObjectType subRep, localRep, tmpObj;
+   ObjectType subRep, localRep;
    u_int32_t maxHeight, minHeight;
    u_int32_t * heights;
    u_int32_t subtreeObjects;
    int idxRep;
    radius = MAXDOUBLE;
+   height = 0;
    bool result = true;
 
    // Let's search
@@ -10211,11 +12355,11 @@ bool tmpl_stSlimTree::Consistency(u_int32_t pageID, ObjectType * repObj,
          result = false;
       }else{
          // Get the node.
-         currNode = stSlimNode::CreateNode(currPage);
+         currNode.SetPage(currPage);
          // Is it an Index node?
-         if (currNode->GetNodeType() == stSlimNode::INDEX) {
+         if (currNode.GetNodeType() == stSlimNode::INDEX) {
             // Get Index node
-            stSlimIndexNode * indexNode = (stSlimIndexNode *)currNode;
+            stSlimNodeView * indexNode = &currNode;
             numberOfEntries = indexNode->GetNumberOfEntries();
             heights = new u_int32_t[numberOfEntries];
             // Set the height variables.
@@ -10235,8 +12379,6 @@ bool tmpl_stSlimTree::Consistency(u_int32_t pageID, ObjectType * repObj,
                // Get the representative.
                localRep.Unserialize(indexNode->GetObject(idxRep),
                                     indexNode->GetObjectSize(idxRep));
-               // Check the field entries.
-               result = true;
                // Test all entries in this node.
                for (idx = 0; idx < numberOfEntries; idx++) {
                   // Set the subtree number of objects.
@@ -10245,11 +12387,14 @@ bool tmpl_stSlimTree::Consistency(u_int32_t pageID, ObjectType * repObj,
                   subRep.Unserialize(indexNode->GetObject(idx),
                                      indexNode->GetObjectSize(idx));
             
-                  result = result && this->Consistency(indexNode->GetIndexEntry(idx).PageID,
-                                                       &subRep, radius, heights[idx],
-                                                       subtreeObjects);
-                  // Test the subtree radius with the local field.
-                  if (radius != indexNode->GetIndexEntry(idx).Radius){
+                  if (!this->Consistency(indexNode->GetIndexEntry(idx).PageID,
+                                         &subRep, radius, heights[idx],
+                                         subtreeObjects, tmpObj)){
+                     result = false;
+                  }//end if
+                  // Test the subtree radius with the local field. It must
+                  // cover the subtree.
+                  if (radius > indexNode->GetIndexEntry(idx).Radius){
                      #ifdef __stPRINTMSG__
                         cout << "\nThere is a radius problem with entry " << idx
                              << " in Index pageID: " << indexNode->GetIndexEntry(idx).PageID
@@ -10338,7 +12483,7 @@ bool tmpl_stSlimTree::Consistency(u_int32_t pageID, ObjectType * repObj,
 			heights = 0;
          }else{
             // It is a leaf node. Get it.
-            stSlimLeafNode * leafNode = (stSlimLeafNode *)currNode;
+            stSlimNodeView * leafNode = &currNode;
             numberOfEntries = leafNode->GetNumberOfEntries();
             objectCount += numberOfEntries;
    
@@ -10354,19 +12499,13 @@ bool tmpl_stSlimTree::Consistency(u_int32_t pageID, ObjectType * repObj,
                result = false;
             }else{
                // Get the representative.
-               localRep.Unserialize(leafNode->GetObject(idxRep),
+               localRep.IncludedUnserialize(leafNode->GetObject(idxRep),
                                     leafNode->GetObjectSize(idxRep));
-               // Check the field entries.
-               result = true;
                // Test all entries in this node.
                for (idx = 0; idx < numberOfEntries; idx++) {
-                  // Get the subtree representative.
-                  subRep.Unserialize(leafNode->GetObject(idx),
-                                     leafNode->GetObjectSize(idx));
-            
                   // Calculate the distance.
                   if (idx != (u_int32_t )idxRep){
-                     tmpObj.Unserialize(leafNode->GetObject(idx),
+                     tmpObj.IncludedUnserialize(leafNode->GetObject(idx),
                                         leafNode->GetObjectSize(idx));
                      // Evaluate it!
                      distance = this->myMetricEvaluator->GetDistance(*repObj, tmpObj);
@@ -10404,8 +12543,6 @@ bool tmpl_stSlimTree::Consistency(u_int32_t pageID, ObjectType * repObj,
          }//end else
    
          // Free it all
-         delete currNode;
-		 currNode = 0;
          tMetricTree::myPageManager->ReleasePage(currPage);
       }//end if
    }//end if
@@ -10436,7 +12573,7 @@ stResult<ObjectType> * tmpl_stSlimTree::preConstrainedNearestQuery(
     tDynamicPriorityQueue * queue;
     u_int32_t idx;
     stPage * currPage;
-    stSlimNode * currNode;
+    stSlimNodeView currNode;
     ObjectType tmpObj;
     double distance;
     double distanceRepres = 0;
@@ -10457,11 +12594,11 @@ stResult<ObjectType> * tmpl_stSlimTree::preConstrainedNearestQuery(
     while (pqCurrValue.PageID != 0) {
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
         // Get Index node
-        stSlimIndexNode * indexNode = (stSlimIndexNode *) currNode;
+        stSlimNodeView * indexNode = &currNode;
         numberOfEntries = indexNode->GetNumberOfEntries();
 
         // for each entry...
@@ -10487,7 +12624,7 @@ stResult<ObjectType> * tmpl_stSlimTree::preConstrainedNearestQuery(
       }
       else {
         // No, it is a leaf node. Get it.
-        stSlimLeafNode * leafNode = (stSlimLeafNode *) currNode;
+        stSlimNodeView * leafNode = &currNode;
         numberOfEntries = leafNode->GetNumberOfEntries();
 
         // for each entry...
@@ -10543,8 +12680,6 @@ stResult<ObjectType> * tmpl_stSlimTree::preConstrainedNearestQuery(
       }//end else
 
       // Free it all
-      delete currNode;
-      currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
 
       if (queue->GetSize() > this->maxQueue)
@@ -10606,7 +12741,7 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountGreater
     tDynamicPriorityQueue * queue;
     u_int32_t idx;
     stPage * currPage;
-    stSlimNode * currNode;
+    stSlimNodeView currNode;
     ObjectType tmpObj;
     double distance;
     double distanceRepres = 0;
@@ -10627,11 +12762,11 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountGreater
     while (pqCurrValue.PageID != 0) {
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
         // Get Index node
-        stSlimIndexNode * indexNode = (stSlimIndexNode *) currNode;
+        stSlimNodeView * indexNode = &currNode;
         numberOfEntries = indexNode->GetNumberOfEntries();
 
         // for each entry...
@@ -10657,7 +12792,7 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountGreater
       }
       else {
         // No, it is a leaf node. Get it.
-        stSlimLeafNode * leafNode = (stSlimLeafNode *) currNode;
+        stSlimNodeView * leafNode = &currNode;
         numberOfEntries = leafNode->GetNumberOfEntries();
 
         // for each entry...
@@ -10746,8 +12881,6 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountGreater
       }//end else
 
       // Free it all
-      delete currNode;
-      currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
 
       if (queue->GetSize() > this->maxQueue)
@@ -10808,7 +12941,7 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountLessTha
     tDynamicPriorityQueue * queue;
     u_int32_t idx;
     stPage * currPage;
-    stSlimNode * currNode;
+    stSlimNodeView currNode;
     ObjectType tmpObj;
     double distance;
     double distanceRepres = 0;
@@ -10829,11 +12962,11 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountLessTha
     while (pqCurrValue.PageID != 0) {
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
         // Get Index node
-        stSlimIndexNode * indexNode = (stSlimIndexNode *) currNode;
+        stSlimNodeView * indexNode = &currNode;
         numberOfEntries = indexNode->GetNumberOfEntries();
 
         // for each entry...
@@ -10859,7 +12992,7 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountLessTha
       }
       else {
         // No, it is a leaf node. Get it.
-        stSlimLeafNode * leafNode = (stSlimLeafNode *) currNode;
+        stSlimNodeView * leafNode = &currNode;
         numberOfEntries = leafNode->GetNumberOfEntries();
 
         // for each entry...
@@ -10948,8 +13081,6 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountLessTha
       }//end else
 
       // Free it all
-      delete currNode;
-      currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
 
       if (queue->GetSize() > this->maxQueue)
@@ -11009,7 +13140,7 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountDistinc
     tDynamicPriorityQueue * queue;
     u_int32_t idx;
     stPage * currPage;
-    stSlimNode * currNode;
+    stSlimNodeView currNode;
     ObjectType tmpObj;
     double distance;
     double distanceRepres = 0;
@@ -11030,11 +13161,11 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountDistinc
     while (pqCurrValue.PageID != 0) {
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
         // Get Index node
-        stSlimIndexNode * indexNode = (stSlimIndexNode *) currNode;
+        stSlimNodeView * indexNode = &currNode;
         numberOfEntries = indexNode->GetNumberOfEntries();
 
         // for each entry...
@@ -11060,7 +13191,7 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountDistinc
       }
       else {
         // No, it is a leaf node. Get it.
-        stSlimLeafNode * leafNode = (stSlimLeafNode *) currNode;
+        stSlimNodeView * leafNode = &currNode;
         numberOfEntries = leafNode->GetNumberOfEntries();
 
         // for each entry...
@@ -11241,8 +13372,6 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountDistinc
       }//end else
 
       // Free it all
-      delete currNode;
-      currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
 
       if (queue->GetSize() > this->maxQueue)
@@ -11301,7 +13430,7 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountDistinc
     tDynamicPriorityQueue * queue;
     u_int32_t idx;
     stPage * currPage;
-    stSlimNode * currNode;
+    stSlimNodeView currNode;
     ObjectType tmpObj;
     double distance;
     double distanceRepres = 0;
@@ -11322,11 +13451,11 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountDistinc
     while (pqCurrValue.PageID != 0) {
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
         // Get Index node
-        stSlimIndexNode * indexNode = (stSlimIndexNode *) currNode;
+        stSlimNodeView * indexNode = &currNode;
         numberOfEntries = indexNode->GetNumberOfEntries();
 
         // for each entry...
@@ -11352,7 +13481,7 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountDistinc
       }
       else {
         // No, it is a leaf node. Get it.
-        stSlimLeafNode * leafNode = (stSlimLeafNode *) currNode;
+        stSlimNodeView * leafNode = &currNode;
         numberOfEntries = leafNode->GetNumberOfEntries();
 
         // for each entry...
@@ -11473,8 +13602,6 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountDistinc
       }//end else
 
       // Free it all
-      delete currNode;
-      currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
 
       if (queue->GetSize() > this->maxQueue)
@@ -11539,7 +13666,7 @@ stResult<ObjectType> * tmpl_stSlimTree::preConstrainedNearestQuery(
     tDynamicPriorityQueue * queue;
     u_int32_t idx;
     stPage * currPage;
-    stSlimNode * currNode;
+    stSlimNodeView currNode;
     ObjectType tmpObj;
     double distance;
     double distanceRepres = 0;
@@ -11560,11 +13687,11 @@ stResult<ObjectType> * tmpl_stSlimTree::preConstrainedNearestQuery(
     while (pqCurrValue.PageID != 0) {
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
         // Get Index node
-        stSlimIndexNode * indexNode = (stSlimIndexNode *) currNode;
+        stSlimNodeView * indexNode = &currNode;
         numberOfEntries = indexNode->GetNumberOfEntries();
 
         // for each entry...
@@ -11590,7 +13717,7 @@ stResult<ObjectType> * tmpl_stSlimTree::preConstrainedNearestQuery(
       }
       else {
         // No, it is a leaf node. Get it.
-        stSlimLeafNode * leafNode = (stSlimLeafNode *) currNode;
+        stSlimNodeView * leafNode = &currNode;
         numberOfEntries = leafNode->GetNumberOfEntries();
 
         // for each entry...
@@ -11633,8 +13760,6 @@ stResult<ObjectType> * tmpl_stSlimTree::preConstrainedNearestQuery(
       }//end else
 
       // Free it all
-      delete currNode;
-      currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
 
       if (queue->GetSize() > this->maxQueue)
@@ -11717,11 +13842,11 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountGreater
     while (pqCurrValue.PageID != 0) {
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
         // Get Index node
-        stSlimIndexNode * indexNode = (stSlimIndexNode *) currNode;
+        stSlimNodeView * indexNode = &currNode;
         numberOfEntries = indexNode->GetNumberOfEntries();
 
         // for each entry...
@@ -11747,7 +13872,7 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountGreater
       }
       else {
         // No, it is a leaf node. Get it.
-        stSlimLeafNode * leafNode = (stSlimLeafNode *) currNode;
+        stSlimNodeView * leafNode = &currNode;
         numberOfEntries = leafNode->GetNumberOfEntries();
 
         // for each entry...
@@ -11818,8 +13943,6 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountGreater
       }//end else
 
       // Free it all
-      delete currNode;
-      currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
 
       if (queue->GetSize() > this->maxQueue)
@@ -11901,11 +14024,11 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountLessTha
     while (pqCurrValue.PageID != 0) {
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
         // Get Index node
-        stSlimIndexNode * indexNode = (stSlimIndexNode *) currNode;
+        stSlimNodeView * indexNode = &currNode;
         numberOfEntries = indexNode->GetNumberOfEntries();
 
         // for each entry...
@@ -11931,7 +14054,7 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountLessTha
       }
       else {
         // No, it is a leaf node. Get it.
-        stSlimLeafNode * leafNode = (stSlimLeafNode *) currNode;
+        stSlimNodeView * leafNode = &currNode;
         numberOfEntries = leafNode->GetNumberOfEntries();
 
         // for each entry...
@@ -12002,8 +14125,6 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountLessTha
       }//end else
 
       // Free it all
-      delete currNode;
-      currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
 
       if (queue->GetSize() > this->maxQueue)
@@ -12084,11 +14205,11 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountDistinc
     while (pqCurrValue.PageID != 0) {
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
         // Get Index node
-        stSlimIndexNode * indexNode = (stSlimIndexNode *) currNode;
+        stSlimNodeView * indexNode = &currNode;
         numberOfEntries = indexNode->GetNumberOfEntries();
 
         // for each entry...
@@ -12114,7 +14235,7 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountDistinc
       }
       else {
         // No, it is a leaf node. Get it.
-        stSlimLeafNode * leafNode = (stSlimLeafNode *) currNode;
+        stSlimNodeView * leafNode = &currNode;
         numberOfEntries = leafNode->GetNumberOfEntries();
 
         // for each entry...
@@ -12280,8 +14401,6 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountDistinc
       }//end else
 
       // Free it all
-      delete currNode;
-      currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
 
       if (queue->GetSize() > this->maxQueue)
@@ -12361,11 +14480,11 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountDistinc
     while (pqCurrValue.PageID != 0) {
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
         // Get Index node
-        stSlimIndexNode * indexNode = (stSlimIndexNode *) currNode;
+        stSlimNodeView * indexNode = &currNode;
         numberOfEntries = indexNode->GetNumberOfEntries();
 
         // for each entry...
@@ -12391,7 +14510,7 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountDistinc
       }
       else {
         // No, it is a leaf node. Get it.
-        stSlimLeafNode * leafNode = (stSlimLeafNode *) currNode;
+        stSlimNodeView * leafNode = &currNode;
         numberOfEntries = leafNode->GetNumberOfEntries();
 
         // for each entry...
@@ -12497,8 +14616,6 @@ stResult<ObjectType> * tmpl_stSlimTree::intraConstrainedNearestQueryCountDistinc
       }//end else
 
       // Free it all
-      delete currNode;
-      currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
 
       if (queue->GetSize() > this->maxQueue)
@@ -12581,11 +14698,11 @@ stResult<ObjectType> * tmpl_stSlimTree::BConstrainedNearestQuery(std::multiset<R
     while (pqCurrValue.PageID != 0) {
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
         // Get Index node
-        stSlimIndexNode * indexNode = (stSlimIndexNode *) currNode;
+        stSlimNodeView * indexNode = &currNode;
         numberOfEntries = indexNode->GetNumberOfEntries();
 
         // for each entry...
@@ -12611,7 +14728,7 @@ stResult<ObjectType> * tmpl_stSlimTree::BConstrainedNearestQuery(std::multiset<R
       }
       else {
         // No, it is a leaf node. Get it.
-        stSlimLeafNode * leafNode = (stSlimLeafNode *) currNode;
+        stSlimNodeView * leafNode = &currNode;
         numberOfEntries = leafNode->GetNumberOfEntries();
 
         // for each entry...
@@ -12674,8 +14791,6 @@ stResult<ObjectType> * tmpl_stSlimTree::BConstrainedNearestQuery(std::multiset<R
       }//end else
 
       // Free it all
-      delete currNode;
-      currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
 
       if (queue->GetSize() > this->maxQueue)
@@ -12758,11 +14873,11 @@ stResult<ObjectType> * tmpl_stSlimTree::BSlimIntraConstrainedNearestQueryCountGr
     while (pqCurrValue.PageID != 0) {
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
         // Get Index node
-        stSlimIndexNode * indexNode = (stSlimIndexNode *) currNode;
+        stSlimNodeView * indexNode = &currNode;
         numberOfEntries = indexNode->GetNumberOfEntries();
 
         // for each entry...
@@ -12788,7 +14903,7 @@ stResult<ObjectType> * tmpl_stSlimTree::BSlimIntraConstrainedNearestQueryCountGr
       }
       else {
         // No, it is a leaf node. Get it.
-        stSlimLeafNode * leafNode = (stSlimLeafNode *) currNode;
+        stSlimNodeView * leafNode = &currNode;
         numberOfEntries = leafNode->GetNumberOfEntries();
 
         // for each entry...
@@ -12865,8 +14980,6 @@ stResult<ObjectType> * tmpl_stSlimTree::BSlimIntraConstrainedNearestQueryCountGr
       }//end else
 
       // Free it all
-      delete currNode;
-      currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
 
       if (queue->GetSize() > this->maxQueue)
@@ -12948,11 +15061,11 @@ stResult<ObjectType> * tmpl_stSlimTree::BSlimIntraConstrainedNearestQueryCountLe
     while (pqCurrValue.PageID != 0) {
       // Read node...
       currPage = tMetricTree::myPageManager->GetPage(pqCurrValue.PageID);
-      currNode = stSlimNode::CreateNode(currPage);
+      currNode.SetPage(currPage);
       // Is it a Index node?
-      if (currNode->GetNodeType() == stSlimNode::INDEX) {
+      if (currNode.GetNodeType() == stSlimNode::INDEX) {
         // Get Index node
-        stSlimIndexNode * indexNode = (stSlimIndexNode *) currNode;
+        stSlimNodeView * indexNode = &currNode;
         numberOfEntries = indexNode->GetNumberOfEntries();
 
         // for each entry...
@@ -12978,7 +15091,7 @@ stResult<ObjectType> * tmpl_stSlimTree::BSlimIntraConstrainedNearestQueryCountLe
       }
       else {
         // No, it is a leaf node. Get it.
-        stSlimLeafNode * leafNode = (stSlimLeafNode *) currNode;
+        stSlimNodeView * leafNode = &currNode;
         numberOfEntries = leafNode->GetNumberOfEntries();
 
         // for each entry...
@@ -13057,8 +15170,6 @@ stResult<ObjectType> * tmpl_stSlimTree::BSlimIntraConstrainedNearestQueryCountLe
       }//end else
 
       // Free it all
-      delete currNode;
-      currNode = 0;
       tMetricTree::myPageManager->ReleasePage(currPage);
 
       if (queue->GetSize() > this->maxQueue)
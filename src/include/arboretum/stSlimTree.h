@@ -31,6 +31,18 @@
 #include <arboretum/stSlimNode.h>
 #include <arboretum/stPageManager.h>
 #include <arboretum/stGenericPriorityQueue.h>
+#include <arboretum/stLatch.h>
+#include <arboretum/stConcurrentPageManager.h>
+#include <arboretum/stSnapshotPageManager.h>
+#include <arboretum/stSerializer.h>
+#include <arboretum/stPivotTable.h>
+#include <arboretum/stKMedoids.h>
+#include <arboretum/stSlimResidentLevels.h>
+#include <arboretum/stQueryStats.h>
+#include <arboretum/stTaskPool.h>
+#include <arboretum/stSharedPageCache.h>
+#include <arboretum/stRangeCursor.h>
+#include <arboretum/stNearestQueryHint.h>
 
 // this is used to set the initial size of the dynamic queue
 #ifndef STARTVALUEQUEUE
@@ -49,6 +61,34 @@
    #define SECUREVALUE 1.2
 #endif //SECUREVALUE
 
+// Minimum number of entries of a node to evaluate the MinMax candidate pairs
+// in parallel.
+#ifndef STMINMAXPARALLELENTRIES
+   #define STMINMAXPARALLELENTRIES 64
+#endif //STMINMAXPARALLELENTRIES
+
+// Default fraction of each node filled by BulkLoadMedoids(). The free space
+// left absorbs the objects that do not fit the exact packing.
+#ifndef STMEDOIDOCCUPANCY
+   #define STMEDOIDOCCUPANCY 0.7
+#endif //STMEDOIDOCCUPANCY
+
+// Minimum number of outer subtrees per thread of the NearestJoinQuery().
+#ifndef STJOINTASKSPERTHREAD
+   #define STJOINTASKSPERTHREAD 4
+#endif //STJOINTASKSPERTHREAD
+
+// Default number of pages of the shared page cache of the RangeJoinQuery().
+#ifndef STJOINCACHEPAGES
+   #define STJOINCACHEPAGES 256
+#endif //STJOINCACHEPAGES
+
+// Maximum number of entries of the priority queue prefetched by the
+// NearestQuery() (see SetPrefetch()).
+#ifndef STPREFETCHQUEUE
+   #define STPREFETCHQUEUE 16
+#endif //STPREFETCHQUEUE
+
 #include <string.h>
 #include <math.h>
 //#include <values.h>
@@ -57,10 +97,17 @@
 
 #include <stack>
 #include <vector>
+#include <thread>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <deque>
+#include <chrono>
+#include <arboretum/stHistogram.h>
 
 // Include disk access statistics classes
 #ifdef __stDISKACCESSSTATS__
-   #include <arboretum/stHistogram.h>
    #include <arboretum/stLevelDiskAccess.h>
 #endif //__stDISKACCESSSTATS__
 
@@ -165,6 +212,11 @@ typedef struct {
 template <class ObjectType, class EvaluatorType>
 class stSlimLogicNode{
    public:
+      /**
+      * This type writes the objects directly into the node pages.
+      */
+      typedef stSerializer < ObjectType > tSerializer;
+
       /**
       * Creates a new instance of this node with no objects.
       *
@@ -301,6 +353,31 @@ class stSlimLogicNode{
       */
       void AddLeafNode(stSlimLeafNode * node);
 
+      /**
+      * Adds the object idx to a leaf node, filling its distance to the
+      * representative of the leaf (and its pivot distances, if any).
+      *
+      * @param node The leaf node.
+      * @param idx The index of the object in this node.
+      * @param distance The distance to the representative of node.
+      * @return The index of the new entry in node or a negative value if
+      * it does not fit.
+      */
+      int AddLeafEntry(stSlimLeafNode * node, u_int32_t idx, double distance);
+
+      #ifdef __stSLIMPIVOTS__
+         /**
+         * Returns the pivot distances of the object idx. They are copied from
+         * the leaf by AddLeafNode(); the tree must fill them for the other
+         * entries.
+         *
+         * @param idx The index of the object.
+         */
+         double * GetPivotDistances(u_int32_t idx){
+            return Entries[idx].PivotDistance;
+         }//end GetPivotDistances
+      #endif //__stSLIMPIVOTS__
+
       /**
       * Returns the idx of the representative object.
       *
@@ -413,6 +490,31 @@ class stSlimLogicNode{
       u_int32_t TestDistribution(stSlimLeafNode * node0, stSlimLeafNode * node1,
                                EvaluatorType * metricEvaluator);
 
+      /**
+      * Simulates TestDistribution() for a pair of representatives without
+      * writing any node. The distances come from a precomputed matrix and
+      * the space of each node is accounted using the size of each entry, so
+      * the result is the same of TestDistribution() followed by
+      * GetMinimumRadius() on both nodes.
+      *
+      * <P>This method does not change this node, so many pairs may be tested
+      * at the same time as long as each caller uses its own work areas.
+      *
+      * @param rep0 Index of representative 0.
+      * @param rep1 Index of representative 1.
+      * @param distances The distance matrix (Count x Count).
+      * @param sizes Space used by each entry in a node (object and entry).
+      * @param capacity Space available in an empty node.
+      * @param idx0 Work area with Count elements.
+      * @param idx1 Work area with Count elements.
+      * @param mapped Work area with Count elements.
+      * @return The largest of the 2 covering radii.
+      */
+      double TestDistribution(u_int32_t rep0, u_int32_t rep1,
+                              const double * distances, const u_int32_t * sizes,
+                              u_int32_t capacity, doubleIndex * idx0,
+                              doubleIndex * idx1, bool * mapped);
+
       /**
       * Set minimum occupation. This must be the minimum number of objects
       * in a page. This value must be at least 1.
@@ -505,6 +607,20 @@ class stSlimLogicNode{
          * Node Map.
          */
          bool Mapped;
+
+         #ifdef __stSLIMPIVOTS__
+            /**
+            * Distances to the global pivots (leaf entries only).
+            */
+            double PivotDistance[STSLIMPIVOTS];
+         #endif //__stSLIMPIVOTS__
+
+         #ifdef __stSLIMRKNN__
+            /**
+            * Distance to the k-th nearest neighbor (leaf entries only).
+            */
+            double KNNDistance;
+         #endif //__stSLIMRKNN__
       };
 
       /**
@@ -567,6 +683,11 @@ class stSlimMSTSplitter{
       */
       typedef stSlimLogicNode < ObjectType, EvaluatorType > tLogicNode;
 
+      /**
+      * This type writes the objects directly into the node pages.
+      */
+      typedef stSerializer < ObjectType > tSerializer;
+
       /**
       * Builds a new instance of this class. It will claim the ownership of the
       * logic node provided as input.
@@ -807,6 +928,22 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
          * Total number of nodes.
          */
          u_int32_t NodeCount;
+
+         #ifdef __stSLIMPIVOTS__
+            /**
+            * Size of the serialized pivots. They are stored in the header
+            * page right after this structure.
+            */
+            u_int32_t PivotSize;
+         #endif //__stSLIMPIVOTS__
+
+         #ifdef __stSLIMRKNN__
+            /**
+            * The k of the k-th nearest neighbor distances stored in the
+            * nodes or 0 if they are not maintained.
+            */
+            u_int32_t KNNDistanceK;
+         #endif //__stSLIMRKNN__
       }stSlimHeader;   
 
       /**
@@ -907,6 +1044,23 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
       */
       typedef stJoinedResult <ObjectType> tJoinedResult;
 
+      /**
+      * This is the callback of the streaming joins. It receives a pair of
+      * objects and their distance and returns false to stop the join.
+      */
+      typedef std::function < bool (ObjectType & obj, ObjectType & joinedObj,
+            double distance) > tJoinCallback;
+
+      /**
+      * This is the visitor of the streaming queries. It receives each
+      * qualifying object as stored in the leaves (decode it with
+      * ObjectType::IncludedUnserialize()) and its distance to the sample and
+      * returns false to stop the query. The bytes are only valid during the
+      * call.
+      */
+      typedef std::function < bool (const unsigned char * data, u_int32_t size,
+            double distance) > tVisitor;
+
       /**
       * This type is used by the priority key.
       */
@@ -929,9 +1083,74 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
       */
       typedef stSlimMemLeafNode < ObjectType > tMemLeafNode;
 
-      #ifdef __stDISKACCESSSTATS__
-         typedef stHistogram < ObjectType, EvaluatorType > tHistogram;
-      #endif //__stDISKACCESSSTATS__
+      /**
+      * Distance distribution (see tApproximate).
+      */
+      typedef stHistogram < ObjectType, EvaluatorType > tHistogram;
+
+      /**
+      * The knobs of the approximate NearestQuery(). Each knob trades
+      * accuracy for time and the default values give the exact query.
+      */
+      struct tApproximate{
+         /**
+         * Maximum number of nodes read by the query or 0 for no limit.
+         */
+         u_int32_t MaxNodes;
+
+         /**
+         * Relaxation of the pruning. A subtree is only visited if
+         * d(sample, rep) <= rangeK / (1 + Epsilon) + radius, so the k-th
+         * distance found is at most (1 + Epsilon) times the exact one.
+         */
+         double Epsilon;
+
+         /**
+         * Time budget of the query in milliseconds or 0 for no limit.
+         */
+         double MaxTime;
+
+         /**
+         * Distance distribution of the objects (the fraction of the pairs
+         * of objects within each distance) or NULL. Build it with
+         * tHistogram::Add() and tHistogram::Build() from a sample.
+         */
+         tHistogram * Distribution;
+
+         /**
+         * Once k objects are found, the query stops when the expected number
+         * of unread objects closer than the k-th one, estimated from
+         * Distribution, is not greater than this value. 0 disables it.
+         */
+         double MaxMiss;
+
+         /**
+         * Creates the knobs of the exact query.
+         */
+         tApproximate(){
+            MaxNodes = 0;
+            Epsilon = 0;
+            MaxTime = 0;
+            Distribution = NULL;
+            MaxMiss = 0;
+         }//end tApproximate
+      };
+
+      /**
+      * Query hint of NearestQuery() (see CreateQueryHint()).
+      */
+      typedef stNearestQueryHint < ObjectType > tNearestQueryHint;
+
+      /**
+      * The query hint types of the Slim-Tree.
+      */
+      enum stSlimQueryHintType{
+         /**
+         * The hint of NearestQuery(ObjectType *, u_int32_t, stQueryHint *,
+         * bool, bool), a tNearestQueryHint.
+         */
+         QHT_NEARESTQUERY = 1024
+      };//end stSlimQueryHintType
 
       /**
       * Creates a new metric tree using a given page manager. This instance will
@@ -967,18 +1186,114 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
       */
       virtual bool Add(ObjectType * newObj);
 
+      /**
+      * This method adds an object to the metric tree. It may be called by
+      * many threads at the same time, concurrently with the queries, if the
+      * concurrent mode is enabled. Otherwise it is the same as Add().
+      *
+      * <P>The insertion is optimistic: the path is chosen without latching
+      * the index nodes, only the leaf and the index entries that must be
+      * updated (radius and number of entries) are latched in exclusive
+      * mode, one at a time. If the leaf is full, the insertion restarts with
+      * exclusive access to the whole tree and uses Add().
+      *
+      * @param newObj The object to be added.
+      * @see SetConcurrent()
+      */
+      bool ConcurrentAdd(ObjectType * newObj);
+
+      /**
+      * Enables or disables the concurrent mode. When enabled, the page
+      * manager of this tree is wrapped by a stConcurrentPageManager and
+      * ConcurrentAdd(), RangeQuery(), ExistsQuery(), ReversedRangeQuery(),
+      * NearestQuery(), FarthestQuery(), PointQuery(), KAndRangeQuery(),
+      * KOrRangeQuery() and RingQuery() may be called by many threads at the
+      * same time. All other methods still require exclusive access.
+      *
+      * <P>This method must not be called while other threads are using this
+      * tree.
+      *
+      * @param concurrent True to enable the concurrent mode.
+      * @warning The distance count of the metric evaluator is not
+      * synchronized, so it is only an estimate in the concurrent mode.
+      */
+      void SetConcurrent(bool concurrent);
+
+      /**
+      * Returns true if the concurrent mode is enabled.
+      */
+      bool IsConcurrent(){
+         return ConcurrentPageManager != NULL;
+      }//end IsConcurrent
+
+      /**
+      * Enables or disables the snapshot isolation. When enabled, the page
+      * manager of this tree is wrapped by a stSnapshotPageManager. One thread
+      * may modify the tree (Add(), Optimize(), ...) while other threads run
+      * queries inside read views. A read view sees the tree as it was at the
+      * last CommitSnapshot() before BeginReadView().
+      *
+      * <P>This method must not be called while other threads are using this
+      * tree and the snapshot isolation can not be combined with
+      * SetConcurrent().
+      *
+      * @param enabled True to enable the snapshot isolation.
+      */
+      void SetSnapshotIsolation(bool enabled);
+
+      /**
+      * Returns true if the snapshot isolation is enabled.
+      */
+      bool IsSnapshotIsolation(){
+         return SnapshotPageManager != NULL;
+      }//end IsSnapshotIsolation
+
+      /**
+      * Publishes all modifications performed since the last call to the read
+      * views that will be started from now on. Must be called by the thread
+      * that modifies the tree.
+      */
+      void CommitSnapshot();
+
+      /**
+      * Starts a read view for the calling thread. Until EndReadView() is
+      * called, all queries performed by this thread see the last committed
+      * snapshot, including its root. Read views may be nested.
+      *
+      * @return True for success or false if the snapshot isolation is
+      * disabled.
+      * @warning The thread must not modify the tree while the view is active.
+      */
+      bool BeginReadView();
+
+      /**
+      * Ends the most recent read view of the calling thread, allowing the
+      * page versions it pinned to be reclaimed.
+      */
+      void EndReadView();
+
       /**
       * Returns the height of the tree.
       */
       virtual u_int32_t GetHeight(){
-         return Header->Height;
+         tReadView * view = GetReadView();
+
+         if (view != NULL){
+            return view->Height;
+         }//end if
+         return __atomic_load_n(&Header->Height, __ATOMIC_RELAXED);
       }//end GetHeight
 
       /**
       * Returns the number of objetcs of this tree.
       */
       virtual long GetNumberOfObjects(){
-         return Header->ObjectCount;
+         tReadView * view = GetReadView();
+
+         if (view != NULL){
+            return view->ObjectCount;
+         }//end if
+         return __atomic_load_n(&Header->ObjectCount, __ATOMIC_RELAXED);
       }//end GetNumberOfObjects
 
       /**
@@ -1011,6 +1326,163 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
          Header->MinOccupation = min;
       }//end SetMinOccupation
 
+      #ifdef __stSLIMPIVOTS__
+         /**
+         * Chooses the global pivots of the leaves from a sample of objects
+         * using the HF algorithm (see stPivotTable). The pivots are stored in
+         * the header page and the distances of every leaf entry to them are
+         * recomputed, so this method may be called before or after the
+         * objects are inserted. Add() and Optimize() keep the distances.
+         * Entries without distances (e.g. after a bulk load) are never
+         * pruned; call this method again to set them.
+         *
+         * <P>Range and k-nearest neighbor queries use these distances to
+         * discard leaf entries without decoding them.
+         *
+         * @param objects The sample.
+         * @param numObject The number of objects in the sample.
+         * @param numPivots The number of pivots. It is limited to
+         * STSLIMPIVOTS.
+         * @return False if no pivot could be chosen or if the pivots do not
+         * fit in the header page. In this case, the tree has no pivots.
+         * @warning This method must not be called while other threads use the
+         * tree.
+         */
+         bool SetPivots(ObjectType ** objects, u_int32_t numObject,
+               u_int32_t numPivots = STSLIMPIVOTS);
+
+         /**
+         * Returns the number of global pivots of the leaves.
+         */
+         u_int32_t GetNumberOfPivots(){
+            return Pivots.GetNumberOfPivots();
+         }//end GetNumberOfPivots
+      #endif //__stSLIMPIVOTS__
+
+      #ifdef __stSLIMRKNN__
+         /**
+         * Sets the k of the reverse k-nearest neighbor queries. The distance
+         * of each object to its k-th nearest neighbor (the object itself is
+         * not one of its neighbors) is computed and stored in its leaf entry,
+         * and each index entry stores the maximum of these distances in its
+         * subtree. From now on, Add() keeps them up to date.
+         *
+         * <P>Optimize() keeps them too. Other changes of the tree (bulk
+         * loads, deletions) do not maintain these distances; call this method
+         * again after them.
+         *
+         * @param k The number of neighbors or 0 to stop maintaining them.
+         * @warning This method must not be called while other threads use the
+         * tree.
+         * @see ReverseNearestQuery()
+         */
+         void SetKNNDistances(u_int32_t k);
+
+         /**
+         * Returns the k of the reverse k-nearest neighbor queries or 0 if it
+         * is not set.
+         */
+         u_int32_t GetKNNDistanceK(){
+            return Header->KNNDistanceK;
+         }//end GetKNNDistanceK
+
+         /**
+         * Performs a reverse k-nearest neighbor query. It returns all objects
+         * of the tree that have the sample among their k nearest neighbors,
+         * that is, every object whose distance to the sample is not greater
+         * than the distance to its own k-th nearest neighbor. k is set by
+         * SetKNNDistances().
+         *
+         * <P>A subtree is discarded when the distance of the sample to its
+         * representative is greater than its radius plus the maximum k-th
+         * nearest neighbor distance stored in its index entry. Entries whose
+         * distances are unknown are never discarded and the k-th nearest
+         * neighbor distances of their objects are computed on the fly.
+         *
+         * <P>If the sample is stored in the tree, it is also returned. The
+         * result is empty if k is not set.
+         *
+         * @param sample The sample object.
+         * @return The result. The distances are the distances to the sample.
+         * @warning The instance of tResult returned must be destroied by user.
+         * @see SetKNNDistances()
+         */
+         tResult * ReverseNearestQuery(ObjectType * sample);
+      #endif //__stSLIMRKNN__
+
+      /**
+      * Enables the resident upper levels. The index nodes of the top levels
+      * of the tree are kept decoded in memory (see stSlimResidentLevels) and
+      * RangeQuery() and NearestQuery() use them instead of reading and
+      * unserializing their pages.
+      *
+      * <P>The resident levels are built by the first query and rebuilt by
+      * the first query after any modification of the tree. They are not
+      * used by the queries performed inside a read view.
+      *
+      * @param levels The number of index levels, starting from the root. 0
+      * disables this feature.
+      * @param maxBytes The maximum total size of the resident pages or 0 for
+      * no limit. The nodes that do not fit are read from the pages.
+      */
+      void SetResidentLevels(u_int32_t levels, u_int32_t maxBytes = 0);
+
+      /**
+      * Returns the number of resident upper levels or 0 if this feature is
+      * disabled.
+      */
+      u_int32_t GetResidentLevels(){
+         return ResidentLevels;
+      }//end GetResidentLevels
+
+      #ifdef __stQUERYSTATS__
+         /**
+         * Enables the per-query statistics. When enabled, each result
+         * returned by RangeQuery() and NearestQuery() carries a stQueryStats
+         * (see stBasicResult::GetQueryStats()) with the nodes visited per
+         * level, the entries pruned by each rule, the distance and filter
+         * calls, the peak size of the priority queue, the bytes decoded and
+         * the time spent in each phase of the query.
+         *
+         * <P>The statistics are compiled only if __stQUERYSTATS__ is defined,
+         * so they cost nothing otherwise.
+         *
+         * @param enable True to enable them.
+         */
+         void SetQueryStats(bool enable){
+            QueryStatsEnabled = enable;
+         }//end SetQueryStats
+
+         /**
+         * Returns true if the per-query statistics are enabled.
+         */
+         bool GetQueryStats(){
+            return QueryStatsEnabled;
+         }//end GetQueryStats
+      #endif //__stQUERYSTATS__
+
+      /**
+      * Enables the prefetch of child nodes. Once an index node is evaluated,
+      * RangeQuery() submits the reads of its qualifying children and
+      * NearestQuery() the reads of the first entries of its priority queue
+      * (see stPageManager::SubmitPrefetch()) before reading the first one.
+      * Page managers without asynchronous reads ignore it.
+      *
+      * @param depth The maximum number of pages prefetched at once. 0
+      * disables this feature.
+      */
+      void SetPrefetch(u_int32_t depth){
+         PrefetchDepth = depth;
+      }//end SetPrefetch
+
+      /**
+      * Returns the maximum number of pages prefetched at once or 0 if the
+      * prefetch is disabled.
+      */
+      u_int32_t GetPrefetch(){
+         return PrefetchDepth;
+      }//end GetPrefetch
+
       /**
        * Computes the number of elements that an index node can hold.
        * The function considers every object is the same size.
@@ -1238,6 +1710,11 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
          * time.
          */
          u_int32_t GetRoot(){
+            tReadView * view = GetReadView();
+
+            if (view != NULL){
+               return view->Root;
+            }//end if
             return this->Header->Root;
          }//end GetRoot
       #endif //__stDEBUG__
@@ -1327,6 +1804,71 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
               double internalRadius = 0, double externalRadius = MAXDOUBLE,
               long oid = MAXLONG);
 
+      /**
+      * This method will perform a Forward range query that streams the
+      * objects to a visitor in increasing order of distance (ties in
+      * increasing order of OID) instead of returning pages of nObj objects.
+      * The visitor is called for each object o with internalRadius < d(o,
+      * sample) <= externalRadius, or d(o, sample) == internalRadius and
+      * o.GetOID() > oid, until it returns false. Only the qualifying nodes
+      * and objects not yet visited are kept, never the visited ones.
+      *
+      * @param sample The sample object.
+      * @param visitor The visitor.
+      * @param internalRadius The internal radius of the query.
+      * @param externalRadius The external radius of the query.
+      * @param oid The last OID of the previous query.
+      * @return False if the query was stopped by the visitor.
+      * @see tVisitor
+      */
+      bool ForwardRangeQuery(ObjectType * sample, tVisitor visitor,
+              double internalRadius = 0, double externalRadius = MAXDOUBLE,
+              long oid = MAXLONG){
+         stRangeCursor cursor(internalRadius, externalRadius, oid);
+
+         return ForwardRangeQuery(sample, &cursor, visitor);
+      }//end ForwardRangeQuery
+
+      /**
+      * This method will resume a Forward range query from a cursor,
+      * streaming the objects to a visitor in increasing order of distance
+      * (ties in increasing order of OID) until it returns false. The cursor
+      * keeps the frontier of the traversal, so the next call continues
+      * after the last visited object without reading again the nodes
+      * already read. If the tree was modified since the cursor was used
+      * (or it is new), the query starts from the root at the position of
+      * the cursor.
+      *
+      * @param sample The sample object. It must be the same in all calls
+      * with a cursor.
+      * @param cursor The cursor.
+      * @param visitor The visitor.
+      * @return False if the query was stopped by the visitor.
+      * @see stRangeCursor
+      */
+      bool ForwardRangeQuery(ObjectType * sample, stRangeCursor * cursor,
+              tVisitor visitor){
+         return RangeCursorQuery(sample, cursor, false, visitor);
+      }//end ForwardRangeQuery
+
+      /**
+      * This method will return the next page of a Forward range query
+      * kept by a cursor (see ForwardRangeQuery(ObjectType *,
+      * stRangeCursor *, tVisitor)). The cost of each page does not depend
+      * on the number of pages already returned.
+      *
+      * @param sample The sample object.
+      * @param nObj The number of objects of the page.
+      * @param cursor The cursor. It is finished (stRangeCursor::IsFinished())
+      * after the last page.
+      * @return The result.
+      * @warning The instance of tResult returned must be destroied by user.
+      */
+      tResultPaged * ForwardRangeQuery(ObjectType * sample, u_int32_t nObj,
+              stRangeCursor * cursor){
+         return RangeCursorQuery(sample, nObj, cursor, false);
+      }//end ForwardRangeQuery
+
       /**
       * This method will perform a Backward range query without list of the priority.
       * The result will be a set of pairs object/distance.
@@ -1361,6 +1903,41 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
               double internalRadius = 0, double externalRadius = MAXDOUBLE,
               long oid = MAXLONG);
 
+      /**
+      * This method will resume a Backward range query from a cursor,
+      * streaming the objects to a visitor in decreasing order of distance
+      * (ties in decreasing order of OID) until it returns false. The objects
+      * o with internalRadius < d(o, sample) < externalRadius (or equal to
+      * externalRadius, after the OID of the cursor) are visited.
+      *
+      * @param sample The sample object. It must be the same in all calls
+      * with a cursor.
+      * @param cursor The cursor.
+      * @param visitor The visitor.
+      * @return False if the query was stopped by the visitor.
+      * @see ForwardRangeQuery(ObjectType *, stRangeCursor *, tVisitor)
+      */
+      bool BackwardRangeQuery(ObjectType * sample, stRangeCursor * cursor,
+              tVisitor visitor){
+         return RangeCursorQuery(sample, cursor, true, visitor);
+      }//end BackwardRangeQuery
+
+      /**
+      * This method will return the next page of a Backward range query
+      * kept by a cursor.
+      *
+      * @param sample The sample object.
+      * @param nObj The number of objects of the page.
+      * @param cursor The cursor.
+      * @return The result.
+      * @warning The instance of tResult returned must be destroied by user.
+      * @see BackwardRangeQuery(ObjectType *, stRangeCursor *, tVisitor)
+      */
+      tResultPaged * BackwardRangeQuery(ObjectType * sample, u_int32_t nObj,
+              stRangeCursor * cursor){
+         return RangeCursorQuery(sample, nObj, cursor, true);
+      }//end BackwardRangeQuery
+
       /**
       * This method will perform a range query.
       * The result will be a set of pairs object/distance.
@@ -1373,6 +1950,26 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
       */
       tResult * RangeQuery(ObjectType * sample, double range);
 
+      /**
+      * This method will perform a range query that streams the qualifying
+      * objects to a visitor as the leaves are read, without copying them or
+      * keeping a result, so its memory does not depend on the size of the
+      * answer. The objects are visited in no particular order.
+      *
+      * @param sample The sample object.
+      * @param range The range of the results.
+      * @param visitor The visitor.
+      * @return False if the query was stopped by the visitor.
+      * @see tVisitor
+      */
+      bool RangeQuery(ObjectType * sample, double range, tVisitor visitor){
+         stSharedLatchGuard readLatch(GetReadLatch());
+         ObjectType tmpObj;
+
+         return VisitRing(this->GetRoot(), sample, -1, range, false, 0, tmpObj,
+               visitor);
+      }//end RangeQuery
+
       tResult * GetEmptyResult();
 
       tResult * ExistsQuery(ObjectType * sample, double range);
@@ -1437,7 +2034,110 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
       * @warning The instance of tResult returned must be destroied by user.
       * @see void NearestQuery
       */
-      tResult * NearestQuery(ObjectType * sample, u_int32_t k, bool tie = false, bool tiebreaker = false);
+      tResult * NearestQuery(ObjectType * sample, u_int32_t k, bool tie = false, bool tiebreaker = false){
+         return NearestQuery(sample, k, tApproximate(), tie, tiebreaker);
+      }//end NearestQuery
+
+      /**
+      * This method performs an approximate K-Nearest Neighbor query. It is
+      * the best-first NearestQuery() stopped by the knobs of approx: a
+      * budget of nodes, a budget of time, a relaxed pruning and a
+      * probabilistic stop based on the distance distribution. If a budget
+      * runs out before k objects are found, the result has less than k
+      * objects.
+      *
+      * @param sample The sample object.
+      * @param k The number of neighbors.
+      * @param approx The knobs.
+      * @param tie The tie list. Default false.
+      * @param tiebreaker If true, the objects tied with the k-th one are
+      * chosen by ObjectType::operator<().
+      * @return The result.
+      * @warning The instance of tResult returned must be destroied by user.
+      * @see tApproximate
+      */
+      tResult * NearestQuery(ObjectType * sample, u_int32_t k,
+            const tApproximate & approx, bool tie = false,
+            bool tiebreaker = false);
+
+      /**
+      * This method performs a K-Nearest Neighbor query that uses and updates
+      * a query hint. The answer has the same distances of NearestQuery()
+      * (which objects are chosen among the ones tied at the same distance may
+      * vary with the traversal, as in NearestQuery()), but:
+      *
+      * <UL>
+      * <LI>A query already in the LRU cache of the hint is answered by a copy
+      * of the cached answer, without reading the tree.
+      * <LI>Otherwise, the query starts with the range given by the last query
+      * of the hint (its k-th distance plus the distance between the samples
+      * and the distances to its answer) instead of MAXDOUBLE. This helps
+      * repeated or nearby queries, like the ones issued by an interactive
+      * user.
+      * </UL>
+      *
+      * @param sample The sample object.
+      * @param k The number of neighbors.
+      * @param hint The hint created by CreateQueryHint(QHT_NEARESTQUERY). A
+      * NULL or another hint is ignored.
+      * @param tie The tie list. Default false.
+      * @param tiebreaker If true, the objects tied with the k-th one are
+      * chosen by ObjectType::operator<().
+      * @return The result.
+      * @warning The instance of tResult returned must be destroied by user.
+      * @see tNearestQueryHint
+      */
+      tResult * NearestQuery(ObjectType * sample, u_int32_t k,
+            stQueryHint * hint, bool tie = false, bool tiebreaker = false);
+
+      /**
+      * Creates the proper query hint for a given operation type.
+      *
+      * @param type The operation type (see stSlimQueryHintType).
+      * @return A new hint or NULL if the type is not supported.
+      * @warning The returned instance must be disposed by the application.
+      */
+      virtual stQueryHint * CreateQueryHint(int type){
+         if (type == QHT_NEARESTQUERY){
+            return new tNearestQueryHint(QHT_NEARESTQUERY);
+         }//end if
+         return NULL;
+      }//end CreateQueryHint
+
+      /**
+      * Performs a diversified k-nearest neighbor query based on BRID (Better
+      * Results with Influence Diversification). The objects are visited in
+      * increasing distance to the sample by an incremental best-first
+      * traversal, and an object is added to the result only if no object
+      * already in the result influences it. A result r influences an object
+      * s when d(r, s) < diversity * d(sample, s), that is, r stands between
+      * the sample and s, or when s is a duplicate of r (d(r, s) = 0). Near
+      * duplicates of a result are therefore skipped and the traversal goes
+      * on until k objects are found.
+      *
+      * <P>A subtree is discarded as soon as all of its objects are
+      * influenced by one of the results, so the candidates are expanded on
+      * demand instead of fetching a large k and filtering it afterwards.
+      *
+      * <P>With diversity 0 no object is ever influenced and the result is
+      * the same of NearestQuery(). tie and tiebreaker have the same meaning
+      * of NearestQuery(): tied objects are either all kept or taken in the
+      * order given by ObjectType::operator<().
+      *
+      * @param sample The sample object.
+      * @param k The number of neighbors.
+      * @param diversity The influence factor. 1 is the original BRID; larger
+      * values give more diverse (and farther) results.
+      * @param tie If true, the objects tied with the k-th one that are not
+      * influenced are also returned.
+      * @param tiebreaker If true, the tied objects are taken in the order
+      * given by ObjectType::operator<().
+      * @return The result.
+      * @warning The instance of tResult returned must be destroied by user.
+      * @see NearestQuery()
+      */
+      tResult * DiverseNearestQuery(ObjectType * sample, u_int32_t k,
+            double diversity = 1.0, bool tie = false, bool tiebreaker = false);
 
       /**
       * This method will perform a K-Farthest Neighbor query using a global priority
@@ -1740,6 +2440,29 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
       tResult * RingQuery(ObjectType * sample, double inRange,
                           double outRange);
 
+      /**
+      * This method will perform a ring query that streams the qualifying
+      * objects to a visitor (see RangeQuery(ObjectType *, double,
+      * tVisitor)).
+      *
+      * @param sample The sample object.
+      * @param inRange The inner range of the results.
+      * @param outRange The outter range of the results.
+      * @param visitor The visitor.
+      * @return False if the query was stopped by the visitor.
+      */
+      bool RingQuery(ObjectType * sample, double inRange, double outRange,
+            tVisitor visitor){
+         stSharedLatchGuard readLatch(GetReadLatch());
+         ObjectType tmpObj;
+
+         if (inRange >= outRange){
+            return true;
+         }//end if
+         return VisitRing(this->GetRoot(), sample, inRange, outRange, false, 0,
+               tmpObj, visitor);
+      }//end RingQuery
+
       /**
       * This method will perform a ring query with K-Nearest Neighbor query.
       * The result will be a set of pairs object/distance.
@@ -1806,30 +2529,108 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
                                        bool tie = false);
 
       /**
-      * This method will perform a k-nearest neighbor join query.
+      * This method will perform a k-nearest neighbor join query. For each
+      * object of this tree, the result holds a triple with each one of its k
+      * nearest neighbors in slimTree.
+      *
+      * <P>Both trees are traversed together. Each outer subtree carries the
+      * list of inner subtrees and objects that may hold a neighbor of any of
+      * its objects. The lower bound of a pair of subtrees is
+      * d(rep1, rep2) - r1 - r2 and the upper bound of the k-nearest neighbor
+      * distance of an outer subtree is the k-th smallest d(rep1, rep2) + r1 +
+      * r2, each inner subtree counting as many objects as it holds. The
+      * list is pruned and its largest subtrees expanded at each outer level.
+      * In the outer leaves, the k nearest neighbors of each object are kept
+      * and their distances bound the rest of the search.
+      *
+      * <P>The outer subtrees are split among nThreads threads. Since the page
+      * managers are shared, more than one thread is used only if both trees
+      * are in the concurrent mode (see SetConcurrent()).
       *
       * @param slimTree The tree being joined.
       * @param k The number of neighbours.
       * @param tie The tie list. Default false.
+      * @param nThreads The number of threads. 0 means one thread per hardware
+      * core. Default 1.
       * @return The result or NULL if this method is not implemented.
       * @warning The instance of tJoinedResult returned must be destroied by user.
-      * @autor Implemented by Enzo Seraphim
       */
       tJoinedResult * NearestJoinQuery(stSlimTree * slimTree, u_int32_t k,
-                                       bool tie = false);
+                                       bool tie = false, u_int32_t nThreads = 1);
 
       /**
       * This method will perform a range joined query.
       *
       * @param slimTree The tree being joined.
       * @param range The range of the results.
-      * @param activeBuffer Active buffer of sub nodes in Joined Tree.
+      * @param buffer Ignored. The pages are always cached (see
+      * RangeJoinQuery(stSlimTree *, double, tJoinCallback, u_int32_t,
+      * u_int32_t)).
       * @return The result or NULL if this method is not implemented.
       * @warning The instance of tJoinedResult returned must be destroied by user.
       */
       tJoinedResult * RangeJoinQuery(stSlimTree * slimTree, double range,
                                      bool buffer = true);
 
+      /**
+      * This method will perform a range joined query that streams its pairs
+      * to a callback instead of storing them, so its memory does not depend
+      * on the size of the answer.
+      *
+      * <P>The join is split into pairs of nodes, one of each tree, run by a
+      * work stealing pool (see stTaskPool). A pair of nodes is cut when
+      * d(rep1, rep2) - r1 - r2 > range, using the distances to the parent
+      * representatives before computing new distances. The children of a
+      * pair are scheduled grouped by the child of slimTree, so each page of
+      * slimTree is reused by many pages of this tree while it is still in
+      * the shared page cache (see stSharedPageCache). All pages are read
+      * through this cache, so the join may use many threads even if the
+      * trees are not in the concurrent mode, as long as no other thread
+      * modifies them.
+      *
+      * @param slimTree The tree being joined.
+      * @param range The range of the results.
+      * @param callback Receives each pair of objects (one of this tree and
+      * one of slimTree) within range and their distance. The objects are
+      * only valid during the call. It returns false to stop the join. The
+      * calls are serialized.
+      * @param nThreads The number of threads. 0 means one thread per hardware
+      * core. Default 1.
+      * @param cachePages The number of pages of the shared page cache.
+      * @return False if the join was stopped by the callback.
+      */
+      bool RangeJoinQuery(stSlimTree * slimTree, double range,
+            tJoinCallback callback, u_int32_t nThreads = 1,
+            u_int32_t cachePages = STJOINCACHEPAGES){
+         return RunRangeJoin(slimTree, range, callback, false, nThreads,
+               cachePages);
+      }//end RangeJoinQuery
+
+      /**
+      * This method will find all pairs of objects of this tree within a
+      * given range (the self join), reporting each unordered pair once. It
+      * is the RangeJoinQuery() of this tree with itself, but a pair of nodes
+      * is visited only once (the pairs of children of a node with itself
+      * are taken with i <= j) and the distances between the objects of a
+      * leaf are computed only once for each pair. An entry is never paired
+      * with itself, but 2 equal objects stored in different entries are
+      * reported at distance 0.
+      *
+      * @param range The range of the results.
+      * @param callback Receives each pair of objects within range and their
+      * distance. The objects are only valid during the call. It returns
+      * false to stop the join. The calls are serialized.
+      * @param nThreads The number of threads. 0 means one thread per hardware
+      * core. Default 1.
+      * @param cachePages The number of pages of the shared page cache.
+      * @return False if the join was stopped by the callback.
+      * @see RangeJoinQuery()
+      */
+      bool SelfRangeJoin(double range, tJoinCallback callback,
+            u_int32_t nThreads = 1, u_int32_t cachePages = STJOINCACHEPAGES){
+         return RunRangeJoin(this, range, callback, true, nThreads, cachePages);
+      }//end SelfRangeJoin
+
       /**
       * This method will perform a generic range join query with a metric tree.
       * It will perform a range query for each object in the first tree.
@@ -1850,6 +2651,13 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
       * @param sampleList list of query centers
       * @param sampleSize number of objects in sampleList
       * @param range aggregate query radius
+      * @param weights weight of each sample or NULL for 1
+      *
+      * <P>The distances from the samples to each representative are kept and
+      * bound the distances of its entries, so an entry may be cut before
+      * any distance is computed (for g > 0, infinity and -infinity). The
+      * distances to the samples stop as soon as the aggregate exceeds the
+      * range.
       */
       tResult * AggregateRangeQuery(double numerator, double denominator, ObjectType ** sampleList, u_int32_t sampleSize, double range, double *weights = NULL);
 
@@ -1860,6 +2668,12 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
       * @param sampleList list of query centers
       * @param sampleSize number of objects in sampleList
       * @param k number of nearest neighbors
+      * @param tie unused
+      * @param weights weight of each sample or NULL for 1
+      *
+      * <P>The subtrees are visited in increasing order of their aggregate
+      * distance bound and pruned as in AggregateRangeQuery(), using the
+      * distance of the current k-th neighbor as the range.
       */
       tResult * AggregateNearestQuery(double numerator, double denominator, ObjectType ** sampleList, u_int32_t sampleSize, u_int32_t k, bool tie = false, double *weights = NULL);
 
@@ -1870,6 +2684,29 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
       */
       double GetFatFactor();
 
+      /**
+      * Builds this tree from a set of objects. The objects are grouped level
+      * by level, from the root to the leaves, around k-medoids chosen by the
+      * CLARA algorithm (see stKMedoids). Each group becomes a subtree whose
+      * representative is its medoid and the groups are balanced to fit the
+      * nodes, so all leaves are at the same level.
+      *
+      * <P>The clusters are more compact than the ones built by insertion,
+      * giving trees with a smaller FatFactor and less node accesses per
+      * query, but the construction computes many more distances. The few
+      * objects that do not fit their leaves are added by Add() at the end.
+      *
+      * @param objects The objects to be added.
+      * @param numObj The number of objects.
+      * @param nodeOccupancy The fraction of each node to be filled.
+      * @param nThreads The number of threads used to compute the distances.
+      * 0 means one thread per hardware core.
+      * @return False if the tree is not empty.
+      * @warning EvaluatorType must be copy constructible.
+      */
+      bool BulkLoadMedoids(ObjectType ** objects, u_int32_t numObj,
+            double nodeOccupancy = STMEDOIDOCCUPANCY, u_int32_t nThreads = 0);
+
 
       #ifdef __BULKLOAD__
 
@@ -1933,6 +2770,14 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
       * implementation errors that a developer may introduce in his/her 
       * implementation.
       *
+      * <P>It may also be used to verify a tree recovered from a crash by a
+      * page manager with write-ahead log (see
+      * stPlainDiskPageManager::GetRecoveredUpdates()). The tree is consistent
+      * if every covering radius holds its subtree, the distances to the
+      * representatives are right, all leaves are in the same level and the
+      * object counts match the header.
+      *
+      * @return True if no inconsistency was found.
       * @see Consistency(u_int32_t pageID, ObjectType * repObj, double & radius)
       */
       bool Consistency();
@@ -2061,19 +2906,187 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
    private:
 
       /**
-      * This method compute the grouping distance from an object to a set of objects.
+      * The kinds of aggregate distances.
       */
-      double GroupDistance(double numerator, double denominator, ObjectType ** sampleList, u_int32_t sampleSize, ObjectType *obj, double *weights = NULL);
+      enum tAggregateKind{
+         /**
+         * Denominator 0. The distance is always 0.
+         */
+         aggNONE,
 
-      /**
-      * Computes the aggregate distance to a Slim-tree subtree
-      */
-      double AggregateDistanceToSlimNode(double numerator, double denominator, ObjectType ** sampleList, u_int32_t sampleSize, ObjectType *representativeObject, double nodeRadius, double *weights);
+         /**
+         * g = infinity, the largest weighted distance.
+         */
+         aggMAX,
+
+         /**
+         * g = -infinity, the smallest weighted distance.
+         */
+         aggMIN,
+
+         /**
+         * g > 0, the g-th root of the weighted sum of the g-th powers.
+         */
+         aggPOWER,
+
+         /**
+         * g < 0.
+         */
+         aggNEGATIVE
+      };
 
       /**
-      * Recursion of AggregateRangeQuery.
+      * The scratch of an aggregate query, built once per query. It keeps
+      * the weights, the exponent and one vector of distances to the samples
+      * for each level of the tree.
       */
-      void AggregateRangeQuery(u_int32_t pageID, tResult * result, double numerator, double denominator, ObjectType ** sampleList, u_int32_t sampleSize, double range, double *weights);
+      struct tAggregate{
+         /**
+         * The samples.
+         */
+         ObjectType ** Samples;
+
+         /**
+         * The number of samples.
+         */
+         u_int32_t SampleSize;
+
+         /**
+         * The weight of each sample.
+         */
+         std::vector < double > Weights;
+
+         /**
+         * The kind of aggregate.
+         */
+         tAggregateKind Kind;
+
+         /**
+         * The exponent g = numerator/denominator.
+         */
+         double Power;
+
+         /**
+         * The inverse of g.
+         */
+         double InversePower;
+
+         /**
+         * The numerator of g (used by aggNEGATIVE).
+         */
+         double Numerator;
+
+         /**
+         * The distances from the samples to the representative of the
+         * current entry of each level.
+         */
+         std::vector < std::vector < double > > Levels;
+      };
+
+      /**
+      * Builds the scratch of an aggregate query.
+      *
+      * @param agg The scratch (output).
+      * @param numerator The numerator of g.
+      * @param denominator The denominator of g.
+      * @param sampleList The samples.
+      * @param sampleSize The number of samples.
+      * @param weights The weights or NULL for 1.
+      */
+      void InitAggregate(tAggregate & agg, double numerator, double denominator,
+            ObjectType ** sampleList, u_int32_t sampleSize, double * weights);
+
+      /**
+      * Returns |d|^g, avoiding pow() for g = 1 and g = 2.
+      */
+      double AggregateTerm(const tAggregate & agg, double d){
+         if (agg.Power == 1){
+            return fabs(d);
+         }else if (agg.Power == 2){
+            return d * d;
+         }else{
+            return pow(fabs(d), agg.Power);
+         }//end if
+      }//end AggregateTerm
+
+      /**
+      * Returns true if the aggregate grows with each distance, so
+      * distances may be replaced by lower bounds.
+      */
+      bool IsAggregateMonotone(const tAggregate & agg){
+         return (agg.Kind == aggMAX) || (agg.Kind == aggMIN) ||
+               (agg.Kind == aggPOWER);
+      }//end IsAggregateMonotone
+
+      /**
+      * Computes the aggregate distance of a subtree (node is true) or of an
+      * object from the distances to the samples.
+      *
+      * @param agg The scratch of the query.
+      * @param distances The distances from the samples to the
+      * representative or the object (or lower bounds of them).
+      * @param radius The covering radius of the subtree.
+      * @param node True for a subtree.
+      * @return The aggregate distance. For a subtree, it is a lower bound of
+      * the aggregate distances of its objects.
+      */
+      double AggregateValue(const tAggregate & agg, const double * distances,
+            double radius, bool node);
+
+      /**
+      * Computes the distances from the samples to an object, stopping as
+      * soon as the aggregate is known to be larger than a limit. The
+      * remaining distances are replaced by their lower bounds while
+      * checking it.
+      *
+      * @param agg The scratch of the query.
+      * @param obj The object.
+      * @param distances On input, lower bounds of the distances (if
+      * bounded is true). On output, the distances.
+      * @param bounded True if distances has lower bounds.
+      * @param radius The covering radius of the subtree of obj or 0.
+      * @param limit The limit.
+      * @return False if it stopped early.
+      */
+      bool AggregateDistances(const tAggregate & agg, ObjectType & obj,
+            double * distances, bool bounded, double radius, double limit);
+
+      /**
+      * Computes the distances from the samples to an entry of a node. They
+      * are copied from the parent if the entry shares its representative.
+      * Otherwise, the entry is first tested with the lower bounds given by
+      * the parent distances and then its distances are computed.
+      *
+      * @param agg The scratch of the query.
+      * @param node The node.
+      * @param idx The entry.
+      * @param parent The distances of the representative of node or NULL.
+      * @param distances The distances of the entry (output).
+      * @param radius The covering radius of the entry or 0.
+      * @param limit The largest aggregate distance of interest.
+      * @param tmpObj Scratch object.
+      * @return The aggregate distance of the entry or MAXDOUBLE if it was
+      * cut.
+      */
+      double AggregateEntry(const tAggregate & agg, stSlimNodeView & node,
+            u_int32_t idx, const double * parent, double * distances,
+            double radius, double limit, ObjectType & tmpObj);
+
+      /**
+      * Recursion of AggregateRangeQuery.
+      *
+      * @param pageID The node.
+      * @param result The result.
+      * @param agg The scratch of the query.
+      * @param range The range.
+      * @param parent The distances of the representative of the node or
+      * NULL for the root.
+      * @param level The level of the node.
+      * @param tmpObj Scratch object.
+      */
+      void AggregateRangeQuery(u_int32_t pageID, tResult * result,
+            tAggregate & agg, double range, const double * parent,
+            u_int32_t level, ObjectType & tmpObj);
        
       /**
       * This type defines the logic node for this class.
@@ -2085,6 +3098,11 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
       */
       typedef stSlimMSTSplitter < ObjectType, EvaluatorType > tMSTSplitter;
 
+      /**
+      * This type writes the objects directly into the node pages.
+      */
+      typedef stSerializer < ObjectType > tSerializer;
+
       /**
       * This type is used by the priority key.
       */
@@ -2190,6 +3208,372 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
       */
       bool HeaderUpdate;
 
+      #ifdef __stSLIMPIVOTS__
+         /**
+         * This type is the table of global pivots of the leaves.
+         */
+         typedef stPivotTable < ObjectType, EvaluatorType > tPivotTable;
+
+         /**
+         * The global pivots of the leaves. They are a copy of the pivots
+         * serialized in the header page.
+         */
+         tPivotTable Pivots;
+
+         /**
+         * Fills the pivot distances of a leaf entry. The distances to the
+         * missing pivots are set to 0.
+         *
+         * @param leafNode The leaf node.
+         * @param idx The index of the entry.
+         * @param obj The object of the entry.
+         */
+         void SetPivotDistances(stSlimLeafNode * leafNode, u_int32_t idx,
+               ObjectType * obj);
+
+         /**
+         * Computes the pivot distances of an object, setting the distances to
+         * the missing pivots to 0.
+         *
+         * @param obj The object.
+         * @param distances The distances (output) with room for STSLIMPIVOTS
+         * values.
+         */
+         void BuildPivotDistances(ObjectType * obj, double * distances){
+            memset(distances, 0, sizeof(double) * STSLIMPIVOTS);
+            Pivots.BuildDistances(obj, distances, this->myMetricEvaluator);
+         }//end BuildPivotDistances
+
+         /**
+         * Returns true if the leaf entry idx can not be within range of the
+         * sample, according to the pivot distances. Entries whose distances
+         * are unknown (negative) are never pruned.
+         *
+         * @param leafNode The leaf node.
+         * @param idx The index of the entry.
+         * @param samplePivots The pivot distances of the sample.
+         * @param range The range.
+         */
+         bool PivotPrune(stSlimNodeView * leafNode, u_int32_t idx,
+               const double * samplePivots, double range){
+            double pivots[STSLIMPIVOTS];
+
+            // The entries are not aligned.
+            memcpy(pivots, leafNode->GetLeafEntry(idx).PivotDistance,
+                   sizeof(pivots));
+            if (pivots[0] < 0){
+               return false;
+            }//end if
+            return tPivotTable::GetLowerBound(pivots, samplePivots,
+                  Pivots.GetNumberOfPivots()) > range;
+         }//end PivotPrune
+
+         /**
+         * Recomputes the pivot distances of all leaf entries of a subtree.
+         *
+         * @param pageID The root of the subtree.
+         * @param tmpObj Scratch object.
+         */
+         void UpdatePivotDistances(u_int32_t pageID, ObjectType & tmpObj);
+      #endif //__stSLIMPIVOTS__
+
+      #ifdef __stSLIMRKNN__
+         /**
+         * Returns the distance of an object of the tree to its k-th nearest
+         * neighbor, not counting the object itself, or MAXDOUBLE if the tree
+         * has no more than k objects. It does not hold any latch.
+         *
+         * @param obj The object.
+         * @param k The number of neighbors.
+         */
+         double GetKNNDistance(ObjectType * obj, u_int32_t k);
+
+         /**
+         * Updates the k-th nearest neighbor distances of a subtree. If newObj
+         * is NULL, all of them are recomputed. Otherwise, newObj has just been
+         * inserted and only the entries that may have it among their k nearest
+         * neighbors (and the unknown ones) are visited.
+         *
+         * @param pageID The root of the subtree.
+         * @param newObj The new object or NULL.
+         * @param distanceRepres The distance of newObj to the representative
+         * of the subtree or a negative value if it is unknown.
+         * @param tmpObj Scratch object.
+         * @return The maximum k-th nearest neighbor distance of the subtree.
+         */
+         double UpdateKNNDistances(u_int32_t pageID, ObjectType * newObj,
+               double distanceRepres, ObjectType & tmpObj);
+
+         /**
+         * Returns the maximum k-th nearest neighbor distance of the entries
+         * of a leaf or a negative value if one of them is unknown.
+         *
+         * @param leafNode The leaf node.
+         */
+         double GetMaxKNNDistance(stSlimLeafNode * leafNode){
+            double maxDistance = 0;
+            double kDistance;
+
+            for (u_int32_t idx = 0; idx < leafNode->GetNumberOfEntries(); idx++){
+               kDistance = leafNode->GetLeafEntry(idx).KNNDistance;
+               if (kDistance < 0){
+                  return -1;
+               }else if (kDistance > maxDistance){
+                  maxDistance = kDistance;
+               }//end if
+            }//end for
+            return maxDistance;
+         }//end GetMaxKNNDistance
+
+         /**
+         * Reverse k-nearest neighbor query over a subtree.
+         *
+         * @param pageID The root of the subtree.
+         * @param result The result.
+         * @param sample The sample object.
+         * @param distanceRepres The distance of the sample to the
+         * representative of the subtree or a negative value if there is none.
+         * @param tmpObj Scratch object.
+         * @see ReverseNearestQuery()
+         */
+         void ReverseNearestQuery(u_int32_t pageID, tResult * result,
+               ObjectType * sample, double distanceRepres, ObjectType & tmpObj);
+      #endif //__stSLIMRKNN__
+
+      /**
+      * The page manager wrapper used by the concurrent mode or NULL if the
+      * concurrent mode is disabled.
+      */
+      stConcurrentPageManager * ConcurrentPageManager;
+
+      /**
+      * Latch of the whole tree. It is held in shared mode by the queries and
+      * optimistic insertions and in exclusive mode by the insertions that
+      * change the structure of the tree (splits and new roots).
+      */
+      stLatch TreeLatch;
+
+      /**
+      * This type holds the resident upper levels.
+      */
+      typedef stSlimResidentLevels < ObjectType > tResidentLevels;
+
+      /**
+      * This type is a resident index node.
+      */
+      typedef typename tResidentLevels::tNode tResidentNode;
+
+      /**
+      * Number of resident upper levels (0 means disabled).
+      */
+      u_int32_t ResidentLevels;
+
+      /**
+      * Maximum size of the resident pages (0 means no limit).
+      */
+      u_int32_t ResidentMaxBytes;
+
+      /**
+      * Maximum number of child pages prefetched at once (0 means disabled).
+      */
+      u_int32_t PrefetchDepth;
+
+      #ifdef __stQUERYSTATS__
+         /**
+         * If true, each query result carries its statistics.
+         */
+         std::atomic < bool > QueryStatsEnabled;
+
+         /**
+         * Creates the statistics of a new query and attaches them to its
+         * result if they are enabled. The phase phTOTAL is started.
+         *
+         * @param result The result of the query.
+         * @return The statistics or NULL if they are disabled.
+         */
+         stQueryStats * NewQueryStats(tResult * result){
+            stQueryStats * stats;
+
+            if (!QueryStatsEnabled){
+               return NULL;
+            }//end if
+            stats = new stQueryStats();
+            stats->AddQuery();
+            result->SetQueryStats(stats);
+            stats->StartPhase(stQueryStats::phTOTAL);
+            return stats;
+         }//end NewQueryStats
+      #endif //__stQUERYSTATS__
+
+      /**
+      * Submits the prefetch of child pages if it is enabled. Only the first
+      * PrefetchDepth pages are submitted.
+      *
+      * @param pageIDs The IDs of the pages.
+      * @param count The number of pages.
+      */
+      void Prefetch(const u_int32_t * pageIDs, u_int32_t count){
+         if ((PrefetchDepth > 0) && (count > 0)){
+            tMetricTree::myPageManager->SubmitPrefetch(pageIDs,
+                  (count < PrefetchDepth) ? count : PrefetchDepth);
+         }//end if
+      }//end Prefetch
+
+      /**
+      * Submits the prefetch of the first entries of a priority queue of the
+      * NearestQuery() if it is enabled.
+      *
+      * @param queue The queue.
+      */
+      void Prefetch(tDynamicPriorityQueue * queue);
+
+      /**
+      * Number of modifications of the tree. The range cursors started at an
+      * older count are stale.
+      */
+      u_int32_t ModificationCount;
+
+      /**
+      * Number of modifications of the tree that the resident levels can not
+      * follow. The resident levels built at an older count are stale.
+      */
+      u_int32_t StructureCount;
+
+      /**
+      * The current resident levels. It is replaced atomically, so a query
+      * keeps the levels it started with.
+      */
+      std::shared_ptr < tResidentLevels > Resident;
+
+      /**
+      * Serializes the builds of the resident levels.
+      */
+      std::mutex ResidentMutex;
+
+      /**
+      * Reports a modification of the tree. It must be called after the pages
+      * are changed.
+      */
+      void NotifyModification(){
+         __atomic_add_fetch(&StructureCount, 1, __ATOMIC_RELEASE);
+         __atomic_add_fetch(&ModificationCount, 1, __ATOMIC_RELEASE);
+      }//end NotifyModification
+
+      /**
+      * Reports an insertion that did not split any node. Its index entries
+      * were copied to the resident levels by UpdateResidentEntry(), so only
+      * the range cursors become stale. It must be called after the pages
+      * are changed.
+      */
+      void NotifyInsertion(){
+         __atomic_add_fetch(&ModificationCount, 1, __ATOMIC_RELEASE);
+      }//end NotifyInsertion
+
+      /**
+      * Copies the number of entries and the radius of an index entry changed
+      * by an insertion that did not split any node to the current resident
+      * levels, if this entry is resident. It must be called after the page
+      * is changed and released.
+      *
+      * @param pageID The page of the index node.
+      * @param idx The entry.
+      * @param nEntries The new number of entries.
+      * @param radius The new radius.
+      */
+      void UpdateResidentEntry(u_int32_t pageID, u_int32_t idx,
+            u_int32_t nEntries, double radius);
+
+      /**
+      * Returns the resident levels that must be used by a query, building
+      * them if they are stale, or NULL if they must not be used.
+      */
+      std::shared_ptr < tResidentLevels > GetResident();
+
+      /**
+      * Decodes the index nodes of the top ResidentLevels levels into levels,
+      * level by level, until ResidentMaxBytes is reached.
+      *
+      * @param levels The resident levels (empty).
+      */
+      void BuildResident(tResidentLevels * levels);
+
+      /**
+      * Returns the latch that must be held by the queries or NULL if the
+      * concurrent mode is disabled.
+      */
+      stLatch * GetReadLatch(){
+         if (ConcurrentPageManager != NULL){
+            return &TreeLatch;
+         }else{
+            return NULL;
+         }//end if
+      }//end GetReadLatch
+
+      /**
+      * Inserts an object without changing the structure of the tree. The
+      * caller must hold TreeLatch in shared mode.
+      *
+      * @param newObj The object to be added.
+      * @return True if the object was inserted or false if the leaf is full
+      * (nothing is changed in this case).
+      * @see ConcurrentAdd()
+      */
+      bool OptimisticInsert(ObjectType * newObj);
+
+      /**
+      * The page manager wrapper used by the snapshot isolation or NULL if it
+      * is disabled.
+      */
+      stSnapshotPageManager * SnapshotPageManager;
+
+      /**
+      * A read view started by BeginReadView().
+      */
+      struct tReadView{
+         /**
+         * The tree.
+         */
+         stSlimTree * Tree;
+
+         /**
+         * Root of the snapshot.
+         */
+         u_int32_t Root;
+
+         /**
+         * Height of the snapshot.
+         */
+         u_int32_t Height;
+
+         /**
+         * Number of objects of the snapshot.
+         */
+         u_int32_t ObjectCount;
+
+         /**
+         * The previous view of the same thread.
+         */
+         tReadView * Previous;
+      };
+
+      /**
+      * Read views of the current thread (most recent first).
+      */
+      static thread_local tReadView * ThreadReadView;
+
+      /**
+      * Returns the most recent read view of the calling thread on this tree
+      * or NULL if there is none.
+      */
+      tReadView * GetReadView(){
+         tReadView * view = ThreadReadView;
+
+         while ((view != NULL) && (view->Tree != this)){
+            view = view->Previous;
+         }//end while
+         return view;
+      }//end GetReadView
+
       /**
       * The SlimTree header. This variable points to data in the HeaderPage.
       */
@@ -2236,10 +3620,17 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
       
       /**
       * Creates a new empty page and updates the node counter.
+      *
+      * @param leaf If true, the page will hold a leaf node (see
+      * stPageManager::GetNewLeafPage()).
       */
-      stPage * NewPage(){
+      stPage * NewPage(bool leaf = false){
          Header->NodeCount++;
-         return tMetricTree::myPageManager->GetNewPage();
+         if (leaf){
+            return tMetricTree::myPageManager->GetNewLeafPage();
+         }else{
+            return tMetricTree::myPageManager->GetNewPage();
+         }//end if
       }//end NewPage
       
       /**
@@ -2292,6 +3683,57 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
       */
       void MinMaxPromote(tLogicNode * node);
 
+      /**
+      * Evaluates the MinMax candidate pairs (i, j) with i in
+      * [first, node->GetNumberOfEntries()) taking one row of every step rows.
+      * The best pair is the first one with the smallest radius.
+      *
+      * @param node The node.
+      * @param distances The distance matrix of the node.
+      * @param sizes Space used by each entry.
+      * @param capacity Space available in an empty node.
+      * @param first The first row.
+      * @param step The step between rows.
+      * @param minRadius The radius of the best pair (output).
+      * @param idx1 The first index of the best pair (output).
+      * @param idx2 The second index of the best pair (output).
+      */
+      void MinMaxEvaluate(tLogicNode * node, const double * distances,
+                          const u_int32_t * sizes, u_int32_t capacity,
+                          u_int32_t first, u_int32_t step, double & minRadius,
+                          u_int32_t & idx1, u_int32_t & idx2);
+
+      /**
+      * Clustering used by BulkLoadMedoids().
+      */
+      typedef stKMedoids < ObjectType, EvaluatorType > tKMedoids;
+
+      /**
+      * Builds a subtree of BulkLoadMedoids().
+      *
+      * @param clustering The clustering.
+      * @param objects The objects of the subtree.
+      * @param sizes Space used by each object in a leaf.
+      * @param distances Distance between each object and rep.
+      * @param rep The representative of the subtree or objects.size() for
+      * the root.
+      * @param height The height of the subtree.
+      * @param fanout The expected number of entries of an index node.
+      * @param indexFree Space available in an empty index node.
+      * @param leafCapacity Space to be filled in each leaf.
+      * @param nodeOccupancy The fraction of each node to be filled.
+      * @param overflow The objects that did not fit their leaves (output).
+      * @param info The root, radius and number of objects of the subtree
+      * (output).
+      */
+      void BulkLoadMedoidsRecursive(tKMedoids & clustering,
+            std::vector < ObjectType * > & objects,
+            std::vector < u_int32_t > & sizes,
+            std::vector < double > & distances, u_int32_t rep,
+            u_int32_t height, u_int32_t fanout, u_int32_t indexFree,
+            double leafCapacity, double nodeOccupancy,
+            std::vector < ObjectType * > & overflow, stSubtreeInfo & info);
+
       /**
       * This method find a new center for the objects in the node P.
       * It works by finding the objects that minimizes the covering circle.
@@ -2321,6 +3763,11 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
          * Get root page id.
          */
          u_int32_t GetRoot(){
+            tReadView * view = GetReadView();
+
+            if (view != NULL){
+               return view->Root;
+            }//end if
             return this->Header->Root;
          }//end GetRoot
       #endif // __stDEBUG__
@@ -2339,6 +3786,7 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
       void UpdateObjectCounter(int inc){
          Header->ObjectCount += inc;
          HeaderUpdate = true;
+         NotifyModification();
       }//end UpdateObjectCounter
 
       /**
@@ -2542,15 +3990,36 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
       * @param sample The sample object.
       * @param range The range of the result.
       * @param distanceRepres The distance of the representative.
+      * @param tmpObj Scratch object of the query, reused by all nodes.
+      * @param samplePivots The distances of the sample to the global pivots
+      * (used only if __stSLIMPIVOTS__ is defined).
+      * @param level The level of the node (used only if __stQUERYSTATS__ is
+      * defined).
       * @see tResult * RangeQuery()
       */
       void RangeQuery(u_int32_t pageID, tResult * result,
                       ObjectType * sample, double range,
-                      double distanceRepres);
+                      double distanceRepres, ObjectType & tmpObj,
+                      const double * samplePivots, u_int32_t level);
+
+      /**
+      * This method will perform a range query starting from a resident
+      * node.
+      *
+      * @param node The resident node.
+      * @param hasRepres If false, node is the root and distanceRepres is not
+      * valid.
+      * @see RangeQuery(u_int32_t, tResult *, ObjectType *, double, double,
+      * ObjectType &, const double *, u_int32_t)
+      */
+      void RangeQuery(tResidentNode * node, tResult * result,
+                      ObjectType * sample, double range, bool hasRepres,
+                      double distanceRepres, ObjectType & tmpObj,
+                      const double * samplePivots, u_int32_t level);
 
       void ExistsQuery(u_int32_t pageID, tResult * result,
                       ObjectType * sample, double range,
-                      double distanceRepres);
+                      double distanceRepres, ObjectType & tmpObj);
 
       /**
       * This method will perform a reverse range query.
@@ -2607,10 +4076,39 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
       * @param sample The sample object.
       * @param rangeK The range of the results.
       * @param k The number of neighbours.
+      * @param tiebreaker If true, the ties are chosen by operator<().
+      * @param approx The knobs of the approximate query.
       * @see tResult * NearestQuery
       */
       void NearestQuery(tResult * result, ObjectType * sample,
-                        double rangeK, u_int32_t k, bool tiebreaker);
+                        double rangeK, u_int32_t k, bool tiebreaker,
+                        const tApproximate & approx);
+
+      /**
+      * Returns true if an approximate NearestQuery() must stop before
+      * reading the next node.
+      *
+      * @param approx The knobs.
+      * @param result The current result.
+      * @param k The number of neighbours.
+      * @param nodes The number of nodes read so far.
+      * @param objects The number of objects of the leaves read so far.
+      * @param start The start time of the query.
+      */
+      bool IsApproximateStop(const tApproximate & approx, tResult * result,
+            u_int32_t k, u_int32_t nodes, u_int32_t objects,
+            std::chrono::steady_clock::time_point start);
+
+      /**
+      * Returns an upper bound of the k-th distance of a query given by the
+      * last query of a hint, or MAXDOUBLE if it gives none.
+      *
+      * @param hint The hint.
+      * @param sample The sample object.
+      * @param k The number of neighbours.
+      */
+      double GetNearestBound(tNearestQueryHint * hint, ObjectType * sample,
+            u_int32_t k);
 
       /**
       * This method will perform a K-Farthest Neighbor query using a priority
@@ -2693,12 +4191,71 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
       * @param outRange The inner range of the results.
       * @return The result or NULL if this method is not implemented.
       * @param distanceRepres The distance of the representative.
+      * @param tmpObj Scratch object of the query, reused by all nodes.
       * @warning The value of outRange must be higher than inRange.
       * @see tResult * RingQuery()
       */
       void RingQuery(u_int32_t pageID, tResult * result,
                      ObjectType * sample, double inRange,
-                     double outRange, double distanceRepres);
+                     double outRange, double distanceRepres,
+                     ObjectType & tmpObj);
+
+      /**
+      * Sends the objects of a subtree with inRange < d(o, sample) <= outRange
+      * to a visitor. It is the engine of the streaming RangeQuery() (inRange
+      * is negative) and RingQuery().
+      *
+      * @param pageID The root of the subtree.
+      * @param sample The sample object.
+      * @param inRange The inner range.
+      * @param outRange The outter range.
+      * @param hasRepres If false, the node is the root and distanceRepres is
+      * not valid.
+      * @param distanceRepres The distance of the representative.
+      * @param tmpObj Scratch object of the query, reused by all nodes.
+      * @param visitor The visitor.
+      * @return False if the query was stopped by the visitor.
+      */
+      bool VisitRing(u_int32_t pageID, ObjectType * sample, double inRange,
+            double outRange, bool hasRepres, double distanceRepres,
+            ObjectType & tmpObj, tVisitor & visitor);
+
+      /**
+      * Resumes the traversal kept by a cursor, sending the objects to a
+      * visitor in the order of the cursor. It is the engine of the
+      * ForwardRangeQuery() and BackwardRangeQuery() with cursors.
+      *
+      * @param sample The sample object.
+      * @param cursor The cursor.
+      * @param backward The direction.
+      * @param visitor The visitor.
+      * @return False if the query was stopped by the visitor.
+      */
+      bool RangeCursorQuery(ObjectType * sample, stRangeCursor * cursor,
+            bool backward, tVisitor & visitor);
+
+      /**
+      * Clears the frontier of a cursor and puts the root in it, so the
+      * traversal restarts as a keyset query from the position of the cursor.
+      *
+      * @param cursor The cursor.
+      * @param backward The direction.
+      * @param modification The modification count of the tree.
+      */
+      void StartRangeCursor(stRangeCursor * cursor, bool backward,
+            u_int32_t modification);
+
+      /**
+      * Returns the next nObj objects of the traversal kept by a cursor.
+      *
+      * @param sample The sample object.
+      * @param nObj The number of objects.
+      * @param cursor The cursor.
+      * @param backward The direction.
+      * @return The result.
+      */
+      tResultPaged * RangeCursorQuery(ObjectType * sample, u_int32_t nObj,
+            stRangeCursor * cursor, bool backward);
 
       /**
       * This method will perform a ring query with K-Nearest Neighbor based on
@@ -2768,50 +4325,405 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
                                   u_int32_t k);
 
       /**
-      * This method will perform a range joined query.
+      * An entry of the queue of DiverseNearestQuery(): a subtree, keyed by
+      * the smallest possible distance of its objects to the sample, or an
+      * object, keyed by its distance to the sample.
+      */
+      struct tDiverseItem{
+         /**
+         * The key.
+         */
+         double Distance;
+
+         /**
+         * The page of the subtree or 0 for an object.
+         */
+         u_int32_t PageID;
+
+         /**
+         * The covering radius of the subtree.
+         */
+         double Radius;
+
+         /**
+         * The representative of the subtree (NULL for the root) or the
+         * object.
+         */
+         ObjectType * Object;
+
+         /**
+         * Order of the queue (a min heap). Subtrees come before the objects
+         * with the same key, so all objects tied at a distance are in the
+         * queue when the first of them is removed.
+         */
+         bool operator > (const tDiverseItem & item) const{
+            if (Distance != item.Distance){
+               return Distance > item.Distance;
+            }//end if
+            return (PageID == 0) && (item.PageID != 0);
+         }//end operator >
+      };
+
+      /**
+      * Returns true if an object of DiverseNearestQuery() is influenced by
+      * one of the objects already in the result.
       *
-      * @param currIndexNode The node in index tree to be analyzed.
-      * @param objIndex The object representative in index tree.
-      * @param radiusObjIndex The object representative in index tree.
-      * @param heightIndex Actual height of indexed tree.
-      * @param currNodeJoin The node in join tree to be analyzed.
-      * @param objJoin The object representative in join tree.
-      * @param radiusObjJoin The radius of object representative in join tree.
-      * @param heightJoin Actual height of joined tree.
-      * @param PageManagerJoin The PageManager of join tree.
-      * @param distRepres The distance of the representative of indexed and
-      * joined tree.
+      * @param result The result.
+      * @param obj The object.
+      * @param distance The distance of obj to the sample.
+      * @param diversity The influence factor.
+      */
+      bool IsInfluenced(tResult * result, ObjectType * obj, double distance,
+            double diversity);
+
+      /**
+      * A pair of nodes of the RangeJoinQuery(), one of this tree and one of
+      * the joined tree.
+      */
+      struct tRangeJoinPair{
+         /**
+         * The page of the node of this tree.
+         */
+         u_int32_t PageID;
+
+         /**
+         * The representative of the node of this tree or NULL for the root.
+         */
+         std::shared_ptr < ObjectType > Representative;
+
+         /**
+         * The covering radius of the node of this tree.
+         */
+         double Radius;
+
+         /**
+         * The page of the node of the joined tree.
+         */
+         u_int32_t JoinedPageID;
+
+         /**
+         * The representative of the node of the joined tree or NULL for the
+         * root.
+         */
+         std::shared_ptr < ObjectType > JoinedRepresentative;
+
+         /**
+         * The covering radius of the node of the joined tree.
+         */
+         double JoinedRadius;
+
+         /**
+         * The distance between both representatives or -1 if one of them is
+         * NULL.
+         */
+         double Distance;
+      };
+
+      /**
+      * The state shared by all tasks of a RangeJoinQuery().
+      */
+      struct tRangeJoinContext{
+         /**
+         * The joined tree.
+         */
+         stSlimTree * JoinedTree;
+
+         /**
+         * The range of the join.
+         */
+         double Range;
+
+         /**
+         * True for the SelfRangeJoin().
+         */
+         bool Self;
+
+         /**
+         * The callback.
+         */
+         tJoinCallback Callback;
+
+         /**
+         * Serializes the calls of Callback.
+         */
+         std::mutex CallbackMutex;
+
+         /**
+         * Set when Callback asks to stop.
+         */
+         std::atomic < bool > Stop;
+
+         /**
+         * The pages of both trees.
+         */
+         stSharedPageCache * Cache;
+
+         /**
+         * The pool running the pairs.
+         */
+         stTaskPool * Pool;
+
+         /**
+         * The metric evaluator of each thread.
+         */
+         std::vector < EvaluatorType * > Evaluators;
+      };
+
+      /**
+      * Runs the RangeJoinQuery() or the SelfRangeJoin().
+      *
+      * @param slimTree The tree being joined.
       * @param range The range of the results.
-      * @param result The query result.
-      * @param activeBuffer Active buffered of sub nodes in Joined Tree.
-      * @warning The instance of tJoinedResult returned must be destroied by user.
-      * @autor Implemented by Enzo Seraphim
+      * @param callback The callback.
+      * @param self True for the SelfRangeJoin(). slimTree must be this tree.
+      * @param nThreads The number of threads.
+      * @param cachePages The number of pages of the shared page cache.
+      * @return False if the join was stopped by the callback.
       */
-      void RangeJoinQueryRecursive(stSlimNode * currIndexNode, double radiusObjIndex,
-                  stSlimNode * currNodeJoin, double radiusObjJoin,
-                  stPageManager * PageManagerJoin, double distRepres,
-                  const double range, tJoinedResult * result,
-                  bool buffer);
+      bool RunRangeJoin(stSlimTree * slimTree, double range,
+            tJoinCallback callback, bool self, u_int32_t nThreads,
+            u_int32_t cachePages);
 
-      void RangeJoinRecursive(u_int32_t heightIndex, stSlimNode * currNode,
-                  stSlimTree * slimTree, double range, bool buffer,
-                  tJoinedResult * result);
+      /**
+      * Evaluates a pair of nodes of the RangeJoinQuery(). The qualifying
+      * pairs of children are submitted to the pool, grouped by the child of
+      * the joined tree so its page is reused by the pairs that run next. The
+      * pairs of objects of 2 leaves within the range are sent to the
+      * callback. In the SelfRangeJoin(), a node paired with itself takes only
+      * the pairs of entries i <= j (i < j in a leaf).
+      *
+      * @param context The join.
+      * @param pair The pair of nodes.
+      * @param thread The thread running it.
+      */
+      void RangeJoinPair(tRangeJoinContext * context, const tRangeJoinPair & pair,
+            u_int32_t thread);
 
       /**
-      * Recursive algoritm for navegate Joined Tree when Index Tree went in leaf
-      * node.
+      * Submits a pair of nodes of the RangeJoinQuery() to the pool.
+      */
+      void SubmitRangeJoinPair(tRangeJoinContext * context,
+            const tRangeJoinPair & pair, u_int32_t thread){
+         context->Pool->Submit(thread, [this, context, pair](u_int32_t t){
+            RangeJoinPair(context, pair, t);
+         });
+      }//end SubmitRangeJoinPair
+
+      /**
+      * An inner subtree or object that may hold a neighbor of the objects of
+      * an outer subtree in the NearestJoinQuery().
+      */
+      struct tJoinCandidate{
+         /**
+         * The object or the representative of the subtree. It is NULL until
+         * it is decoded.
+         */
+         std::shared_ptr < ObjectType > Object;
+
+         /**
+         * The offset of the serialized object in the buffer of its
+         * expansion.
+         */
+         u_int32_t Offset;
+
+         /**
+         * The size of the serialized object.
+         */
+         u_int32_t Size;
+
+         /**
+         * The page of the subtree or 0 for objects.
+         */
+         u_int32_t PageID;
+
+         /**
+         * The covering radius of the subtree or 0 for objects.
+         */
+         double Radius;
+
+         /**
+         * The number of entries of the subtree or 1 for objects.
+         */
+         u_int32_t NEntries;
+
+         /**
+         * The distance to the representative of the outer subtree.
+         */
+         double Distance;
+      };
+
+      /**
+      * The candidates of an outer subtree.
+      */
+      typedef std::vector < tJoinCandidate > tJoinCandidates;
+
+      /**
+      * An outer subtree of the NearestJoinQuery() and its candidates.
+      */
+      struct tJoinTask{
+         /**
+         * The page of the outer subtree.
+         */
+         u_int32_t PageID;
+
+         /**
+         * The representative of the outer subtree or NULL for the root.
+         */
+         std::shared_ptr < ObjectType > Representative;
+
+         /**
+         * The covering radius of the outer subtree.
+         */
+         double Radius;
+
+         /**
+         * The upper bound of the k-nearest neighbor distance of all objects
+         * of the outer subtree.
+         */
+         double Bound;
+
+         /**
+         * The candidates. Their distances are not valid for the root.
+         */
+         tJoinCandidates Candidates;
+      };
+
+      /**
+      * A triple found by the NearestJoinQuery(). The objects are owned by
+      * the result they are added to.
+      */
+      struct tJoinTriple{
+         ObjectType * Object;
+
+         ObjectType * JoinedObject;
+
+         double Distance;
+      };
+
+      /**
+      * A candidate in the queue of an outer object in the outer leaves.
+      */
+      struct tJoinStep{
+         /**
+         * The lower bound of the distance to the candidate.
+         */
+         double LowerBound;
+
+         /**
+         * The candidate.
+         */
+         u_int32_t Item;
+
+         /**
+         * The distance to the candidate, if it is already known, or -1.
+         */
+         double Distance;
+
+         /**
+         * Inverted, so std::make_heap() keeps the smallest lower bound on
+         * top.
+         */
+         bool operator < (const tJoinStep & step) const{
+            if (LowerBound != step.LowerBound){
+               return LowerBound > step.LowerBound;
+            }else{
+               return Item > step.Item;
+            }//end if
+         }//end operator <
+      };
+
+      /**
+      * The neighbors of an outer object, sorted by distance.
+      */
+      typedef std::vector < std::pair < double, std::shared_ptr < ObjectType > > >
+            tJoinNeighbors;
+
+      /**
+      * Solves an outer subtree of the NearestJoinQuery(). For index nodes,
+      * the candidates of each child are computed and each child is solved
+      * recursively or, if split is not NULL, added to it instead.
+      *
+      * @param task The outer subtree.
+      * @param joinedTree The inner tree.
+      * @param k The number of neighbours.
+      * @param tie The tie list.
+      * @param evaluator The metric evaluator of this thread.
+      * @param triples The triples found (output).
+      * @param split The children tasks (output) or NULL.
+      */
+      void NearestJoinTask(tJoinTask & task, stSlimTree * joinedTree,
+            u_int32_t k, bool tie, EvaluatorType * evaluator,
+            std::vector < tJoinTriple > & triples,
+            std::vector < tJoinTask > * split);
+
+      /**
+      * Solves an outer leaf of the NearestJoinQuery(). Each object performs
+      * a best first search starting from the candidates of the leaf, whose
+      * distances to the representative give their lower bounds for free.
+      * The candidate subtrees are read and decoded only once for all
+      * objects.
+      *
+      * @param node The outer leaf.
+      * @see NearestJoinTask()
+      */
+      void NearestJoinLeaf(stSlimNodeView * node, tJoinTask & task,
+            stSlimTree * joinedTree, u_int32_t k, bool tie,
+            EvaluatorType * evaluator, std::vector < tJoinTriple > & triples);
+
+      /**
+      * Reads the entries of a candidate subtree. Their distances are the
+      * distances to the representative of the subtree. The objects are not
+      * decoded, they are copied to data (see GetJoinObject()).
+      *
+      * @param cand The candidate subtree.
+      * @param joinedTree The inner tree.
+      * @param candidates The entries are appended to it.
+      * @param data The serialized objects are appended to it.
+      */
+      void ExpandJoinCandidate(const tJoinCandidate & cand,
+            stSlimTree * joinedTree, tJoinCandidates & candidates,
+            std::vector < unsigned char > & data);
+
+      /**
+      * Returns the object of a candidate, decoding it from data on its first
+      * use.
+      *
+      * @param cand The candidate.
+      * @param data The serialized objects of its expansion.
+      */
+      ObjectType * GetJoinObject(tJoinCandidate & cand,
+            const std::vector < unsigned char > & data){
+         if (cand.Object == NULL){
+            cand.Object.reset(new ObjectType());
+            if (cand.PageID != 0){
+               cand.Object->Unserialize(data.data() + cand.Offset, cand.Size);
+            }else{
+               cand.Object->IncludedUnserialize(data.data() + cand.Offset, cand.Size);
+            }//end if
+         }//end if
+         return cand.Object.get();
+      }//end GetJoinObject
+
+      /**
+      * Returns the upper bound of the k-nearest neighbor distance of an outer
+      * subtree given its candidates, or bound if it is smaller.
+      *
+      * @param candidates The candidates.
+      * @param radius The covering radius of the outer subtree.
+      * @param k The number of neighbours.
+      * @param bound The current bound.
+      */
+      double GetJoinBound(tJoinCandidates & candidates, double radius,
+            u_int32_t k, double bound);
+
+      /**
+      * Adds a neighbor to the sorted list of neighbors of an outer object.
       *
-      * @param PageManagerJoin
-      * @param currNodeJoin
-      * @param objIndex
-      * @param distRepres
-      * @param range
-      * @param result
+      * @return The k-nearest neighbor distance of the list or MAXDOUBLE if it
+      * has less than k neighbors.
       */
-      void JoinedTreeRangeJoinRecursive(stPageManager * PageManagerJoin,
-                  stSlimNode * currNodeJoin, ObjectType * objIndex,
-                  double distRepres, double range,
-                  tJoinedResult * result);
+      double AddJoinNeighbor(tJoinNeighbors & neighbors, double distance,
+            const std::shared_ptr < ObjectType > & obj, u_int32_t k, bool tie);
 
       /**
       * For each entry in the leaf entry call the range query in the
@@ -2968,11 +4880,12 @@ class stSlimTree: public stMetricTree <ObjectType, EvaluatorType> {
       * implementation errors that a developer may introduce in his/her 
       * implementation.
       *
+      * @param tmpObj Scratch object shared by all levels.
       * @see Consistency()
       */
       bool Consistency(u_int32_t pageID, ObjectType * repObj, 
                        double & radius, u_int32_t & height, 
-                       u_int32_t & objectCount);
+                       u_int32_t & objectCount, ObjectType & tmpObj);
 
 };//end stSlimTree
 
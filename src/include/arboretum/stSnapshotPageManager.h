@@ -0,0 +1,293 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file defines the class stSnapshotPageManager.
+*
+* @version 1.0
+*/
+#ifndef __STSNAPSHOTPAGEMANAGER_H
+#define __STSNAPSHOTPAGEMANAGER_H
+
+#include <arboretum/stPageManager.h>
+#include <arboretum/stUtil.h>
+
+#include <mutex>
+#include <map>
+#include <set>
+#include <deque>
+
+//==============================================================================
+// Class stSnapshotPageManager
+//------------------------------------------------------------------------------
+/**
+* This class wraps another stPageManager adding snapshot isolation with
+* copy-on-write page versions.
+*
+* <P>The modifications are grouped in epochs. The writer works on the epoch
+* GetCommittedEpoch() + 1 and Commit() publishes it atomically, including the
+* header page. Before the writer gets a page for the first time in an epoch,
+* the current image of the page is saved as a version valid for the snapshots
+* taken before this epoch.
+*
+* <P>A reader pins the last committed epoch with BeginSnapshot(). While the
+* snapshot is pinned, every GetPage() of the calling thread returns a private
+* copy of the page as it was when the epoch was committed, no matter what the
+* writer does. Versions are reclaimed (epoch-based reclamation) when no
+* pinned snapshot may read them anymore.
+*
+* <P>Only one thread may modify the pages at a time. Threads holding a
+* snapshot must not modify the pages. This instance will not claim the
+* ownership of the wrapped page manager.
+*
+* <P>The versions are kept in pages of a single size, so the leaf pages are
+* allocated by the GetNewPage() of the wrapped page manager even if it
+* supports larger leaf pages.
+*
+* @version 1.0
+* @see stSlimTree::SetSnapshotIsolation()
+* @ingroup storage
+*/
+class stSnapshotPageManager: public stPageManager{
+   public:
+      /**
+      * Creates a new stSnapshotPageManager.
+      *
+      * @param pageman The page manager to be wrapped.
+      */
+      stSnapshotPageManager(stPageManager * pageman);
+
+      /**
+      * Disposes this instance and all versions. The wrapped page manager is
+      * not disposed.
+      */
+      virtual ~stSnapshotPageManager();
+
+      /**
+      * Returns the wrapped page manager.
+      */
+      stPageManager * GetPageManager(){
+         return PageManager;
+      }//end GetPageManager
+
+      /**
+      * Publishes the modifications performed since the last call. The
+      * contents of the header page written by the last WriteHeaderPage() are
+      * published with them.
+      *
+      * @return The new committed epoch.
+      */
+      u_int64_t Commit();
+
+      /**
+      * Returns the last committed epoch.
+      */
+      u_int64_t GetCommittedEpoch();
+
+      /**
+      * Pins the last committed epoch for the calling thread. Snapshots may be
+      * nested. In this case, the most recent one is used.
+      *
+      * @param header Buffer that will receive the committed header data or
+      * NULL.
+      * @param size Size of the buffer.
+      * @return The pinned epoch.
+      * @see EndSnapshot()
+      */
+      u_int64_t BeginSnapshot(void * header = NULL, u_int32_t size = 0);
+
+      /**
+      * Unpins the most recent snapshot of the calling thread.
+      */
+      void EndSnapshot();
+
+      /**
+      * Returns the number of page versions kept by this page manager.
+      */
+      u_int32_t GetVersionCount();
+
+      /**
+      * @copydoc stPageManager::IsEmpty()
+      */
+      virtual bool IsEmpty();
+
+      /**
+      * @copydoc stPageManager::GetHeaderPage()
+      */
+      virtual stPage * GetHeaderPage();
+
+      /**
+      * Returns the page with the given page ID. If the calling thread holds
+      * a snapshot, the page is a private copy of the version seen by the
+      * snapshot.
+      *
+      * @param pageid The desired page id.
+      * @return The page or NULL for an invalid page ID.
+      */
+      virtual stPage * GetPage(u_int32_t pageid);
+
+      /**
+      * @copydoc stPageManager::ReleasePage()
+      */
+      virtual void ReleasePage(stPage * page);
+
+      /**
+      * @copydoc stPageManager::GetNewPage()
+      */
+      virtual stPage * GetNewPage();
+
+      /**
+      * @copydoc stPageManager::WritePage()
+      */
+      virtual void WritePage(stPage * page);
+
+      /**
+      * @copydoc stPageManager::WriteHeaderPage()
+      */
+      virtual void WriteHeaderPage(stPage * headerpage);
+
+      /**
+      * @copydoc stPageManager::DisposePage()
+      */
+      virtual void DisposePage(stPage * page);
+
+      /**
+      * @copydoc stPageManager::BeginUpdate()
+      */
+      virtual void BeginUpdate();
+
+      /**
+      * @copydoc stPageManager::EndUpdate()
+      */
+      virtual void EndUpdate();
+
+      /**
+      * @copydoc stPageManager::SubmitPrefetch()
+      */
+      virtual void SubmitPrefetch(const u_int32_t * pageIDs, u_int32_t count);
+
+      /**
+      * Restarts the statistics of this page manager and of the wrapped one.
+      */
+      virtual void ResetStatistics();
+
+      /**
+      * @copydoc stPageManager::GetMinimumPageSize()
+      */
+      virtual u_int32_t GetMinimumPageSize();
+
+      /**
+      * @copydoc stPageManager::GetPageCount()
+      */
+      virtual u_int32_t GetPageCount();
+
+   private:
+      /**
+      * A saved image of a page.
+      */
+      struct tVersion{
+         /**
+         * This image is seen by the snapshots older than this epoch.
+         */
+         u_int64_t Until;
+
+         /**
+         * The image.
+         */
+         stPage * Image;
+      };//end tVersion
+
+      /**
+      * Versions of a page sorted by Until.
+      */
+      typedef std::deque < tVersion > tVersionList;
+
+      /**
+      * Cache of page instances.
+      */
+      typedef stInstanceCache < stPage, stPageAllocator > tPageInstanceCache;
+
+      /**
+      * The wrapped page manager.
+      */
+      stPageManager * PageManager;
+
+      /**
+      * Serializes the calls to the wrapped page manager and the access to
+      * the versions.
+      */
+      std::mutex Mutex;
+
+      /**
+      * Last committed epoch.
+      */
+      u_int64_t CommittedEpoch;
+
+      /**
+      * Versions of each page.
+      */
+      std::map < u_int32_t, tVersionList > Versions;
+
+      /**
+      * All versions in the order they were created (same order of Until).
+      */
+      std::deque < u_int32_t > VersionOrder;
+
+      /**
+      * Number of versions.
+      */
+      u_int32_t VersionCount;
+
+      /**
+      * Epochs pinned by the readers.
+      */
+      std::multiset < u_int64_t > Pinned;
+
+      /**
+      * The last header page written.
+      */
+      stPage * HeaderPage;
+
+      /**
+      * Header data of the last committed epoch.
+      */
+      stPage * CommittedHeader;
+
+      /**
+      * Page instances used by images and private copies.
+      */
+      tPageInstanceCache * PageCache;
+
+      /**
+      * Returns the epoch pinned by the calling thread or 0 if it has no
+      * snapshot.
+      */
+      u_int64_t GetThreadSnapshot();
+
+      /**
+      * Saves the current image of a page if it was not saved in the current
+      * epoch. The caller must hold Mutex.
+      *
+      * @param page The page.
+      */
+      void SaveVersion(stPage * page);
+
+      /**
+      * Disposes the versions no pinned snapshot (current or future) may
+      * read. The caller must hold Mutex.
+      */
+      void Reclaim();
+};//end stSnapshotPageManager
+
+#endif //__STSNAPSHOTPAGEMANAGER_H
@@ -0,0 +1,138 @@
+/* Copyright 2003-2017 GBDI-ICMC-USP <caetano@icmc.usp.br>
+* 
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+* 
+* 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+* 
+* 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+* 
+* 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**
+* @file
+*
+* This file defines the class stTaskPool.
+*
+* @version 1.0
+*/
+#ifndef __STTASKPOOL_H
+#define __STTASKPOOL_H
+
+#include <arboretum/stCommon.h>
+
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <functional>
+
+//=============================================================================
+// Class stTaskPool
+//-----------------------------------------------------------------------------
+/**
+* This class implements a work stealing pool of threads. Each thread owns a
+* queue of tasks. A thread takes the tasks of its own queue from the back (the
+* last task submitted first, so related tasks run together) and, when its
+* queue is empty, steals the oldest task of the queue of another thread.
+*
+* <P>Tasks may submit new tasks to the queue of the thread running them. Run()
+* returns when all tasks, including the ones submitted while running, are
+* finished.
+*
+* @version 1.0
+* @ingroup struct
+*/
+class stTaskPool{
+   public:
+      /**
+      * A task. It receives the number of the thread running it.
+      */
+      typedef std::function < void (u_int32_t thread) > tTask;
+
+      /**
+      * Creates a new pool.
+      *
+      * @param nThreads The number of threads. 0 means one thread per
+      * hardware core.
+      */
+      stTaskPool(u_int32_t nThreads = 0);
+
+      /**
+      * Returns the number of threads.
+      */
+      u_int32_t GetNumberOfThreads(){
+         return Queues.size();
+      }//end GetNumberOfThreads
+
+      /**
+      * Adds a task to the queue of a thread.
+      *
+      * @param thread The thread. Tasks must use the number they received.
+      * @param task The task.
+      */
+      void Submit(u_int32_t thread, tTask task);
+
+      /**
+      * Runs all tasks. The calling thread is the thread 0.
+      */
+      void Run();
+
+      /**
+      * Returns the number of tasks stolen by the last Run().
+      */
+      u_int64_t GetStealCount(){
+         return StealCount;
+      }//end GetStealCount
+
+   private:
+      /**
+      * The queue of a thread.
+      */
+      struct tQueue{
+         /**
+         * Guards Tasks.
+         */
+         std::mutex Mutex;
+
+         /**
+         * The tasks.
+         */
+         std::deque < tTask > Tasks;
+      };
+
+      /**
+      * The queues, one per thread.
+      */
+      std::vector < std::unique_ptr < tQueue > > Queues;
+
+      /**
+      * Number of tasks submitted but not finished.
+      */
+      std::atomic < u_int64_t > Pending;
+
+      /**
+      * Number of tasks stolen.
+      */
+      std::atomic < u_int64_t > StealCount;
+
+      /**
+      * Takes the next task of a thread, stealing it if its queue is empty.
+      *
+      * @param thread The thread.
+      * @param task The task (output).
+      * @return False if no task was found.
+      */
+      bool Take(u_int32_t thread, tTask & task);
+
+      /**
+      * The loop of each thread.
+      *
+      * @param thread The thread.
+      */
+      void Work(u_int32_t thread);
+};//end stTaskPool
+
+#endif //__STTASKPOOL_H
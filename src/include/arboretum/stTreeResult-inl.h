@@ -619,10 +619,6 @@ stJoinedResult<ObjectType>::~stJoinedResult(){
       delete *ite;
       Triples.erase(ite);
    }//end while
-   // Dispose sample object.
-   if (this->Sample != NULL){
-      delete this->Sample;
-   }//end if
 }//end stResult<ObjectType>::~stResult
 
 //----------------------------------------------------------------------------
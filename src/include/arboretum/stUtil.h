@@ -611,6 +611,17 @@ class stDynamicRPriorityQueue{
          return size;
       }//end GetSize
 
+      /**
+      * Returns the value of an entry without removing it. The entries are
+      * kept as a heap, so the entry 0 is the next one returned by Get() and
+      * the first entries are usually the next ones.
+      *
+      * @param idx The index of the entry. It must be less than GetSize().
+      */
+      const TValue & GetValue(int idx){
+         return entries[idx].value;
+      }//end GetValue
+
    private:
 
       /**
@@ -864,12 +875,14 @@ typedef struct stQueryPriorityQueueValue{
       * Parent of this node.
       */
       u_int32_t Parent;
-   
+   #endif //__stMAMVIEW__
+
+   #if defined(__stMAMVIEW__) || defined(__stQUERYSTATS__)
       /**
       * Level of this node.
       */
       int Level;  
-   #endif //__stMAMVIEW__
+   #endif //__stMAMVIEW__ || __stQUERYSTATS__
    
    /**
    * Operator = . 
@@ -882,8 +895,10 @@ typedef struct stQueryPriorityQueueValue{
       this->Radius = v.Radius;
       #ifdef __stMAMVIEW__
          this->Parent = v.Parent;
-         this->Level = v.Level;
       #endif //__stMAMVIEW__
+      #if defined(__stMAMVIEW__) || defined(__stQUERYSTATS__)
+         this->Level = v.Level;
+      #endif //__stMAMVIEW__ || __stQUERYSTATS__
       return *this;
    }//end operator =
    
@@ -162,6 +162,25 @@ class DistanceFunction{
             distCount++;
         }
 
+        /**
+        * @copydoc updateDistanceCount(u_int32_t count) .
+        */
+        void UpdateDistanceCount(u_int32_t count){
+
+            updateDistanceCount(count);
+        }
+
+        /**
+        * Updates the distance counter by adding count. It is used to merge
+        * the statistics of evaluator copies used by other threads.
+        *
+        * @param count The number of distances to add.
+        */
+        void updateDistanceCount(u_int32_t count){
+
+            distCount += count;
+        }
+
    
 };//end DistanceFunction
 #endif //__DistanceFunction_H